@@ -120,6 +120,14 @@ PackageHelper(Opus ${OPUS_FOUND} "${OPUS_INCLUDE_DIRS}" "${OPUS_LIBRARIES}")
 
 
 
+#bzip2
+find_package(BZip2 QUIET)
+if(BZIP2_FOUND)
+  SET(SAIGA_USE_BZIP2 1)
+endif()
+PackageHelper(BZip2 ${BZIP2_FOUND} "${BZIP2_INCLUDE_DIR}" "${BZIP2_LIBRARIES}")
+
+
 #libfreeimage
 find_package(FreeImagePlus QUIET)
 PackageHelper(FreeImagePlus ${FREEIMAGEPLUS_FOUND} "${FREEIMAGEPLUS_INCLUDE_PATH}" "${FREEIMAGEPLUS_LIBRARIES}")
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/Core.h"
+#include "saiga/core/image/integralImage.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/CpuFeatures.h"
+#include "saiga/core/util/table.h"
+using namespace Saiga;
+
+// Compares the naive box filter and window statistics with the integral image / running sum implementations.
+struct BoxFilterBenchmark
+{
+    BoxFilterBenchmark(int w, int h) : gray(h, w), grayf(h, w), result(h, w), resultf(h, w)
+    {
+        for (int i = 0; i < h; ++i)
+        {
+            for (int j = 0; j < w; ++j)
+            {
+                gray(i, j)  = Random::uniformInt(0, 255);
+                grayf(i, j) = gray(i, j);
+            }
+        }
+    }
+
+    void NaiveBoxFilter(int radius)
+    {
+        for (int i = 0; i < gray.h; ++i)
+        {
+            for (int j = 0; j < gray.w; ++j)
+            {
+                int sum = 0, n = 0;
+                for (int y = std::max(i - radius, 0); y <= std::min(i + radius, gray.h - 1); ++y)
+                {
+                    for (int x = std::max(j - radius, 0); x <= std::min(j + radius, gray.w - 1); ++x)
+                    {
+                        sum += gray(y, x);
+                        n++;
+                    }
+                }
+                result(i, j) = (sum + n / 2) / n;
+            }
+        }
+    }
+
+    // Local variance at every pixel, as used by contrast and noise estimators.
+    double NaiveVariance(int radius)
+    {
+        double total = 0;
+        for (int i = 0; i < gray.h; i += 4)
+        {
+            for (int j = 0; j < gray.w; j += 4)
+            {
+                double sum = 0, sq = 0;
+                int n      = 0;
+                for (int y = std::max(i - radius, 0); y <= std::min(i + radius, gray.h - 1); ++y)
+                {
+                    for (int x = std::max(j - radius, 0); x <= std::min(j + radius, gray.w - 1); ++x)
+                    {
+                        double v = gray(y, x);
+                        sum += v;
+                        sq += v * v;
+                        n++;
+                    }
+                }
+                total += sq / n - (sum / n) * (sum / n);
+            }
+        }
+        return total;
+    }
+
+    double IntegralVariance(int radius)
+    {
+        integral.create(gray, true);
+        double total = 0;
+        for (int i = 0; i < gray.h; i += 4)
+        {
+            for (int j = 0; j < gray.w; j += 4)
+            {
+                total += integral.BoxVariance(i, j, radius);
+            }
+        }
+        return total;
+    }
+
+    void Run()
+    {
+        std::cout << cpuFeatures() << std::endl;
+        std::cout << "Image size " << gray.w << "x" << gray.h << std::endl;
+
+        Table table({10, 14, 14, 14, 14, 14, 14});
+        table << "Radius"
+              << "Naive (ms)"
+              << "Scalar (ms)"
+              << "SIMD (ms)"
+              << "Float (ms)"
+              << "Var Naive"
+              << "Var Integral";
+
+        for (int radius : {1, 3, 7, 15, 31})
+        {
+            auto naive = measureObject(radius > 7 ? 1 : 5, [&]() { NaiveBoxFilter(radius); });
+            setSimdEnabled(false);
+            auto scalar = measureObject(20, [&]() { ImageTransformation::BoxFilter(gray, result, radius); });
+            setSimdEnabled(true);
+            auto simd  = measureObject(20, [&]() { ImageTransformation::BoxFilter(gray, result, radius); });
+            auto simdf = measureObject(20, [&]() { ImageTransformation::BoxFilter(grayf, resultf, radius); });
+
+            double v1, v2;
+            auto var_naive    = measureObject(1, [&]() { v1 = NaiveVariance(radius); });
+            auto var_integral = measureObject(5, [&]() { v2 = IntegralVariance(radius); });
+            SAIGA_ASSERT(std::abs(v1 - v2) < 1e-6 * std::abs(v1));
+
+            table << radius << naive.median << scalar.median << simd.median << simdf.median << var_naive.median
+                  << var_integral.median;
+        }
+    }
+
+    TemplatedImage<unsigned char> gray;
+    TemplatedImage<float> grayf;
+    TemplatedImage<unsigned char> result;
+    TemplatedImage<float> resultf;
+    IntegralImage<unsigned char> integral;
+};
+
+
+int main(int, char**)
+{
+    BoxFilterBenchmark bench(1280, 960);
+    bench.Run();
+    return 0;
+}
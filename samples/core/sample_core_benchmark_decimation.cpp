@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/Core.h"
+#include "saiga/core/geometry/QuadricDecimation.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/Thread/omp.h"
+#include "saiga/core/util/table.h"
+
+using namespace Saiga;
+
+// Quadric error decimation of a bumpy height field to 10% of the faces.
+//   - Serial:   QuadricDecimate
+//   - Parallel: QuadricDecimateParallel with 4x4x4 chunks
+// 'Error' is the maximum vertical distance of the result vertices to the height field.
+
+static float Height(float x, float y)
+{
+    return 0.05f * sin(20 * x) * cos(15 * y);
+}
+
+static TriangleMesh<VertexNC, uint32_t> HeightField(int n)
+{
+    TriangleMesh<VertexNC, uint32_t> mesh;
+    mesh.vertices.resize(size_t(n) * n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            float x                           = float(j) / n;
+            float y                           = float(i) / n;
+            mesh.vertices[i * n + j].position = vec4(x, y, Height(x, y), 1);
+        }
+    }
+    for (int i = 0; i < n - 1; ++i)
+    {
+        for (int j = 0; j < n - 1; ++j)
+        {
+            uint32_t v = i * n + j;
+            mesh.addFace(v, v + 1, v + n + 1);
+            mesh.addFace(v, v + n + 1, v + n);
+        }
+    }
+    return mesh;
+}
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    std::cout << "Threads: " << OMP::getMaxThreads() << std::endl;
+
+    Table table({12, 12, 14, 12, 16, 12});
+    table << "Faces"
+          << "Target"
+          << "Serial (ms)"
+          << "Error"
+          << "Parallel (ms)"
+          << "Error";
+
+    auto error = [](const TriangleMesh<VertexNC, uint32_t>& mesh) {
+        float e = 0;
+        for (auto& v : mesh.vertices) e = std::max(e, std::abs(v.position.z() - Height(v.position.x(), v.position.y())));
+        return e;
+    };
+
+    for (int n : {300, 1000, 2000})
+    {
+        auto input = HeightField(n);
+        QuadricDecimationSettings settings;
+        settings.target_faces = input.faces.size() / 10;
+
+        float t_serial, t_parallel;
+        auto serial = input;
+        {
+            ScopedTimer<float> timer(t_serial);
+            QuadricDecimate(serial, settings);
+        }
+        auto parallel = input;
+        {
+            ScopedTimer<float> timer(t_parallel);
+            QuadricDecimateParallel(parallel, settings, 4);
+        }
+        table << input.faces.size() << settings.target_faces << t_serial << error(serial) << t_parallel
+              << error(parallel);
+    }
+    return 0;
+}
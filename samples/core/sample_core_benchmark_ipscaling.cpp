@@ -5,13 +5,81 @@
  */
 
 #include "saiga/core/Core.h"
+#include "saiga/core/image/imageTransformations.h"
 #include "saiga/core/time/all.h"
+#include "saiga/core/util/CpuFeatures.h"
 #include "saiga/core/util/Thread/omp.h"
+#include "saiga/core/util/table.h"
 using namespace Saiga;
 
 struct ImageProcessing
 {
-    ImageProcessing(int w, int h) : rgbImage(h, w), floatImage(h, w), grayImage(h, w) {}
+    ImageProcessing(int w, int h)
+        : rgbImage(h, w),
+          rgbImageNoAlpha(h, w),
+          floatImage(h, w),
+          grayImage(h, w),
+          rgbHalf(h / 2, w / 2),
+          grayHalf(h / 2, w / 2),
+          rgbResized(h * 2 / 3, w * 2 / 3)
+    {
+        rgbImage.getImageView().set(ucvec4(10, 100, 200, 255));
+        rgbImageNoAlpha.getImageView().set(ucvec3(10, 100, 200));
+        floatImage.getImageView().set(2.5f);
+        grayImage.getImageView().set(100);
+    }
+
+    // Runs the kernel with and without SIMD dispatch and prints the bandwidth.
+    // bytesRW is the number of bytes read + written by one execution of the kernel.
+    template <typename F>
+    void benchmarkKernel(Table& table, const std::string& name, size_t bytesRW, F f)
+    {
+        double gbRW = bytesRW / (1000.0 * 1000.0 * 1000.0);
+
+        setSimdEnabled(false);
+        auto stats_scalar = measureObject(50, f);
+        setSimdEnabled(true);
+        auto stats_simd = measureObject(50, f);
+
+        double bw_scalar = gbRW / (stats_scalar.median / 1000.0);
+        double bw_simd   = gbRW / (stats_simd.median / 1000.0);
+        table << name << stats_scalar.median << bw_scalar << stats_simd.median << bw_simd << bw_simd / bw_scalar;
+    }
+
+    void testKernels()
+    {
+        std::cout << cpuFeatures() << std::endl;
+
+        Table table({24, 14, 14, 14, 14, 10});
+        table << "Kernel"
+              << "Scalar (ms)"
+              << "Scalar GB/s"
+              << "SIMD (ms)"
+              << "SIMD GB/s"
+              << "Speedup";
+
+        benchmarkKernel(table, "RGBAToGray8", rgbImage.size() + grayImage.size(),
+                        [&]() { ImageTransformation::RGBAToGray8(rgbImage, grayImage); });
+        benchmarkKernel(table, "RGBAToGrayF", rgbImage.size() + floatImage.size(),
+                        [&]() { ImageTransformation::RGBAToGrayF(rgbImage, floatImage); });
+        benchmarkKernel(table, "Gray8ToRGBA", rgbImage.size() + grayImage.size(),
+                        [&]() { ImageTransformation::Gray8ToRGBA(grayImage, rgbImage); });
+        benchmarkKernel(table, "addAlphaChannel", rgbImage.size() + rgbImageNoAlpha.size(),
+                        [&]() { ImageTransformation::addAlphaChannel(rgbImageNoAlpha, rgbImage); });
+        benchmarkKernel(table, "depthToRGBA", rgbImage.size() + floatImage.size(),
+                        [&]() { ImageTransformation::depthToRGBA(floatImage, rgbImage); });
+        benchmarkKernel(table, "ScaleDown2", rgbImage.size() + rgbHalf.size(),
+                        [&]() { ImageTransformation::ScaleDown2(rgbImage, rgbHalf); });
+        benchmarkKernel(table, "RGBAToGray8ScaleDown2", rgbImage.size() + grayHalf.size(),
+                        [&]() { ImageTransformation::RGBAToGray8ScaleDown2(rgbImage, grayHalf); });
+        benchmarkKernel(table, "Resize Bilinear", rgbImage.size() + rgbResized.size(), [&]() {
+            ImageTransformation::Resize(rgbImage, rgbResized, ImageTransformation::ResizeFilter::Bilinear);
+        });
+        benchmarkKernel(table, "Resize Area", rgbImage.size() + rgbResized.size(), [&]() {
+            ImageTransformation::Resize(rgbImage, rgbResized, ImageTransformation::ResizeFilter::Area);
+        });
+        std::cout << std::endl;
+    }
 
     double testRGB2Gray(int threads)
     {
@@ -44,8 +112,13 @@ struct ImageProcessing
 
     const vec3 rgbToGray = vec3(0.299f, 0.587f, 0.114f);
     TemplatedImage<ucvec4> rgbImage;
+    TemplatedImage<ucvec3> rgbImageNoAlpha;
     TemplatedImage<float> floatImage;
     TemplatedImage<unsigned char> grayImage;
+
+    TemplatedImage<ucvec4> rgbHalf;
+    TemplatedImage<unsigned char> grayHalf;
+    TemplatedImage<ucvec4> rgbResized;
 };
 
 
@@ -53,6 +126,9 @@ int main(int, char**)
 {
     ImageProcessing ip(640 * 4, 480 * 4);
 
+    // Single threaded bandwidth of the image transformation kernels
+    ip.testKernels();
+
     int maxThreads = OMP::getMaxThreads();
 #pragma omp parallel
     maxThreads = OMP::getNumThreads();
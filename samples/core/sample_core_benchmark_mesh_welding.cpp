@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/Core.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/Thread/omp.h"
+#include "saiga/core/util/table.h"
+
+using namespace Saiga;
+
+// Welding of triangle soups, for example the output of marching cubes.
+// The soup is a tesselated height field with 3 vertices per triangle.
+//   - Sort + Dedup: sortVerticesByPosition + removeSubsequentDuplicates + removeDegenerateFaces
+//   - Weld:         weldVertices(1e-5)
+//   - Weld exact:   weldVertices(0)
+// 'Vertices' is the number of vertices after welding.
+
+static TriangleMesh<VertexNC, uint32_t> HeightFieldSoup(int n)
+{
+    auto height = [n](int i, int j) {
+        float x = float(j) / n, y = float(i) / n;
+        return vec4(x, y, 0.1f * sin(20 * x) * cos(15 * y), 1);
+    };
+
+    TriangleMesh<VertexNC, uint32_t> mesh;
+    mesh.vertices.resize(size_t(n - 1) * (n - 1) * 6);
+    mesh.faces.resize(size_t(n - 1) * (n - 1) * 2);
+#pragma omp parallel for
+    for (int i = 0; i < n - 1; ++i)
+    {
+        for (int j = 0; j < n - 1; ++j)
+        {
+            uint32_t f      = (i * (n - 1) + j) * 2;
+            vec4 corners[6] = {height(i, j), height(i, j + 1),     height(i + 1, j + 1),
+                               height(i, j), height(i + 1, j + 1), height(i + 1, j)};
+            for (int k = 0; k < 6; ++k)
+            {
+                mesh.vertices[f * 3 + k].position = corners[k];
+                mesh.vertices[f * 3 + k].color    = vec4(1, 1, 1, 1);
+            }
+            mesh.faces[f]     = {f * 3, f * 3 + 1, f * 3 + 2};
+            mesh.faces[f + 1] = {f * 3 + 3, f * 3 + 4, f * 3 + 5};
+        }
+    }
+    return mesh;
+}
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    std::cout << "Threads: " << OMP::getMaxThreads() << std::endl;
+
+    Table table({12, 12, 18, 12, 16, 12});
+    table << "Soup Verts"
+          << "Faces"
+          << "Sort+Dedup (ms)"
+          << "Weld (ms)"
+          << "Weld exact (ms)"
+          << "Vertices";
+
+    for (int n : {300, 1000, 1300})
+    {
+        auto soup = HeightFieldSoup(n);
+
+        float t_sort, t_weld, t_exact;
+        {
+            auto mesh = soup;
+            ScopedTimer<float> timer(t_sort);
+            mesh.sortVerticesByPosition();
+            mesh.removeSubsequentDuplicates();
+            mesh.removeDegenerateFaces();
+        }
+        {
+            auto mesh = soup;
+            ScopedTimer<float> timer(t_exact);
+            mesh.weldVertices(0);
+        }
+        size_t vertices;
+        {
+            ScopedTimer<float> timer(t_weld);
+            soup.weldVertices(1e-5);
+            vertices = soup.vertices.size();
+        }
+        table << soup.faces.size() * 3 << soup.faces.size() << t_sort << t_weld << t_exact << vertices;
+    }
+    return 0;
+}
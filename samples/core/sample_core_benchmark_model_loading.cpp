@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/Core.h"
+#include "saiga/core/model/UnifiedModelBinary.h"
+#include "saiga/core/model/model_loader_obj.h"
+#include "saiga/core/model/model_loader_off.h"
+#include "saiga/core/model/model_loader_ply.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/Thread/omp.h"
+#include "saiga/core/util/table.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace Saiga;
+
+// Loading times of large meshes (a tesselated height field) with the OBJ, OFF and PLY loaders.
+// The files are generated in the working directory and removed afterwards.
+//   - OBJ:        v/vt/vn per vertex and 'f a/a/a' faces
+//   - OFF:        positions and triangle faces
+//   - PLY ascii:  positions, normals and uchar colors
+//   - PLY binary: PLYLoader::save of a VertexNC mesh
+//
+// The second table shows the binary cache of UnifiedModel for the largest mesh.
+//   - Cold:   Parsing the source file + writing the cache (first start)
+//   - Warm:   UnifiedModel constructor with an existing cache
+//   - Mapped: UnifiedModelMapped::open (no copy, including the checksum test)
+
+static TriangleMesh<VertexNC, uint32_t> HeightField(int n)
+{
+    TriangleMesh<VertexNC, uint32_t> mesh;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            float x = float(j) / n, y = float(i) / n;
+            VertexNC v;
+            v.position = vec4(x, y, 0.1f * sin(20 * x) * cos(15 * y), 1);
+            v.normal   = vec4(0, 0, 1, 0);
+            v.color    = vec4(x, y, 1, 1);
+            mesh.vertices.push_back(v);
+        }
+    }
+    for (int i = 0; i + 1 < n; ++i)
+    {
+        for (int j = 0; j + 1 < n; ++j)
+        {
+            uint32_t a = i * n + j;
+            mesh.faces.push_back({a, a + 1, a + n + 1});
+            mesh.faces.push_back({a, a + n + 1, a + n});
+        }
+    }
+    return mesh;
+}
+
+static void WriteObj(const std::string& file, const TriangleMesh<VertexNC, uint32_t>& mesh)
+{
+    std::ofstream strm(file);
+    for (auto& v : mesh.vertices) strm << "v " << v.position(0) << " " << v.position(1) << " " << v.position(2) << "\n";
+    for (auto& v : mesh.vertices) strm << "vt " << v.position(0) << " " << v.position(1) << "\n";
+    for (auto& v : mesh.vertices) strm << "vn " << v.normal(0) << " " << v.normal(1) << " " << v.normal(2) << "\n";
+    for (auto& f : mesh.faces)
+    {
+        strm << "f";
+        for (int k = 0; k < 3; ++k)
+        {
+            auto i = f(k) + 1;
+            strm << " " << i << "/" << i << "/" << i;
+        }
+        strm << "\n";
+    }
+}
+
+static void WriteOff(const std::string& file, const TriangleMesh<VertexNC, uint32_t>& mesh)
+{
+    std::ofstream strm(file);
+    strm << "OFF\n" << mesh.vertices.size() << " " << mesh.faces.size() << " 0\n";
+    for (auto& v : mesh.vertices) strm << v.position(0) << " " << v.position(1) << " " << v.position(2) << "\n";
+    for (auto& f : mesh.faces) strm << "3 " << f(0) << " " << f(1) << " " << f(2) << "\n";
+}
+
+static void WritePlyAscii(const std::string& file, const TriangleMesh<VertexNC, uint32_t>& mesh)
+{
+    std::ofstream strm(file);
+    strm << "ply\nformat ascii 1.0\nelement vertex " << mesh.vertices.size() << "\n";
+    for (auto p : {"x", "y", "z", "nx", "ny", "nz"}) strm << "property float " << p << "\n";
+    for (auto p : {"red", "green", "blue"}) strm << "property uchar " << p << "\n";
+    strm << "element face " << mesh.faces.size() << "\nproperty list uchar int vertex_indices\nend_header\n";
+    for (auto& v : mesh.vertices)
+    {
+        strm << v.position(0) << " " << v.position(1) << " " << v.position(2) << " " << v.normal(0) << " "
+             << v.normal(1) << " " << v.normal(2) << " " << int(v.color(0) * 255) << " " << int(v.color(1) * 255)
+             << " " << int(v.color(2) * 255) << "\n";
+    }
+    for (auto& f : mesh.faces) strm << "3 " << f(0) << " " << f(1) << " " << f(2) << "\n";
+}
+
+int main(int, char**)
+{
+    catchSegFaults();
+
+    int samples = 3;
+
+    Table table({10, 12, 12, 12, 14, 14});
+    table << "Vertices"
+          << "Triangles"
+          << "OBJ (ms)"
+          << "OFF (ms)"
+          << "PLY asc (ms)"
+          << "PLY bin (ms)";
+
+    std::vector<std::string> files = {"benchmark.obj", "benchmark.off", "benchmark_ascii.ply", "benchmark_binary.ply"};
+    for (int n : {250, 500, 1000})
+    {
+        auto mesh = HeightField(n);
+        WriteObj("benchmark.obj", mesh);
+        WriteOff("benchmark.off", mesh);
+        WritePlyAscii("benchmark_ascii.ply", mesh);
+        PLYLoader::save("benchmark_binary.ply", mesh);
+
+        auto tObj      = measureObject(samples, [&]() { ObjModelLoader loader("benchmark.obj"); }).median;
+        auto tOff      = measureObject(samples, [&]() { OffModelLoader loader("benchmark.off"); }).median;
+        auto tPlyAscii = measureObject(samples, [&]() { PLYLoader loader("benchmark_ascii.ply"); }).median;
+        auto tPlyBin   = measureObject(samples, [&]() { PLYLoader loader("benchmark_binary.ply"); }).median;
+        table << mesh.vertices.size() << mesh.faces.size() << tObj << tOff << tPlyAscii << tPlyBin;
+    }
+    std::cout << std::endl;
+
+    Table table2({22, 12, 12, 12, 12});
+    table2 << "File"
+           << "Size (MB)"
+           << "Cold (ms)"
+           << "Warm (ms)"
+           << "Mapped (ms)";
+    for (auto& file : files)
+    {
+        auto cache = file + ".saiga_model";
+        auto tCold = measureObject(samples, [&]() {
+                         std::filesystem::remove(cache);
+                         UnifiedModel model(file);
+                     }).median;
+        auto tWarm   = measureObject(samples, [&]() { UnifiedModel model(file); }).median;
+        auto tMapped = measureObject(samples, [&]() {
+                           UnifiedModelMapped mapped;
+                           SAIGA_ASSERT(mapped.open(cache));
+                       }).median;
+        table2 << file << std::filesystem::file_size(file) / (1000.0 * 1000.0) << tCold << tWarm << tMapped;
+        std::filesystem::remove(cache);
+    }
+
+    for (auto& file : files)
+    {
+        std::filesystem::remove(file);
+    }
+    std::cout << "Threads: " << OMP::getMaxThreads() << std::endl;
+    return 0;
+}
@@ -5,12 +5,40 @@
  */
 
 #include "saiga/core/Core.h"
+#include "saiga/core/geometry/BVH4.h"
+#include "saiga/core/model/model_from_shape.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/table.h"
 
 using namespace Saiga;
 
+// Compares the acceleration structures on the teapot and on a large scan.
+//   - Build:   Construction time
+//   - Trace:   One primary ray per pixel of a 500x500 image
+//   - Closest: 100k closest point queries close to the surface
+// The second table shows the packet traversal of the BVH4 for primary rays and shadow rays.
+// The scan is loaded from the first argument. Without argument, a noisy sphere with 1M triangles is used instead.
+
+static std::vector<Triangle> NoisySphere(int rings, int sectors, float radius, float noise)
+{
+    auto model = UVSphereMesh(Sphere(vec3(0, 0, 0), 1), rings, sectors);
+    for (auto& p : model.position) p = p.normalized() * radius + Random::MatrixUniform<vec3>(-noise, noise);
+    std::vector<Triangle> result;
+    for (auto& f : model.triangles)
+    {
+        Triangle t;
+        t.a = model.position[f(0)];
+        t.b = model.position[f(1)];
+        t.c = model.position[f(2)];
+        result.push_back(t);
+    }
+    return result;
+}
+
 int main(int argc, char* args[])
 {
     initSaigaSampleNoWindow();
+    Random::setSeed(3462);
 
     int w = 500;
     int h = 500;
@@ -19,44 +47,146 @@ int main(int argc, char* args[])
     camera.setProj(60.0f, 1, 0.1f, 50.0f, true);
     camera.setView(vec3(0, 3, 6), vec3(0, 0, 0), vec3(0, 1, 0));
 
-    //    ObjModelLoader loader("teapot.obj");
-
+    std::vector<std::pair<std::string, std::vector<Triangle>>> scenes;
+    scenes.push_back({"teapot", UnifiedModel("teapot.obj").Mesh<VertexNC, uint32_t>().toTriangleList()});
+    if (argc > 1)
+    {
+        scenes.push_back({args[1], UnifiedModel(args[1]).Mesh<VertexNC, uint32_t>().toTriangleList()});
+    }
+    else
+    {
+        scenes.push_back({"scan", NoisySphere(700, 700, 2, 0.005)});
+    }
 
+    // Primary rays ordered in 4x4 pixel tiles, so that consecutive rays are coherent
+    std::vector<Ray> rays;
+    std::vector<ivec2> pixels;
+    for (int ti = 0; ti < h; ti += 4)
+    {
+        for (int tj = 0; tj < w; tj += 4)
+        {
+            for (int i = ti; i < std::min(ti + 4, h); ++i)
+            {
+                for (int j = tj; j < std::min(tj + 4, w); ++j)
+                {
+                    rays.push_back(camera.PixelRay(vec2(j, i), w, h, false));
+                    pixels.push_back(ivec2(j, i));
+                }
+            }
+        }
+    }
 
-    auto mesh = UnifiedModel("teapot.obj").Mesh<VertexNC, uint32_t>();
-    //    loader.toTriangleMesh(mesh);
+    Table table({10, 16, 10, 12, 12, 12, 14});
+    table << "Scene"
+          << "Method"
+          << "Triangles"
+          << "Build (ms)"
+          << "Trace (ms)"
+          << "MRays/s"
+          << "Closest (ms)";
 
+    for (auto& [name, triangles] : scenes)
+    {
+        AABB box;
+        box.makeNegative();
+        for (auto& t : triangles)
+        {
+            box.growBox(t.a);
+            box.growBox(t.b);
+            box.growBox(t.c);
+        }
 
-    auto triangles = mesh.toTriangleList();
+        // Points close to the surface, for example the voxels in the truncation band of a TSDF
+        float band = (box.max - box.min).norm() * 0.02f;
+        std::vector<vec3> query_points(100000);
+        for (auto& p : query_points)
+        {
+            p = triangles[Random::uniformInt(0, triangles.size() - 1)].center() + Random::ballRand(band).cast<float>();
+        }
 
+        TemplatedImage<ucvec3> img(w, h);
 
-    AccelerationStructure::ObjectMedianBVH bf(triangles);
+        auto bench = [&](const std::string& method, auto build) {
+            float build_time;
+            decltype(build()) bvh;
+            {
+                ScopedTimer<float> timer(build_time);
+                bvh = build();
+            }
 
-    std::cout << "Num triangles = " << triangles.size() << std::endl;
+            float trace_time;
+            {
+                ScopedTimer<float> timer(trace_time);
+#pragma omp parallel for
+                for (int k = 0; k < (int)rays.size(); ++k)
+                {
+                    auto inter = bvh->getClosest(rays[k]);
+                    auto& c    = img(pixels[k].y(), pixels[k].x());
+                    c          = (inter && !inter.backFace) ? ucvec3(0, 255, 0) : ucvec3(255, 0, 0);
+                }
+            }
 
+            float closest_time;
+            double sum = 0;
+            {
+                ScopedTimer<float> timer(closest_time);
+#pragma omp parallel for reduction(+ : sum)
+                for (int i = 0; i < (int)query_points.size(); ++i)
+                {
+                    sum += bvh->ClosestPoint(query_points[i]).first;
+                }
+            }
+            table << name << method << triangles.size() << build_time << trace_time
+                  << (w * h) / (trace_time * 1000.0f) << closest_time;
+        };
 
-    TemplatedImage<ucvec3> img(w, h);
+        bench("ObjectMedian",
+              [&]() { return std::make_unique<AccelerationStructure::ObjectMedianBVH>(triangles); });
+        bench("SAH", [&]() { return std::make_unique<AccelerationStructure::SAHBVH>(triangles); });
+        bench("BVH4", [&]() { return std::make_unique<AccelerationStructure::BVH4>(triangles); });
 
+        if (name == "teapot") img.save("raytracing.png");
+    }
+    std::cout << std::endl;
+
+    // Batched BVH4 queries with different packet sizes.
+    //   - Closest:  getClosestBatch with the primary rays
+    //   - Occluded: isOccludedBatch with shadow rays from the hit points to a point light
+    Table table2({10, 8, 14, 12, 15, 12});
+    table2 << "Scene"
+           << "Packet"
+           << "Closest (ms)"
+           << "MRays/s"
+           << "Occluded (ms)"
+           << "MRays/s";
+    for (auto& [name, triangles] : scenes)
     {
-        SAIGA_BLOCK_TIMER();
-#pragma omp parallel for
-        for (int i = 0; i < h; ++i)
+        AccelerationStructure::BVH4 bvh(triangles);
+        std::vector<Intersection::RayTriangleIntersection> result(rays.size());
+
+        vec3 light = camera.getPosition() + vec3(2, 4, 0);
+        bvh.getClosestBatch(rays, result);
+        std::vector<Ray> shadow_rays;
+        std::vector<float> light_distance;
+        for (size_t k = 0; k < rays.size(); ++k)
         {
-            for (int j = 0; j < w; ++j)
-            {
-                img(i, j) = ucvec3(255, 0, 0);
-
-                //                vec3 dir = camera.inverseprojectToWorldSpace(vec2(j, i), 1, w, h);
-                //                Ray ray(normalize(dir), camera.getPosition());
-                Ray ray = camera.PixelRay(vec2(j, i), w, h, false);
+            if (!result[k]) continue;
+            vec3 p   = rays[k].positionOnRay(result[k].t);
+            vec3 dir = light - p;
+            light_distance.push_back(dir.norm());
+            shadow_rays.push_back(Ray(dir.normalized(), p + dir.normalized() * 1e-3f));
+        }
+        std::vector<uint8_t> occluded(shadow_rays.size());
+        float max_distance = shadow_rays.empty() ? 0 : *std::max_element(light_distance.begin(), light_distance.end());
 
-                auto inter = bf.getClosest(ray);
-                if (inter && !inter.backFace)
-                {
-                    img(i, j) = ucvec3(0, 255, 0);
-                }
-            }
+        for (int packet_size : {1, 4, 8, 16})
+        {
+            bvh.packet_size = packet_size;
+            auto t_closest  = measureObject(5, [&]() { bvh.getClosestBatch(rays, result); }).median;
+            auto t_occluded =
+                measureObject(5, [&]() { bvh.isOccludedBatch(shadow_rays, max_distance, occluded); }).median;
+            table2 << name << packet_size << t_closest << rays.size() / (t_closest * 1000.0f) << t_occluded
+                   << shadow_rays.size() / (t_occluded * 1000.0f);
         }
     }
-    img.save("raytracing.png");
 }
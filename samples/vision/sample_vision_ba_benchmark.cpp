@@ -164,6 +164,95 @@ void test_to_file(const OptimizationOptions& baoptions, const std::string& file,
     }
 }
 
+// Compares the double precision solver (BARec) with the mixed precision solver (BARecMixed).
+// Throughput is the number of processed observations per second (observations * LM iterations / total time).
+void test_mixed_precision(const std::vector<std::string>& files, int its)
+{
+    std::cout << "Running mixed precision test..." << std::endl;
+
+    struct Setting
+    {
+        std::string name;
+        OptimizationOptions::SolverType type;
+        int refinementSteps;
+    };
+    std::vector<Setting> settings = {{"CG", OptimizationOptions::SolverType::Iterative, 0},
+                                     {"CG + Refinement", OptimizationOptions::SolverType::Iterative, 1},
+                                     {"LDLT", OptimizationOptions::SolverType::Direct, 0},
+                                     {"LDLT + Refinement", OptimizationOptions::SolverType::Direct, 1}};
+
+    auto run = [&](const std::string& name, const Scene& scene) {
+        std::cout << "> " << name << std::endl;
+        Saiga::Table table({20, 22, 15, 15, 15, 15, 15});
+        table << "Solver"
+              << "Name"
+              << "Final Error"
+              << "Delta (%)"
+              << "Time_LS"
+              << "Time_Total"
+              << "Obs/s";
+
+        int observations = 0;
+        for (auto& img : scene.images)
+            for (auto& ip : img.stereoPoints) observations += ip.wp >= 0;
+
+        for (auto& setting : settings)
+        {
+            OptimizationOptions baoptions;
+            baoptions.maxIterations          = 5;
+            baoptions.maxIterativeIterations = 50;
+            baoptions.iterativeTolerance     = 1e-10;
+            baoptions.minChi2Delta           = 0;
+            baoptions.solverType             = setting.type;
+            baoptions.refinementSteps        = setting.refinementSteps;
+
+            std::vector<std::shared_ptr<BABase>> solvers;
+            solvers.push_back(std::make_shared<BARec>());
+            solvers.push_back(std::make_shared<BARecMixed>());
+
+            double reference = 0;
+            for (auto& s : solvers)
+            {
+                std::vector<double> times, timesl;
+                double chi2 = 0;
+                for (int i = 0; i < its; ++i)
+                {
+                    Scene cpy = scene;
+                    s->create(cpy);
+                    auto opt                 = dynamic_cast<Optimizer*>(s.get());
+                    opt->optimizationOptions = baoptions;
+                    auto result              = opt->initAndSolve();
+                    chi2                     = result.cost_final;
+                    times.push_back(result.total_time);
+                    timesl.push_back(result.linear_solver_time);
+                }
+                auto t  = Statistics(times).median;
+                auto tl = Statistics(timesl).median;
+                if (reference == 0) reference = chi2;
+                double throughput = double(observations) * baoptions.maxIterations / (t / 1000.0);
+                table << setting.name << s->name << chi2 << (chi2 - reference) / reference * 100.0 << tl << t
+                      << throughput;
+            }
+        }
+        std::cout << std::endl;
+    };
+
+    {
+        Scene scene = SynteticScene::CircleSphere(20000, 200, 250, true);
+        scene.addWorldPointNoise(0.01);
+        scene.addExtrinsicNoise(0.01);
+        run("Synthetic", scene);
+    }
+
+    for (auto file : files)
+    {
+        if (hasEnding(file, ".scene") || SearchPathes::data(balPrefix + file).empty()) continue;
+        Scene scene;
+        buildSceneBAL(scene, SearchPathes::data(balPrefix + file));
+        run(file, scene);
+    }
+}
+
 
 int main(int, char**)
 {
@@ -172,6 +261,10 @@ int main(int, char**)
     Saiga::EigenHelper::checkEigenCompabitilty<2765>();
     Saiga::Random::setSeed(93865023985);
 
+#if 1
+    test_mixed_precision(getBALFiles(), 3);
+#endif
+
 
 #if 0
 
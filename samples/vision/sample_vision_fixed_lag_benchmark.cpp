@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/recursive/BAFixedLag.h"
+#include "saiga/vision/recursive/BARecursive.h"
+#include "saiga/vision/scene/SynteticScene.h"
+
+using namespace Saiga;
+
+// Simulates the local BA of an online SLAM system on a long synthetic trajectory.
+// A new keyframe is added in every step and the last #windowSize keyframes are optimized.
+//   - BARec: The map is rebuilt from the scene in every step and the older keyframes are set constant.
+//   - BAFixedLag: The keyframes are added incrementally and the old keyframes are marginalized.
+// The time per keyframe of BARec grows with the size of the map, the time of BAFixedLag is constant.
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    Saiga::Random::setSeed(93865023985);
+
+    int numCameras = 1000;
+    int windowSize = 10;
+    int reportStep = 100;
+
+    Scene reference = SynteticScene::Trajectory(numCameras * 50, numCameras, 0.5);
+    for (auto& img : reference.images)
+    {
+        for (auto& ip : img.stereoPoints)
+        {
+            ip.depth = (img.se3 * reference.worldPoints[ip.wp].p).z();
+        }
+    }
+    reference.addImagePointNoise(0.5);
+
+    Scene noisy = reference;
+    noisy.addExtrinsicNoise(0.01);
+    noisy.addWorldPointNoise(0.01);
+    noisy.images[0].se3 = reference.images[0].se3;
+
+    OptimizationOptions options;
+    options.maxIterations = 5;
+    options.solverType    = OptimizationOptions::SolverType::Direct;
+
+    Table table({12, 15, 15, 15, 15});
+    table << "Keyframes"
+          << "BARec (ms)"
+          << "FixedLag (ms)"
+          << "BARec Points"
+          << "FixedLag Points";
+
+    // Full rebuild
+    Scene map = noisy;
+    map.images.clear();
+    BARec ba;
+    ba.optimizationOptions = options;
+
+    // Incremental
+    Scene scene = noisy;
+    BAFixedLag fl;
+    fl.windowSize          = windowSize;
+    fl.optimizationOptions = options;
+    fl.create(scene);
+
+    std::vector<double> timesRec, timesFl;
+    for (int i = 0; i < numCameras; ++i)
+    {
+        {
+            float time;
+            {
+                ScopedTimer<float> timer(time);
+                map.images.push_back(noisy.images[i]);
+                map.fixWorldPointReferences();
+                for (int j = 0; j < (int)map.images.size(); ++j)
+                {
+                    map.images[j].constant = j == 0 || j + windowSize <= i;
+                }
+                ba.create(map);
+                ba.initAndSolve();
+            }
+            timesRec.push_back(time);
+        }
+
+        {
+            float time;
+            {
+                ScopedTimer<float> timer(time);
+                fl.addKeyframe(i);
+                fl.initAndSolve();
+            }
+            timesFl.push_back(time);
+        }
+
+        if ((i + 1) % reportStep == 0)
+        {
+            auto tr = Statistics(timesRec).median;
+            auto tf = Statistics(timesFl).median;
+            table << (i + 1) << tr << tf << map.validPoints().size() << fl.numPoints();
+            timesRec.clear();
+            timesFl.clear();
+        }
+    }
+
+    // Mean position error of the keyframes
+    auto error = [&](const Scene& s) {
+        double e = 0;
+        for (int i = 0; i < numCameras; ++i)
+        {
+            e += (s.images[i].se3.inverse().translation() - reference.images[i].se3.inverse().translation()).norm();
+        }
+        return e / numCameras;
+    };
+
+    std::cout << std::endl;
+    std::cout << "Mean position error BARec:    " << error(map) << std::endl;
+    std::cout << "Mean position error FixedLag: " << error(scene) << std::endl;
+    return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/image/all.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/icp/ICPDepthMap.h"
+#include "saiga/vision/icp/MultiViewICP.h"
+#include "saiga/vision/util/Random.h"
+
+using namespace Saiga;
+
+// Frame-to-frame alignment of 640x480 depth maps with the projective point-to-plane ICP.
+//   - Corrs:   projectiveCorrespondences + pointToPlane on the full resolution
+//   - Fused:   projectivePointToPlane on the full resolution
+//   - Pyramid: projectivePointToPlane with 3 pyramid levels and fewer iterations per level
+// The time includes the computation of the point clouds and normal maps.
+//
+// The second table shows the global multi-view ICP (multiViewICPGlobal) on a 360 degree scan of a room with
+// 160x120 depth maps. Every view is connected to a constant number of neighbours.
+
+// Depth image of a camera inside a box shaped room
+static TemplatedImage<float> renderRoom(const Intrinsics4& K, const SE3& T_w_c, int h, int w,
+                                        Vec3 boxMin = Vec3(-1, -0.8, -1), Vec3 boxMax = Vec3(1, 0.8, 4))
+{
+    TemplatedImage<float> img(h, w);
+    for (int i = 0; i < h; ++i)
+    {
+        for (int j = 0; j < w; ++j)
+        {
+            Vec3 o   = T_w_c.translation();
+            Vec3 d   = T_w_c.so3() * K.unproject(Vec2(j, i), 1);
+            double t = std::numeric_limits<double>::infinity();
+            for (int k = 0; k < 3; ++k)
+            {
+                if (d(k) > 0) t = std::min(t, (boxMax(k) - o(k)) / d(k));
+                if (d(k) < 0) t = std::min(t, (boxMin(k) - o(k)) / d(k));
+            }
+            img(i, j) = t;
+        }
+    }
+    return img;
+}
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+
+    int w = 640, h = 480;
+    int iterations = 5;
+    int samples    = 20;
+    Intrinsics4 K(525, 525, 319.5, 239.5);
+
+    SE3 refPose;
+    SE3 srcPose(Sophus::SO3d::exp(Vec3(0.02, -0.03, 0.01)), Vec3(0.05, -0.02, 0.04));
+    auto refImg = renderRoom(K, refPose, h, w);
+    auto srcImg = renderRoom(K, srcPose, h, w);
+
+    ICP::ProjectiveCorrespondencesParams params;
+
+    auto corrBased = [&]() {
+        ICP::DepthMapExtended ref(refImg.getImageView(), K, refPose);
+        ICP::DepthMapExtended src(srcImg.getImageView(), K, SE3());
+        for (int k = 0; k < iterations; ++k)
+        {
+            auto corrs = ICP::projectiveCorrespondences(ref, src, params);
+            src.pose   = ICP::pointToPlane(corrs, ref.pose, src.pose);
+        }
+        return src.pose;
+    };
+    auto fused = [&](int its, int levels) {
+        return ICP::alignDepthMaps(refImg.getImageView(), srcImg.getImageView(), refPose, SE3(), K, its, params,
+                                   levels);
+    };
+
+    Table table({12, 15, 10, 15});
+    table << "Method"
+          << "Time (ms)"
+          << "FPS"
+          << "Error";
+
+    auto bench = [&](const std::string& name, auto f) {
+        SE3 result;
+        auto t       = measureObject(samples, [&]() { result = f(); }).median;
+        double error = (result.inverse() * srcPose).log().norm();
+        table << name << t << 1000.0 / t << error;
+    };
+
+    bench("Corrs", corrBased);
+    bench("Fused", [&]() { return fused(iterations, 1); });
+    bench("Pyramid", [&]() { return fused(2, 3); });
+    std::cout << std::endl;
+
+    Random::setSeed(3497);
+    Intrinsics4 Ksmall(60, 60, 79.5, 59.5);
+    int neighbours = 8;
+
+    Table table2({8, 8, 15, 18, 18});
+    table2 << "Views"
+           << "Pairs"
+           << "Time (ms)"
+           << "Error before"
+           << "Error after";
+    for (int N : {50, 100, 200, 400})
+    {
+        AlignedVector<SE3> poses, guesses;
+        std::vector<TemplatedImage<float>> images;
+        for (int i = 0; i < N; ++i)
+        {
+            double alpha = 2 * pi<double>() * i / N;
+            SE3 pose(Sophus::SO3d::exp(Vec3(0, alpha, 0)), Vec3(0.2 * sin(alpha), 0, 0.2 * cos(alpha)));
+            poses.push_back(pose);
+            images.push_back(renderRoom(Ksmall, pose, 120, 160, Vec3(-1.5, -1, -1.5), Vec3(1.5, 1, 1.5)));
+            guesses.push_back(i == 0 ? pose : Random::JitterPose(pose, 0.01, 0.005));
+        }
+        std::vector<Depthmap::DepthMap> depthMaps;
+        for (auto& img : images) depthMaps.push_back(img.getImageView());
+
+        auto error = [&]() {
+            double e = 0;
+            for (int i = 0; i < N; ++i) e += (guesses[i].inverse() * poses[i]).log().norm();
+            return e / N;
+        };
+
+        ICP::MultiViewICPParams params;
+        params.iterations   = 3;
+        params.maxViewAngle = (neighbours + 0.5) * 2 * pi<double>() / N;
+
+        double before = error();
+        int pairs;
+        float time;
+        {
+            ScopedTimer<float> timer(time);
+            pairs = ICP::multiViewICPGlobal(depthMaps, guesses, Ksmall, params);
+        }
+        table2 << N << pairs << time << before << error();
+    }
+    return 0;
+}
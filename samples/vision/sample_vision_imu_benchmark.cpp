@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/imu/all.h"
+#include "saiga/vision/util/Random.h"
+
+using namespace Saiga;
+using namespace Saiga::Imu;
+
+// Decoupled IMU optimization (bias, velocity, gravity, scale) on random scenes.
+//   - Preint:      Time of DecoupledImuScene::PreintAll (parallel over the edges)
+//   - Recompute:   Every bias change triggers a new integration of the outgoing edges
+//   - First order: Small bias changes are applied with the bias jacobians of the preintegration
+// The 'Preints' columns show how many edges were integrated during the solve.
+//
+// The second table compares the generic sparse LDLT with the block tridiagonal solver on long trajectories.
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    Random::setSeed(39486);
+
+    int K = 50;
+
+    DecoupledImuScene::SolverOptions options;
+    options.solver_flags    = IMU_SOLVE_BA | IMU_SOLVE_BG | IMU_SOLVE_VELOCITY | IMU_SOLVE_GRAVITY | IMU_SOLVE_SCALE;
+    options.max_its         = 5;
+    options.final_recompute = false;
+
+    DecoupledImuSolver solver;
+    solver.optimizationOptions.maxIterations = options.max_its;
+    solver.optimizationOptions.debugOutput   = false;
+    solver.optimizationOptions.solverType    = OptimizationOptions::SolverType::Direct;
+
+    Table table({8, 13, 16, 10, 16, 10, 14});
+    table << "N"
+          << "Preint (ms)"
+          << "Recompute (ms)"
+          << "Preints"
+          << "1st order (ms)"
+          << "Preints"
+          << "Chi2 diff";
+
+    for (int N : {100, 500, 2000})
+    {
+        DecoupledImuScene scene;
+        scene.MakeRandom(N, K, 1.0 / 100.0);
+        for (auto& s : scene.states)
+        {
+            s.velocity_and_bias.acc_bias += Vec3::Random() * 0.1;
+            s.velocity_and_bias.gyro_bias += Vec3::Random() * 0.1;
+            s.velocity_and_bias.velocity += Vec3::Random() * 0.1;
+        }
+        scene.scale += Random::sampleDouble(-0.2, 0.2);
+        scene.gravity.R = scene.gravity.R * SO3::exp(Vec3::Random() * 0.1);
+
+        auto tPreint = measureObject(10, [&]() { scene.PreintAll(); }).median;
+
+        auto solve = [&](double threshold, double& chi2) {
+            // The copies share the preintegrations with 'scene'
+            auto cpy = scene;
+            cpy.PreintAll();
+            options.bias_recompute_delta_squared = threshold;
+            solver.Create(cpy, options);
+            float time;
+            {
+                ScopedTimer<float> timer(time);
+                solver.initAndSolve();
+            }
+            chi2 = cpy.chi2();
+            return time;
+        };
+
+        double chi2Recompute, chi2FirstOrder;
+        auto tRecompute  = solve(0, chi2Recompute);
+        int recompute    = solver.RecomputedPreints();
+        auto tFirstOrder = solve(0.01, chi2FirstOrder);
+        int firstOrder   = solver.RecomputedPreints();
+        table << N << tPreint << tRecompute << recompute << tFirstOrder << firstOrder
+              << std::abs(chi2Recompute - chi2FirstOrder);
+    }
+    std::cout << std::endl;
+
+    options.bias_recompute_delta_squared = 0.01;
+
+    Table table2({8, 16, 20, 14});
+    table2 << "N"
+           << "Sparse (ms)"
+           << "Tridiagonal (ms)"
+           << "Chi2 diff";
+    for (int N : {1000, 5000, 20000})
+    {
+        DecoupledImuScene scene;
+        scene.MakeRandom(N, 10, 1.0 / 100.0);
+        for (auto& s : scene.states)
+        {
+            s.velocity_and_bias.acc_bias += Vec3::Random() * 0.1;
+            s.velocity_and_bias.velocity += Vec3::Random() * 0.1;
+        }
+
+        auto solve = [&](bool tridiagonal, double& chi2) {
+            auto cpy = scene;
+            cpy.PreintAll();
+            options.block_tridiagonal = tridiagonal;
+            solver.Create(cpy, options);
+            float time;
+            {
+                ScopedTimer<float> timer(time);
+                solver.initAndSolve();
+            }
+            chi2 = cpy.chi2();
+            return time;
+        };
+
+        double chi2Sparse, chi2Tridiagonal;
+        auto tSparse      = solve(false, chi2Sparse);
+        auto tTridiagonal = solve(true, chi2Tridiagonal);
+        table2 << N << tSparse << tTridiagonal << std::abs(chi2Sparse - chi2Tridiagonal);
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/fileChecker.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/recursive/BARecursive.h"
+#include "saiga/vision/recursive/PGORecursive.h"
+#include "saiga/vision/scene/BALDataset.h"
+#include "saiga/vision/scene/PoseGraph.h"
+#include "saiga/vision/scene/SynteticPoseGraph.h"
+#include "saiga/vision/scene/SynteticScene.h"
+
+using namespace Saiga;
+
+// Compares the sparse direct solvers on the reduced camera system of BA problems and on PGO problems:
+//   - RecursiveSimplicialLDLT
+//   - SupernodalLDLT
+//   - Cholmod (only if saiga was compiled with cholmod)
+//
+// The BAL files are skipped if they are not found in the data directory.
+
+const std::string balPrefix = "vision/bal/";
+
+struct DirectSolver
+{
+    std::string name;
+    bool cholmod;
+    bool supernodal;
+};
+
+std::vector<DirectSolver> directSolvers()
+{
+    std::vector<DirectSolver> solvers;
+    solvers.push_back({"Simplicial", false, false});
+    solvers.push_back({"Supernodal", false, true});
+#ifdef SOLVER_USE_CHOLMOD
+    solvers.push_back({"Cholmod", true, false});
+#endif
+    return solvers;
+}
+
+OptimizationOptions benchmarkOptions(const DirectSolver& s)
+{
+    OptimizationOptions options;
+    options.maxIterations = 3;
+    options.solverType    = OptimizationOptions::SolverType::Direct;
+    options.minChi2Delta  = 0;
+    options.initialLambda = 1000;
+    options.cholmod       = s.cholmod;
+    options.supernodal    = s.supernodal;
+    return options;
+}
+
+template <typename Problem, typename Solver>
+void benchmark(const std::string& name, const Problem& problem, int its)
+{
+    Table table({25, 15, 15, 15, 15});
+    std::cout << "> " << name << std::endl;
+    table << "Solver"
+          << "Final Error"
+          << "Time_LS"
+          << "Time_Total"
+          << "Speedup";
+
+    double reference = 0;
+    for (auto& s : directSolvers())
+    {
+        std::vector<double> times, timesl;
+        double chi2 = 0;
+        for (int i = 0; i < its; ++i)
+        {
+            Problem cpy = problem;
+            Solver solver;
+            solver.create(cpy);
+            solver.optimizationOptions = benchmarkOptions(s);
+            auto result                = solver.initAndSolve();
+            chi2                       = result.cost_final;
+            times.push_back(result.total_time);
+            timesl.push_back(result.linear_solver_time);
+        }
+        auto t  = Statistics(times).median;
+        auto tl = Statistics(timesl).median;
+        if (reference == 0) reference = tl;
+        table << s.name << chi2 << tl << t << reference / tl;
+    }
+    std::cout << std::endl;
+}
+
+Scene loadBAL(const std::string& file)
+{
+    Scene scene;
+    Saiga::BALDataset bald(SearchPathes::data(balPrefix + file));
+    scene = bald.makeScene();
+
+    Saiga::Random::setSeed(926703466);
+    scene.applyErrorToImagePoints();
+    scene.addImagePointNoise(0.001);
+    scene.addWorldPointNoise(0.001);
+    scene.globalScale = 1.0 / scene.statistics().median;
+    scene.removeOutliers(10);
+    scene.compress();
+    return scene;
+}
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    Saiga::Random::setSeed(93865023985);
+
+    int its = 5;
+
+    // ============ Bundle adjustment (reduced camera system) ============
+    {
+        Scene scene = SynteticScene::CircleSphere(20000, 200, 250, true);
+        scene.addWorldPointNoise(0.01);
+        benchmark<Scene, BARec>("Synthetic BA", scene, its);
+    }
+
+    for (std::string file : {"dubrovnik-00161-103832.txt", "final-00394-100368.txt", "ladybug-00539-65220.txt",
+                             "trafalgar-00257-65132.txt", "venice-00052-64053.txt"})
+    {
+        if (SearchPathes::data(balPrefix + file).empty())
+        {
+            std::cout << "> Skipping " << file << " (not found)" << std::endl;
+            continue;
+        }
+        auto scene = loadBAL(file);
+        benchmark<Scene, BARec>(file, scene, its);
+
+        // ============ PGO of the same scene ============
+        PoseGraph pg(scene, 50);
+        pg.addNoise(0.05);
+        benchmark<PoseGraph, PGORec>(file + " (PGO)", pg, its);
+    }
+
+    // ============ Pose graph optimization ============
+    for (int n : {1000, 5000, 20000})
+    {
+        // Scale the noise with the number of vertices, so that the drift stays in a reasonable range
+        double sigma = 2.5 / n;
+        PoseGraph pg = SyntheticPoseGraph::CircleWithDrift(5, n, 6, sigma, sigma / 2);
+        benchmark<PoseGraph, PGORec>("Synthetic PGO " + std::to_string(n), pg, its);
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/recursive/PGORecursive.h"
+#include "saiga/vision/scene/SynteticPoseGraph.h"
+
+using namespace Saiga;
+
+// Repeated pose graph optimization on a growing graph, like in the loop closing of a SLAM system.
+// In every step new vertices and edges are added and the graph is optimized a few times.
+//   - Rebuild: The structure of S and the fill reducing ordering are recomputed for every solve.
+//   - Reuse:   The structure is only recomputed if the graph has changed. The ordering of the previous
+//              factorization is extended by the new vertices.
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    Saiga::Random::setSeed(93865023985);
+
+    int numVertices    = 4000;
+    int stepSize       = 250;
+    int solvesPerStep  = 5;
+    PoseGraph complete = SyntheticPoseGraph::CircleWithDrift(5, numVertices, 6, 0.01, 0);
+    complete.addNoise(0.01);
+    complete.sortEdges();
+
+    OptimizationOptions options;
+    options.maxIterations = 3;
+    options.minChi2Delta  = 0;
+    options.solverType    = OptimizationOptions::SolverType::Direct;
+
+    for (bool supernodal : {false, true})
+    {
+        options.supernodal = supernodal;
+        std::cout << (supernodal ? "Supernodal LDLT" : "Simplicial LDLT") << std::endl;
+
+        Table table({10, 10, 18, 18, 18, 18});
+        table << "Vertices"
+              << "Edges"
+              << "Rebuild (ms)"
+              << "Reuse (ms)"
+              << "Rebuild chi2"
+              << "Reuse chi2";
+
+        PoseGraph pgRebuild, pgReuse;
+        PGORec rebuild, reuse;
+        rebuild.reuseStructure      = false;
+        rebuild.optimizationOptions = options;
+        reuse.optimizationOptions   = options;
+        rebuild.create(pgRebuild);
+        reuse.create(pgReuse);
+
+        for (int n = stepSize; n <= numVertices; n += stepSize)
+        {
+            // Add the new vertices and all edges between existing vertices
+            for (auto pg : {&pgRebuild, &pgReuse})
+            {
+                for (int i = pg->vertices.size(); i < n; ++i) pg->vertices.push_back(complete.vertices[i]);
+                pg->edges.clear();
+                for (auto& e : complete.edges)
+                {
+                    if (e.to < n) pg->edges.push_back(e);
+                }
+            }
+
+            auto timeSolves = [&](PGORec& pgo) {
+                float time;
+                {
+                    ScopedTimer<float> timer(time);
+                    for (int k = 0; k < solvesPerStep; ++k) pgo.initAndSolve();
+                }
+                return time / solvesPerStep;
+            };
+
+            auto tRebuild = timeSolves(rebuild);
+            auto tReuse   = timeSolves(reuse);
+            table << n << pgReuse.edges.size() << tRebuild << tReuse << pgRebuild.chi2() << pgReuse.chi2();
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/fileChecker.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/recursive/BARecursive.h"
+#include "saiga/vision/recursive/PGORecursive.h"
+#include "saiga/vision/scene/BALDataset.h"
+#include "saiga/vision/scene/PoseGraph.h"
+#include "saiga/vision/scene/SynteticPoseGraph.h"
+#include "saiga/vision/scene/SynteticScene.h"
+
+using namespace Saiga;
+
+// Compares the preconditioners of the iterative (PCG) solver on BA (reduced camera system) and PGO problems.
+// For each preconditioner the total number of CG iterations, the linear solver time and the final error is reported.
+//
+// The BAL files are skipped if they are not found in the data directory.
+
+const std::string balPrefix = "vision/bal/";
+
+using PT = OptimizationOptions::PreconditionerType;
+
+struct PreconditionerSetting
+{
+    std::string name;
+    PT type;
+    int fillLevel;
+    double omega;
+};
+
+std::vector<PreconditionerSetting> preconditioners()
+{
+    return {{"BlockJacobi", PT::BlockJacobi, 0, 1},
+            {"SGS", PT::SSOR, 0, 1},
+            {"SSOR(1.3)", PT::SSOR, 0, 1.3},
+            {"IC(0)", PT::IncompleteCholesky, 0, 1},
+            {"IC(1)", PT::IncompleteCholesky, 1, 1},
+            {"ClusterJacobi", PT::ClusterJacobi, 0, 1}};
+}
+
+OptimizationOptions benchmarkOptions(const PreconditionerSetting& p)
+{
+    OptimizationOptions options;
+    options.maxIterations          = 5;
+    options.solverType             = OptimizationOptions::SolverType::Iterative;
+    options.maxIterativeIterations = 500;
+    options.iterativeTolerance     = 1e-8;
+    options.minChi2Delta           = 0;
+    options.initialLambda          = 1e-4;
+    options.preconditioner         = p.type;
+    options.icFillLevel            = p.fillLevel;
+    options.ssorOmega              = p.omega;
+    options.clusterSize            = 8;
+    return options;
+}
+
+template <typename Problem, typename Solver>
+void benchmark(const std::string& name, const Problem& problem, int its)
+{
+    Table table({20, 15, 15, 15, 15, 15});
+    std::cout << "> " << name << std::endl;
+    table << "Preconditioner"
+          << "Final Error"
+          << "CG Iterations"
+          << "Time_LS"
+          << "Time_Total"
+          << "Speedup";
+
+    double reference = 0;
+    for (auto& p : preconditioners())
+    {
+        std::vector<double> times, timesl;
+        double chi2 = 0;
+        int iters   = 0;
+        for (int i = 0; i < its; ++i)
+        {
+            Problem cpy = problem;
+            Solver solver;
+            solver.create(cpy);
+            solver.optimizationOptions = benchmarkOptions(p);
+            auto result                = solver.initAndSolve();
+            chi2                       = result.cost_final;
+            iters                      = result.linear_solver_iterations;
+            times.push_back(result.total_time);
+            timesl.push_back(result.linear_solver_time);
+        }
+        auto t  = Statistics(times).median;
+        auto tl = Statistics(timesl).median;
+        if (reference == 0) reference = tl;
+        table << p.name << chi2 << iters << tl << t << reference / tl;
+    }
+    std::cout << std::endl;
+}
+
+Scene loadBAL(const std::string& file)
+{
+    Scene scene;
+    Saiga::BALDataset bald(SearchPathes::data(balPrefix + file));
+    scene = bald.makeScene();
+
+    Saiga::Random::setSeed(926703466);
+    scene.applyErrorToImagePoints();
+    scene.addImagePointNoise(0.001);
+    scene.addWorldPointNoise(0.001);
+    scene.globalScale = 1.0 / scene.statistics().median;
+    scene.removeOutliers(10);
+    scene.compress();
+    return scene;
+}
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    Saiga::Random::setSeed(93865023985);
+
+    int its = 3;
+
+    // ============ Bundle adjustment (reduced camera system) ============
+    {
+        Scene scene = SynteticScene::CircleSphere(20000, 200, 250, true);
+        scene.addWorldPointNoise(0.01);
+        scene.addExtrinsicNoise(0.01);
+        benchmark<Scene, BARec>("Synthetic BA", scene, its);
+    }
+
+    for (std::string file : {"dubrovnik-00161-103832.txt", "final-00394-100368.txt", "ladybug-00539-65220.txt",
+                             "trafalgar-00257-65132.txt", "venice-00052-64053.txt"})
+    {
+        if (SearchPathes::data(balPrefix + file).empty())
+        {
+            std::cout << "> Skipping " << file << " (not found)" << std::endl;
+            continue;
+        }
+        auto scene = loadBAL(file);
+        benchmark<Scene, BARec>(file, scene, its);
+    }
+
+    // ============ Pose graph optimization ============
+    for (int n : {1000, 5000})
+    {
+        double sigma = 2.5 / n;
+        PoseGraph pg = SyntheticPoseGraph::CircleWithDrift(5, n, 6, sigma, sigma / 2);
+        benchmark<PoseGraph, PGORec>("Synthetic PGO " + std::to_string(n), pg, its);
+    }
+
+    return 0;
+}
@@ -86,12 +86,12 @@ class RPOTest
     {
         std::fill(outlier.begin(), outlier.end(), false);
         SE3Type p = pose;
-        int inliers;
 
-#pragma omp parallel num_threads(4)
-        {
-            inliers = rpo.optimizePoseRobustOMP(wps, obs, outlier, p, K, wps.size());
-        }
+        // Split the observations of this small scene over all threads
+        int minObs                   = rpo.minObservationsPerThread;
+        rpo.minObservationsPerThread = 1;
+        int inliers                  = rpo.optimizePoseRobust(wps, obs, outlier, p, K);
+        rpo.minObservationsPerThread = minObs;
         return inliers;
     }
     int optimize()
@@ -139,17 +139,16 @@ int main(int, char**)
     //    return 0;
 
 
-    //    int its      = 2000;
+    int its      = 2000;
     auto inliers = test_double.optimize();
     std::cout << "inliers: " << inliers << std::endl;
-    //    sum += test_float.optimize();
-    //    auto a = measureObject("Float", its, [&]() { sum += test_float.optimize(); });
-    //    int sum = 0;
-    //    auto b  = measureObject("Double", its, [&]() { sum += test_double.optimize(); });
-    //    std::cout << "Sum: " << sum << std::endl;
-    //    sum = 0;
-    //    auto c = measureObject("Double", its, [&]() { sum += test_double.optimizeOMP(); });
-    //    std::cout << "Sum: " << sum << std::endl;
-    //    std::cout << a.median << " " << b.median << std::endl;
+
+    int sum = 0;
+    auto b  = measureObject(its, [&]() { sum += test_double.optimize(); });
+    std::cout << "Sum: " << sum << std::endl;
+    sum    = 0;
+    auto c = measureObject(its, [&]() { sum += test_double.optimizeOMP(); });
+    std::cout << "Sum: " << sum << std::endl;
+    std::cout << "Single thread: " << b.median << "ms, OMP: " << c.median << "ms" << std::endl;
     return 0;
 }
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "saiga/core/framework/framework.h"
+#include "saiga/core/time/all.h"
+#include "saiga/core/util/FileSystem.h"
+#include "saiga/core/util/table.h"
+#include "saiga/vision/scene/SynteticScene.h"
+#include "saiga/vision/util/Random.h"
+
+using namespace Saiga;
+
+// Save and load times of the scene file formats.
+//   - Text:   Scene::save / Scene::load
+//   - Binary: Scene::saveBinary / Scene::loadBinary
+//   - Zlib:   Scene::saveBinary with compression
+
+int main(int, char**)
+{
+    initSaigaSampleNoWindow();
+    Random::setSeed(3498);
+
+    std::string file = "scene_io_benchmark.scene";
+
+    Table table({10, 10, 10, 12, 12, 12});
+    table << "Format"
+          << "Images"
+          << "Obs"
+          << "Save (ms)"
+          << "Load (ms)"
+          << "Size (MB)";
+
+    for (int N : {100, 1000})
+    {
+        Scene scene = SynteticScene::CircleSphere(N * 50, N, 1000);
+        int obs     = N * 1000;
+
+        auto bench = [&](const std::string& name, auto save, auto load) {
+            float tSave, tLoad;
+            {
+                ScopedTimer<float> timer(tSave);
+                save(scene);
+            }
+            Scene scene2;
+            {
+                ScopedTimer<float> timer(tLoad);
+                load(scene2);
+            }
+            SAIGA_ASSERT(scene2.images.size() == scene.images.size());
+            double size = std::filesystem::file_size(file) / (1000.0 * 1000.0);
+            table << name << N << obs << tSave << tLoad << size;
+        };
+
+        bench(
+            "Text", [&](Scene& s) { s.save(file); }, [&](Scene& s) { s.load(file); });
+        bench(
+            "Binary", [&](Scene& s) { s.saveBinary(file); }, [&](Scene& s) { s.loadBinary(file); });
+        bench(
+            "Zlib", [&](Scene& s) { s.saveBinary(file, true); }, [&](Scene& s) { s.loadBinary(file); });
+    }
+    std::filesystem::remove(file);
+    return 0;
+}
@@ -5,12 +5,42 @@
  */
 #include "AccelerationStructure.h"
 
+#include "saiga/core/util/assert.h"
+
 #include "algorithm"
 
+#include <atomic>
+
 namespace Saiga
 {
 namespace AccelerationStructure
 {
+bool Base::isOccluded(const Ray& ray, float t_max)
+{
+    auto inter = getClosest(ray);
+    return inter.valid && inter.t < t_max;
+}
+
+void Base::getClosestBatch(ArrayView<const Ray> rays, ArrayView<RayTriangleIntersection> result)
+{
+    SAIGA_ASSERT(rays.size() == result.size());
+#pragma omp parallel for
+    for (int i = 0; i < (int)rays.size(); ++i)
+    {
+        result[i] = getClosest(rays[i]);
+    }
+}
+
+void Base::isOccludedBatch(ArrayView<const Ray> rays, float t_max, ArrayView<uint8_t> result)
+{
+    SAIGA_ASSERT(rays.size() == result.size());
+#pragma omp parallel for
+    for (int i = 0; i < (int)rays.size(); ++i)
+    {
+        result[i] = isOccluded(rays[i], t_max);
+    }
+}
+
 BruteForce::BruteForce(const std::vector<Saiga::Triangle>& triangles) : triangles(triangles) {}
 
 RayTriangleIntersection BruteForce::getClosest(const Ray& ray)
@@ -262,6 +292,196 @@ int ObjectMedianBVH::construct(int start, int end)
     return nodeid;
 }
 
+// ================================= SAH BVH =================================
+
+namespace
+{
+constexpr int sah_bins = 16;
+
+// Subtrees with more triangles are built in a separate task
+constexpr int sah_task_threshold = 4096;
+
+inline float HalfArea(const AABB& box)
+{
+    vec3 d = box.max - box.min;
+    return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+}
+}  // namespace
+
+struct SAHBVH::BuildData
+{
+    std::vector<AABB> boxes;
+    std::vector<vec3> centroids;
+    // The build only permutes these indices. The triangles are reordered at the end.
+    std::vector<int> ids;
+    std::atomic<int> num_nodes;
+};
+
+void SAHBVH::construct()
+{
+    nodes.clear();
+    int n = triangles.size();
+    if (n == 0) return;
+
+    BuildData data;
+    data.boxes.resize(n);
+    data.centroids.resize(n);
+    data.ids.resize(n);
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+    {
+        auto& t = triangles[i].first;
+        AABB box;
+        box.makeNegative();
+        box.growBox(t.a);
+        box.growBox(t.b);
+        box.growBox(t.c);
+        data.boxes[i]     = box;
+        data.centroids[i] = box.getPosition();
+        data.ids[i]       = i;
+    }
+
+    // A binary tree with at least one triangle per leaf has at most 2n-1 nodes.
+    // The nodes are allocated with an atomic counter, so that the tasks can write to them without locking.
+    nodes.resize(2 * n);
+    data.num_nodes = 1;
+
+#pragma omp parallel
+    {
+#pragma omp single
+        construct(data, 0, 0, n);
+    }
+    nodes.resize(data.num_nodes);
+
+    auto cpy = triangles;
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+    {
+        triangles[i] = cpy[data.ids[i]];
+    }
+}
+
+void SAHBVH::construct(BuildData& data, int nodeid, int start, int end)
+{
+    AABB box, centroid_box;
+    box.makeNegative();
+    centroid_box.makeNegative();
+    for (int i = start; i < end; ++i)
+    {
+        int id = data.ids[i];
+        box.growBox(data.boxes[id]);
+        centroid_box.growBox(data.centroids[id]);
+    }
+
+    BVHNode& node = nodes[nodeid];
+    node.box      = box;
+    node.box.min -= vec3(bvh_epsilon, bvh_epsilon, bvh_epsilon);
+    node.box.max += vec3(bvh_epsilon, bvh_epsilon, bvh_epsilon);
+
+    int count = end - start;
+    if (count <= leafTriangles)
+    {
+        node._inner = 0;
+        node._left  = start;
+        node._right = end;
+        return;
+    }
+
+    // Binned SAH. The cost of a split is area(L) * |L| + area(R) * |R|.
+    float best_cost = std::numeric_limits<float>::infinity();
+    int best_axis   = -1;
+    int best_bin    = -1;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float extent = centroid_box.max[axis] - centroid_box.min[axis];
+        if (extent <= 0) continue;
+        float scale = sah_bins / extent;
+
+        int bin_count[sah_bins] = {};
+        AABB bin_box[sah_bins];
+        for (auto& b : bin_box) b.makeNegative();
+
+        for (int i = start; i < end; ++i)
+        {
+            int id = data.ids[i];
+            int b  = std::min(int((data.centroids[id][axis] - centroid_box.min[axis]) * scale), sah_bins - 1);
+            bin_count[b]++;
+            bin_box[b].growBox(data.boxes[id]);
+        }
+
+        float right_cost[sah_bins];
+        AABB acc;
+        acc.makeNegative();
+        int acc_count = 0;
+        for (int b = sah_bins - 1; b > 0; --b)
+        {
+            if (bin_count[b] > 0) acc.growBox(bin_box[b]);
+            acc_count += bin_count[b];
+            right_cost[b] = acc_count > 0 ? HalfArea(acc) * acc_count : 0;
+        }
+
+        acc.makeNegative();
+        acc_count = 0;
+        for (int b = 0; b < sah_bins - 1; ++b)
+        {
+            if (bin_count[b] > 0) acc.growBox(bin_box[b]);
+            acc_count += bin_count[b];
+            if (acc_count == 0 || acc_count == count) continue;
+            float cost = HalfArea(acc) * acc_count + right_cost[b + 1];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin  = b;
+            }
+        }
+    }
+
+    // Traversing a node costs about as much as intersecting a triangle
+    float leaf_cost = HalfArea(box) * count;
+    if (count <= maxLeafTriangles && (best_axis == -1 || HalfArea(box) + best_cost >= leaf_cost))
+    {
+        node._inner = 0;
+        node._left  = start;
+        node._right = end;
+        return;
+    }
+
+    int mid;
+    if (best_axis == -1)
+    {
+        // All centroids are equal
+        mid = (start + end) / 2;
+    }
+    else
+    {
+        float min   = centroid_box.min[best_axis];
+        float scale = sah_bins / (centroid_box.max[best_axis] - min);
+        auto it     = std::partition(data.ids.begin() + start, data.ids.begin() + end, [&](int id) {
+            return std::min(int((data.centroids[id][best_axis] - min) * scale), sah_bins - 1) <= best_bin;
+        });
+        mid         = it - data.ids.begin();
+    }
+
+    int left    = data.num_nodes.fetch_add(2);
+    node._inner = 1;
+    node._left  = left;
+    node._right = left + 1;
+
+    if (count > sah_task_threshold)
+    {
+#pragma omp task shared(data)
+        construct(data, left, start, mid);
+        construct(data, left + 1, mid, end);
+#pragma omp taskwait
+    }
+    else
+    {
+        construct(data, left, start, mid);
+        construct(data, left + 1, mid, end);
+    }
+}
 
 }  // namespace AccelerationStructure
 }  // namespace Saiga
@@ -8,6 +8,7 @@
 
 #include "saiga/config.h"
 #include "saiga/core/math/math.h"
+#include "saiga/core/util/DataStructures/ArrayView.h"
 
 #include "aabb.h"
 #include "intersection.h"
@@ -31,6 +32,14 @@ class SAIGA_CORE_API Base
     virtual RayTriangleIntersection getClosest(const Ray& ray)          = 0;
     virtual std::vector<RayTriangleIntersection> getAll(const Ray& ray) = 0;
 
+    // Any hit in (0, t_max). Can terminate at the first hit, because the closest one is not required.
+    virtual bool isOccluded(const Ray& ray, float t_max);
+
+    // Batched queries into caller provided buffers of the same size as 'rays'.
+    // The default implementations call the single ray functions in parallel.
+    virtual void getClosestBatch(ArrayView<const Ray> rays, ArrayView<RayTriangleIntersection> result);
+    virtual void isOccludedBatch(ArrayView<const Ray> rays, float t_max, ArrayView<uint8_t> result);
+
     float bvh_epsilon      = 0.0001;
     float triangle_epsilon = 0.00001;
 };
@@ -88,6 +97,10 @@ class SAIGA_CORE_API BVH : public Base
     virtual std::vector<RayTriangleIntersection> getAll(const Ray& ray) override;
     virtual std::pair<float, int> ClosestPoint(const vec3& p);
 
+    // The tree after construction. The leaves reference the ranges [_left,_right) of Triangles().
+    const std::vector<BVHNode>& Nodes() const { return nodes; }
+    const std::vector<std::pair<Triangle, int>>& Triangles() const { return triangles; }
+
    protected:
     std::vector<std::pair<Triangle, int>> triangles;
     std::vector<BVHNode> nodes;
@@ -117,5 +130,34 @@ class SAIGA_CORE_API ObjectMedianBVH : public BVH
     int construct(int start, int end);
 };
 
+/**
+ * BVH built with the surface area heuristic (SAH).
+ *
+ * The triangle centroids are sorted into a fixed number of bins per axis and the split with the lowest SAH cost
+ * is chosen. No sorting is required, so the construction is O(n log n). Subtrees with many triangles are built in
+ * parallel with OpenMP tasks.
+ * A node becomes a leaf if it has at most 'leafTriangles' triangles, or if the SAH prefers a leaf and it has at most
+ * 'maxLeafTriangles' triangles.
+ */
+class SAIGA_CORE_API SAHBVH : public BVH
+{
+   public:
+    SAHBVH(const std::vector<Triangle>& triangles, int leafTriangles = 4, int maxLeafTriangles = 16)
+        : BVH(triangles), leafTriangles(leafTriangles), maxLeafTriangles(maxLeafTriangles)
+    {
+        construct();
+    }
+    virtual ~SAHBVH() {}
+
+   protected:
+    int leafTriangles;
+    int maxLeafTriangles;
+    void construct() override;
+
+   private:
+    struct BuildData;
+    void construct(BuildData& data, int node, int start, int end);
+};
+
 }  // namespace AccelerationStructure
 }  // namespace Saiga
@@ -0,0 +1,871 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "BVH4.h"
+
+#include "saiga/core/math/imath.h"
+#include "saiga/core/util/CpuFeatures.h"
+#include "saiga/core/util/assert.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef SAIGA_HAS_X86_SIMD
+#    include <immintrin.h>
+#endif
+
+namespace Saiga
+{
+namespace AccelerationStructure
+{
+namespace
+{
+// Minimal 4-wide float vector. SSE2 is part of x86-64, so no runtime dispatch is required.
+// Comparisons return a lane mask, which can be used with select() and movemask().
+#ifdef SAIGA_HAS_X86_SIMD
+struct vfloat4
+{
+    __m128 v;
+    vfloat4() {}
+    vfloat4(__m128 v) : v(v) {}
+    explicit vfloat4(float f) : v(_mm_set1_ps(f)) {}
+    static vfloat4 load(const float* ptr) { return _mm_load_ps(ptr); }
+};
+inline vfloat4 operator+(vfloat4 a, vfloat4 b)
+{
+    return _mm_add_ps(a.v, b.v);
+}
+inline vfloat4 operator-(vfloat4 a, vfloat4 b)
+{
+    return _mm_sub_ps(a.v, b.v);
+}
+inline vfloat4 operator*(vfloat4 a, vfloat4 b)
+{
+    return _mm_mul_ps(a.v, b.v);
+}
+inline vfloat4 operator/(vfloat4 a, vfloat4 b)
+{
+    return _mm_div_ps(a.v, b.v);
+}
+inline vfloat4 operator&(vfloat4 a, vfloat4 b)
+{
+    return _mm_and_ps(a.v, b.v);
+}
+inline vfloat4 operator|(vfloat4 a, vfloat4 b)
+{
+    return _mm_or_ps(a.v, b.v);
+}
+inline vfloat4 operator<(vfloat4 a, vfloat4 b)
+{
+    return _mm_cmplt_ps(a.v, b.v);
+}
+inline vfloat4 operator<=(vfloat4 a, vfloat4 b)
+{
+    return _mm_cmple_ps(a.v, b.v);
+}
+inline vfloat4 operator>(vfloat4 a, vfloat4 b)
+{
+    return _mm_cmpgt_ps(a.v, b.v);
+}
+inline vfloat4 operator>=(vfloat4 a, vfloat4 b)
+{
+    return _mm_cmpge_ps(a.v, b.v);
+}
+// If a is NaN, b is returned
+inline vfloat4 vmin(vfloat4 a, vfloat4 b)
+{
+    return _mm_min_ps(a.v, b.v);
+}
+inline vfloat4 vmax(vfloat4 a, vfloat4 b)
+{
+    return _mm_max_ps(a.v, b.v);
+}
+inline vfloat4 select(vfloat4 mask, vfloat4 a, vfloat4 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+inline int movemask(vfloat4 mask)
+{
+    return _mm_movemask_ps(mask.v);
+}
+inline void store(float* ptr, vfloat4 a)
+{
+    _mm_storeu_ps(ptr, a.v);
+}
+#else
+struct vfloat4
+{
+    float v[4];
+    vfloat4() {}
+    explicit vfloat4(float f) : v{f, f, f, f} {}
+    static vfloat4 load(const float* ptr)
+    {
+        vfloat4 r;
+        for (int i = 0; i < 4; ++i) r.v[i] = ptr[i];
+        return r;
+    }
+};
+template <typename Op>
+inline vfloat4 apply(vfloat4 a, vfloat4 b, Op op)
+{
+    vfloat4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = op(a.v[i], b.v[i]);
+    return r;
+}
+inline float maskValue(bool b)
+{
+    uint32_t bits = b ? 0xFFFFFFFFu : 0;
+    float f;
+    std::memcpy(&f, &bits, 4);
+    return f;
+}
+inline bool maskBit(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, 4);
+    return bits >> 31;
+}
+inline vfloat4 operator+(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return x + y; });
+}
+inline vfloat4 operator-(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return x - y; });
+}
+inline vfloat4 operator*(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return x * y; });
+}
+inline vfloat4 operator/(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return x / y; });
+}
+inline vfloat4 operator&(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return maskValue(maskBit(x) && maskBit(y)); });
+}
+inline vfloat4 operator|(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return maskValue(maskBit(x) || maskBit(y)); });
+}
+inline vfloat4 operator<(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return maskValue(x < y); });
+}
+inline vfloat4 operator<=(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return maskValue(x <= y); });
+}
+inline vfloat4 operator>(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return maskValue(x > y); });
+}
+inline vfloat4 operator>=(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return maskValue(x >= y); });
+}
+inline vfloat4 vmin(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return x < y ? x : y; });
+}
+inline vfloat4 vmax(vfloat4 a, vfloat4 b)
+{
+    return apply(a, b, [](float x, float y) { return x > y ? x : y; });
+}
+inline vfloat4 select(vfloat4 mask, vfloat4 a, vfloat4 b)
+{
+    vfloat4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = maskBit(mask.v[i]) ? a.v[i] : b.v[i];
+    return r;
+}
+inline int movemask(vfloat4 mask)
+{
+    int r = 0;
+    for (int i = 0; i < 4; ++i) r |= int(maskBit(mask.v[i])) << i;
+    return r;
+}
+inline void store(float* ptr, vfloat4 a)
+{
+    for (int i = 0; i < 4; ++i) ptr[i] = a.v[i];
+}
+#endif
+
+struct vec3x4
+{
+    vfloat4 x, y, z;
+    vec3x4() {}
+    vec3x4(vfloat4 x, vfloat4 y, vfloat4 z) : x(x), y(y), z(z) {}
+    explicit vec3x4(const vec3& v) : x(v.x()), y(v.y()), z(v.z()) {}
+    static vec3x4 load(const float (&ptr)[3][4])
+    {
+        return {vfloat4::load(ptr[0]), vfloat4::load(ptr[1]), vfloat4::load(ptr[2])};
+    }
+};
+inline vec3x4 operator+(const vec3x4& a, const vec3x4& b)
+{
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+inline vec3x4 operator-(const vec3x4& a, const vec3x4& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+inline vec3x4 operator*(vfloat4 s, const vec3x4& a)
+{
+    return {s * a.x, s * a.y, s * a.z};
+}
+inline vfloat4 dot(const vec3x4& a, const vec3x4& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+inline vec3x4 cross(const vec3x4& a, const vec3x4& b)
+{
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+// Squared distance of p to the segment a + t * e, t in [0,1]. ap = p - a.
+inline vfloat4 SegmentDistanceSquared(const vec3x4& ap, const vec3x4& e)
+{
+    // NaN (degenerate edge) -> 0
+    vfloat4 t = vmin(vmax(dot(ap, e) / dot(e, e), vfloat4(0)), vfloat4(1));
+    vec3x4 d  = ap - t * e;
+    return dot(d, d);
+}
+
+constexpr int stack_size = 256;
+
+// Entry of the traversal stack
+struct StackEntry
+{
+    int32_t child;
+    int32_t count;
+    float distance;
+};
+
+// Pushes the children given by 'mask' sorted by their distance. The closest child is on top of the stack.
+inline void PushSorted(const BVH4::Node& node, int mask, const float* distance, StackEntry* stack, int& sp)
+{
+    StackEntry entries[4];
+    int n = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        if (mask & (1 << k))
+        {
+            StackEntry e = {node.child[k], node.count[k], distance[k]};
+            // insertion sort descending
+            int j = n++;
+            while (j > 0 && entries[j - 1].distance < e.distance)
+            {
+                entries[j] = entries[j - 1];
+                --j;
+            }
+            entries[j] = e;
+        }
+    }
+    for (int k = 0; k < n; ++k) stack[sp++] = entries[k];
+}
+
+struct RayData
+{
+    vec3x4 origin, direction, inv_direction;
+    RayData() {}
+    RayData(const Ray& ray)
+        : origin(ray.origin),
+          direction(ray.direction),
+          inv_direction(vec3(1.0f / ray.direction.x(), 1.0f / ray.direction.y(), 1.0f / ray.direction.z()))
+    {
+    }
+
+    // Mask of the children hit in [0, t_max]. t_near is the entry distance.
+    int intersect(const BVH4::Node& node, vfloat4 t_max, vfloat4& t_near) const
+    {
+        vec3x4 bmin = vec3x4::load(node.min);
+        vec3x4 bmax = vec3x4::load(node.max);
+        vec3x4 t1   = {(bmin.x - origin.x) * inv_direction.x, (bmin.y - origin.y) * inv_direction.y,
+                     (bmin.z - origin.z) * inv_direction.z};
+        vec3x4 t2   = {(bmax.x - origin.x) * inv_direction.x, (bmax.y - origin.y) * inv_direction.y,
+                     (bmax.z - origin.z) * inv_direction.z};
+
+        t_near       = vmax(vmax(vmin(t1.x, t2.x), vmin(t1.y, t2.y)), vmax(vmin(t1.z, t2.z), vfloat4(0)));
+        vfloat4 tfar = vmin(vmin(vmax(t1.x, t2.x), vmax(t1.y, t2.y)), vmin(vmax(t1.z, t2.z), t_max));
+        return movemask(t_near <= tfar);
+    }
+
+    // Möller–Trumbore for 4 triangles. Same tests as Intersection::RayTriangle.
+    // Returns the mask of valid hits in (epsilon, t_max) and their distance.
+    int intersect(const BVH4::TrianglePacket& packet, float epsilon, vfloat4 t_max, vfloat4& t) const
+    {
+        vec3x4 a  = vec3x4::load(packet.a);
+        vec3x4 e1 = vec3x4::load(packet.e1);
+        vec3x4 e2 = vec3x4::load(packet.e2);
+
+        vec3x4 P    = cross(direction, e2);
+        vfloat4 det = dot(e1, P);
+        vfloat4 eps(epsilon);
+        vfloat4 valid = (det <= vfloat4(-epsilon)) | (det >= eps);
+
+        vfloat4 inv_det = vfloat4(1) / det;
+        vec3x4 T        = origin - a;
+        vfloat4 u       = dot(T, P) * inv_det;
+        valid           = valid & (u >= vfloat4(0)) & (u <= vfloat4(1));
+
+        vec3x4 Q  = cross(T, e1);
+        vfloat4 v = dot(direction, Q) * inv_det;
+        valid     = valid & (v >= vfloat4(0)) & (u + v <= vfloat4(1));
+
+        t     = dot(e2, Q) * inv_det;
+        valid = valid & (t > eps) & (t < t_max);
+        return movemask(valid);
+    }
+};
+
+RayTriangleIntersection MakeIntersection(const Ray& ray, const Triangle& tri, float t, int id)
+{
+    RayTriangleIntersection inter;
+    inter.valid         = true;
+    inter.t             = t;
+    inter.backFace      = ray.direction.dot((tri.b - tri.a).cross(tri.c - tri.a)) > 0;
+    inter.triangleIndex = id;
+    return inter;
+}
+
+// Interval bounds of a ray packet for frustum culling. If all rays have the same direction signs, the
+// entry and exit distances of every ray are inside the intervals computed from the bounds of the origins and inverse
+// directions. A box that is missed by this conservative test is missed by all rays of the packet.
+struct PacketBounds
+{
+    vec3x4 origin_min, origin_max, inv_min, inv_max;
+    bool negative[3];
+    bool coherent = true;
+
+    // Clamped to avoid inf * 0 = NaN in the interval products
+    static vec3 Inverse(const vec3& direction)
+    {
+        vec3 inv;
+        for (int d = 0; d < 3; ++d) inv[d] = std::clamp(1.0f / direction[d], -1e30f, 1e30f);
+        return inv;
+    }
+
+    PacketBounds(const Ray* rays, int n)
+    {
+        vec3 omin = rays[0].origin, omax = rays[0].origin;
+        vec3 imin = Inverse(rays[0].direction), imax = imin;
+        for (int d = 0; d < 3; ++d) negative[d] = imin[d] < 0;
+        for (int i = 1; i < n; ++i)
+        {
+            vec3 inv = Inverse(rays[i].direction);
+            for (int d = 0; d < 3; ++d) coherent = coherent && ((inv[d] < 0) == negative[d]);
+            omin = omin.cwiseMin(rays[i].origin);
+            omax = omax.cwiseMax(rays[i].origin);
+            imin = imin.cwiseMin(inv);
+            imax = imax.cwiseMax(inv);
+        }
+        origin_min = vec3x4(omin);
+        origin_max = vec3x4(omax);
+        inv_min    = vec3x4(imin);
+        inv_max    = vec3x4(imax);
+    }
+
+    static inline void Interval(vfloat4 plane, vfloat4 omin, vfloat4 omax, vfloat4 imin, vfloat4 imax, vfloat4& lo,
+                                vfloat4& hi)
+    {
+        vfloat4 a = plane - omax, b = plane - omin;
+        vfloat4 p0 = a * imin, p1 = a * imax, p2 = b * imin, p3 = b * imax;
+        lo         = vmin(vmin(p0, p1), vmin(p2, p3));
+        hi         = vmax(vmax(p0, p1), vmax(p2, p3));
+    }
+
+    int intersect(const BVH4::Node& node, vfloat4 t_max, vfloat4& t_near) const
+    {
+        vfloat4 t_far = t_max;
+        t_near        = vfloat4(0);
+        const vfloat4* omin[3] = {&origin_min.x, &origin_min.y, &origin_min.z};
+        const vfloat4* omax[3] = {&origin_max.x, &origin_max.y, &origin_max.z};
+        const vfloat4* imin[3] = {&inv_min.x, &inv_min.y, &inv_min.z};
+        const vfloat4* imax[3] = {&inv_max.x, &inv_max.y, &inv_max.z};
+        for (int d = 0; d < 3; ++d)
+        {
+            vfloat4 near_plane = vfloat4::load(negative[d] ? node.max[d] : node.min[d]);
+            vfloat4 far_plane  = vfloat4::load(negative[d] ? node.min[d] : node.max[d]);
+            vfloat4 lo, hi, unused;
+            Interval(near_plane, *omin[d], *omax[d], *imin[d], *imax[d], lo, unused);
+            Interval(far_plane, *omin[d], *omax[d], *imin[d], *imax[d], unused, hi);
+            t_near = vmax(t_near, lo);
+            t_far  = vmin(t_far, hi);
+        }
+        return movemask(t_near <= t_far);
+    }
+};
+
+}  // namespace
+
+
+BVH4::BVH4(const std::vector<Triangle>& _triangles, int leafTriangles) : triangles(_triangles)
+{
+    static_assert(sizeof(Node) == 128, "Node size broken.");
+    if (triangles.empty()) return;
+
+    SAHBVH bvh(triangles, leafTriangles);
+    nodes.reserve(bvh.Nodes().size() / 2 + 1);
+    packets.reserve(triangles.size() / 2 + 1);
+    collapse(bvh, 0, 1);
+
+    // Every level pushes at most 3 entries onto the stack
+    SAIGA_ASSERT(3 * depth + 1 < stack_size, "BVH too deep.");
+}
+
+int BVH4::collapse(const BVH& bvh, int bnode, int level)
+{
+    auto& bnodes = bvh.Nodes();
+    depth        = std::max(depth, level);
+
+    int id = nodes.size();
+    nodes.push_back({});
+
+    // Open the inner child with the largest surface until there are 4 children
+    int children[4] = {int(bnodes[bnode]._left), int(bnodes[bnode]._right), -1, -1};
+    int n           = 2;
+    if (!bnodes[bnode]._inner)
+    {
+        // Single leaf (only the root)
+        children[0] = bnode;
+        n           = 1;
+    }
+    while (n < 4)
+    {
+        int best        = -1;
+        float best_area = -1;
+        for (int k = 0; k < n; ++k)
+        {
+            auto& c = bnodes[children[k]];
+            if (!c._inner) continue;
+            vec3 d     = c.box.max - c.box.min;
+            float area = d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+            if (area > best_area)
+            {
+                best_area = area;
+                best      = k;
+            }
+        }
+        if (best == -1) break;
+        int c          = children[best];
+        children[best] = bnodes[c]._left;
+        children[n++]  = bnodes[c]._right;
+    }
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int32_t child = -1, count = 0;
+        AABB box;
+        // Empty slot: a box at infinity is never hit and never closer than a triangle
+        box.min = vec3(std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+                       std::numeric_limits<float>::infinity());
+        box.max = box.min;
+
+        if (k < n)
+        {
+            auto& c = bnodes[children[k]];
+            box     = c.box;
+            if (c._inner)
+            {
+                child = collapse(bvh, children[k], level + 1);
+            }
+            else
+            {
+                // Leaf -> pack the triangles into groups of 4
+                int first = packets.size();
+                auto& tris = bvh.Triangles();
+                for (uint32_t i = c._left; i < c._right; i += 4)
+                {
+                    TrianglePacket p;
+                    for (int l = 0; l < 4; ++l)
+                    {
+                        uint32_t ti = i + l;
+                        Triangle t;
+                        int tid = -1;
+                        if (ti < c._right)
+                        {
+                            t   = tris[ti].first;
+                            tid = tris[ti].second;
+                        }
+                        else
+                        {
+                            t.a = t.b = t.c = vec3(0, 0, 0);
+                        }
+                        vec3 e1 = t.b - t.a;
+                        vec3 e2 = t.c - t.a;
+                        for (int d = 0; d < 3; ++d)
+                        {
+                            p.a[d][l]  = t.a[d];
+                            p.e1[d][l] = e1[d];
+                            p.e2[d][l] = e2[d];
+                        }
+                        p.id[l] = tid;
+                    }
+                    packets.push_back(p);
+                }
+                child = -(first + 1);
+                count = packets.size() - first;
+            }
+        }
+
+        // The vector might have been reallocated by the recursion
+        Node& node = nodes[id];
+        for (int d = 0; d < 3; ++d)
+        {
+            node.min[d][k] = box.min[d];
+            node.max[d][k] = box.max[d];
+        }
+        node.child[k] = child;
+        node.count[k] = count;
+    }
+    return id;
+}
+
+template <bool any_hit>
+int BVH4::traceRay(const Ray& ray, float& t) const
+{
+    int best_id = -1;
+    if (nodes.empty()) return best_id;
+
+    RayData r(ray);
+    StackEntry stack[stack_size];
+    int sp      = 0;
+    stack[sp++] = {0, 0, 0};
+
+    while (sp > 0)
+    {
+        StackEntry e = stack[--sp];
+        if (e.distance > t) continue;
+
+        if (e.child >= 0)
+        {
+            vfloat4 t_near;
+            int mask = r.intersect(nodes[e.child], vfloat4(t), t_near);
+            if (!mask) continue;
+            alignas(16) float distance[4];
+            store(distance, t_near);
+            PushSorted(nodes[e.child], mask, distance, stack, sp);
+        }
+        else
+        {
+            int first = -(e.child + 1);
+            for (int i = first; i < first + e.count; ++i)
+            {
+                auto& packet = packets[i];
+                vfloat4 ts;
+                int mask = r.intersect(packet, triangle_epsilon, vfloat4(t), ts);
+                if (!mask) continue;
+                alignas(16) float tl[4];
+                store(tl, ts);
+                for (int l = 0; l < 4; ++l)
+                {
+                    if ((mask & (1 << l)) && tl[l] < t)
+                    {
+                        t       = tl[l];
+                        best_id = packet.id[l];
+                        if (any_hit) return best_id;
+                    }
+                }
+            }
+        }
+    }
+    return best_id;
+}
+
+template <int N, bool any_hit>
+void BVH4::tracePacket(const Ray* rays, int n, float* t, int* id) const
+{
+    SAIGA_ASSERT(n >= 1 && n <= N);
+    for (int i = 0; i < n; ++i) id[i] = -1;
+    if (nodes.empty()) return;
+
+    RayData r[N];
+    for (int i = 0; i < n; ++i) r[i] = RayData(rays[i]);
+    PacketBounds bounds(rays, n);
+
+    // Rays without a result. In any hit mode, a ray is done after the first hit.
+    uint32_t active = (1u << n) - 1;
+    float max_t     = *std::max_element(t, t + n);
+
+    StackEntry stack[stack_size];
+    int sp      = 0;
+    stack[sp++] = {0, 0, 0};
+
+    while (sp > 0)
+    {
+        StackEntry e = stack[--sp];
+        if (e.distance > max_t) continue;
+
+        if (e.child >= 0)
+        {
+            auto& node = nodes[e.child];
+            vfloat4 t_near;
+            int mask = 0;
+            if (bounds.coherent)
+            {
+                // Frustum culling with the packet bounds and then an exact test until every child is hit by a ray
+                int candidates = bounds.intersect(node, vfloat4(max_t), t_near);
+                if (!candidates) continue;
+                for (int i = 0; i < n && mask != candidates; ++i)
+                {
+                    vfloat4 unused;
+                    if (active & (1u << i)) mask |= r[i].intersect(node, vfloat4(t[i]), unused) & candidates;
+                }
+            }
+            else
+            {
+                t_near = vfloat4(std::numeric_limits<float>::infinity());
+                for (int i = 0; i < n; ++i)
+                {
+                    if (!(active & (1u << i))) continue;
+                    vfloat4 tn;
+                    mask |= r[i].intersect(node, vfloat4(t[i]), tn);
+                    t_near = vmin(t_near, tn);
+                }
+            }
+            if (!mask) continue;
+            alignas(16) float distance[4];
+            store(distance, t_near);
+            PushSorted(node, mask, distance, stack, sp);
+        }
+        else
+        {
+            int first = -(e.child + 1);
+            for (int i = 0; i < n; ++i)
+            {
+                if (!(active & (1u << i))) continue;
+                for (int k = first; k < first + e.count; ++k)
+                {
+                    auto& packet = packets[k];
+                    vfloat4 ts;
+                    int mask = r[i].intersect(packet, triangle_epsilon, vfloat4(t[i]), ts);
+                    if (!mask) continue;
+                    alignas(16) float tl[4];
+                    store(tl, ts);
+                    for (int l = 0; l < 4; ++l)
+                    {
+                        if ((mask & (1 << l)) && tl[l] < t[i])
+                        {
+                            t[i]  = tl[l];
+                            id[i] = packet.id[l];
+                        }
+                    }
+                    if (any_hit && id[i] >= 0)
+                    {
+                        active &= ~(1u << i);
+                        break;
+                    }
+                }
+            }
+            if (!active) return;
+            max_t = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                if (active & (1u << i)) max_t = std::max(max_t, t[i]);
+            }
+        }
+    }
+}
+
+template <bool any_hit, typename F>
+void BVH4::traceBatch(ArrayView<const Ray> rays, float t_max, F output) const
+{
+    SAIGA_ASSERT(packet_size == 1 || packet_size == 4 || packet_size == 8 || packet_size == 16);
+    int num_packets = iDivUp((int)rays.size(), packet_size);
+
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int p = 0; p < num_packets; ++p)
+    {
+        int start = p * packet_size;
+        int n     = std::min<int>(packet_size, rays.size() - start);
+        float t[16];
+        int id[16];
+        for (int i = 0; i < n; ++i) t[i] = t_max;
+
+        const Ray* packet = rays.data() + start;
+        switch (packet_size)
+        {
+            case 1:
+                id[0] = traceRay<any_hit>(packet[0], t[0]);
+                break;
+            case 4:
+                tracePacket<4, any_hit>(packet, n, t, id);
+                break;
+            case 8:
+                tracePacket<8, any_hit>(packet, n, t, id);
+                break;
+            default:
+                tracePacket<16, any_hit>(packet, n, t, id);
+                break;
+        }
+        for (int i = 0; i < n; ++i) output(start + i, t[i], id[i]);
+    }
+}
+
+RayTriangleIntersection BVH4::getClosest(const Ray& ray)
+{
+    RayTriangleIntersection result;
+    float t = std::numeric_limits<float>::infinity();
+    int id  = traceRay<false>(ray, t);
+    if (id >= 0) result = MakeIntersection(ray, triangles[id], t, id);
+    return result;
+}
+
+bool BVH4::isOccluded(const Ray& ray, float t_max)
+{
+    return traceRay<true>(ray, t_max) >= 0;
+}
+
+void BVH4::getClosestBatch(ArrayView<const Ray> rays, ArrayView<RayTriangleIntersection> result)
+{
+    SAIGA_ASSERT(rays.size() == result.size());
+    traceBatch<false>(rays, std::numeric_limits<float>::infinity(), [&](int i, float t, int id) {
+        result[i] = id >= 0 ? MakeIntersection(rays[i], triangles[id], t, id) : RayTriangleIntersection();
+    });
+}
+
+void BVH4::isOccludedBatch(ArrayView<const Ray> rays, float t_max, ArrayView<uint8_t> result)
+{
+    SAIGA_ASSERT(rays.size() == result.size());
+    traceBatch<true>(rays, t_max, [&](int i, float, int id) { result[i] = id >= 0; });
+}
+
+std::vector<RayTriangleIntersection> BVH4::getAll(const Ray& ray)
+{
+    std::vector<RayTriangleIntersection> result;
+    if (nodes.empty()) return result;
+
+    RayData r(ray);
+    vfloat4 t_max(std::numeric_limits<float>::infinity());
+
+    StackEntry stack[stack_size];
+    int sp      = 0;
+    stack[sp++] = {0, 0, 0};
+
+    while (sp > 0)
+    {
+        StackEntry e = stack[--sp];
+        if (e.child >= 0)
+        {
+            vfloat4 t_near;
+            int mask = r.intersect(nodes[e.child], t_max, t_near);
+            auto& node = nodes[e.child];
+            for (int k = 0; k < 4; ++k)
+            {
+                if (mask & (1 << k)) stack[sp++] = {node.child[k], node.count[k], 0};
+            }
+        }
+        else
+        {
+            int first = -(e.child + 1);
+            for (int i = first; i < first + e.count; ++i)
+            {
+                auto& packet = packets[i];
+                vfloat4 t;
+                int mask = r.intersect(packet, triangle_epsilon, t_max, t);
+                if (!mask) continue;
+                alignas(16) float ts[4];
+                store(ts, t);
+                for (int l = 0; l < 4; ++l)
+                {
+                    if (mask & (1 << l))
+                    {
+                        result.push_back(MakeIntersection(ray, triangles[packet.id[l]], ts[l], packet.id[l]));
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::pair<float, int> BVH4::ClosestPoint(const vec3& point, int hint) const
+{
+    std::pair<float, int> result = {std::numeric_limits<float>::infinity(), -1};
+    if (nodes.empty()) return result;
+
+    vec3x4 p(point);
+    // Squared distance of the best triangle
+    float best2 = std::numeric_limits<float>::infinity();
+    if (hint >= 0)
+    {
+        result = {triangles[hint].Distance(point), hint};
+        best2  = result.first * result.first;
+    }
+
+    StackEntry stack[stack_size];
+    int sp      = 0;
+    stack[sp++] = {0, 0, 0};
+
+    while (sp > 0)
+    {
+        StackEntry e = stack[--sp];
+        if (e.distance >= best2) continue;
+
+        if (e.child >= 0)
+        {
+            auto& node  = nodes[e.child];
+            vec3x4 bmin = vec3x4::load(node.min);
+            vec3x4 bmax = vec3x4::load(node.max);
+            vfloat4 dx  = vmax(vmax(bmin.x - p.x, p.x - bmax.x), vfloat4(0));
+            vfloat4 dy  = vmax(vmax(bmin.y - p.y, p.y - bmax.y), vfloat4(0));
+            vfloat4 dz  = vmax(vmax(bmin.z - p.z, p.z - bmax.z), vfloat4(0));
+            vfloat4 d2  = dx * dx + dy * dy + dz * dz;
+            int mask    = movemask(d2 < vfloat4(best2));
+            if (!mask) continue;
+            alignas(16) float distance[4];
+            store(distance, d2);
+            PushSorted(node, mask, distance, stack, sp);
+        }
+        else
+        {
+            int first = -(e.child + 1);
+            for (int i = first; i < first + e.count; ++i)
+            {
+                auto& packet = packets[i];
+                vec3x4 a     = vec3x4::load(packet.a);
+                vec3x4 e1    = vec3x4::load(packet.e1);
+                vec3x4 e2    = vec3x4::load(packet.e2);
+                vec3x4 b     = a + e1;
+                vec3x4 c     = a + e2;
+                vec3x4 ap = p - a, bp = p - b, cp = p - c;
+
+                // Closest point in the interior or on one of the edges
+                vec3x4 n       = cross(e1, e2);
+                vfloat4 nn     = dot(n, n);
+                vfloat4 zero   = vfloat4(0);
+                vfloat4 inside = (nn > zero) & (dot(cross(e1, ap), n) >= zero) &
+                                 (dot(cross(c - b, bp), n) >= zero) & (dot(cross(a - c, cp), n) >= zero);
+                vfloat4 plane = dot(ap, n);
+                plane         = plane * plane / nn;
+                vfloat4 edge  = vmin(vmin(SegmentDistanceSquared(ap, e1), SegmentDistanceSquared(bp, c - b)),
+                                    SegmentDistanceSquared(cp, a - c));
+                vfloat4 d2    = select(inside, plane, edge);
+
+                // The SIMD distance only selects the candidates. The result is computed with Triangle::Distance, so
+                // that it is identical to a brute force search.
+                int mask = movemask(d2 <= vfloat4(best2 * 1.001f + 1e-12f));
+                if (!mask) continue;
+                for (int l = 0; l < 4; ++l)
+                {
+                    int id = packet.id[l];
+                    if (!(mask & (1 << l)) || id < 0) continue;
+                    float d = triangles[id].Distance(point);
+                    if (d * d < best2 || (d * d == best2 && d < result.first))
+                    {
+                        best2  = d * d;
+                        result = {d, id};
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace AccelerationStructure
+}  // namespace Saiga
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "AccelerationStructure.h"
+
+namespace Saiga
+{
+namespace AccelerationStructure
+{
+/**
+ * Flattened 4-wide BVH for fast ray and closest point queries.
+ *
+ * The tree is built with the SAHBVH and then collapsed, so that every node has up to 4 children. The bounding boxes
+ * of the children and the triangles of the leaves are stored as structure of arrays. A single SSE instruction
+ * processes 4 boxes or 4 triangles. The traversal is iterative with a small stack on the call stack.
+ *
+ * Usage:
+ *
+ *   AccelerationStructure::BVH4 bvh(mesh.toTriangleList());
+ *   auto inter = bvh.getClosest(ray);
+ *   auto [distance, triangle] = bvh.ClosestPoint(p);
+ */
+class SAIGA_CORE_API BVH4 : public Base
+{
+   public:
+    // The children of a node. Leaves and empty slots have a negative child index:
+    //   leaf:  child = -(first_packet + 1), count = number of packets
+    //   empty: child = -1, count = 0, box at infinity
+    struct alignas(16) Node
+    {
+        float min[3][4];
+        float max[3][4];
+        int32_t child[4];
+        int32_t count[4];
+    };
+
+    // 4 triangles stored as a, b - a, c - a. Unused slots have id = -1.
+    struct alignas(16) TrianglePacket
+    {
+        float a[3][4];
+        float e1[3][4];
+        float e2[3][4];
+        int32_t id[4];
+    };
+
+    BVH4(const std::vector<Triangle>& triangles, int leafTriangles = 4);
+    virtual ~BVH4() {}
+
+    virtual RayTriangleIntersection getClosest(const Ray& ray) override;
+    virtual std::vector<RayTriangleIntersection> getAll(const Ray& ray) override;
+    virtual bool isOccluded(const Ray& ray, float t_max) override;
+
+    // Consecutive rays are traced together as a packet of 'packet_size' rays. The nodes are culled with the
+    // frustum of the packet, therefore the rays should be coherent, for example the primary rays of a 4x4 pixel tile.
+    virtual void getClosestBatch(ArrayView<const Ray> rays, ArrayView<RayTriangleIntersection> result) override;
+    virtual void isOccludedBatch(ArrayView<const Ray> rays, float t_max, ArrayView<uint8_t> result) override;
+
+    // Same as BVH::ClosestPoint: (distance, triangle index). The distance is computed by Triangle::Distance.
+    // 'hint' is an optional triangle close to p, for example the result of a neighbouring query point. Its distance is
+    // used as the initial search radius.
+    std::pair<float, int> ClosestPoint(const vec3& p, int hint = -1) const;
+
+    int NumNodes() const { return nodes.size(); }
+    int NumPackets() const { return packets.size(); }
+    int Depth() const { return depth; }
+
+    // 1, 4, 8 or 16
+    int packet_size = 8;
+
+   protected:
+    std::vector<Node> nodes;
+    std::vector<TrianglePacket> packets;
+
+    // Input triangles for the exact closest point distance and the back face flag
+    std::vector<Triangle> triangles;
+    int depth = 0;
+
+    int collapse(const BVH& bvh, int node, int level);
+
+    // Returns the hit triangle or -1. t is the maximum distance as input and the hit distance as output.
+    template <bool any_hit>
+    int traceRay(const Ray& ray, float& t) const;
+    // n <= N rays at once
+    template <int N, bool any_hit>
+    void tracePacket(const Ray* rays, int n, float* t, int* id) const;
+    template <bool any_hit, typename F>
+    void traceBatch(ArrayView<const Ray> rays, float t_max, F output) const;
+};
+
+}  // namespace AccelerationStructure
+}  // namespace Saiga
@@ -0,0 +1,329 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "BatchCulling.h"
+
+#include "saiga/core/math/imath.h"
+#include "saiga/core/util/CpuFeatures.h"
+
+#ifdef SAIGA_HAS_X86_SIMD
+#    include <immintrin.h>
+#endif
+
+namespace Saiga
+{
+SphereSoA::SphereSoA(const std::vector<Sphere>& spheres)
+{
+    resize(spheres.size());
+    for (int i = 0; i < n; ++i) set(i, spheres[i]);
+}
+
+void SphereSoA::resize(int new_size)
+{
+    n          = new_size;
+    int padded = iAlignUp(n, 4);
+    x.resize(padded);
+    y.resize(padded);
+    z.resize(padded);
+    r.resize(padded);
+}
+
+void SphereSoA::reserve(int capacity)
+{
+    int padded = iAlignUp(capacity, 4);
+    x.reserve(padded);
+    y.reserve(padded);
+    z.reserve(padded);
+    r.reserve(padded);
+}
+
+void SphereSoA::push_back(const Sphere& s)
+{
+    resize(n + 1);
+    set(n - 1, s);
+}
+
+void SphereSoA::set(int i, const Sphere& s)
+{
+    x[i] = s.pos.x();
+    y[i] = s.pos.y();
+    z[i] = s.pos.z();
+    r[i] = s.r;
+}
+
+AABBSoA::AABBSoA(const std::vector<AABB>& boxes)
+{
+    resize(boxes.size());
+    for (int i = 0; i < n; ++i) set(i, boxes[i]);
+}
+
+void AABBSoA::resize(int new_size)
+{
+    n          = new_size;
+    int padded = iAlignUp(n, 4);
+    for (auto* v : {&min_x, &min_y, &min_z, &max_x, &max_y, &max_z}) v->resize(padded);
+}
+
+void AABBSoA::reserve(int capacity)
+{
+    int padded = iAlignUp(capacity, 4);
+    for (auto* v : {&min_x, &min_y, &min_z, &max_x, &max_y, &max_z}) v->reserve(padded);
+}
+
+void AABBSoA::push_back(const AABB& box)
+{
+    resize(n + 1);
+    set(n - 1, box);
+}
+
+void AABBSoA::set(int i, const AABB& box)
+{
+    min_x[i] = box.min.x();
+    min_y[i] = box.min.y();
+    min_z[i] = box.min.z();
+    max_x[i] = box.max.x();
+    max_y[i] = box.max.y();
+    max_z[i] = box.max.z();
+}
+
+PlaneSoA::PlaneSoA(const std::vector<Plane>& planes)
+{
+    resize(planes.size());
+    for (int i = 0; i < n; ++i) set(i, planes[i]);
+}
+
+void PlaneSoA::resize(int new_size)
+{
+    n          = new_size;
+    int padded = iAlignUp(n, 4);
+    nx.resize(padded);
+    ny.resize(padded);
+    nz.resize(padded);
+    d.resize(padded);
+}
+
+void PlaneSoA::push_back(const Plane& p)
+{
+    resize(n + 1);
+    set(n - 1, p);
+}
+
+void PlaneSoA::set(int i, const Plane& p)
+{
+    nx[i] = p.normal.x();
+    ny[i] = p.normal.y();
+    nz[i] = p.normal.z();
+    d[i]  = p.d;
+}
+
+namespace
+{
+// Each block function returns the visibility of the objects [i, i+4) in the lower 4 bits.
+// The arithmetic is done in the same order as Plane::distance, so that the results are identical to the scalar
+// Frustum tests.
+
+int SphereBlockScalar(const Plane* planes, int num_planes, const SphereSoA& s, int i)
+{
+    int visible = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        vec3 c(s.x[i + k], s.y[i + k], s.z[i + k]);
+        bool outside = false;
+        for (int p = 0; p < num_planes && !outside; ++p)
+        {
+            outside = planes[p].distance(c) >= s.r[i + k];
+        }
+        visible |= int(!outside) << k;
+    }
+    return visible;
+}
+
+int AABBBlockScalar(const Plane* planes, int num_planes, const AABBSoA& b, int i)
+{
+    int visible = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        vec3 bmin(b.min_x[i + k], b.min_y[i + k], b.min_z[i + k]);
+        vec3 bmax(b.max_x[i + k], b.max_y[i + k], b.max_z[i + k]);
+        vec3 center  = (bmin + bmax) * 0.5f;
+        vec3 extent  = (bmax - bmin) * 0.5f;
+        bool outside = false;
+        for (int p = 0; p < num_planes && !outside; ++p)
+        {
+            outside = planes[p].distance(center) >= planes[p].normal.cwiseAbs().dot(extent);
+        }
+        visible |= int(!outside) << k;
+    }
+    return visible;
+}
+
+#ifdef SAIGA_HAS_X86_SIMD
+// SSE2 is part of x86-64, so no runtime dispatch is required.
+inline __m128 Dot(__m128 x, __m128 y, __m128 z, const vec3& n)
+{
+    __m128 r = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(n.x())), _mm_mul_ps(y, _mm_set1_ps(n.y())));
+    return _mm_add_ps(r, _mm_mul_ps(z, _mm_set1_ps(n.z())));
+}
+
+int SphereBlockSSE(const Plane* planes, int num_planes, const SphereSoA& s, int i)
+{
+    __m128 x = _mm_loadu_ps(s.x.data() + i);
+    __m128 y = _mm_loadu_ps(s.y.data() + i);
+    __m128 z = _mm_loadu_ps(s.z.data() + i);
+    __m128 r = _mm_loadu_ps(s.r.data() + i);
+
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < num_planes; ++p)
+    {
+        __m128 dist = _mm_sub_ps(Dot(x, y, z, planes[p].normal), _mm_set1_ps(planes[p].d));
+        outside     = _mm_or_ps(outside, _mm_cmpge_ps(dist, r));
+        if (_mm_movemask_ps(outside) == 0xF) break;
+    }
+    return ~_mm_movemask_ps(outside) & 0xF;
+}
+
+int AABBBlockSSE(const Plane* planes, int num_planes, const AABBSoA& b, int i)
+{
+    __m128 half  = _mm_set1_ps(0.5f);
+    __m128 min_x = _mm_loadu_ps(b.min_x.data() + i);
+    __m128 min_y = _mm_loadu_ps(b.min_y.data() + i);
+    __m128 min_z = _mm_loadu_ps(b.min_z.data() + i);
+    __m128 max_x = _mm_loadu_ps(b.max_x.data() + i);
+    __m128 max_y = _mm_loadu_ps(b.max_y.data() + i);
+    __m128 max_z = _mm_loadu_ps(b.max_z.data() + i);
+
+    __m128 cx = _mm_mul_ps(_mm_add_ps(min_x, max_x), half);
+    __m128 cy = _mm_mul_ps(_mm_add_ps(min_y, max_y), half);
+    __m128 cz = _mm_mul_ps(_mm_add_ps(min_z, max_z), half);
+    __m128 ex = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+    __m128 ey = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+    __m128 ez = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < num_planes; ++p)
+    {
+        const vec3& n = planes[p].normal;
+        __m128 dist   = _mm_sub_ps(Dot(cx, cy, cz, n), _mm_set1_ps(planes[p].d));
+        __m128 radius = Dot(ex, ey, ez, n.cwiseAbs());
+        outside       = _mm_or_ps(outside, _mm_cmpge_ps(dist, radius));
+        if (_mm_movemask_ps(outside) == 0xF) break;
+    }
+    return ~_mm_movemask_ps(outside) & 0xF;
+}
+#endif
+
+template <typename Block>
+void CullMask(int n, Block block, std::vector<uint32_t>& mask)
+{
+    mask.assign(iDivUp(n, 32), 0);
+    for (int i = 0; i < n; i += 4)
+    {
+        mask[i / 32] |= uint32_t(block(i)) << (i % 32);
+    }
+    // Remove the padding
+    if (n % 32 != 0) mask.back() &= (1u << (n % 32)) - 1;
+}
+
+template <typename Block>
+int CullIndices(int n, Block block, std::vector<int>& indices)
+{
+    indices.resize(iAlignUp(n, 4));
+    int count = 0;
+    for (int i = 0; i < n; i += 4)
+    {
+        int bits = block(i);
+        if (i + 4 > n) bits &= (1 << (n - i)) - 1;
+        // Branchless compaction. count <= i + k, so this never writes past the padded size.
+        for (int k = 0; k < 4; ++k)
+        {
+            indices[count] = i + k;
+            count += (bits >> k) & 1;
+        }
+    }
+    indices.resize(count);
+    return count;
+}
+
+}  // namespace
+
+void FrustumCullMask(const Plane* planes, int num_planes, const SphereSoA& spheres, std::vector<uint32_t>& mask)
+{
+#ifdef SAIGA_HAS_X86_SIMD
+    if (simdEnabled())
+    {
+        CullMask(spheres.size(), [&](int i) { return SphereBlockSSE(planes, num_planes, spheres, i); }, mask);
+        return;
+    }
+#endif
+    CullMask(spheres.size(), [&](int i) { return SphereBlockScalar(planes, num_planes, spheres, i); }, mask);
+}
+
+void FrustumCullMask(const Plane* planes, int num_planes, const AABBSoA& boxes, std::vector<uint32_t>& mask)
+{
+#ifdef SAIGA_HAS_X86_SIMD
+    if (simdEnabled())
+    {
+        CullMask(boxes.size(), [&](int i) { return AABBBlockSSE(planes, num_planes, boxes, i); }, mask);
+        return;
+    }
+#endif
+    CullMask(boxes.size(), [&](int i) { return AABBBlockScalar(planes, num_planes, boxes, i); }, mask);
+}
+
+int FrustumCullIndices(const Plane* planes, int num_planes, const SphereSoA& spheres, std::vector<int>& indices)
+{
+#ifdef SAIGA_HAS_X86_SIMD
+    if (simdEnabled())
+    {
+        auto block = [&](int i) { return SphereBlockSSE(planes, num_planes, spheres, i); };
+        return CullIndices(spheres.size(), block, indices);
+    }
+#endif
+    auto block = [&](int i) { return SphereBlockScalar(planes, num_planes, spheres, i); };
+    return CullIndices(spheres.size(), block, indices);
+}
+
+int FrustumCullIndices(const Plane* planes, int num_planes, const AABBSoA& boxes, std::vector<int>& indices)
+{
+#ifdef SAIGA_HAS_X86_SIMD
+    if (simdEnabled())
+    {
+        auto block = [&](int i) { return AABBBlockSSE(planes, num_planes, boxes, i); };
+        return CullIndices(boxes.size(), block, indices);
+    }
+#endif
+    auto block = [&](int i) { return AABBBlockScalar(planes, num_planes, boxes, i); };
+    return CullIndices(boxes.size(), block, indices);
+}
+
+void PlaneDistances(const PlaneSoA& planes, const vec3& p, float* out)
+{
+    int padded = planes.paddedSize();
+#ifdef SAIGA_HAS_X86_SIMD
+    if (simdEnabled())
+    {
+        __m128 px = _mm_set1_ps(p.x());
+        __m128 py = _mm_set1_ps(p.y());
+        __m128 pz = _mm_set1_ps(p.z());
+        for (int i = 0; i < padded; i += 4)
+        {
+            __m128 nx = _mm_loadu_ps(planes.nx.data() + i);
+            __m128 ny = _mm_loadu_ps(planes.ny.data() + i);
+            __m128 nz = _mm_loadu_ps(planes.nz.data() + i);
+            __m128 d  = _mm_loadu_ps(planes.d.data() + i);
+            __m128 r  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, nx), _mm_mul_ps(py, ny)), _mm_mul_ps(pz, nz));
+            _mm_storeu_ps(out + i, _mm_sub_ps(r, d));
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < padded; ++i)
+    {
+        out[i] = (p.x() * planes.nx[i] + p.y() * planes.ny[i] + p.z() * planes.nz[i]) - planes.d[i];
+    }
+}
+
+}  // namespace Saiga
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+#include "saiga/core/geometry/Frustum.h"
+#include "saiga/core/geometry/aabb.h"
+#include "saiga/core/geometry/plane.h"
+#include "saiga/core/geometry/sphere.h"
+
+#include <vector>
+
+namespace Saiga
+{
+/**
+ * Batched culling of many objects against a frustum (or any convex set of planes).
+ *
+ * The objects are stored as structure of arrays, so that 4 objects are tested against one plane with a single SSE
+ * instruction. All arrays are padded to a multiple of 4. The padding is never reported as visible.
+ *
+ * The results are either a bitmask (bit i%32 of mask[i/32] is set if object i is visible) or a compacted list of the
+ * visible indices. An object is visible if it is not completely on the positive side of any plane. For spheres this
+ * is the same test as Frustum::sphereInFrustum(s) != OUTSIDE.
+ *
+ *   SphereSoA spheres;
+ *   for (auto& l : lights) spheres.push_back(Sphere(l.position, l.radius));
+ *   std::vector<int> visible;
+ *   FrustumCullIndices(camera, spheres, visible);
+ */
+class SAIGA_CORE_API SphereSoA
+{
+   public:
+    std::vector<float> x, y, z, r;
+
+    SphereSoA() {}
+    SphereSoA(const std::vector<Sphere>& spheres);
+
+    int size() const { return n; }
+    int paddedSize() const { return x.size(); }
+
+    void clear() { resize(0); }
+    void resize(int new_size);
+    void reserve(int capacity);
+
+    void push_back(const Sphere& s);
+    void set(int i, const Sphere& s);
+    Sphere get(int i) const { return Sphere(vec3(x[i], y[i], z[i]), r[i]); }
+
+   private:
+    int n = 0;
+};
+
+class SAIGA_CORE_API AABBSoA
+{
+   public:
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+
+    AABBSoA() {}
+    AABBSoA(const std::vector<AABB>& boxes);
+
+    int size() const { return n; }
+    int paddedSize() const { return min_x.size(); }
+
+    void clear() { resize(0); }
+    void resize(int new_size);
+    void reserve(int capacity);
+
+    void push_back(const AABB& box);
+    void set(int i, const AABB& box);
+    AABB get(int i) const
+    {
+        return AABB(vec3(min_x[i], min_y[i], min_z[i]), vec3(max_x[i], max_y[i], max_z[i]));
+    }
+
+   private:
+    int n = 0;
+};
+
+// Plane equations as structure of arrays.
+// Used to evaluate one point against many planes, for example the slice planes of a light clusterer.
+class SAIGA_CORE_API PlaneSoA
+{
+   public:
+    std::vector<float> nx, ny, nz, d;
+
+    PlaneSoA() {}
+    PlaneSoA(const std::vector<Plane>& planes);
+
+    int size() const { return n; }
+    int paddedSize() const { return nx.size(); }
+
+    void clear() { resize(0); }
+    void resize(int new_size);
+
+    void push_back(const Plane& p);
+    void set(int i, const Plane& p);
+
+   private:
+    int n = 0;
+};
+
+// Returns true if bit i is set in the mask computed by FrustumCullMask.
+inline bool MaskBit(const std::vector<uint32_t>& mask, int i)
+{
+    return (mask[i / 32] >> (i % 32)) & 1;
+}
+
+// Bitmask of the visible objects. The mask is resized to (size + 31) / 32 words.
+SAIGA_CORE_API void FrustumCullMask(const Plane* planes, int num_planes, const SphereSoA& spheres,
+                                    std::vector<uint32_t>& mask);
+SAIGA_CORE_API void FrustumCullMask(const Plane* planes, int num_planes, const AABBSoA& boxes,
+                                    std::vector<uint32_t>& mask);
+
+// Compacted indices of the visible objects in increasing order. Returns the number of visible objects.
+SAIGA_CORE_API int FrustumCullIndices(const Plane* planes, int num_planes, const SphereSoA& spheres,
+                                      std::vector<int>& indices);
+SAIGA_CORE_API int FrustumCullIndices(const Plane* planes, int num_planes, const AABBSoA& boxes,
+                                      std::vector<int>& indices);
+
+inline void FrustumCullMask(const Frustum& frustum, const SphereSoA& spheres, std::vector<uint32_t>& mask)
+{
+    FrustumCullMask(frustum.planes.data(), frustum.planes.size(), spheres, mask);
+}
+inline void FrustumCullMask(const Frustum& frustum, const AABBSoA& boxes, std::vector<uint32_t>& mask)
+{
+    FrustumCullMask(frustum.planes.data(), frustum.planes.size(), boxes, mask);
+}
+inline int FrustumCullIndices(const Frustum& frustum, const SphereSoA& spheres, std::vector<int>& indices)
+{
+    return FrustumCullIndices(frustum.planes.data(), frustum.planes.size(), spheres, indices);
+}
+inline int FrustumCullIndices(const Frustum& frustum, const AABBSoA& boxes, std::vector<int>& indices)
+{
+    return FrustumCullIndices(frustum.planes.data(), frustum.planes.size(), boxes, indices);
+}
+
+// Signed distance of p to all planes: out[i] = planes[i].distance(p).
+// 'out' must have space for planes.paddedSize() elements.
+SAIGA_CORE_API void PlaneDistances(const PlaneSoA& planes, const vec3& p, float* out);
+
+}  // namespace Saiga
@@ -103,6 +103,25 @@ Frustum::IntersectionResult Frustum::sphereInFrustum(const Sphere& s) const
     return result;
 }
 
+Frustum::IntersectionResult Frustum::aabbInFrustum(const AABB& box) const
+{
+    IntersectionResult result = INSIDE;
+    vec3 center               = (box.min + box.max) * 0.5f;
+    vec3 extent               = (box.max - box.min) * 0.5f;
+
+    for (int i = 0; i < 6; i++)
+    {
+        // Distance of the center and projected radius of the box
+        float distance = planes[i].distance(center);
+        float radius   = planes[i].normal.cwiseAbs().dot(extent);
+        if (distance >= radius)
+            return OUTSIDE;
+        else if (distance > -radius)
+            result = INTERSECT;
+    }
+    return result;
+}
+
 Frustum::IntersectionResult Frustum::pointInSphereFrustum(const vec3& p) const
 {
     if (boundingSphere.contains(p))
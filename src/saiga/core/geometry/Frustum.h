@@ -57,6 +57,8 @@ class SAIGA_CORE_API Frustum
     // culling stuff
     IntersectionResult pointInFrustum(const vec3& p) const;
     IntersectionResult sphereInFrustum(const Sphere& s) const;
+    // Conservative test: The box is only OUTSIDE if it is completely on the positive side of one plane.
+    IntersectionResult aabbInFrustum(const AABB& box) const;
 
     IntersectionResult pointInSphereFrustum(const vec3& p) const;
     IntersectionResult sphereInSphereFrustum(const Sphere& s) const;
@@ -0,0 +1,837 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/core/geometry/half_edge_mesh.h"
+#include "saiga/core/util/Thread/omp.h"
+
+#include <limits>
+#include <type_traits>
+
+namespace Saiga
+{
+struct QuadricDecimationSettings
+{
+    // Stop if the mesh has at most this number of faces. 0 means no limit.
+    int target_faces = 0;
+
+    // Stop if the cheapest collapse has a larger error. The error is the (area weighted) sum of squared distances to
+    // the planes of the original faces.
+    float max_error = std::numeric_limits<float>::infinity();
+
+    // Weight of the virtual planes through boundary edges, which are perpendicular to the adjacent face.
+    // Large values keep the boundary in place. 0 disables the boundary preservation.
+    float boundary_weight = 1000;
+
+    // Boundary vertices are neither moved nor removed.
+    bool lock_boundary = false;
+
+    // Collapses, which rotate a face normal by more than acos(min_normal_dot), are rejected.
+    // This prevents fold overs and flipped triangles.
+    float min_normal_dot = 0.2;
+
+    // Move the remaining vertex to the minimum of the quadric. Otherwise the better end point is used.
+    bool optimal_placement = true;
+};
+
+/**
+ * Symmetric 4x4 error quadric of [Garland and Heckbert 1997].
+ * The error of a point p is [p,1]^T Q [p,1].
+ */
+struct Quadric
+{
+    // Upper triangle of Q in row major order
+    double a[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    Quadric() {}
+
+    // The squared distance to the plane n^T p + d = 0, scaled by 'weight'.
+    Quadric(const Vec3& n, double d, double weight)
+    {
+        a[0] = weight * n(0) * n(0);
+        a[1] = weight * n(0) * n(1);
+        a[2] = weight * n(0) * n(2);
+        a[3] = weight * n(0) * d;
+        a[4] = weight * n(1) * n(1);
+        a[5] = weight * n(1) * n(2);
+        a[6] = weight * n(1) * d;
+        a[7] = weight * n(2) * n(2);
+        a[8] = weight * n(2) * d;
+        a[9] = weight * d * d;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for (int i = 0; i < 10; ++i) a[i] += other.a[i];
+        return *this;
+    }
+
+    Quadric operator+(const Quadric& other) const
+    {
+        Quadric result = *this;
+        result += other;
+        return result;
+    }
+
+    double Error(const Vec3& p) const
+    {
+        double x = p(0), y = p(1), z = p(2);
+        double e = a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x + a[4] * y * y +
+                   2 * a[5] * y * z + 2 * a[6] * y + a[7] * z * z + 2 * a[8] * z + a[9];
+        return std::max(e, 0.0);
+    }
+
+    // Computes the point with the smallest error. Returns false if the system is (nearly) singular, for example if all
+    // planes are parallel.
+    bool Minimum(Vec3& p) const
+    {
+        Mat3 A;
+        A << a[0], a[1], a[2], a[1], a[4], a[5], a[2], a[5], a[7];
+        double det   = A.determinant();
+        double scale = A.diagonal().sum();
+        if (!(std::abs(det) > 1e-10 * scale * scale * scale)) return false;
+        p = -(A.inverse() * Vec3(a[3], a[6], a[8]));
+        return true;
+    }
+};
+
+namespace DecimationDetail
+{
+template <typename T, typename = void>
+struct HasNormal : std::false_type
+{
+};
+template <typename T>
+struct HasNormal<T, std::void_t<decltype(std::declval<T>().normal)>> : std::true_type
+{
+};
+template <typename T, typename = void>
+struct HasColor : std::false_type
+{
+};
+template <typename T>
+struct HasColor<T, std::void_t<decltype(std::declval<T>().color)>> : std::true_type
+{
+};
+template <typename T, typename = void>
+struct HasTexture : std::false_type
+{
+};
+template <typename T>
+struct HasTexture<T, std::void_t<decltype(std::declval<T>().texture)>> : std::true_type
+{
+};
+template <typename T, typename = void>
+struct HasData : std::false_type
+{
+};
+template <typename T>
+struct HasData<T, std::void_t<decltype(std::declval<T>().data)>> : std::true_type
+{
+};
+}  // namespace DecimationDetail
+
+/**
+ * Linear interpolation of the vertex attributes (normal, color, texture, data) from a (t=0) to b (t=1).
+ * All other members are copied from the closer vertex. The normal is normalized again.
+ */
+template <typename vertex_t>
+vertex_t InterpolateVertexAttributes(const vertex_t& a, const vertex_t& b, float t)
+{
+    vertex_t result = (t < 0.5f) ? a : b;
+    if constexpr (DecimationDetail::HasNormal<vertex_t>::value)
+    {
+        vec3 n        = make_vec3(a.normal) * (1 - t) + make_vec3(b.normal) * t;
+        float length  = n.norm();
+        result.normal = make_vec4(length > 0 ? vec3(n / length) : make_vec3(result.normal), result.normal[3]);
+    }
+    if constexpr (DecimationDetail::HasColor<vertex_t>::value) result.color = a.color * (1 - t) + b.color * t;
+    if constexpr (DecimationDetail::HasTexture<vertex_t>::value) result.texture = a.texture * (1 - t) + b.texture * t;
+    if constexpr (DecimationDetail::HasData<vertex_t>::value) result.data = a.data * (1 - t) + b.data * t;
+    return result;
+}
+
+/**
+ * Mesh simplification with the quadric error metric [Garland and Heckbert 1997].
+ *
+ * All edges are stored in a priority queue (indexed binary heap) ordered by their collapse error. The cheapest edge is
+ * collapsed with HalfEdgeMesh::halfEdgeCollapse and the errors of the edges around the remaining vertex are updated in
+ * place. Therefore the heap never contains more entries than edges.
+ *
+ * A collapse is only performed if it keeps the mesh manifold (link condition) and does not flip a face.
+ * Boundaries are preserved with additional perpendicular planes at the boundary edges. The vertex attributes are
+ * interpolated at the new position (see InterpolateVertexAttributes).
+ *
+ * Usage:
+ *   HalfEdgeMesh<VertexNC, uint32_t> hem(mesh);
+ *   QuadricDecimation<VertexNC, uint32_t> decimation(hem, settings);
+ *   decimation.decimate();
+ *   hem.toIFS(mesh);
+ *   mesh.removeUnusedVertices();
+ */
+template <typename vertex_t, typename index_t>
+class QuadricDecimation
+{
+   public:
+    using MeshType = HalfEdgeMesh<vertex_t, index_t>;
+
+    QuadricDecimation(MeshType& mesh, const QuadricDecimationSettings& settings);
+
+    // The vertex will neither be moved nor removed. Must be called before decimate().
+    void lockVertex(int vertex) { locked[vertex] = true; }
+
+    // Use these quadrics instead of computing them from the faces, for example to continue a previous decimation.
+    // Must be called before decimate().
+    void setQuadrics(std::vector<Quadric> vertex_quadrics) { quadrics = std::move(vertex_quadrics); }
+
+    // The accumulated quadric of every vertex. Valid after decimate().
+    const std::vector<Quadric>& vertexQuadrics() const { return quadrics; }
+
+    // Returns the number of collapsed edges.
+    int decimate();
+
+    void setTargetFaces(int target_faces) { settings.target_faces = target_faces; }
+
+    int numFaces() const { return num_faces; }
+
+   private:
+    struct Collapse
+    {
+        float error;
+        // The start vertex of 'he' remains
+        int he;
+        vec3 target;
+    };
+
+    MeshType& mesh;
+    QuadricDecimationSettings settings;
+
+    std::vector<Quadric> quadrics;
+    std::vector<vec3> positions;
+    std::vector<char> locked;
+    int num_faces    = 0;
+    bool initialized = false;
+
+    // Min-heap of (error, edge). An edge is identified by its smaller half edge index (see edgeId).
+    std::vector<std::pair<float, int>> heap;
+    // The position of every half edge in the heap or -1
+    std::vector<int> heap_position;
+
+    // Temporary buffers for the legality test
+    std::vector<int> ring1, ring2;
+
+    // Computes the quadrics and the collapses of all edges. Called by the first decimate(), because both depend on the
+    // locked vertices.
+    void computeQuadrics();
+    void initQueue();
+    bool computeCollapse(int he, Collapse& result) const;
+    bool isLegal(const Collapse& c);
+    void collapse(const Collapse& c);
+
+    int edgeId(int he) const
+    {
+        int op = mesh.edgeList[he].oppositeHalfEdge;
+        return (op != -1 && op < he) ? op : he;
+    }
+
+    // Recomputes the collapse of the edge and moves it to the correct position in the heap
+    void updateEdge(int he);
+    void heapUpdate(int he, float error);
+    void heapRemove(int he);
+    void siftUp(int i);
+    void siftDown(int i);
+
+    // The neighbours of the vertex (sorted). Returns true if the vertex is on the boundary.
+    bool ring(int vertex, std::vector<int>& neighbours) const;
+    vec3 faceNormal(int f) const;
+};
+
+template <typename vertex_t, typename index_t>
+QuadricDecimation<vertex_t, index_t>::QuadricDecimation(MeshType& mesh, const QuadricDecimationSettings& settings)
+    : mesh(mesh), settings(settings)
+{
+    int num_vertices = mesh.vertices.size();
+    positions.resize(num_vertices);
+    locked.resize(num_vertices, false);
+
+    for (auto& f : mesh.faces) num_faces += f.valid;
+
+    // Vertices with more than one fan (non-manifold) are only partially reachable by forEachOutgoing
+    std::vector<int> valence(num_vertices, 0);
+    for (int he = 0; he < (int)mesh.edgeList.size(); ++he)
+    {
+        if (mesh.validHalfEdge(he)) valence[mesh.edgeList[he].vertex]++;
+    }
+
+#pragma omp parallel for
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        positions[v] = make_vec3(mesh.vertices[v].v.position);
+        if (!mesh.vertices[v].valid) continue;
+
+        int count     = 0;
+        bool boundary = false;
+        mesh.forEachOutgoing(v, [&](int he) {
+            count++;
+            boundary |= mesh.edgeList[he].boundary() || mesh.edgeList[MeshType::prevHalfEdge(he)].boundary();
+        });
+        if (count != valence[v] || (settings.lock_boundary && boundary)) locked[v] = true;
+    }
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::computeQuadrics()
+{
+    int num_vertices = mesh.vertices.size();
+    quadrics.resize(num_vertices);
+
+#pragma omp parallel for
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        if (!mesh.vertices[v].valid) continue;
+
+        Quadric q;
+        mesh.forEachOutgoing(v, [&](int he) {
+            int f  = MeshType::face(he);
+            Vec3 a = positions[mesh.edgeList[f * 3].vertex].template cast<double>();
+            Vec3 b = positions[mesh.edgeList[f * 3 + 1].vertex].template cast<double>();
+            Vec3 c = positions[mesh.edgeList[f * 3 + 2].vertex].template cast<double>();
+
+            Vec3 n      = (b - a).cross(c - a);
+            double area = n.norm() * 0.5;
+            if (area <= 0) return;
+            n /= area * 2;
+            q += Quadric(n, -n.dot(a), area);
+
+            // Perpendicular planes through the boundary edges of this face, which are adjacent to v.
+            // Edges between two locked vertices can not change and are skipped. This includes the seams of
+            // QuadricDecimateParallel, which are not a boundary of the complete mesh.
+            for (int e : {he, MeshType::prevHalfEdge(he)})
+            {
+                int from_vertex = mesh.fromVertex(e);
+                int to_vertex   = mesh.edgeList[e].vertex;
+                if (!mesh.edgeList[e].boundary() || (locked[from_vertex] && locked[to_vertex])) continue;
+                Vec3 from = positions[from_vertex].template cast<double>();
+                Vec3 to   = positions[to_vertex].template cast<double>();
+                Vec3 d    = to - from;
+                Vec3 m    = d.cross(n);
+                double l  = m.norm();
+                if (l <= 0) continue;
+                m /= l;
+                q += Quadric(m, -m.dot(from), settings.boundary_weight * d.squaredNorm());
+            }
+        });
+        quadrics[v] = q;
+    }
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::initQueue()
+{
+    if (quadrics.empty()) computeQuadrics();
+    SAIGA_ASSERT(quadrics.size() == mesh.vertices.size());
+
+    // Every edge once. Boundary edges only have one half edge.
+    // The error is negative for edges, which can not be collapsed.
+    std::vector<float> errors(mesh.edgeList.size(), -1);
+#pragma omp parallel for
+    for (int he = 0; he < (int)mesh.edgeList.size(); ++he)
+    {
+        if (!mesh.validHalfEdge(he) || edgeId(he) != he) continue;
+        Collapse c;
+        if (computeCollapse(he, c)) errors[he] = c.error;
+    }
+
+    for (int he = 0; he < (int)errors.size(); ++he)
+    {
+        if (errors[he] >= 0) heap.emplace_back(errors[he], he);
+    }
+    std::make_heap(heap.begin(), heap.end(), [](auto a, auto b) { return a.first > b.first; });
+
+    heap_position.resize(mesh.edgeList.size(), -1);
+    for (int i = 0; i < (int)heap.size(); ++i) heap_position[heap[i].second] = i;
+    initialized = true;
+}
+
+template <typename vertex_t, typename index_t>
+int QuadricDecimation<vertex_t, index_t>::decimate()
+{
+    if (!initialized) initQueue();
+
+    int collapses = 0;
+    while (!heap.empty() && num_faces > settings.target_faces)
+    {
+        if (heap.front().first > settings.max_error) break;
+        int he = heap.front().second;
+        heapRemove(he);
+
+        // The edge is inserted again if its neighbourhood changes
+        Collapse c;
+        if (!computeCollapse(he, c) || !isLegal(c)) continue;
+        collapse(c);
+        collapses++;
+    }
+    return collapses;
+}
+
+template <typename vertex_t, typename index_t>
+bool QuadricDecimation<vertex_t, index_t>::computeCollapse(int he, Collapse& result) const
+{
+    int v1 = mesh.fromVertex(he);
+    int v2 = mesh.edgeList[he].vertex;
+    if (locked[v1] && locked[v2]) return false;
+
+    // halfEdgeCollapse keeps the start vertex. Boundary edges can only be collapsed in one direction.
+    if (locked[v2])
+    {
+        he = mesh.edgeList[he].oppositeHalfEdge;
+        if (he == -1) return false;
+        std::swap(v1, v2);
+    }
+
+    Quadric q = quadrics[v1] + quadrics[v2];
+    Vec3 p1   = positions[v1].template cast<double>();
+    Vec3 p2   = positions[v2].template cast<double>();
+
+    Vec3 target;
+    bool found = false;
+    if (locked[v1])
+    {
+        target = p1;
+        found  = true;
+    }
+    else if (settings.optimal_placement && q.Minimum(target))
+    {
+        // Reject solutions far away from the edge, which occur for almost singular systems
+        found = (target - (p1 + p2) * 0.5).squaredNorm() <= (p2 - p1).squaredNorm();
+    }
+
+    if (!found)
+    {
+        target = (q.Error(p1) <= q.Error(p2)) ? p1 : p2;
+        Vec3 m = (p1 + p2) * 0.5;
+        if (!locked[v1] && q.Error(m) < q.Error(target)) target = m;
+    }
+
+    result.error  = q.Error(target);
+    result.he     = he;
+    result.target = target.cast<float>();
+    return true;
+}
+
+template <typename vertex_t, typename index_t>
+bool QuadricDecimation<vertex_t, index_t>::ring(int vertex, std::vector<int>& neighbours) const
+{
+    neighbours.clear();
+    bool boundary = false;
+    mesh.forEachOutgoing(vertex, [&](int he) {
+        neighbours.push_back(mesh.edgeList[he].vertex);
+        int prev = MeshType::prevHalfEdge(he);
+        if (mesh.edgeList[prev].boundary())
+        {
+            boundary = true;
+            neighbours.push_back(mesh.fromVertex(prev));
+        }
+        boundary |= mesh.edgeList[he].boundary();
+    });
+    std::sort(neighbours.begin(), neighbours.end());
+    return boundary;
+}
+
+template <typename vertex_t, typename index_t>
+vec3 QuadricDecimation<vertex_t, index_t>::faceNormal(int f) const
+{
+    vec3 a = positions[mesh.edgeList[f * 3].vertex];
+    vec3 b = positions[mesh.edgeList[f * 3 + 1].vertex];
+    vec3 c = positions[mesh.edgeList[f * 3 + 2].vertex];
+    return (b - a).cross(c - a);
+}
+
+template <typename vertex_t, typename index_t>
+bool QuadricDecimation<vertex_t, index_t>::isLegal(const Collapse& c)
+{
+    int he = c.he;
+    int op = mesh.edgeList[he].oppositeHalfEdge;
+    int v1 = mesh.fromVertex(he);
+    int v2 = mesh.edgeList[he].vertex;
+
+    // A face with 3 boundary edges would leave an isolated vertex
+    for (int e : {he, op})
+    {
+        if (e == -1) continue;
+        if (mesh.edgeList[MeshType::nextHalfEdge(e)].boundary() && mesh.edgeList[MeshType::prevHalfEdge(e)].boundary())
+            return false;
+    }
+
+    // Link condition: The common neighbours of v1 and v2 must be exactly the opposite vertices of the removed faces.
+    bool boundary1 = ring(v1, ring1);
+    bool boundary2 = ring(v2, ring2);
+    int common     = 0;
+    for (int i = 0, j = 0; i < (int)ring1.size() && j < (int)ring2.size();)
+    {
+        if (ring1[i] < ring2[j])
+        {
+            ++i;
+        }
+        else if (ring1[i] > ring2[j])
+        {
+            ++j;
+        }
+        else
+        {
+            common++;
+            ++i;
+            ++j;
+        }
+    }
+    int expected = (op == -1) ? 1 : 2;
+    if (common != expected) return false;
+
+    // An inner edge between two boundary vertices would pinch the surface
+    if (op != -1 && boundary1 && boundary2) return false;
+
+    // Do not collapse closed meshes to a tetrahedron or smaller
+    if (op != -1 && (int)(ring1.size() + ring2.size()) - common - 2 < 3) return false;
+
+    // The remaining faces must not flip or degenerate
+    bool legal = true;
+    for (int v : {v1, v2})
+    {
+        mesh.forEachOutgoing(v, [&](int e) {
+            int f = MeshType::face(e);
+            if (!legal || f == MeshType::face(he) || (op != -1 && f == MeshType::face(op))) return;
+            vec3 n_old = faceNormal(f);
+            vec3 p[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                int vk = mesh.edgeList[f * 3 + k].vertex;
+                p[k]   = (vk == v1 || vk == v2) ? c.target : positions[vk];
+            }
+            vec3 n_new = (p[1] - p[0]).cross(p[2] - p[0]);
+            float l    = n_new.norm() * n_old.norm();
+            if (!(l > 0) || n_new.dot(n_old) < settings.min_normal_dot * l) legal = false;
+        });
+    }
+    return legal;
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::collapse(const Collapse& c)
+{
+    int he = c.he;
+    int v1 = mesh.fromVertex(he);
+    int v2 = mesh.edgeList[he].vertex;
+
+    // Interpolate the attributes at the projection of the new position onto the edge
+    vec3 d    = positions[v2] - positions[v1];
+    float dd  = d.squaredNorm();
+    float t   = dd > 0 ? std::clamp((c.target - positions[v1]).dot(d) / dd, 0.0f, 1.0f) : 0.0f;
+    auto& dst = mesh.vertices[v1].v;
+    float w   = dst.position[3];
+    dst       = InterpolateVertexAttributes(mesh.vertices[v1].v, mesh.vertices[v2].v, t);
+    dst.position = make_vec4(c.target, w);
+
+    positions[v1] = c.target;
+    quadrics[v1] += quadrics[v2];
+
+    // Remove the edges of the removed faces
+    int op = mesh.edgeList[he].oppositeHalfEdge;
+    for (int e : {he, op})
+    {
+        if (e == -1) continue;
+        int f = MeshType::face(e);
+        for (int k = 0; k < 3; ++k) heapRemove(f * 3 + k);
+        num_faces--;
+    }
+
+    mesh.halfEdgeCollapse(he);
+
+    // Update all edges around the remaining vertex
+    mesh.forEachOutgoing(v1, [&](int e) {
+        updateEdge(e);
+        int prev = MeshType::prevHalfEdge(e);
+        if (mesh.edgeList[prev].boundary()) updateEdge(prev);
+    });
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::updateEdge(int he)
+{
+    // The opposite links change during a collapse. The entry of the other half edge is outdated.
+    int id = edgeId(he);
+    int op = mesh.edgeList[id].oppositeHalfEdge;
+    if (op != -1) heapRemove(op);
+
+    Collapse c;
+    if (computeCollapse(id, c))
+    {
+        heapUpdate(id, c.error);
+    }
+    else
+    {
+        heapRemove(id);
+    }
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::heapUpdate(int he, float error)
+{
+    int i = heap_position[he];
+    if (i == -1)
+    {
+        heap.emplace_back(error, he);
+        siftUp(heap.size() - 1);
+        return;
+    }
+    float old     = heap[i].first;
+    heap[i].first = error;
+    if (error < old)
+    {
+        siftUp(i);
+    }
+    else
+    {
+        siftDown(i);
+    }
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::heapRemove(int he)
+{
+    int i = heap_position[he];
+    if (i == -1) return;
+    heap_position[he] = -1;
+
+    auto last = heap.back();
+    heap.pop_back();
+    if (i == (int)heap.size()) return;
+
+    heap[i]                    = last;
+    heap_position[last.second] = i;
+    siftUp(i);
+    siftDown(heap_position[last.second]);
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::siftUp(int i)
+{
+    auto e = heap[i];
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (heap[parent].first <= e.first) break;
+        heap[i]                       = heap[parent];
+        heap_position[heap[i].second] = i;
+        i                             = parent;
+    }
+    heap[i]                 = e;
+    heap_position[e.second] = i;
+}
+
+template <typename vertex_t, typename index_t>
+void QuadricDecimation<vertex_t, index_t>::siftDown(int i)
+{
+    auto e = heap[i];
+    int n  = heap.size();
+    while (true)
+    {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap[child + 1].first < heap[child].first) ++child;
+        if (heap[child].first >= e.first) break;
+        heap[i]                       = heap[child];
+        heap_position[heap[i].second] = i;
+        i                             = child;
+    }
+    heap[i]                 = e;
+    heap_position[e.second] = i;
+}
+
+/**
+ * Simplifies a triangle mesh with QuadricDecimation.
+ * Unused vertices are removed afterwards.
+ */
+template <typename vertex_t, typename index_t>
+void QuadricDecimate(TriangleMesh<vertex_t, index_t>& mesh, const QuadricDecimationSettings& settings)
+{
+    HalfEdgeMesh<vertex_t, index_t> hem(mesh);
+    QuadricDecimation<vertex_t, index_t> decimation(hem, settings);
+    decimation.decimate();
+    hem.toIFS(mesh);
+    mesh.removeUnusedVertices();
+}
+
+/**
+ * Parallel version of QuadricDecimate for large meshes.
+ *
+ * The faces are partitioned into chunks_per_axis^3 spatial chunks, which are decimated independently and in parallel.
+ * The vertices on the seams between chunks are locked, so the chunks can be stitched together exactly. The seams are
+ * then removed by a final (serial) pass on the already reduced mesh, which continues with the accumulated quadrics of
+ * the chunks. Each chunk is reduced by the ratio target_faces / faces.
+ */
+template <typename vertex_t, typename index_t>
+void QuadricDecimateParallel(TriangleMesh<vertex_t, index_t>& mesh, const QuadricDecimationSettings& settings,
+                             int chunks_per_axis = 4)
+{
+    using Face = typename TriangleMesh<vertex_t, index_t>::Face;
+
+    int num_faces    = mesh.faces.size();
+    int num_vertices = mesh.vertices.size();
+    int k            = chunks_per_axis;
+    int num_chunks   = k * k * k;
+    if (k <= 1 || num_faces == 0)
+    {
+        QuadricDecimate(mesh, settings);
+        return;
+    }
+
+    // Assign the faces to chunks by their centroid and sort them by chunk
+    AABB box    = mesh.aabb();
+    vec3 extent = (box.max - box.min).cwiseMax(vec3(1e-10, 1e-10, 1e-10));
+    std::vector<int> face_chunk(num_faces);
+#pragma omp parallel for
+    for (int i = 0; i < num_faces; ++i)
+    {
+        auto& f  = mesh.faces[i];
+        vec3 c   = (make_vec3(mesh.vertices[f(0)].position) + make_vec3(mesh.vertices[f(1)].position) +
+                  make_vec3(mesh.vertices[f(2)].position)) /
+                 3.0f;
+        ivec3 id = ((c - box.min).array() / extent.array() * k).template cast<int>();
+        id       = id.cwiseMax(ivec3(0, 0, 0)).cwiseMin(ivec3(k - 1, k - 1, k - 1));
+        face_chunk[i] = (id.z() * k + id.y()) * k + id.x();
+    }
+
+    std::vector<int> chunk_offset(num_chunks + 1, 0);
+    for (int c : face_chunk) chunk_offset[c + 1]++;
+    for (int c = 0; c < num_chunks; ++c) chunk_offset[c + 1] += chunk_offset[c];
+    std::vector<int> chunk_faces(num_faces);
+    {
+        std::vector<int> pos(chunk_offset.begin(), chunk_offset.end() - 1);
+        for (int i = 0; i < num_faces; ++i) chunk_faces[pos[face_chunk[i]]++] = i;
+    }
+
+    // Vertices referenced by more than one chunk are on a seam (-2)
+    std::vector<int> owner(num_vertices, -1);
+    for (int i = 0; i < num_faces; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            int& o = owner[mesh.faces[i](j)];
+            o      = (o == -1 || o == face_chunk[i]) ? face_chunk[i] : -2;
+        }
+    }
+
+    double ratio = settings.target_faces > 0 ? double(settings.target_faces) / num_faces : 0;
+
+    struct ChunkResult
+    {
+        // The global index of the local vertices
+        std::vector<int> global_index;
+        TriangleMesh<vertex_t, index_t> mesh;
+        std::vector<Quadric> quadrics;
+    };
+    std::vector<ChunkResult> results(num_chunks);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < num_chunks; ++c)
+    {
+        int begin = chunk_offset[c], end = chunk_offset[c + 1];
+        if (begin == end) continue;
+        auto& result = results[c];
+
+        auto& global_index = result.global_index;
+        for (int i = begin; i < end; ++i)
+        {
+            for (int j = 0; j < 3; ++j) global_index.push_back(mesh.faces[chunk_faces[i]](j));
+        }
+        std::sort(global_index.begin(), global_index.end());
+        global_index.erase(std::unique(global_index.begin(), global_index.end()), global_index.end());
+
+        TriangleMesh<vertex_t, index_t> local;
+        local.vertices.reserve(global_index.size());
+        for (int v : global_index) local.vertices.push_back(mesh.vertices[v]);
+        local.faces.reserve(end - begin);
+        for (int i = begin; i < end; ++i)
+        {
+            Face f = mesh.faces[chunk_faces[i]];
+            for (int j = 0; j < 3; ++j)
+            {
+                f(j) = std::lower_bound(global_index.begin(), global_index.end(), (int)f(j)) - global_index.begin();
+            }
+            local.faces.push_back(f);
+        }
+
+        HalfEdgeMesh<vertex_t, index_t> hem(local);
+        QuadricDecimation<vertex_t, index_t> decimation(hem, settings);
+        int seam_vertices = 0;
+        for (int v = 0; v < (int)global_index.size(); ++v)
+        {
+            if (owner[global_index[v]] == -2)
+            {
+                decimation.lockVertex(v);
+                seam_vertices++;
+            }
+        }
+
+        // Every seam edge keeps one face in this chunk until the final pass. Without this extra budget the inner part
+        // of the chunk would be reduced much further than the target ratio.
+        int target = int(std::ceil((end - begin) * ratio)) + seam_vertices;
+        decimation.setTargetFaces(settings.target_faces > 0 ? target : 0);
+        decimation.decimate();
+        hem.toIFS(result.mesh);
+        result.quadrics = decimation.vertexQuadrics();
+    }
+
+    // Stitch the chunks. The locked seam vertices are shared by all chunks. Every face of the input mesh belongs to
+    // exactly one chunk, so the sum of the chunk quadrics of a seam vertex is its complete quadric.
+    TriangleMesh<vertex_t, index_t> stitched;
+    std::vector<Quadric> stitched_quadrics;
+    std::vector<int> seam_index(num_vertices, -1);
+    std::vector<int> local_to_stitched;
+    for (auto& result : results)
+    {
+        auto& local = result.mesh;
+        local_to_stitched.assign(local.vertices.size(), -1);
+        for (auto& f : local.faces)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                int v = f(j);
+                if (local_to_stitched[v] == -1)
+                {
+                    int g = result.global_index[v];
+                    if (owner[g] == -2 && seam_index[g] != -1)
+                    {
+                        local_to_stitched[v] = seam_index[g];
+                        stitched_quadrics[seam_index[g]] += result.quadrics[v];
+                    }
+                    else
+                    {
+                        local_to_stitched[v] = stitched.vertices.size();
+                        stitched.vertices.push_back(local.vertices[v]);
+                        stitched_quadrics.push_back(result.quadrics[v]);
+                        if (owner[g] == -2) seam_index[g] = local_to_stitched[v];
+                    }
+                }
+                f(j) = local_to_stitched[v];
+            }
+            stitched.faces.push_back(f);
+        }
+        local.free();
+    }
+
+    // Final pass over the complete mesh, which also removes the seams
+    HalfEdgeMesh<vertex_t, index_t> hem(stitched);
+    stitched.free();
+    QuadricDecimation<vertex_t, index_t> decimation(hem, settings);
+    decimation.setQuadrics(std::move(stitched_quadrics));
+    decimation.decimate();
+    hem.toIFS(mesh);
+    mesh.removeUnusedVertices();
+}
+
+}  // namespace Saiga
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "VertexWelding.h"
+
+#include "saiga/core/util/Algorithm.h"
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace Saiga
+{
+namespace
+{
+using Cell = std::array<int64_t, 3>;
+
+inline uint64_t CellHash(const Cell& c)
+{
+    return uint64_t(c[0]) * 73856093ull ^ uint64_t(c[1]) * 19349663ull ^ uint64_t(c[2]) * 83492791ull;
+}
+
+// Lock-free union-find. Roots are only linked to smaller roots, so the root of a set is its smallest element.
+struct UnionFind
+{
+    std::unique_ptr<std::atomic<int>[]> parent;
+
+    UnionFind(int n) : parent(new std::atomic<int>[n])
+    {
+#pragma omp parallel for
+        for (int i = 0; i < n; ++i) parent[i].store(i, std::memory_order_relaxed);
+    }
+
+    int Find(int x)
+    {
+        while (true)
+        {
+            int p = parent[x].load(std::memory_order_relaxed);
+            if (p == x) return x;
+            int gp = parent[p].load(std::memory_order_relaxed);
+            // Path halving
+            if (p != gp) parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            x = gp;
+        }
+    }
+
+    void Unite(int a, int b)
+    {
+        while (true)
+        {
+            a = Find(a);
+            b = Find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            // a is the larger root -> a becomes a child of b
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+        }
+    }
+};
+}  // namespace
+
+std::vector<int> WeldPoints(ArrayView<const vec3> points, float epsilon)
+{
+    int n = points.size();
+    std::vector<int> result(n);
+    if (n == 0) return result;
+
+    // With epsilon = 0 the cell is the exact bit pattern of the position
+    auto cell_of = [&](const vec3& p) {
+        Cell c;
+        for (int d = 0; d < 3; ++d)
+        {
+            if (epsilon > 0)
+            {
+                c[d] = (int64_t)std::floor(p[d] / epsilon);
+            }
+            else
+            {
+                // +0 and -0 are the same point
+                float f = p[d] == 0 ? 0.f : p[d];
+                uint32_t bits;
+                std::memcpy(&bits, &f, sizeof(float));
+                c[d] = bits;
+            }
+        }
+        return c;
+    };
+    int r = epsilon > 0 ? 1 : 0;
+
+    // Counting sort of the points into the hash buckets
+    uint64_t num_buckets = 1;
+    while (num_buckets < 2 * uint64_t(n)) num_buckets *= 2;
+    std::vector<int> bucket(n);
+    std::vector<int> bucket_start(num_buckets + 1, 0);
+
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+    {
+        bucket[i] = CellHash(cell_of(points[i])) & (num_buckets - 1);
+#pragma omp atomic
+        bucket_start[bucket[i]]++;
+    }
+    Saiga::exclusive_scan(bucket_start.begin(), bucket_start.end(), bucket_start.begin(), 0);
+
+    std::vector<int> sorted(n);
+    {
+        std::unique_ptr<std::atomic<int>[]> cursor(new std::atomic<int>[num_buckets]);
+#pragma omp parallel for
+        for (int64_t b = 0; b < (int64_t)num_buckets; ++b) cursor[b].store(bucket_start[b], std::memory_order_relaxed);
+#pragma omp parallel for
+        for (int i = 0; i < n; ++i)
+        {
+            sorted[cursor[bucket[i]].fetch_add(1, std::memory_order_relaxed)] = i;
+        }
+    }
+
+    UnionFind uf(n);
+    float eps2 = epsilon * epsilon;
+
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (int i = 0; i < n; ++i)
+    {
+        const vec3& p = points[i];
+        Cell c        = cell_of(p);
+        for (int z = -r; z <= r; ++z)
+        {
+            for (int y = -r; y <= r; ++y)
+            {
+                for (int x = -r; x <= r; ++x)
+                {
+                    uint64_t b = CellHash({c[0] + x, c[1] + y, c[2] + z}) & (num_buckets - 1);
+                    for (int k = bucket_start[b]; k < bucket_start[b + 1]; ++k)
+                    {
+                        // Every pair is found from both sides
+                        int j = sorted[k];
+                        if (j >= i) continue;
+                        bool same = epsilon > 0 ? (points[j] - p).squaredNorm() <= eps2 : points[j] == p;
+                        if (same) uf.Unite(i, j);
+                    }
+                }
+            }
+        }
+    }
+
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+    {
+        result[i] = uf.Find(i);
+    }
+    return result;
+}
+
+}  // namespace Saiga
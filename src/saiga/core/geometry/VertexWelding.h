@@ -0,0 +1,31 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+#include "saiga/core/math/math.h"
+#include "saiga/core/util/DataStructures/ArrayView.h"
+
+#include <vector>
+
+namespace Saiga
+{
+/**
+ * Groups points that are at most 'epsilon' apart.
+ *
+ * Two points are in the same group, if they are connected by a chain of points with a distance <= epsilon (single
+ * linkage). The group id of a point is the smallest point index in its group, therefore the result is deterministic
+ * and independent of the number of threads. With epsilon = 0 only points with identical coordinates are grouped.
+ *
+ * The points are hashed into a uniform grid with cell size epsilon, so every point is only compared to the points of
+ * the 27 neighbouring cells. The groups are merged with a lock-free union-find in parallel.
+ *
+ * Returns the group id of every point.
+ */
+SAIGA_CORE_API std::vector<int> WeldPoints(ArrayView<const vec3> points, float epsilon);
+
+}  // namespace Saiga
@@ -9,6 +9,8 @@
 #include "saiga/config.h"
 
 #include "AccelerationStructure.h"
+#include "BVH4.h"
+#include "BatchCulling.h"
 #include "cone.h"
 #include "iRect.h"
 
@@ -6,39 +6,32 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
-#include <map>
 
 #include "triangle_mesh.h"
-#include <unordered_map>
 
 namespace Saiga
 {
 /*
- * Data structur for simple triangle meshes.
- * Can be turned into a IndexedVertexBuffer for drawing with OpenGL
+ * Half edge data structure for manifold triangle meshes.
+ *
+ * The 3 half edges of face f are stored at 3f, 3f+1 and 3f+2. The face, the next and the previous half edge are
+ * therefore implicit and a half edge only stores its opposite and the vertex it points to (8 bytes). Removed faces
+ * are only marked as invalid, so the indices stay stable during edge collapses.
  */
 
 template <typename vertex_t, typename index_t>
 class HalfEdgeMesh
 {
    public:
-    //    std::vector<vertex_t> vertices;
-    //    std::vector<Face> faces;
-    //    AABB boundingBox;
-
-
     struct HalfEdge
     {
-        bool valid           = true;
         int oppositeHalfEdge = -1;
-        int nextHalfEdge;
-        int prevHalfEdge;
         // The vertex this half edge points to (not the start!!!)
         int vertex;
-        int face;
 
-        bool boundary() { return oppositeHalfEdge == -1; }
+        bool boundary() const { return oppositeHalfEdge == -1; }
     };
 
     struct HalfVertex
@@ -46,7 +39,7 @@ class HalfEdgeMesh
         bool valid = true;
         vertex_t v;
         // one outgoing halfedge
-        int halfEdge;
+        int halfEdge = -1;
     };
 
     struct HalfFace
@@ -57,18 +50,13 @@ class HalfEdgeMesh
     };
 
     std::vector<HalfEdge> edgeList;
-
-    //    std::map< std::pair<int,int>, int > vertexEdges2;
-    std::unordered_map<uint64_t, int> vertexEdges;
-    //    std::map< uint64_t, int > vertexEdges;
-
     std::vector<HalfVertex> vertices;
     std::vector<HalfFace> faces;
 
     HalfEdgeMesh() {}
-    HalfEdgeMesh(TriangleMesh<vertex_t, index_t>& ifs);
+    HalfEdgeMesh(const TriangleMesh<vertex_t, index_t>& ifs);
 
-    void fromIFS(TriangleMesh<vertex_t, index_t>& ifs);
+    void fromIFS(const TriangleMesh<vertex_t, index_t>& ifs);
     void toIFS(TriangleMesh<vertex_t, index_t>& ifs);
 
     void clear();
@@ -80,150 +68,91 @@ class HalfEdgeMesh
     void removeFace(int f);
 
     void getNeighbours(int vertex, std::vector<int>& neighs);
+
+    static int face(int he) { return he / 3; }
+    static int nextHalfEdge(int he) { return (he % 3 == 2) ? he - 2 : he + 1; }
+    static int prevHalfEdge(int he) { return (he % 3 == 0) ? he + 2 : he - 1; }
+
+    // The vertex this half edge starts at.
+    int fromVertex(int he) const { return edgeList[prevHalfEdge(he)].vertex; }
+    bool validHalfEdge(int he) const { return faces[face(he)].valid; }
+
+    bool isBoundaryVertex(int vertex) const;
+
+    // Calls f(he) for every outgoing half edge of 'vertex', which is once for every face around the vertex.
+    template <typename F>
+    void forEachOutgoing(int vertex, F f) const;
 };
 
 template <typename vertex_t, typename index_t>
-HalfEdgeMesh<vertex_t, index_t>::HalfEdgeMesh(TriangleMesh<vertex_t, index_t>& ifs)
+HalfEdgeMesh<vertex_t, index_t>::HalfEdgeMesh(const TriangleMesh<vertex_t, index_t>& ifs)
 {
     fromIFS(ifs);
 }
 
 template <typename vertex_t, typename index_t>
-void HalfEdgeMesh<vertex_t, index_t>::fromIFS(TriangleMesh<vertex_t, index_t>& ifs)
+void HalfEdgeMesh<vertex_t, index_t>::fromIFS(const TriangleMesh<vertex_t, index_t>& ifs)
 {
     clear();
 
-    edgeList.resize(ifs.faces.size() * 3);
+    int num_faces = ifs.faces.size();
+    edgeList.resize(num_faces * 3);
     vertices.resize(ifs.vertices.size());
-    faces.resize(ifs.faces.size());
-
-    vertexEdges.reserve(ifs.faces.size() * 3);
+    faces.resize(num_faces);
 
     for (int i = 0; i < (int)ifs.vertices.size(); ++i)
     {
         vertices[i].v = ifs.vertices[i];
     }
 
-
-
-    for (int i = 0; i < (int)ifs.faces.size(); ++i)
+    // The half edge 3i+k goes from f(k) to f(k+1)
+    std::vector<std::pair<uint64_t, int>> edge_keys(edgeList.size());
+#pragma omp parallel for
+    for (int i = 0; i < num_faces; ++i)
     {
-        typename TriangleMesh<vertex_t, index_t>::Face f = ifs.faces[i];
-
-        // create 3 half edges for every face
-        int heidx    = i * 3;
-        HalfEdge& e1 = edgeList[heidx];
-        HalfEdge& e2 = edgeList[heidx + 1];
-        HalfEdge& e3 = edgeList[heidx + 2];
-
-        // They all belong to the same face
-        e1.face = i;
-        e2.face = i;
-        e3.face = i;
-
-        e1.vertex = f(1);
-        e2.vertex = f(2);
-        e3.vertex = f(0);
-
-        // make the circle pointers
-        e1.nextHalfEdge = heidx + 1;
-        e2.nextHalfEdge = heidx + 2;
-        e3.nextHalfEdge = heidx + 0;
-
-        e1.prevHalfEdge = heidx + 2;
-        e2.prevHalfEdge = heidx + 0;
-        e3.prevHalfEdge = heidx + 1;
-
-
-
-        HalfFace& hf = faces[i];
-        hf.halfEdge  = heidx;
-
-        HalfVertex& hv1 = vertices[f(0)];
-        HalfVertex& hv2 = vertices[f(1)];
-        HalfVertex& hv3 = vertices[f(2)];
-
-        hv1.halfEdge = heidx;
-        hv2.halfEdge = heidx + 1;
-        hv3.halfEdge = heidx + 2;
-
-#if 1
-        uint64_t mapidx;
-
-        mapidx = std::min(f(0), f(1)) * vertices.size() + std::max(f(0), f(1));
-        auto e = vertexEdges.find(mapidx);
-        if (e == vertexEdges.end())
-        {
-            vertexEdges[mapidx] = heidx;
-        }
-        else
-        {
-            e1.oppositeHalfEdge                  = e->second;
-            edgeList[e->second].oppositeHalfEdge = heidx;
-        }
-
-
-        mapidx = std::min(f(1), f(2)) * vertices.size() + std::max(f(1), f(2));
-        e      = vertexEdges.find(mapidx);
-        if (e == vertexEdges.end())
-        {
-            vertexEdges[mapidx] = heidx + 1;
-        }
-        else
-        {
-            e2.oppositeHalfEdge                  = e->second;
-            edgeList[e->second].oppositeHalfEdge = heidx + 1;
-        }
-
-
-        mapidx = std::min(f(2), f(0)) * vertices.size() + std::max(f(2), f(0));
-        e      = vertexEdges.find(mapidx);
-        if (e == vertexEdges.end())
+        auto f = ifs.faces[i];
+        for (int k = 0; k < 3; ++k)
         {
-            vertexEdges[mapidx] = heidx + 2;
+            int heidx              = i * 3 + k;
+            uint64_t v1            = f(k);
+            uint64_t v2            = f((k + 1) % 3);
+            edgeList[heidx].vertex = v2;
+            edge_keys[heidx]       = {std::min(v1, v2) * vertices.size() + std::max(v1, v2), heidx};
         }
-        else
-        {
-            e3.oppositeHalfEdge                  = e->second;
-            edgeList[e->second].oppositeHalfEdge = heidx + 2;
-        }
-
-#else
-        vertexEdges[std::pair<int, int>(f.v1, f.v2)] = heidx;
-        vertexEdges[std::pair<int, int>(f.v2, f.v3)] = heidx + 1;
-        vertexEdges[std::pair<int, int>(f.v3, f.v1)] = heidx + 2;
-#endif
+        faces[i].halfEdge = i * 3;
     }
 
-#if 0
-
-    //create opposite links
-    for(int i = 0; i < (int)ifs.faces.size(); ++i)
+    for (int i = 0; i < (int)edgeList.size(); ++i)
     {
-        typename TriangleMesh<vertex_t, index_t>::Face f = ifs.faces[i];
-
-        int heidx = i * 3;
-
+        vertices[fromVertex(i)].halfEdge = i;
+    }
 
-        auto e = vertexEdges.find(std::pair<int,int>(f.v2,f.v1));
-        if( e != vertexEdges.end())
-        {
-            edgeList[heidx].oppositeHalfEdge = e->second;
-        }
+    // Create the opposite links by sorting the half edges by their (undirected) vertex pair. Edges with more than two
+    // faces and inconsistently oriented faces are not linked and therefore treated as boundaries.
+    std::sort(edge_keys.begin(), edge_keys.end());
+    for (int i = 0; i < (int)edge_keys.size();)
+    {
+        int j = i + 1;
+        while (j < (int)edge_keys.size() && edge_keys[j].first == edge_keys[i].first) ++j;
 
-        e = vertexEdges.find(std::pair<int,int>(f.v3,f.v2));
-        if( e != vertexEdges.end())
+        if (j - i == 2)
         {
-            edgeList[heidx + 1].oppositeHalfEdge = e->second;
+            int h1 = edge_keys[i].second;
+            int h2 = edge_keys[i + 1].second;
+            if (edgeList[h1].vertex == fromVertex(h2))
+            {
+                edgeList[h1].oppositeHalfEdge = h2;
+                edgeList[h2].oppositeHalfEdge = h1;
+            }
         }
+        i = j;
+    }
 
-        e = vertexEdges.find(std::pair<int,int>(f.v1,f.v3));
-        if( e != vertexEdges.end())
-        {
-            edgeList[heidx + 2].oppositeHalfEdge = e->second;
-        }
+    // Start the boundary vertices at a boundary half edge, so that forEachOutgoing visits the faces in order.
+    for (int i = 0; i < (int)edgeList.size(); ++i)
+    {
+        if (edgeList[prevHalfEdge(i)].boundary()) vertices[fromVertex(i)].halfEdge = i;
     }
-#endif
 }
 
 template <typename vertex_t, typename index_t>
@@ -233,7 +162,6 @@ void HalfEdgeMesh<vertex_t, index_t>::toIFS(TriangleMesh<vertex_t, index_t>& ifs
 
 
     ifs.vertices.resize(vertices.size());
-    //    ifs.faces.resize(faces.size());
     for (int i = 0; i < (int)vertices.size(); ++i)
     {
         if (vertices[i].valid) ifs.vertices[i] = vertices[i].v;
@@ -243,30 +171,22 @@ void HalfEdgeMesh<vertex_t, index_t>::toIFS(TriangleMesh<vertex_t, index_t>& ifs
     {
         HalfFace hf = faces[i];
         if (!hf.valid) continue;
-        HalfEdge e1 = edgeList[faces[i].halfEdge];
-        HalfEdge e2 = edgeList[e1.nextHalfEdge];
-        HalfEdge e3 = edgeList[e2.nextHalfEdge];
-
-        // make sure it's a triangle
-        SAIGA_ASSERT(e3.nextHalfEdge == faces[i].halfEdge);
+        int e1 = hf.halfEdge;
+        int e2 = nextHalfEdge(e1);
+        int e3 = nextHalfEdge(e2);
 
         typename TriangleMesh<vertex_t, index_t>::Face f;
-        f(0) = e1.vertex;
-        f(1) = e2.vertex;
-        f(2) = e3.vertex;
+        f(0) = edgeList[e1].vertex;
+        f(1) = edgeList[e2].vertex;
+        f(2) = edgeList[e3].vertex;
 
         ifs.faces.push_back(f);
-        //        ifs.faces[i] = f;
     }
 }
 template <typename vertex_t, typename index_t>
 void HalfEdgeMesh<vertex_t, index_t>::clear()
 {
     edgeList.clear();
-
-    //    std::map< std::pair<int,int>, int > vertexEdges2;
-    vertexEdges.clear();
-
     vertices.clear();
     faces.clear();
 }
@@ -277,8 +197,8 @@ bool HalfEdgeMesh<vertex_t, index_t>::isValid()
     // check opposites
     for (int i = 0; i < (int)edgeList.size(); ++i)
     {
+        if (!validHalfEdge(i)) continue;
         HalfEdge e = edgeList[i];
-        if (!e.valid) continue;
 
         // edge of mesh
         if (e.oppositeHalfEdge == -1)
@@ -286,64 +206,41 @@ bool HalfEdgeMesh<vertex_t, index_t>::isValid()
             continue;
         }
 
-        HalfEdge op = edgeList[e.oppositeHalfEdge];
-
-        if (op.oppositeHalfEdge != i)
+        if (!validHalfEdge(e.oppositeHalfEdge))
         {
-            std::cout << "Opposite Half Edge Broken! " << i << "," << e.oppositeHalfEdge << " - " << op.oppositeHalfEdge
-                      << std::endl;
+            std::cout << "Opposite of valid half edge is invalid! " << i << std::endl;
             return false;
         }
-    }
 
-    // check circles
-    for (int i = 0; i < (int)edgeList.size(); ++i)
-    {
-        HalfEdge e = edgeList[i];
-        if (!e.valid) continue;
+        HalfEdge op = edgeList[e.oppositeHalfEdge];
 
-        if (edgeList[e.nextHalfEdge].prevHalfEdge != i)
+        if (op.oppositeHalfEdge != i)
         {
-            std::cout << "prev broken" << std::endl;
+            std::cout << "Opposite Half Edge Broken! " << i << "," << e.oppositeHalfEdge << " - " << op.oppositeHalfEdge
+                      << std::endl;
             return false;
         }
 
-        int f = e.face;
-        if (f == -1 || !faces[f].valid)
+        if (op.vertex != fromVertex(i))
         {
-            std::cout << "valid half edge with broken face" << std::endl;
+            std::cout << "Opposite Half Edge has the wrong direction! " << i << std::endl;
             return false;
         }
+    }
 
-
-        int count = 0;
-        while (e.nextHalfEdge != i)
+    // check faces
+    for (int i = 0; i < (int)faces.size(); ++i)
+    {
+        if (!faces[i].valid) continue;
+        for (int k = 0; k < 3; ++k)
         {
-            e = edgeList[e.nextHalfEdge];
-            if (count++ > 1000)
-            {
-                std::cout << "Half edge circle broken (over 1000 nodes)!" << std::endl;
-                return false;
-            }
-
-            if (e.valid == false)
-            {
-                std::cout << "valid broken" << std::endl;
-                return false;
-            }
-
-            if (e.face != f)
+            int v = edgeList[i * 3 + k].vertex;
+            if (v < 0 || v >= (int)vertices.size() || !vertices[v].valid)
             {
-                std::cout << "Not all half edges reference the same face" << std::endl;
+                std::cout << "valid face with broken vertex" << std::endl;
                 return false;
             }
         }
-
-        if (count != 2)
-        {
-            std::cout << "Not a triangle mesh" << std::endl;
-            return false;
-        }
     }
 
     // check vertice edges
@@ -351,22 +248,15 @@ bool HalfEdgeMesh<vertex_t, index_t>::isValid()
     for (int i = 0; i < (int)vertices.size(); ++i)
     {
         HalfVertex v = vertices[i];
-        if (!v.valid) continue;
+        if (!v.valid || v.halfEdge == -1) continue;
 
-        if (v.halfEdge == -1)
+        if (!validHalfEdge(v.halfEdge))
         {
-            std::cout << "-1 halfedge on vertex" << std::endl;
+            std::cout << "Vertex references invalid half edge!" << std::endl;
             return false;
         }
 
-        HalfEdge e = edgeList[v.halfEdge];
-
-        while (e.nextHalfEdge != v.halfEdge)
-        {
-            e = edgeList[e.nextHalfEdge];
-        }
-
-        if (e.vertex != i)
+        if (fromVertex(v.halfEdge) != i)
         {
             std::cout << "Vertex edge is broken!" << std::endl;
             return false;
@@ -377,165 +267,125 @@ bool HalfEdgeMesh<vertex_t, index_t>::isValid()
 }
 
 template <typename vertex_t, typename index_t>
-void HalfEdgeMesh<vertex_t, index_t>::halfEdgeCollapse(int he)
+bool HalfEdgeMesh<vertex_t, index_t>::isBoundaryVertex(int vertex) const
 {
-    if (he == -1 || he >= edgeList.size()) return;
-
-    HalfEdge e = edgeList[he];
-
-    if (!e.valid) return;
-
-    // no border
-    //    SAIGA_ASSERT(e.oppositeHalfEdge != -1);
-
-
-    int removeVertex = e.vertex;
-    int newVertex    = edgeList[e.prevHalfEdge].vertex;
-
-
-    //    vertices[removeVertex].v.position += vec4(0,0.5,0,0);
-    //    vertices[newVertex].v.position += vec4(0,0.5,0,0);
-
-
-    int removedFace1 = e.face;
-    int removedFace2 = (e.oppositeHalfEdge == -1) ? -1 : edgeList[e.oppositeHalfEdge].face;
-
-
+    bool boundary = false;
+    forEachOutgoing(vertex, [&](int he) {
+        boundary |= edgeList[he].boundary() || edgeList[prevHalfEdge(he)].boundary();
+    });
+    return boundary;
+}
 
-    // ================================================================================
+template <typename vertex_t, typename index_t>
+template <typename F>
+void HalfEdgeMesh<vertex_t, index_t>::forEachOutgoing(int vertex, F f) const
+{
+    int startHf = vertices[vertex].halfEdge;
+    if (startHf == -1) return;
 
-    // iterate over all triangles of the removed vertex
-    // update the vertices of the "incostd::ming" edges
-    int startHf   = vertices[removeVertex].halfEdge;
+    // Rotate around the vertex until we reach the start again or a boundary
     int currentHf = startHf;
-
     while (true)
     {
-        HalfEdge& current = edgeList[currentHf];
-
-        if (current.oppositeHalfEdge == -1) break;
-
-        // this he points towards the vertex
-        HalfEdge& flip = edgeList[current.oppositeHalfEdge];
-        SAIGA_ASSERT(flip.vertex == removeVertex);
-        flip.vertex = newVertex;
-
-        currentHf = flip.nextHalfEdge;
-
-        if (currentHf == startHf) break;
+        f(currentHf);
+        int flip = edgeList[currentHf].oppositeHalfEdge;
+        if (flip == -1) break;
+        currentHf = nextHalfEdge(flip);
+        if (currentHf == startHf) return;
     }
 
-    if (currentHf != startHf)
+    // Boundary vertex: rotate in the opposite direction
+    currentHf = startHf;
+    while (true)
     {
-        // we need to iterate in the opposite direction
-        startHf   = vertices[removeVertex].halfEdge;
-        currentHf = startHf;
+        int flip = edgeList[prevHalfEdge(currentHf)].oppositeHalfEdge;
+        if (flip == -1) return;
+        currentHf = flip;
+        f(currentHf);
+    }
+}
 
-        while (true)
-        {
-            HalfEdge& current = edgeList[currentHf];
-            HalfEdge& flip    = edgeList[current.prevHalfEdge];
-            SAIGA_ASSERT(flip.vertex == removeVertex);
-            flip.vertex = newVertex;
+template <typename vertex_t, typename index_t>
+void HalfEdgeMesh<vertex_t, index_t>::halfEdgeCollapse(int he)
+{
+    if (he < 0 || he >= (int)edgeList.size()) return;
 
-            if (flip.oppositeHalfEdge == -1) break;
+    if (!validHalfEdge(he)) return;
 
-            currentHf = flip.oppositeHalfEdge;
+    int removeVertex = edgeList[he].vertex;
+    int newVertex    = fromVertex(he);
+    int opposite     = edgeList[he].oppositeHalfEdge;
 
-            if (currentHf == startHf) break;
-        }
-        //        SAIGA_ASSERT(currentHf == startHf);
-    }
+    // ================================================================================
 
+    // iterate over all triangles of the removed vertex
+    // update the vertices of the "incoming" edges
+    forEachOutgoing(removeVertex, [&](int current) { edgeList[prevHalfEdge(current)].vertex = newVertex; });
 
-    int w1 = -1, w2 = -1;
     // ================================================================================
 
-    // set the opposite of the edges connected to the removed triangle
+    // set the opposite of the edges connected to the removed triangles
+    auto link = [&](int o1, int o2) {
+        if (o1 != -1) edgeList[o1].oppositeHalfEdge = o2;
+        if (o2 != -1) edgeList[o2].oppositeHalfEdge = o1;
+    };
 
     // upper triangle
-    HalfEdge tmp = edgeList[e.nextHalfEdge];
-    int o1       = tmp.oppositeHalfEdge;
-    w1           = tmp.vertex;
-    tmp          = edgeList[tmp.nextHalfEdge];
-    int o2       = tmp.oppositeHalfEdge;
-
-    if (o1 != -1) edgeList[o1].oppositeHalfEdge = o2;
-    if (o2 != -1) edgeList[o2].oppositeHalfEdge = o1;
-
-    if (o1 != -1) vertices[w1].halfEdge = o1;
-
-
-
-    //    std::cout << "o1,o2 " << o1 << "," << o2<< std::endl;
+    // o1: w1 -> newVertex
+    // o2: newVertex -> w1
+    int o1 = edgeList[nextHalfEdge(he)].oppositeHalfEdge;
+    int o2 = edgeList[prevHalfEdge(he)].oppositeHalfEdge;
+    int w1 = edgeList[nextHalfEdge(he)].vertex;
+    link(o1, o2);
+    faces[face(he)].valid = false;
 
     // other triangle
-    if (e.oppositeHalfEdge != -1)
+    // o3: w2 -> newVertex
+    // o4: newVertex -> w2
+    int o3 = -1, o4 = -1, w2 = -1;
+    if (opposite != -1)
     {
-        tmp    = edgeList[e.oppositeHalfEdge];
-        tmp    = edgeList[tmp.nextHalfEdge];
-        int o3 = tmp.oppositeHalfEdge;
-        w2     = tmp.vertex;
-        tmp    = edgeList[tmp.nextHalfEdge];
-        int o4 = tmp.oppositeHalfEdge;
-
-        // fix neighbours
-        if (o3 != -1) edgeList[o3].oppositeHalfEdge = o4;
-        if (o4 != -1) edgeList[o4].oppositeHalfEdge = o3;
-
-        if (o3 != -1) vertices[w2].halfEdge = o3;
-
-
-        //        std::cout << "o3,o4 " << o3 << "," << o4 << std::endl;
+        o3 = edgeList[nextHalfEdge(opposite)].oppositeHalfEdge;
+        o4 = edgeList[prevHalfEdge(opposite)].oppositeHalfEdge;
+        w2 = edgeList[nextHalfEdge(opposite)].vertex;
+        link(o3, o4);
+        faces[face(opposite)].valid = false;
     }
 
+    vertices[removeVertex].valid    = false;
+    vertices[removeVertex].halfEdge = -1;
 
+    // The outgoing half edges of the remaining vertices might have been removed
+    auto outgoing = [&](int a, int b) { return a != -1 ? a : (b != -1 ? nextHalfEdge(b) : -1); };
+    vertices[w1].halfEdge        = outgoing(o1, o2);
+    vertices[newVertex].halfEdge = outgoing(o2, o1);
+    if (vertices[newVertex].halfEdge == -1) vertices[newVertex].halfEdge = outgoing(o4, o3);
+    if (w2 != -1) vertices[w2].halfEdge = outgoing(o3, o4);
 
-    // remove faces
-
-    startHf   = he;
-    currentHf = startHf;
-    do
-    {
-        // remove this half edge
-        HalfEdge& e = edgeList[currentHf];
-        e.valid     = false;
-        currentHf   = e.nextHalfEdge;
-    } while (currentHf != startHf);
-    faces[removedFace1].valid = false;
-
-    if (e.oppositeHalfEdge != -1)
+    // Keep boundary vertices at a boundary half edge
+    for (int v : {w1, w2, newVertex})
     {
-        startHf   = e.oppositeHalfEdge;
-        currentHf = startHf;
-        do
+        if (v == -1) continue;
+        if (vertices[v].halfEdge == -1)
         {
-            // remove this half edge
-            HalfEdge& e = edgeList[currentHf];
-            e.valid     = false;
-            currentHf   = e.nextHalfEdge;
-        } while (currentHf != startHf);
-        faces[removedFace2].valid = false;
+            vertices[v].valid = false;
+            continue;
+        }
+        forEachOutgoing(v, [&](int current) {
+            if (edgeList[prevHalfEdge(current)].boundary()) vertices[v].halfEdge = current;
+        });
     }
-
-    //    removeFace(removedFace1);
-    //    removeFace(removedFace2);
-
-    vertices[removeVertex].valid = false;
-    //    if(edgeList[vertices[w1].halfEdge].face == removedFace1)
-    //    {
-    //    }
 }
 
 
 template <typename vertex_t, typename index_t>
 void HalfEdgeMesh<vertex_t, index_t>::flipEdge(int he)
 {
-    if (he == -1 || he >= edgeList.size()) return;
+    if (he < 0 || he >= (int)edgeList.size()) return;
 
     HalfEdge e = edgeList[he];
 
-    if (!e.valid) return;
+    if (!validHalfEdge(he)) return;
 
     // border edges are not flipable
     if (e.oppositeHalfEdge == -1) return;
@@ -543,12 +393,12 @@ void HalfEdgeMesh<vertex_t, index_t>::flipEdge(int he)
     // http://15462.courses.cs.cmu.edu/fall2015content/misc/HalfedgeEdgeOpImplementationGuide.pdf
 
     int h0 = he;
-    int h1 = edgeList[h0].nextHalfEdge;
-    int h2 = edgeList[h1].nextHalfEdge;
+    int h1 = nextHalfEdge(h0);
+    int h2 = nextHalfEdge(h1);
 
     int h3 = edgeList[h0].oppositeHalfEdge;
-    int h4 = edgeList[h3].nextHalfEdge;
-    int h5 = edgeList[h4].nextHalfEdge;
+    int h4 = nextHalfEdge(h3);
+    int h5 = nextHalfEdge(h4);
 
     int h6 = edgeList[h1].oppositeHalfEdge;
     int h7 = edgeList[h2].oppositeHalfEdge;
@@ -568,10 +418,6 @@ void HalfEdgeMesh<vertex_t, index_t>::flipEdge(int he)
     }
 
 
-    //    int f0 = edgeList[h0].face;
-    //    int f1 = edgeList[h3].face;
-
-
     edgeList[h0].vertex = v2;
     edgeList[h1].vertex = v0;
     edgeList[h2].vertex = v3;
@@ -595,10 +441,6 @@ void HalfEdgeMesh<vertex_t, index_t>::flipEdge(int he)
     vertices[v1].halfEdge = h5;
     vertices[v2].halfEdge = h1;
     vertices[v3].halfEdge = h4;
-
-    std::cout << h0 << "," << h1 << "," << h2 << "," << h3 << "," << h4 << "," << h5 << "," << std::endl;
-    std::cout << h6 << "," << h7 << "," << h8 << "," << h9 << "," << std::endl;
-    std::cout << std::endl;
 }
 
 
@@ -612,79 +454,26 @@ void HalfEdgeMesh<vertex_t, index_t>::removeFace(int f)
 
 
     // go in circle around face
-    int startHf   = hf.halfEdge;
-    int currentHf = startHf;
-    do
+    for (int k = 0; k < 3; ++k)
     {
-        // remove this half edge
-        HalfEdge& e = edgeList[currentHf];
-        e.valid     = false;
-
+        HalfEdge& e = edgeList[f * 3 + k];
         if (e.oppositeHalfEdge != -1)
         {
             HalfEdge& op        = edgeList[e.oppositeHalfEdge];
             op.oppositeHalfEdge = -1;
         }
-
-        currentHf = e.nextHalfEdge;
-    } while (currentHf != startHf);
+        e.oppositeHalfEdge = -1;
+    }
 }
 
 template <typename vertex_t, typename index_t>
 void HalfEdgeMesh<vertex_t, index_t>::getNeighbours(int vertex, std::vector<int>& neighs)
 {
-    // ================================================================================
-
-    // iterate over all triangles of the removed vertex
-    // update the vertices of the "incostd::ming" edges
-    int startHf   = vertices[vertex].halfEdge;
-    int currentHf = startHf;
-
-    while (true)
-    {
-        HalfEdge& current = edgeList[currentHf];
-        neighs.push_back(current.vertex);
-
-        if (current.oppositeHalfEdge == -1)
-        {
-            break;
-        }
-
-        // this he points towards the vertex
-        HalfEdge& flip = edgeList[current.oppositeHalfEdge];
-        currentHf      = flip.nextHalfEdge;
-
-        if (currentHf == startHf)
-        {
-            //            neighs.push_back(edgeList[currentHf].vertex);
-            return;
-        }
-    }
-
-    //    if(currentHf != startHf)
-    {
-        // we need to iterate in the opposite direction
-        startHf   = vertices[vertex].halfEdge;
-        currentHf = startHf;
-
-        while (true)
-        {
-            HalfEdge& current = edgeList[currentHf];
-            HalfEdge& flip    = edgeList[current.prevHalfEdge];
-            //            SAIGA_ASSERT(flip.vertex == removeVertex);
-            //            flip.vertex = newVertex;
-
-            if (flip.oppositeHalfEdge == -1) break;
-
-            currentHf = flip.oppositeHalfEdge;
-
-
-            if (currentHf == startHf) break;
-
-            neighs.push_back(edgeList[currentHf].vertex);
-        }
-        //        SAIGA_ASSERT(currentHf == startHf);
-    }
+    // The target of every outgoing half edge and for boundary vertices the start of the incoming boundary edge
+    forEachOutgoing(vertex, [&](int current) {
+        neighs.push_back(edgeList[current].vertex);
+        if (edgeList[prevHalfEdge(current)].boundary()) neighs.push_back(fromVertex(prevHalfEdge(current)));
+    });
 }
 
 }  // namespace Saiga
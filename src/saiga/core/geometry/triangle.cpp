@@ -170,6 +170,70 @@ float Triangle::Distance(const vec3& x0) const
     }
 }
 
+vec3 Triangle::ClosestPoint(const vec3& x, vec3& barycentric) const
+{
+    // Voronoi region test from Real-Time Collision Detection, Ericson 2004
+    vec3 ab = b - a, ac = c - a, ap = x - a;
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0)
+    {
+        barycentric = vec3(1, 0, 0);
+        return a;
+    }
+
+    vec3 bp  = x - b;
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3)
+    {
+        barycentric = vec3(0, 1, 0);
+        return b;
+    }
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+    {
+        float v     = d1 / (d1 - d3);
+        barycentric = vec3(1 - v, v, 0);
+        return a + v * ab;
+    }
+
+    vec3 cp  = x - c;
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6)
+    {
+        barycentric = vec3(0, 0, 1);
+        return c;
+    }
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+    {
+        float w     = d2 / (d2 - d6);
+        barycentric = vec3(1 - w, 0, w);
+        return a + w * ac;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+    {
+        float w     = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        barycentric = vec3(0, 1 - w, w);
+        return b + w * (c - b);
+    }
+
+    float sum = va + vb + vc;
+    if (!(sum > 0))
+    {
+        // Degenerate triangle
+        barycentric = vec3(1, 0, 0);
+        return a;
+    }
+    float v     = vb / sum;
+    float w     = vc / sum;
+    barycentric = vec3(1 - v - w, v, w);
+    return a + v * ab + w * ac;
+}
+
 std::ostream& operator<<(std::ostream& os, const Triangle& t)
 {
     os << "Triangle: " << t.a.transpose() << "," << t.b.transpose() << "," << t.c.transpose();
@@ -89,6 +89,10 @@ class SAIGA_CORE_API Triangle
     // Distance of a point to the triangle
     float Distance(const vec3& x) const;
 
+    // Closest point on the triangle to x. 'barycentric' are the weights of a, b and c.
+    // A weight is exactly 0, if the closest point is on the opposite edge or on a corner.
+    vec3 ClosestPoint(const vec3& x, vec3& barycentric) const;
+
     friend SAIGA_CORE_API std::ostream& operator<<(std::ostream& os, const Triangle& dt);
 };
 
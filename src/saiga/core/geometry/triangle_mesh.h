@@ -10,9 +10,11 @@
 #include "saiga/core/geometry/triangle.h"
 #include "saiga/core/geometry/vertex.h"
 #include "saiga/core/math/math.h"
+#include "saiga/core/util/Algorithm.h"
 #include "saiga/core/util/assert.h"
 
 #include "Mesh.h"
+#include "VertexWelding.h"
 
 #include <algorithm>
 #include <cstring>
@@ -120,6 +122,7 @@ class TriangleMesh : public Mesh<vertex_t>
     /**
      * Removes all vertices that are not referenced by a triangle.
      * Computes the new vertex indices for each triangle.
+     * The order of the remaining vertices is preserved.
      */
     void removeUnusedVertices();
 
@@ -141,6 +144,9 @@ class TriangleMesh : public Mesh<vertex_t>
     /**
      * Sorts the vertices by (x,y,z) lexical.
      * The face indices are correct to match the new vertices.
+     *
+     * The epsilon is ignored, because an epsilon comparison is not a strict weak ordering. Use weldVertices to merge
+     * vertices that are close to each other.
      */
     void sortVerticesByPosition(double epsilon = 1e-5);
 
@@ -158,6 +164,13 @@ class TriangleMesh : public Mesh<vertex_t>
      */
     void removeDegenerateFaces();
 
+    /**
+     * Merges all vertices with a distance <= epsilon (see WeldPoints) and updates the face indices.
+     * Afterwards, the degenerate faces and the unused vertices are removed.
+     * A merged vertex keeps the attributes of the vertex with the smallest index.
+     */
+    void weldVertices(float epsilon = 1e-5);
+
     float distancePointMesh(const vec3& x);
 
     template <typename v, typename i>
@@ -405,25 +418,34 @@ void TriangleMesh<vertex_t, index_t>::computePerVertexNormal()
 template <typename vertex_t, typename index_t>
 void TriangleMesh<vertex_t, index_t>::removeUnusedVertices()
 {
-    std::vector<int> vmap(vertices.size(), -1);
-    auto vcopy = vertices;
-    vertices.clear();
+    std::vector<int> vmap(vertices.size(), 0);
+#pragma omp parallel for
     for (int i = 0; i < (int)faces.size(); ++i)
     {
-        auto& f = faces[i];
-
-        for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
         {
-            auto& v = f[i];
-            if (vmap[v] == -1)
-            {
-                int count = vertices.size();
-                vmap[v]   = count;
-                vertices.push_back(vcopy[v]);
-            }
-            v = vmap[v];
+#pragma omp atomic write
+            vmap[faces[i][j]] = 1;
         }
     }
+
+    int new_size = Saiga::exclusive_scan(vmap.begin(), vmap.end(), vmap.begin(), 0);
+    std::vector<vertex_t> new_vertices(new_size);
+
+#pragma omp parallel for
+    for (int i = 0; i < (int)vertices.size(); ++i)
+    {
+        // Used vertices increase the index of the next vertex
+        int next = i + 1 < (int)vertices.size() ? vmap[i + 1] : new_size;
+        if (next != vmap[i]) new_vertices[vmap[i]] = vertices[i];
+    }
+
+#pragma omp parallel for
+    for (int i = 0; i < (int)faces.size(); ++i)
+    {
+        for (int j = 0; j < 3; ++j) faces[i][j] = vmap[faces[i][j]];
+    }
+    vertices.swap(new_vertices);
 }
 
 
@@ -442,25 +464,15 @@ bool TriangleMesh<vertex_t, index_t>::isValid() const
 }
 
 template <typename vertex_t, typename index_t>
-void TriangleMesh<vertex_t, index_t>::sortVerticesByPosition(double epsilon)
+void TriangleMesh<vertex_t, index_t>::sortVerticesByPosition(double)
 {
-    double eps_squared = epsilon * epsilon;
-
     std::vector<int> tmp_indices(vertices.size());
     std::vector<int> tmp_indices2(vertices.size());
     std::iota(tmp_indices.begin(), tmp_indices.end(), 0);
 
     std::sort(tmp_indices.begin(), tmp_indices.end(), [&](int a, int b) {
-        vec4 p1 = vertices[a].position;
-        vec4 p2 = vertices[b].position;
-
-        vec4 p3 = (p1 - p2);
-        p3      = p3.array() * p3.array();
-
-        p1[0] = p3[0] < eps_squared ? p2[0] : p1[0];
-        p1[1] = p3[1] < eps_squared ? p2[1] : p1[1];
-        p1[2] = p3[2] < eps_squared ? p2[2] : p1[2];
-
+        const vec4& p1 = vertices[a].position;
+        const vec4& p2 = vertices[b].position;
         return std::tie(p1[0], p1[1], p1[2]) < std::tie(p2[0], p2[1], p2[2]);
     });
 
@@ -524,9 +536,48 @@ void TriangleMesh<vertex_t, index_t>::removeSubsequentDuplicates(double epsilon)
 template <typename vertex_t, typename index_t>
 void TriangleMesh<vertex_t, index_t>::removeDegenerateFaces()
 {
-    faces.erase(std::remove_if(faces.begin(), faces.end(),
-                               [](const Face& f) { return f(0) == f(1) || f(0) == f(2) || f(1) == f(2); }),
-                faces.end());
+    // Parallel stream compaction: valid flags -> scan -> scatter
+    std::vector<int> offset(faces.size());
+#pragma omp parallel for
+    for (int i = 0; i < (int)faces.size(); ++i)
+    {
+        auto& f   = faces[i];
+        offset[i] = !(f(0) == f(1) || f(0) == f(2) || f(1) == f(2));
+    }
+
+    int new_size = Saiga::exclusive_scan(offset.begin(), offset.end(), offset.begin(), 0);
+    std::vector<Face> new_faces(new_size);
+
+#pragma omp parallel for
+    for (int i = 0; i < (int)faces.size(); ++i)
+    {
+        int next = i + 1 < (int)faces.size() ? offset[i + 1] : new_size;
+        if (next != offset[i]) new_faces[offset[i]] = faces[i];
+    }
+    faces.swap(new_faces);
+}
+
+template <typename vertex_t, typename index_t>
+void TriangleMesh<vertex_t, index_t>::weldVertices(float epsilon)
+{
+    std::vector<vec3> positions(vertices.size());
+#pragma omp parallel for
+    for (int i = 0; i < (int)vertices.size(); ++i)
+    {
+        positions[i] = make_vec3(vertices[i].position);
+    }
+
+    auto group = WeldPoints(positions, epsilon);
+
+#pragma omp parallel for
+    for (int i = 0; i < (int)faces.size(); ++i)
+    {
+        for (int j = 0; j < 3; ++j) faces[i][j] = group[faces[i][j]];
+    }
+
+    removeDegenerateFaces();
+    // Only the group representatives are referenced now
+    removeUnusedVertices();
 }
 
 template <typename vertex_t, typename index_t>
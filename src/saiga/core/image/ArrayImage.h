@@ -25,14 +25,15 @@ class ArrayImage : public ImageBase
 
     ImageView<T> getImageView()
     {
-        ImageView<T> res(*this);
+        // Note: The cast is required, because otherwise the conversion operator below is called recursively.
+        ImageView<T> res(static_cast<const ImageBase&>(*this));
         res.data = data();
         return res;
     }
 
     ImageView<const T> getConstImageView() const
     {
-        ImageView<const T> res(*this);
+        ImageView<const T> res(static_cast<const ImageBase&>(*this));
         res.data = data();
         return res;
     }
@@ -10,9 +10,11 @@
 
 #include "ArrayImage.h"
 #include "imageBase.h"
+#include "imageBufferPool.h"
 #include "imageFormat.h"
 #include "imageTransformations.h"
 #include "imageView.h"
+#include "integralImage.h"
 #include "managedImage.h"
 #include "templatedImage.h"
 #include "ImageDraw.h"
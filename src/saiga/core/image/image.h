@@ -10,8 +10,10 @@
 
 #include "ArrayImage.h"
 #include "imageBase.h"
+#include "imageBufferPool.h"
 #include "imageFormat.h"
 #include "imageTransformations.h"
 #include "imageView.h"
+#include "integralImage.h"
 #include "managedImage.h"
 #include "templatedImage.h"
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "imageBufferPool.h"
+
+#include "saiga/core/util/assert.h"
+
+namespace Saiga
+{
+size_t ImageBufferPool::sizeClass(size_t bytes)
+{
+    if (bytes <= 4096)
+    {
+        return 4096;
+    }
+
+    // Highest power of two <= bytes
+    size_t p = 1;
+    while (p <= bytes / 2) p *= 2;
+
+    size_t step = p / 8;
+    return (bytes + step - 1) / step * step;
+}
+
+ImageBufferPool::Buffer ImageBufferPool::acquire(size_t bytes)
+{
+    size_t cls = sizeClass(bytes);
+    {
+        std::unique_lock l(mutex);
+        auto it = buffers.find(cls);
+        if (it != buffers.end() && !it->second.empty())
+        {
+            Buffer result = std::move(it->second.back());
+            it->second.pop_back();
+            stats.cached_bytes -= result.capacity();
+            stats.reuses++;
+
+            // Shrinking doesn't reallocate
+            result.resize(bytes);
+            return result;
+        }
+        stats.allocations++;
+    }
+
+    Buffer result;
+    result.reserve(cls);
+    result.resize(bytes);
+    return result;
+}
+
+void ImageBufferPool::release(Buffer&& buffer)
+{
+    size_t capacity = buffer.capacity();
+    if (capacity == 0) return;
+
+    if (capacity < 4096)
+    {
+        Buffer().swap(buffer);
+        return;
+    }
+
+    // Buffers that were not created by the pool are stored in the largest class that fits into them.
+    size_t p = 1;
+    while (p <= capacity / 2) p *= 2;
+    size_t step = p / 8;
+    size_t cls  = capacity / step * step;
+    SAIGA_ASSERT(sizeClass(cls) == cls);
+
+    std::unique_lock l(mutex);
+    if (stats.cached_bytes + capacity > max_cached_bytes)
+    {
+        l.unlock();
+        Buffer().swap(buffer);
+        return;
+    }
+
+    stats.cached_bytes += capacity;
+    buffers[cls].push_back(std::move(buffer));
+    buffer = Buffer();
+}
+
+void ImageBufferPool::clear()
+{
+    std::unique_lock l(mutex);
+    buffers.clear();
+    stats.cached_bytes = 0;
+}
+
+ImageBufferPool::Statistics ImageBufferPool::statistics()
+{
+    std::unique_lock l(mutex);
+    return stats;
+}
+
+const std::shared_ptr<ImageBufferPool>& globalImageBufferPool()
+{
+    static std::shared_ptr<ImageBufferPool> pool = std::make_shared<ImageBufferPool>();
+    return pool;
+}
+
+}  // namespace Saiga
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Saiga
+{
+/**
+ * A thread-safe cache of image buffers, grouped by size classes.
+ *
+ * Images that are attached to a pool (see Image::setBufferPool) acquire their memory from here and
+ * return it on free() or destruction. In a steady state, for example a camera that produces images of
+ * the same size every frame, no memory is allocated at all.
+ *
+ * The pool keeps at most 'max_cached_bytes' of unused memory. Buffers returned above this limit are
+ * released to the system.
+ */
+class SAIGA_CORE_API ImageBufferPool
+{
+   public:
+    using Buffer = std::vector<unsigned char>;
+
+    struct Statistics
+    {
+        // Number of acquire() calls that allocated new memory.
+        size_t allocations = 0;
+        // Number of acquire() calls that reused a cached buffer.
+        size_t reuses = 0;
+        // Memory that is currently unused and cached in the pool.
+        size_t cached_bytes = 0;
+    };
+
+    ImageBufferPool(size_t max_cached_bytes = size_t(512) * 1024 * 1024) : max_cached_bytes(max_cached_bytes) {}
+
+    // Returns a buffer with size() == bytes. The capacity is the size class of 'bytes'.
+    Buffer acquire(size_t bytes);
+
+    // Puts the buffer back into the pool. The buffer is empty afterwards.
+    void release(Buffer&& buffer);
+
+    // Releases all cached buffers.
+    void clear();
+
+    Statistics statistics();
+
+    // Sizes are rounded up to 8 steps per power of two (max. 12.5% overhead).
+    static size_t sizeClass(size_t bytes);
+
+   private:
+    std::mutex mutex;
+    std::map<size_t, std::vector<Buffer>> buffers;
+    size_t max_cached_bytes;
+    Statistics stats;
+};
+
+// The process-wide pool used by the camera and feature classes.
+SAIGA_CORE_API const std::shared_ptr<ImageBufferPool>& globalImageBufferPool();
+
+}  // namespace Saiga
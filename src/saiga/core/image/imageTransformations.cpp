@@ -6,22 +6,193 @@
 
 #include "imageTransformations.h"
 
+#include "saiga/core/util/CpuFeatures.h"
 #include "saiga/core/util/color.h"
 
 #include "internal/noGraphicsAPI.h"
 
 #include "templatedImage.h"
 
+#ifdef SAIGA_HAS_X86_SIMD
+#    include <immintrin.h>
+#endif
+
 namespace Saiga
 {
 namespace ImageTransformation
 {
+// const vec3 rgbToGray(0.2126f, 0.7152f, 0.0722f);
+const vec3 rgbToGray(0.299f, 0.587f, 0.114f);  // opencv values
+
+
+#ifdef SAIGA_HAS_X86_SIMD
+// ======================== SIMD Kernels ========================
+// All kernels process one row. The remaining pixels at the end of a row are handled by the caller with
+// the scalar code path.
+
+// Returns the number of processed pixels
+SAIGA_TARGET_SSE41 static int AddAlphaRowSSE(const ucvec3* src, ucvec4* dst, int n, unsigned char alpha)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha_v = _mm_set1_epi32(int(uint32_t(alpha) << 24));
+
+    int j = 0;
+    // 4 pixels per iteration. We load 16 bytes but use only 12 of them.
+    for (; j + 6 <= n; j += 4)
+    {
+        __m128i px  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j));
+        __m128i res = _mm_or_si128(_mm_shuffle_epi8(px, shuffle), alpha_v);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), res);
+    }
+    return j;
+}
+
+// Gray values of 8 rgba pixels.
+SAIGA_TARGET_AVX2 static inline __m256 GrayAVX2(__m256i px)
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    __m256 r           = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+    __m256 g           = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+    __m256 b           = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+
+    __m256 gray = _mm256_mul_ps(r, _mm256_set1_ps(rgbToGray[0]));
+    gray        = _mm256_fmadd_ps(g, _mm256_set1_ps(rgbToGray[1]), gray);
+    gray        = _mm256_fmadd_ps(b, _mm256_set1_ps(rgbToGray[2]), gray);
+    return gray;
+}
+
+// Converts 8 floats to 8 bytes (with truncation) and stores them.
+SAIGA_TARGET_AVX2 static inline void StoreTruncated8AVX2(__m256 v, unsigned char* dst)
+{
+    __m256i i32 = _mm256_cvttps_epi32(v);
+    __m256i i16 = _mm256_packus_epi32(i32, i32);
+    __m256i i8  = _mm256_packus_epi16(i16, i16);
+    i8          = _mm256_permutevar8x32_epi32(i8, _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(i8));
+}
+
+SAIGA_TARGET_AVX2 static int RGBAToGray8RowAVX2(const ucvec4* src, unsigned char* dst, int n)
+{
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + j));
+        StoreTruncated8AVX2(GrayAVX2(px), dst + j);
+    }
+    return j;
+}
+
+SAIGA_TARGET_AVX2 static int RGBAToGrayFRowAVX2(const ucvec4* src, float* dst, int n, float scale)
+{
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    int j                = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + j));
+        _mm256_storeu_ps(dst + j, _mm256_mul_ps(GrayAVX2(px), scale_v));
+    }
+    return j;
+}
+
+SAIGA_TARGET_AVX2 static int Gray8ToRGBARowAVX2(const unsigned char* src, ucvec4* dst, int n, unsigned char alpha)
+{
+    const __m256i alpha_v = _mm256_set1_epi32(int(uint32_t(alpha) << 24));
+    const __m256i mult    = _mm256_set1_epi32(0x00010101);
+    int j                 = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i g   = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + j)));
+        __m256i res = _mm256_or_si256(_mm256_mullo_epi32(g, mult), alpha_v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), res);
+    }
+    return j;
+}
+
+// Replicates the truncated 8-bit value of v into rgb and sets alpha to 255.
+SAIGA_TARGET_AVX2 static int DepthToRGBARowAVX2(const float* src, ucvec4* dst, int n, float minD, float maxD)
+{
+    const __m256 min_v    = _mm256_set1_ps(minD);
+    const __m256 range_v  = _mm256_set1_ps(maxD - minD);
+    const __m256 zero     = _mm256_setzero_ps();
+    const __m256 one      = _mm256_set1_ps(1.0f);
+    const __m256 s255     = _mm256_set1_ps(255.0f);
+    const __m256i alpha_v = _mm256_set1_epi32(int(0xFF000000u));
+    const __m256i mult    = _mm256_set1_epi32(0x00010101);
+    int j                 = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256 d    = _mm256_div_ps(_mm256_sub_ps(_mm256_loadu_ps(src + j), min_v), range_v);
+        d           = _mm256_min_ps(_mm256_max_ps(d, zero), one);
+        __m256i g   = _mm256_cvttps_epi32(_mm256_mul_ps(d, s255));
+        __m256i res = _mm256_or_si256(_mm256_mullo_epi32(g, mult), alpha_v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), res);
+    }
+    return j;
+}
+
+// Averages the 2x2 blocks of 8 rgba pixels in two rows. Returns the 4 resulting pixels.
+SAIGA_TARGET_AVX2 static inline __m128i ScaleDown2x4AVX2(const ucvec4* row0, const ucvec4* row1)
+{
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1));
+
+    // Vertical sum in 16 bit. lo contains the pixels 0-3 and hi 4-7.
+    __m256i lo = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)),
+                                  _mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)));
+    __m256i hi = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)),
+                                  _mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)));
+
+    // Horizontal sum of neighboring pixels. Each pixel is 64 bit wide, so we add the swapped halves of each lane.
+    lo = _mm256_add_epi16(lo, _mm256_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+    hi = _mm256_add_epi16(hi, _mm256_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+    lo = _mm256_srli_epi16(lo, 2);
+    hi = _mm256_srli_epi16(hi, 2);
+
+    // Result pixels are in the 32-bit elements [0, 4, 2, 6]
+    __m256i packed = _mm256_packus_epi16(lo, hi);
+    packed         = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 2, 6, 0, 4, 2, 6));
+    return _mm256_castsi256_si128(packed);
+}
+
+SAIGA_TARGET_AVX2 static int ScaleDown2RowAVX2(const ucvec4* row0, const ucvec4* row1, ucvec4* dst, int n)
+{
+    int j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), ScaleDown2x4AVX2(row0 + 2 * j, row1 + 2 * j));
+    }
+    return j;
+}
+
+SAIGA_TARGET_AVX2 static int RGBAToGray8ScaleDown2RowAVX2(const ucvec4* row0, const ucvec4* row1, unsigned char* dst,
+                                                          int n)
+{
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m128i p0 = ScaleDown2x4AVX2(row0 + 2 * j, row1 + 2 * j);
+        __m128i p1 = ScaleDown2x4AVX2(row0 + 2 * j + 8, row1 + 2 * j + 8);
+        __m256i px = _mm256_inserti128_si256(_mm256_castsi128_si256(p0), p1, 1);
+        StoreTruncated8AVX2(GrayAVX2(px), dst + j);
+    }
+    return j;
+}
+#endif
+
+
 void addAlphaChannel(ImageView<const ucvec3> src, ImageView<ucvec4> dst, unsigned char alpha)
 {
     SAIGA_ASSERT(src.width == dst.width && src.height == dst.height);
     for (int i = 0; i < src.height; ++i)
     {
-        for (int j = 0; j < src.width; ++j)
+        int start = 0;
+#ifdef SAIGA_HAS_X86_SIMD
+        if (useSimd(cpuFeatures().sse41))
+        {
+            start = AddAlphaRowSSE(src.rowPtr(i), dst.rowPtr(i), src.width, alpha);
+        }
+#endif
+        for (int j = start; j < src.width; ++j)
         {
             dst(i, j) = make_ucvec4(src(i, j), alpha);
         }
@@ -61,7 +232,14 @@ void depthToRGBA(ImageView<const float> src, ImageView<ucvec4> dst, float minD,
     SAIGA_ASSERT(src.width == dst.width && src.height == dst.height);
     for (int i = 0; i < src.height; ++i)
     {
-        for (int j = 0; j < src.width; ++j)
+        int start = 0;
+#ifdef SAIGA_HAS_X86_SIMD
+        if (useSimd(cpuFeatures().avx2))
+        {
+            start = DepthToRGBARowAVX2(src.rowPtr(i), dst.rowPtr(i), src.width, minD, maxD);
+        }
+#endif
+        for (int j = start; j < src.width; ++j)
         {
             float d = src(i, j);
             d       = (d - minD) / (maxD - minD);
@@ -96,10 +274,6 @@ void depthToRGBA_HSV(ImageView<const float> src, ImageView<ucvec4> dst, float mi
 }
 
 
-
-// const vec3 rgbToGray(0.2126f, 0.7152f, 0.0722f);
-const vec3 rgbToGray(0.299f, 0.587f, 0.114f);  // opencv values
-
 struct RGBATOGRAY8Trans
 {
     unsigned char operator()(const ucvec4& v)
@@ -112,6 +286,22 @@ struct RGBATOGRAY8Trans
 
 void RGBAToGray8(ImageView<const ucvec4> src, ImageView<unsigned char> dst)
 {
+#ifdef SAIGA_HAS_X86_SIMD
+    if (useSimd(cpuFeatures().avx2))
+    {
+        SAIGA_ASSERT(src.width == dst.width && src.height == dst.height);
+        RGBATOGRAY8Trans op;
+        for (int i = 0; i < src.height; ++i)
+        {
+            int start = RGBAToGray8RowAVX2(src.rowPtr(i), dst.rowPtr(i), src.width);
+            for (int j = start; j < src.width; ++j)
+            {
+                dst(i, j) = op(src(i, j));
+            }
+        }
+        return;
+    }
+#endif
     src.copyToTransform(dst, RGBATOGRAY8Trans());
 }
 
@@ -130,6 +320,22 @@ struct RGBATOGRAYFTrans
 };
 void RGBAToGrayF(ImageView<const ucvec4> src, ImageView<float> dst, float scale)
 {
+#ifdef SAIGA_HAS_X86_SIMD
+    if (useSimd(cpuFeatures().avx2))
+    {
+        SAIGA_ASSERT(src.width == dst.width && src.height == dst.height);
+        RGBATOGRAYFTrans op(scale);
+        for (int i = 0; i < src.height; ++i)
+        {
+            int start = RGBAToGrayFRowAVX2(src.rowPtr(i), dst.rowPtr(i), src.width, scale);
+            for (int j = start; j < src.width; ++j)
+            {
+                dst(i, j) = op(src(i, j));
+            }
+        }
+        return;
+    }
+#endif
     src.copyToTransform(dst, RGBATOGRAYFTrans(scale));
 }
 
@@ -142,6 +348,22 @@ struct Gray8ToRGBATrans
 
 void Gray8ToRGBA(ImageView<unsigned char> src, ImageView<ucvec4> dst, unsigned char alpha)
 {
+#ifdef SAIGA_HAS_X86_SIMD
+    if (useSimd(cpuFeatures().avx2))
+    {
+        SAIGA_ASSERT(src.width == dst.width && src.height == dst.height);
+        Gray8ToRGBATrans op(alpha);
+        for (int i = 0; i < src.height; ++i)
+        {
+            int start = Gray8ToRGBARowAVX2(src.rowPtr(i), dst.rowPtr(i), src.width, alpha);
+            for (int j = start; j < src.width; ++j)
+            {
+                dst(i, j) = op(src(i, j));
+            }
+        }
+        return;
+    }
+#endif
     src.copyToTransform(dst, Gray8ToRGBATrans(alpha));
 }
 
@@ -208,22 +430,305 @@ bool save(const std::string& path, ImageView<float> img, float vmin, float vmax)
     return simg.save(path);
 }
 
+static inline ucvec4 ScaleDown2Pixel(ImageView<const ucvec4> src, int i_src, int j_src)
+{
+    ivec4 sum = src(i_src, j_src).cast<int>() + src(i_src + 1, j_src).cast<int>() +
+                src(i_src, j_src + 1).cast<int>() + src(i_src + 1, j_src + 1).cast<int>();
+    sum /= 4;
+    return sum.cast<unsigned char>();
+}
+
 void ScaleDown2(ImageView<const ucvec4> src, ImageView<ucvec4> dst)
 {
+    SAIGA_ASSERT(src.height / 2 == dst.height && src.width / 2 == dst.width);
     for (int i : dst.rowRange())
     {
-        for (int j : dst.colRange())
+        int start = 0;
+#ifdef SAIGA_HAS_X86_SIMD
+        if (useSimd(cpuFeatures().avx2))
+        {
+            start = ScaleDown2RowAVX2(src.rowPtr(i * 2), src.rowPtr(i * 2 + 1), dst.rowPtr(i), dst.width);
+        }
+#endif
+        for (int j = start; j < dst.width; ++j)
         {
-            int i_src = i * 2;
-            int j_src = j * 2;
-            ivec4 sum = src(i_src, j_src).cast<int>() + src(i_src + 1, j_src).cast<int>() +
-                        src(i_src, j_src + 1).cast<int>() + src(i_src + 1, j_src + 1).cast<int>();
-            sum /= 4;
-            dst(i, j) = sum.cast<unsigned char>();
+            dst(i, j) = ScaleDown2Pixel(src, i * 2, j * 2);
         }
     }
 }
 
+void RGBAToGray8ScaleDown2(ImageView<const ucvec4> src, ImageView<unsigned char> dst)
+{
+    SAIGA_ASSERT(src.height / 2 == dst.height && src.width / 2 == dst.width);
+    RGBATOGRAY8Trans op;
+    for (int i : dst.rowRange())
+    {
+        int start = 0;
+#ifdef SAIGA_HAS_X86_SIMD
+        if (useSimd(cpuFeatures().avx2))
+        {
+            start = RGBAToGray8ScaleDown2RowAVX2(src.rowPtr(i * 2), src.rowPtr(i * 2 + 1), dst.rowPtr(i), dst.width);
+        }
+#endif
+        for (int j = start; j < dst.width; ++j)
+        {
+            dst(i, j) = op(ScaleDown2Pixel(src, i * 2, j * 2));
+        }
+    }
+}
+
+
+// ======================== Resize ========================
+
+namespace
+{
+// The contribution of the source pixels to each destination pixel.
+// Every destination pixel has exactly max_count taps. Unused taps have weight 0 and a valid index.
+struct ResizeTaps
+{
+    std::vector<int> index;
+    std::vector<float> weights;
+    int max_count = 0;
+
+    const int* idx(int i) const { return index.data() + i * max_count; }
+    const float* w(int i) const { return weights.data() + i * max_count; }
+};
+
+ResizeTaps computeResizeTaps(int src_size, int dst_size, ResizeFilter filter)
+{
+    ResizeTaps taps;
+    double scale = double(src_size) / dst_size;
+
+    if (filter == ResizeFilter::Area && scale > 1)
+    {
+        taps.max_count = int(std::ceil(scale)) + 1;
+    }
+    else
+    {
+        taps.max_count = 2;
+        filter         = ResizeFilter::Bilinear;
+    }
+
+    taps.index.resize(dst_size * taps.max_count, 0);
+    taps.weights.resize(dst_size * taps.max_count, 0);
+
+    for (int x = 0; x < dst_size; ++x)
+    {
+        int* idx = taps.index.data() + x * taps.max_count;
+        float* w = taps.weights.data() + x * taps.max_count;
+        if (filter == ResizeFilter::Bilinear)
+        {
+            double sx = (x + 0.5) * scale - 0.5;
+            int x0    = int(std::floor(sx));
+            float a   = float(sx - x0);
+            if (x0 < 0)
+            {
+                x0 = 0;
+                a  = 0;
+            }
+            if (x0 >= src_size - 1)
+            {
+                x0 = src_size - 1;
+                a  = 0;
+            }
+            idx[0] = x0;
+            idx[1] = std::min(x0 + 1, src_size - 1);
+            w[0]   = 1.0f - a;
+            w[1]   = a;
+        }
+        else
+        {
+            // The source interval [start, end) covered by this pixel
+            double start = x * scale;
+            double end   = std::min((x + 1) * scale, double(src_size));
+            int x0       = int(std::floor(start));
+            int x1       = std::min(int(std::ceil(end)), src_size);
+            SAIGA_ASSERT(x1 - x0 <= taps.max_count);
+
+            for (int k = 0; k < taps.max_count; ++k)
+            {
+                idx[k] = std::min(x0 + k, src_size - 1);
+            }
+            for (int k = x0; k < x1; ++k)
+            {
+                double overlap = std::min(end, k + 1.0) - std::max(start, double(k));
+                w[k - x0]      = float(overlap / scale);
+            }
+        }
+    }
+    return taps;
+}
+
+#ifdef SAIGA_HAS_X86_SIMD
+// Horizontal pass of one rgba row. Each pixel is processed as one 4-wide float vector.
+SAIGA_TARGET_SSE41 void ResizeHorizontalRGBASSE(const unsigned char* src_row, const ResizeTaps& taps, float* dst_row,
+                                                int n)
+{
+    for (int x = 0; x < n; ++x)
+    {
+        const int* idx = taps.idx(x);
+        const float* w = taps.w(x);
+        __m128 sum     = _mm_setzero_ps();
+        for (int k = 0; k < taps.max_count; ++k)
+        {
+            int v;
+            memcpy(&v, src_row + idx[k] * 4, sizeof(int));
+            __m128 px = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+            sum       = _mm_add_ps(sum, _mm_mul_ps(px, _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(dst_row + x * 4, sum);
+    }
+}
+
+// Rounds and saturates 8 floats per iteration to 8-bit. Returns the number of processed elements.
+SAIGA_TARGET_AVX2 int FloatToByteRoundAVX2(const float* src, unsigned char* dst, int n)
+{
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i i32 = _mm256_cvtps_epi32(_mm256_loadu_ps(src + j));
+        __m256i i16 = _mm256_packus_epi32(i32, i32);
+        __m256i i8  = _mm256_packus_epi16(i16, i16);
+        i8          = _mm256_permutevar8x32_epi32(i8, _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + j), _mm256_castsi256_si128(i8));
+    }
+    return j;
+}
+#endif
+
+template <typename T>
+struct ResizeTexel;
+
+template <>
+struct ResizeTexel<unsigned char>
+{
+    using Element                 = unsigned char;
+    static constexpr int channels = 1;
+    static void set(unsigned char* p, float v) { *p = (unsigned char)std::min(std::max(v + 0.5f, 0.f), 255.f); }
+};
+
+template <>
+struct ResizeTexel<ucvec4> : public ResizeTexel<unsigned char>
+{
+    static constexpr int channels = 4;
+};
+
+template <>
+struct ResizeTexel<float>
+{
+    using Element                 = float;
+    static constexpr int channels = 1;
+    static void set(float* p, float v) { *p = v; }
+};
+
+template <typename T>
+void ResizeImpl(ImageView<const T> src, ImageView<T> dst, ResizeFilter filter)
+{
+    using Texel         = ResizeTexel<T>;
+    using Element       = typename Texel::Element;
+    constexpr int C     = Texel::channels;
+    const int row_elems = dst.width * C;
+
+    auto htaps = computeResizeTaps(src.width, dst.width, filter);
+    auto vtaps = computeResizeTaps(src.height, dst.height, filter);
+
+    // Horizontally resampled source rows. The vertical taps are monotonic, therefore a ring buffer
+    // of max_count rows is enough and every source row is processed at most once.
+    int ring_size = vtaps.max_count;
+    std::vector<float> ring(size_t(ring_size) * row_elems);
+    std::vector<int> ring_row(ring_size, -1);
+
+    auto horizontal_row = [&](int i) -> const float* {
+        float* tmp_row = ring.data() + size_t(i % ring_size) * row_elems;
+        if (ring_row[i % ring_size] == i) return tmp_row;
+        ring_row[i % ring_size] = i;
+
+        const Element* src_row = reinterpret_cast<const Element*>(src.rowPtr(i));
+#ifdef SAIGA_HAS_X86_SIMD
+        if constexpr (std::is_same<T, ucvec4>::value)
+        {
+            if (useSimd(cpuFeatures().sse41))
+            {
+                ResizeHorizontalRGBASSE(src_row, htaps, tmp_row, dst.width);
+                return tmp_row;
+            }
+        }
+#endif
+        for (int x = 0; x < dst.width; ++x)
+        {
+            const int* idx = htaps.idx(x);
+            const float* w = htaps.w(x);
+
+            float sum[C] = {};
+            for (int k = 0; k < htaps.max_count; ++k)
+            {
+                const Element* p = src_row + idx[k] * C;
+                for (int c = 0; c < C; ++c)
+                {
+                    sum[c] += w[k] * float(p[c]);
+                }
+            }
+            for (int c = 0; c < C; ++c)
+            {
+                tmp_row[x * C + c] = sum[c];
+            }
+        }
+        return tmp_row;
+    };
+
+    // Vertical pass. The inner loop runs over contiguous rows and is vectorized by the compiler.
+    std::vector<float> acc(row_elems);
+    for (int y = 0; y < dst.height; ++y)
+    {
+        const int* idx = vtaps.idx(y);
+        const float* w = vtaps.w(y);
+
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        for (int k = 0; k < vtaps.max_count; ++k)
+        {
+            float wk = w[k];
+            if (wk == 0) continue;
+            const float* tmp_row = horizontal_row(idx[k]);
+            for (int e = 0; e < row_elems; ++e)
+            {
+                acc[e] += wk * tmp_row[e];
+            }
+        }
+
+        Element* dst_row = reinterpret_cast<Element*>(dst.rowPtr(y));
+        int start        = 0;
+#ifdef SAIGA_HAS_X86_SIMD
+        if constexpr (std::is_same<Element, unsigned char>::value)
+        {
+            if (useSimd(cpuFeatures().avx2))
+            {
+                start = FloatToByteRoundAVX2(acc.data(), dst_row, row_elems);
+            }
+        }
+#endif
+        for (int e = start; e < row_elems; ++e)
+        {
+            Texel::set(dst_row + e, acc[e]);
+        }
+    }
+}
+}  // namespace
+
+void Resize(ImageView<const unsigned char> src, ImageView<unsigned char> dst, ResizeFilter filter)
+{
+    ResizeImpl(src, dst, filter);
+}
+
+void Resize(ImageView<const ucvec4> src, ImageView<ucvec4> dst, ResizeFilter filter)
+{
+    ResizeImpl(src, dst, filter);
+}
+
+void Resize(ImageView<const float> src, ImageView<float> dst, ResizeFilter filter)
+{
+    ResizeImpl(src, dst, filter);
+}
+
 
 
 }  // namespace ImageTransformation
@@ -15,6 +15,12 @@ namespace Saiga
 {
 namespace ImageTransformation
 {
+/**
+ * Most of the kernels below have SIMD implementations (SSE4.1/AVX2) that are selected at runtime.
+ * See saiga/core/util/CpuFeatures.h. The results are identical to the scalar implementation up to
+ * floating point rounding (+-1 for 8-bit outputs).
+ */
+
 SAIGA_CORE_API void addAlphaChannel(ImageView<const ucvec3> src, ImageView<ucvec4> dst, unsigned char alpha = 255);
 SAIGA_CORE_API void RemoveAlphaChannel(ImageView<const ucvec4> src, ImageView<ucvec3> dst);
 
@@ -32,8 +38,32 @@ SAIGA_CORE_API void Gray8ToRGBA(ImageView<unsigned char> src, ImageView<ucvec4>
 
 
 
+// Averages 2x2 blocks. dst must be exactly half the size of src (rounded down).
 SAIGA_CORE_API void ScaleDown2(ImageView<const ucvec4> src, ImageView<ucvec4> dst);
 
+// Fused ScaleDown2 + RGBAToGray8. The result is identical to calling both functions after each other,
+// but the intermediate image is never written to memory.
+SAIGA_CORE_API void RGBAToGray8ScaleDown2(ImageView<const ucvec4> src, ImageView<unsigned char> dst);
+
+
+enum class ResizeFilter
+{
+    // 2x2 bilinear interpolation at the pixel centers.
+    Bilinear,
+    // Averages all source pixels covered by the destination pixel (weighted by the covered area).
+    // Use this for downsampling by non-integer factors. For upsampling it is identical to Bilinear.
+    Area
+};
+
+// General separable resize of an image to the size of dst.
+// 8-bit outputs are rounded to the nearest integer.
+SAIGA_CORE_API void Resize(ImageView<const unsigned char> src, ImageView<unsigned char> dst,
+                           ResizeFilter filter = ResizeFilter::Bilinear);
+SAIGA_CORE_API void Resize(ImageView<const ucvec4> src, ImageView<ucvec4> dst,
+                           ResizeFilter filter = ResizeFilter::Bilinear);
+SAIGA_CORE_API void Resize(ImageView<const float> src, ImageView<float> dst,
+                           ResizeFilter filter = ResizeFilter::Bilinear);
+
 
 SAIGA_CORE_API float sharpness(ImageView<const unsigned char> src);
 /**
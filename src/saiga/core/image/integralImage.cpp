@@ -0,0 +1,372 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "integralImage.h"
+
+#include "saiga/core/util/CpuFeatures.h"
+#include "saiga/core/util/Thread/omp.h"
+#include "saiga/core/util/assert.h"
+
+#include <cmath>
+#include <type_traits>
+
+#ifdef SAIGA_HAS_X86_SIMD
+#    include <immintrin.h>
+#endif
+
+namespace Saiga
+{
+namespace ImageTransformation
+{
+template <bool Squared, typename T, typename Acc>
+static void IntegralImageImpl(ImageView<const T> src, ImageView<Acc> dst)
+{
+    SAIGA_ASSERT(dst.h == src.h + 1 && dst.w == src.w + 1);
+
+    auto first = dst.rowPtr(0);
+    for (int j = 0; j < dst.w; ++j) first[j] = 0;
+
+    // Pass 1: Prefix sums of the individual rows.
+#pragma omp parallel for
+    for (int i = 0; i < src.h; ++i)
+    {
+        auto s  = src.rowPtr(i);
+        auto d  = dst.rowPtr(i + 1);
+        Acc sum = 0;
+        d[0]    = 0;
+        for (int j = 0; j < src.w; ++j)
+        {
+            Acc v = s[j];
+            if constexpr (Squared) v *= v;
+            sum += v;
+            d[j + 1] = sum;
+        }
+    }
+
+    // Pass 2: Prefix sums of the columns. Each thread processes a block of columns top to bottom, so that the
+    // rows are still accessed sequentially.
+    constexpr int block_size = 512;
+    int num_blocks           = (dst.w + block_size - 1) / block_size;
+#pragma omp parallel for
+    for (int b = 0; b < num_blocks; ++b)
+    {
+        int col_begin = b * block_size;
+        int col_end   = std::min(col_begin + block_size, dst.w);
+        for (int i = 2; i < dst.h; ++i)
+        {
+            auto prev = dst.rowPtr(i - 1);
+            auto cur  = dst.rowPtr(i);
+            for (int j = col_begin; j < col_end; ++j)
+            {
+                cur[j] += prev[j];
+            }
+        }
+    }
+}
+
+void ComputeIntegralImage(ImageView<const unsigned char> src, ImageView<uint64_t> dst)
+{
+    IntegralImageImpl<false>(src, dst);
+}
+void ComputeIntegralImage(ImageView<const uint16_t> src, ImageView<uint64_t> dst)
+{
+    IntegralImageImpl<false>(src, dst);
+}
+void ComputeIntegralImage(ImageView<const float> src, ImageView<double> dst)
+{
+    IntegralImageImpl<false>(src, dst);
+}
+void ComputeIntegralImageSquared(ImageView<const unsigned char> src, ImageView<uint64_t> dst)
+{
+    IntegralImageImpl<true>(src, dst);
+}
+void ComputeIntegralImageSquared(ImageView<const uint16_t> src, ImageView<uint64_t> dst)
+{
+    IntegralImageImpl<true>(src, dst);
+}
+void ComputeIntegralImageSquared(ImageView<const float> src, ImageView<double> dst)
+{
+    IntegralImageImpl<true>(src, dst);
+}
+
+
+// ======================== Box Filter ========================
+//
+// Separable running sums:
+//   - 'column_sums' contains the vertical sum of the current window for each column. Moving to the next row
+//     adds the entering and subtracts the leaving row.
+//   - The horizontal window sum is the difference of two entries of the prefix sum of 'column_sums'.
+// The unsigned 32-bit prefix sums of 8-bit images may overflow. The difference is still correct in modular
+// arithmetic, because a single window sum always fits into 32 bits.
+
+template <typename T>
+struct BoxFilterTypes
+{
+};
+template <>
+struct BoxFilterTypes<unsigned char>
+{
+    using ColumnType = uint32_t;
+    using PrefixType = uint32_t;
+    using ScaleType  = float;
+    // The window sum must fit into a signed int for the float conversion.
+    static constexpr int max_radius = 1024;
+};
+template <>
+struct BoxFilterTypes<uint16_t>
+{
+    using ColumnType = uint32_t;
+    using PrefixType = uint64_t;
+    using ScaleType  = float;
+    static constexpr int max_radius = 32767;
+};
+template <>
+struct BoxFilterTypes<float>
+{
+    using ColumnType = double;
+    using PrefixType = double;
+    using ScaleType  = double;
+    static constexpr int max_radius = 1 << 30;
+};
+
+template <typename T, typename ColumnType>
+static void AddRow(const T* row, ColumnType* column_sums, int n)
+{
+    for (int j = 0; j < n; ++j) column_sums[j] += row[j];
+}
+
+template <typename T, typename ColumnType>
+static void SubRow(const T* row, ColumnType* column_sums, int n)
+{
+    for (int j = 0; j < n; ++j) column_sums[j] -= row[j];
+}
+
+template <typename T, typename PrefixType, typename ScaleType>
+static inline T BoxOutput(PrefixType sum, ScaleType scale)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        return T(sum * scale);
+    }
+    else
+    {
+        return T(std::nearbyint(ScaleType(sum) * scale));
+    }
+}
+
+// Writes the pixels [begin, end) which all have the full horizontal window.
+template <typename T, typename PrefixType, typename ScaleType>
+static void BoxOutputRow(const PrefixType* prefix, T* dst, int begin, int end, int radius, ScaleType scale)
+{
+    for (int j = begin; j < end; ++j)
+    {
+        PrefixType sum = prefix[j + radius + 1] - prefix[j - radius];
+        dst[j]         = BoxOutput<T>(sum, scale);
+    }
+}
+
+#ifdef SAIGA_HAS_X86_SIMD
+SAIGA_TARGET_AVX2 static void AddRowAVX2(const unsigned char* row, uint32_t* column_sums, int n)
+{
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i v   = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j)));
+        __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column_sums + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(column_sums + j), _mm256_add_epi32(sum, v));
+    }
+    AddRow(row + j, column_sums + j, n - j);
+}
+
+SAIGA_TARGET_AVX2 static void SubRowAVX2(const unsigned char* row, uint32_t* column_sums, int n)
+{
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256i v   = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j)));
+        __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column_sums + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(column_sums + j), _mm256_sub_epi32(sum, v));
+    }
+    SubRow(row + j, column_sums + j, n - j);
+}
+
+SAIGA_TARGET_AVX2 static void AddRowAVX2(const float* row, double* column_sums, int n)
+{
+    int j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        __m256d v   = _mm256_cvtps_pd(_mm_loadu_ps(row + j));
+        __m256d sum = _mm256_loadu_pd(column_sums + j);
+        _mm256_storeu_pd(column_sums + j, _mm256_add_pd(sum, v));
+    }
+    AddRow(row + j, column_sums + j, n - j);
+}
+
+SAIGA_TARGET_AVX2 static void SubRowAVX2(const float* row, double* column_sums, int n)
+{
+    int j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        __m256d v   = _mm256_cvtps_pd(_mm_loadu_ps(row + j));
+        __m256d sum = _mm256_loadu_pd(column_sums + j);
+        _mm256_storeu_pd(column_sums + j, _mm256_sub_pd(sum, v));
+    }
+    SubRow(row + j, column_sums + j, n - j);
+}
+
+SAIGA_TARGET_AVX2 static void BoxOutputRowAVX2(const uint32_t* prefix, unsigned char* dst, int begin, int end,
+                                               int radius, float scale)
+{
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    int j                = begin;
+    for (; j + 8 <= end; j += 8)
+    {
+        __m256i a   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prefix + j + radius + 1));
+        __m256i b   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prefix + j - radius));
+        __m256 f    = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(a, b)), scale_v);
+        __m256i i32 = _mm256_cvtps_epi32(f);
+        __m128i i16 = _mm_packus_epi32(_mm256_castsi256_si128(i32), _mm256_extracti128_si256(i32, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + j), _mm_packus_epi16(i16, i16));
+    }
+    BoxOutputRow(prefix, dst, j, end, radius, scale);
+}
+
+SAIGA_TARGET_AVX2 static void BoxOutputRowAVX2(const double* prefix, float* dst, int begin, int end, int radius,
+                                               double scale)
+{
+    const __m256d scale_v = _mm256_set1_pd(scale);
+    int j                 = begin;
+    for (; j + 4 <= end; j += 4)
+    {
+        __m256d a = _mm256_loadu_pd(prefix + j + radius + 1);
+        __m256d b = _mm256_loadu_pd(prefix + j - radius);
+        _mm_storeu_ps(dst + j, _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_sub_pd(a, b), scale_v)));
+    }
+    BoxOutputRow(prefix, dst, j, end, radius, scale);
+}
+#endif
+
+// Dispatch to the SIMD kernels if they exist for this type.
+template <typename T, typename ColumnType>
+static void UpdateColumnSums(const T* add, const T* sub, ColumnType* column_sums, int n)
+{
+#ifdef SAIGA_HAS_X86_SIMD
+    if constexpr (std::is_same_v<T, unsigned char> || std::is_same_v<T, float>)
+    {
+        if (useSimd(cpuFeatures().avx2))
+        {
+            if (add) AddRowAVX2(add, column_sums, n);
+            if (sub) SubRowAVX2(sub, column_sums, n);
+            return;
+        }
+    }
+#endif
+    if (add) AddRow(add, column_sums, n);
+    if (sub) SubRow(sub, column_sums, n);
+}
+
+template <typename T, typename PrefixType, typename ScaleType>
+static void BoxOutputInterior(const PrefixType* prefix, T* dst, int begin, int end, int radius, ScaleType scale)
+{
+#ifdef SAIGA_HAS_X86_SIMD
+    if constexpr (std::is_same_v<T, unsigned char> || std::is_same_v<T, float>)
+    {
+        if (useSimd(cpuFeatures().avx2))
+        {
+            BoxOutputRowAVX2(prefix, dst, begin, end, radius, scale);
+            return;
+        }
+    }
+#endif
+    BoxOutputRow(prefix, dst, begin, end, radius, scale);
+}
+
+template <typename T>
+static void BoxFilterImpl(ImageView<const T> src, ImageView<T> dst, int radius)
+{
+    using Types      = BoxFilterTypes<T>;
+    using ColumnType = typename Types::ColumnType;
+    using PrefixType = typename Types::PrefixType;
+    using ScaleType  = typename Types::ScaleType;
+
+    SAIGA_ASSERT(src.dimensions() == dst.dimensions());
+    SAIGA_ASSERT(radius >= 0 && radius <= Types::max_radius);
+    SAIGA_ASSERT(src.data != dst.data, "Inplace box filtering is not supported.");
+
+    int h = src.h;
+    int w = src.w;
+    if (h == 0 || w == 0) return;
+
+    // Every block initializes its own column sums. The blocks are large, so that this overhead is negligible.
+    int num_blocks = std::max(1, std::min(OMP::getMaxThreads(), h / std::max(16, 2 * radius)));
+
+    // The pixels in [interior_begin, interior_end) have the full horizontal window.
+    int interior_begin = std::min(radius, w);
+    int interior_end   = std::max(w - radius, interior_begin);
+
+#pragma omp parallel for num_threads(num_blocks)
+    for (int b = 0; b < num_blocks; ++b)
+    {
+        int row_begin = int(int64_t(h) * b / num_blocks);
+        int row_end   = int(int64_t(h) * (b + 1) / num_blocks);
+
+        std::vector<ColumnType> column_sums(w, 0);
+        std::vector<PrefixType> prefix(w + 1);
+
+        for (int k = std::max(row_begin - radius, 0); k <= std::min(row_begin + radius, h - 1); ++k)
+        {
+            UpdateColumnSums<T>(src.rowPtr(k), nullptr, column_sums.data(), w);
+        }
+
+        for (int i = row_begin; i < row_end; ++i)
+        {
+            if (i > row_begin)
+            {
+                int add = i + radius;
+                int sub = i - radius - 1;
+                UpdateColumnSums<T>(add < h ? src.rowPtr(add) : nullptr, sub >= 0 ? src.rowPtr(sub) : nullptr,
+                                    column_sums.data(), w);
+            }
+
+            prefix[0] = 0;
+            for (int j = 0; j < w; ++j)
+            {
+                prefix[j + 1] = prefix[j] + column_sums[j];
+            }
+
+            int rows_in_window = std::min(i + radius, h - 1) - std::max(i - radius, 0) + 1;
+            auto out           = dst.rowPtr(i);
+
+            // Border pixels have a smaller window
+            auto border = [&](int j) {
+                int c0         = std::max(j - radius, 0);
+                int c1         = std::min(j + radius + 1, w);
+                PrefixType sum = prefix[c1] - prefix[c0];
+                out[j]         = BoxOutput<T>(sum, ScaleType(1) / (rows_in_window * (c1 - c0)));
+            };
+            for (int j = 0; j < interior_begin; ++j) border(j);
+            BoxOutputInterior(prefix.data(), out, interior_begin, interior_end, radius,
+                              ScaleType(1) / (rows_in_window * (2 * radius + 1)));
+            for (int j = interior_end; j < w; ++j) border(j);
+        }
+    }
+}
+
+void BoxFilter(ImageView<const unsigned char> src, ImageView<unsigned char> dst, int radius)
+{
+    BoxFilterImpl(src, dst, radius);
+}
+void BoxFilter(ImageView<const uint16_t> src, ImageView<uint16_t> dst, int radius)
+{
+    BoxFilterImpl(src, dst, radius);
+}
+void BoxFilter(ImageView<const float> src, ImageView<float> dst, int radius)
+{
+    BoxFilterImpl(src, dst, radius);
+}
+
+}  // namespace ImageTransformation
+}  // namespace Saiga
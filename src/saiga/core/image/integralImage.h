@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/core/image/imageView.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace Saiga
+{
+// 64-bit accumulators, so that even 16-bit images of any practical size cannot overflow.
+template <typename T>
+struct IntegralImageAccumulator
+{
+};
+template <>
+struct IntegralImageAccumulator<unsigned char>
+{
+    using type = uint64_t;
+};
+template <>
+struct IntegralImageAccumulator<uint16_t>
+{
+    using type = uint64_t;
+};
+template <>
+struct IntegralImageAccumulator<float>
+{
+    using type = double;
+};
+
+namespace ImageTransformation
+{
+/**
+ * Computes the summed area table of src (multi-threaded with OpenMP).
+ * dst must have the size (src.h + 1, src.w + 1). The first row and column are set to zero and
+ *
+ *   dst(i, j) = sum of src(y, x) for all y < i and x < j.
+ *
+ * The squared variants sum up src(y, x)^2. They are used for variance queries.
+ */
+SAIGA_CORE_API void ComputeIntegralImage(ImageView<const unsigned char> src, ImageView<uint64_t> dst);
+SAIGA_CORE_API void ComputeIntegralImage(ImageView<const uint16_t> src, ImageView<uint64_t> dst);
+SAIGA_CORE_API void ComputeIntegralImage(ImageView<const float> src, ImageView<double> dst);
+
+SAIGA_CORE_API void ComputeIntegralImageSquared(ImageView<const unsigned char> src, ImageView<uint64_t> dst);
+SAIGA_CORE_API void ComputeIntegralImageSquared(ImageView<const uint16_t> src, ImageView<uint64_t> dst);
+SAIGA_CORE_API void ComputeIntegralImageSquared(ImageView<const float> src, ImageView<double> dst);
+
+/**
+ * Mean filter with a (2 * radius + 1)^2 box (multi-threaded with OpenMP + runtime dispatched AVX2).
+ * The runtime is independent of the radius. Near the border only the pixels inside the image are
+ * averaged. Integer outputs are rounded to the nearest integer (+-1).
+ * src and dst must have the same size and must not overlap.
+ */
+SAIGA_CORE_API void BoxFilter(ImageView<const unsigned char> src, ImageView<unsigned char> dst, int radius);
+SAIGA_CORE_API void BoxFilter(ImageView<const uint16_t> src, ImageView<uint16_t> dst, int radius);
+SAIGA_CORE_API void BoxFilter(ImageView<const float> src, ImageView<float> dst, int radius);
+
+}  // namespace ImageTransformation
+
+
+/**
+ * A summed area table for O(1) rectangle sum, mean and variance queries.
+ *
+ * Usage:
+ *
+ *   IntegralImage<unsigned char> integral(image, true);
+ *   double m = integral.BoxMean(y, x, 5);
+ *   double v = integral.BoxVariance(y, x, 5);
+ *
+ * The rectangles are given as [row_begin, row_end) x [col_begin, col_end) in image coordinates.
+ */
+template <typename T>
+class IntegralImage
+{
+   public:
+    using AccumulatorType = typename IntegralImageAccumulator<T>::type;
+
+    IntegralImage() {}
+    IntegralImage(ImageView<const T> src, bool with_squares = false) { create(src, with_squares); }
+
+    // Recomputes the tables. The memory is reused if the size doesn't change.
+    void create(ImageView<const T> src, bool with_squares = false)
+    {
+        rows = src.rows;
+        cols = src.cols;
+        sums.resize(size_t(rows + 1) * (cols + 1));
+        ImageTransformation::ComputeIntegralImage(src, table());
+        if (with_squares)
+        {
+            squared_sums.resize(sums.size());
+            ImageTransformation::ComputeIntegralImageSquared(src, squaredTable());
+        }
+        else
+        {
+            squared_sums.clear();
+        }
+    }
+
+    AccumulatorType Sum(int row_begin, int col_begin, int row_end, int col_end) const
+    {
+        return RectSum(sums, row_begin, col_begin, row_end, col_end);
+    }
+
+    AccumulatorType SquaredSum(int row_begin, int col_begin, int row_end, int col_end) const
+    {
+        SAIGA_ASSERT(hasSquares());
+        return RectSum(squared_sums, row_begin, col_begin, row_end, col_end);
+    }
+
+    double Mean(int row_begin, int col_begin, int row_end, int col_end) const
+    {
+        double n = double(row_end - row_begin) * (col_end - col_begin);
+        return double(Sum(row_begin, col_begin, row_end, col_end)) / n;
+    }
+
+    // Population variance E[x^2] - E[x]^2 of the rectangle.
+    double Variance(int row_begin, int col_begin, int row_end, int col_end) const
+    {
+        double n    = double(row_end - row_begin) * (col_end - col_begin);
+        double mean = double(Sum(row_begin, col_begin, row_end, col_end)) / n;
+        double sq   = double(SquaredSum(row_begin, col_begin, row_end, col_end)) / n;
+        return std::max(sq - mean * mean, 0.0);
+    }
+
+    // Queries for the (2 * radius + 1)^2 box around (row, col) clipped to the image.
+    double BoxMean(int row, int col, int radius) const
+    {
+        auto [r0, c0, r1, c1] = ClipBox(row, col, radius);
+        return Mean(r0, c0, r1, c1);
+    }
+
+    double BoxVariance(int row, int col, int radius) const
+    {
+        auto [r0, c0, r1, c1] = ClipBox(row, col, radius);
+        return Variance(r0, c0, r1, c1);
+    }
+
+    bool hasSquares() const { return !squared_sums.empty(); }
+
+    ImageView<AccumulatorType> table() { return ImageView<AccumulatorType>(rows + 1, cols + 1, sums.data()); }
+    ImageView<AccumulatorType> squaredTable()
+    {
+        return ImageView<AccumulatorType>(rows + 1, cols + 1, squared_sums.data());
+    }
+
+    int rows = 0, cols = 0;
+
+   private:
+    std::vector<AccumulatorType> sums;
+    std::vector<AccumulatorType> squared_sums;
+
+    AccumulatorType RectSum(const std::vector<AccumulatorType>& t, int row_begin, int col_begin, int row_end,
+                            int col_end) const
+    {
+        size_t stride = cols + 1;
+        return t[row_end * stride + col_end] - t[row_begin * stride + col_end] - t[row_end * stride + col_begin] +
+               t[row_begin * stride + col_begin];
+    }
+
+    std::tuple<int, int, int, int> ClipBox(int row, int col, int radius) const
+    {
+        return {std::max(row - radius, 0), std::max(col - radius, 0), std::min(row + radius + 1, rows),
+                std::min(col + radius + 1, cols)};
+    }
+};
+
+}  // namespace Saiga
@@ -6,7 +6,9 @@
 
 #include "saiga/core/image/managedImage.h"
 
+#include "saiga/core/image/imageBufferPool.h"
 #include "saiga/core/util/BinaryFile.h"
+#include "saiga/core/util/MemoryMappedFile.h"
 #include "saiga/core/util/assert.h"
 #include "saiga/core/util/file.h"
 #include "saiga/core/util/zlib.h"
@@ -35,17 +37,117 @@ Image::Image(int h, int w, ImageType type)
 
 Image::Image(ImageDimensions dimensions, ImageType type) : Image(dimensions.h, dimensions.w, type) {}
 
+Image::Image(int h, int w, ImageType type, std::shared_ptr<ImageBufferPool> pool)
+    : ImageBase(h, w, iAlignUp(elementSize(type) * w, DEFAULT_ALIGNMENT)), type(type), buffer_pool(std::move(pool))
+{
+    create();
+}
+
+Image::~Image()
+{
+    releaseBuffer();
+}
+
+Image::Image(const Image& other) : ImageBase(other), type(other.type), buffer_pool(other.buffer_pool)
+{
+    if (buffer_pool)
+    {
+        vdata = buffer_pool->acquire(other.size());
+        std::copy(other.data8(), other.data8() + other.size(), vdata.begin());
+    }
+    else if (other.isMapped())
+    {
+        vdata.assign(other.data8(), other.data8() + other.size());
+    }
+    else
+    {
+        vdata = other.vdata;
+    }
+}
+
+Image& Image::operator=(const Image& other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    if (buffer_pool)
+    {
+        // Keep the pool and reuse the current buffer if it is large enough.
+        ImageBase::operator=(other);
+        type = other.type;
+        if (other.size() == 0)
+        {
+            free();
+            pitchBytes = other.pitchBytes;
+        }
+        else
+        {
+            create();
+            std::copy(other.data8(), other.data8() + other.size(), data8());
+        }
+    }
+    else
+    {
+        Image tmp(other);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
+Image& Image::operator=(Image&& other)
+{
+    if (this != &other)
+    {
+        releaseBuffer();
+        ImageBase::operator=(other);
+        type          = other.type;
+        vdata         = std::move(other.vdata);
+        mapped_file   = std::move(other.mapped_file);
+        mapped_offset = other.mapped_offset;
+        buffer_pool   = std::move(other.buffer_pool);
+    }
+    return *this;
+}
+
+void Image::releaseBuffer()
+{
+    if (buffer_pool)
+    {
+        buffer_pool->release(std::move(vdata));
+    }
+    vdata.clear();
+}
+
+uint8_t* Image::mappedData() const
+{
+    return reinterpret_cast<uint8_t*>(mapped_file->data()) + mapped_offset;
+}
+
 
 void Image::create()
 {
     SAIGA_ASSERT(width > 0 && height > 0 && type != TYPE_UNKNOWN);
 
+    // Creating a new image always switches back to owned storage.
+    mapped_file.reset();
+    mapped_offset = 0;
+
     if (pitchBytes == 0)
     {
         pitchBytes = iAlignUp(elementSize(type) * width, DEFAULT_ALIGNMENT);
     }
 
-    vdata.resize(size());
+    if (buffer_pool && vdata.capacity() < size())
+    {
+        releaseBuffer();
+        vdata = buffer_pool->acquire(size());
+    }
+    else
+    {
+        vdata.resize(size());
+    }
 
     SAIGA_ASSERT(valid());
 }
@@ -80,24 +182,43 @@ void Image::create(int h, int w, int p, ImageType t)
 
 void Image::clear()
 {
-    (*this) = Image();
+    auto pool   = buffer_pool;
+    (*this)     = Image();
+    buffer_pool = std::move(pool);
 }
 
 void Image::free()
 {
     pitchBytes = 0;
-    vdata.clear();
+    mapped_file.reset();
+    mapped_offset = 0;
+    releaseBuffer();
     vdata.shrink_to_fit();
 }
 
 void Image::makeZero()
 {
-    std::fill(vdata.begin(), vdata.end(), 0);
+    if (mapped_file)
+    {
+        std::fill(data8(), data8() + size(), 0);
+    }
+    else
+    {
+        std::fill(vdata.begin(), vdata.end(), 0);
+    }
 }
 
 bool Image::valid() const
 {
-    return width > 0 && height > 0 && pitchBytes > 0 && type != TYPE_UNKNOWN && size() == vdata.size();
+    if (!(width > 0 && height > 0 && pitchBytes > 0 && type != TYPE_UNKNOWN))
+    {
+        return false;
+    }
+    if (mapped_file)
+    {
+        return mapped_offset + size() <= mapped_file->size();
+    }
+    return size() == vdata.size();
 }
 
 
@@ -190,47 +311,112 @@ bool Image::save(const std::string& path) const
 
 constexpr int saiga_image_magic_number            = 8574385;
 constexpr int saiga_compressed_image_magic_number = 198760233;
+constexpr int saiga_aligned_image_magic_number    = 451196782;
 constexpr size_t saiga_image_header_size          = 4 * sizeof(int);
 
+// The aligned format extends the header by the pitch and the offset of the first pixel.
+// The offset is a multiple of this value, which covers the page size of all common systems.
+constexpr size_t saiga_aligned_image_data_alignment = 4096;
+constexpr size_t saiga_aligned_image_header_size    = saiga_image_header_size + 2 * sizeof(int64_t);
 
+static_assert(sizeof(ImageType) == sizeof(int), "The raw header stores the image type as int.");
 
-bool Image::loadRaw(const std::string& path)
+namespace
 {
-    clear();
+struct RawImageHeader
+{
+    int magic      = 0;
+    int width      = 0;
+    int height     = 0;
+    ImageType type = TYPE_UNKNOWN;
 
+    // only used by the aligned format
+    int64_t pitch       = 0;
+    int64_t data_offset = 0;
 
+    bool read(std::istream& strm)
+    {
+        strm.read((char*)&magic, sizeof(int));
+        strm.read((char*)&width, sizeof(int));
+        strm.read((char*)&height, sizeof(int));
+        strm.read((char*)&type, sizeof(int));
+        if (magic == saiga_aligned_image_magic_number)
+        {
+            strm.read((char*)&pitch, sizeof(int64_t));
+            strm.read((char*)&data_offset, sizeof(int64_t));
+        }
+        return strm.good();
+    }
 
-    auto data = File::loadFileBinary(path);
-    BinaryInputVector stream(data.data(), data.size());
+    bool read(ArrayView<const char> data)
+    {
+        if (data.size() < saiga_image_header_size) return false;
+        memcpy(&magic, data.data(), sizeof(int));
+        memcpy(&width, data.data() + 1 * sizeof(int), sizeof(int));
+        memcpy(&height, data.data() + 2 * sizeof(int), sizeof(int));
+        memcpy(&type, data.data() + 3 * sizeof(int), sizeof(int));
+        if (magic == saiga_aligned_image_magic_number)
+        {
+            if (data.size() < saiga_aligned_image_header_size) return false;
+            memcpy(&pitch, data.data() + saiga_image_header_size, sizeof(int64_t));
+            memcpy(&data_offset, data.data() + saiga_image_header_size + sizeof(int64_t), sizeof(int64_t));
+        }
+        return true;
+    }
 
-    int magic;
-    stream >> magic >> width >> height >> type;
+    void write(std::ostream& strm) const
+    {
+        strm.write((const char*)&magic, sizeof(int));
+        strm.write((const char*)&width, sizeof(int));
+        strm.write((const char*)&height, sizeof(int));
+        strm.write((const char*)&type, sizeof(int));
+        if (magic == saiga_aligned_image_magic_number)
+        {
+            strm.write((const char*)&pitch, sizeof(int64_t));
+            strm.write((const char*)&data_offset, sizeof(int64_t));
+        }
+    }
+};
+}  // namespace
 
 
+bool Image::loadRaw(const std::string& path)
+{
+    clear();
 
-    bool compress = false;
-    if (magic == saiga_image_magic_number)
+    std::ifstream strm(path, std::ios::binary | std::ios::in);
+    if (!strm.is_open())
     {
-        compress = false;
-    }
-    else if (magic == saiga_compressed_image_magic_number)
-    {
-        compress = true;
+        std::cout << "File not found " << path << std::endl;
+        return false;
     }
-    else
+
+    RawImageHeader header;
+    if (!header.read(strm))
     {
-        SAIGA_EXIT_ERROR("invalid magic number");
+        return false;
     }
 
+    width  = header.width;
+    height = header.height;
+    type   = header.type;
+    SAIGA_ASSERT(type != TYPE_UNKNOWN);
+
     pitchBytes = 0;
     create();
-    SAIGA_ASSERT(type != TYPE_UNKNOWN);
     int es = elementSize(type);
 
-    if (compress)
+    if (header.magic == saiga_compressed_image_magic_number)
     {
 #ifdef SAIGA_USE_ZLIB
-        auto uncompressed = Saiga::uncompress(stream.data + stream.current);
+        // The compressed block needs to be in memory as a whole.
+        strm.seekg(0, std::ios::end);
+        size_t compressed_size = size_t(strm.tellg()) - saiga_image_header_size;
+        std::vector<char> compressed(compressed_size);
+        strm.seekg(saiga_image_header_size, std::ios::beg);
+        strm.read(compressed.data(), compressed_size);
+
+        auto uncompressed = Saiga::uncompress(compressed.data());
         size_t line_size  = width * es;
         for (int i = 0; i < height; ++i)
         {
@@ -241,47 +427,153 @@ bool Image::loadRaw(const std::string& path)
         SAIGA_EXIT_ERROR("zlib required!");
 #endif
     }
-    else
+    else if (header.magic == saiga_image_magic_number)
+    {
+        // Read directly into the image rows without an intermediate buffer.
+        for (int i = 0; i < height; ++i)
+        {
+            strm.read((char*)rowPtr(i), width * es);
+        }
+    }
+    else if (header.magic == saiga_aligned_image_magic_number)
     {
         for (int i = 0; i < height; ++i)
         {
-            stream.read((char*)rowPtr(i), width * es);
+            strm.seekg(header.data_offset + i * header.pitch, std::ios::beg);
+            strm.read((char*)rowPtr(i), width * es);
         }
     }
+    else
+    {
+        SAIGA_EXIT_ERROR("invalid magic number");
+    }
 
-    return true;
+    return strm.good();
 }
 
 bool Image::saveRaw(const std::string& path, bool do_compress) const
 {
-    BinaryOutputVector stream;
-
-    int magic = do_compress ? saiga_compressed_image_magic_number : saiga_image_magic_number;
-    stream << magic << width << height << type;
-    SAIGA_ASSERT(stream.data.size() == saiga_image_header_size);
+    SAIGA_ASSERT(valid());
 
-    int es = elementSize(type);
-    for (int i = 0; i < height; ++i)
+    std::ofstream strm(path, std::ios::binary | std::ios::out);
+    if (!strm.is_open())
     {
-        // store it compact
-        stream.write((char*)rowPtr(i), width * es);
+        std::cout << "Could not open " << path << std::endl;
+        return false;
     }
 
+    RawImageHeader header;
+    header.magic  = do_compress ? saiga_compressed_image_magic_number : saiga_image_magic_number;
+    header.width  = width;
+    header.height = height;
+    header.type   = type;
+
+    int es           = elementSize(type);
+    size_t line_size = width * es;
+
 #ifdef SAIGA_USE_ZLIB
     if (do_compress)
     {
-        auto compressed_data =
-            Saiga::compress(stream.data.data() + saiga_image_header_size, stream.data.size() - saiga_image_header_size);
+        header.write(strm);
 
-        std::ofstream is(path, std::ios::binary | std::ios::out);
-        is.write(stream.data.data(), saiga_image_header_size);
-        is.write((const char*)compressed_data.data(), compressed_data.size());
+        // zlib requires a contiguous input. Images without padding are compressed in place.
+        std::vector<unsigned char> compressed_data;
+        if (line_size == pitchBytes)
+        {
+            compressed_data = Saiga::compress(data8(), size());
+        }
+        else
+        {
+            std::vector<unsigned char> compact(line_size * height);
+            for (int i = 0; i < height; ++i)
+            {
+                memcpy(compact.data() + i * line_size, rowPtr(i), line_size);
+            }
+            compressed_data = Saiga::compress(compact.data(), compact.size());
+        }
+        strm.write((const char*)compressed_data.data(), compressed_data.size());
+        return strm.good();
     }
-    else
 #endif
+
+    // The uncompressed format is streamed row by row into the file.
+    header.magic = saiga_image_magic_number;
+    header.write(strm);
+    for (int i = 0; i < height; ++i)
     {
-        File::saveFileBinary(path, stream.data.data(), stream.data.size());
+        // store it compact
+        strm.write((const char*)rowPtr(i), line_size);
     }
+    return strm.good();
+}
+
+bool Image::saveRawAligned(const std::string& path) const
+{
+    SAIGA_ASSERT(valid());
+
+    std::ofstream strm(path, std::ios::binary | std::ios::out);
+    if (!strm.is_open())
+    {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    RawImageHeader header;
+    header.magic       = saiga_aligned_image_magic_number;
+    header.width       = width;
+    header.height      = height;
+    header.type        = type;
+    header.pitch       = pitchBytes;
+    header.data_offset = iAlignUp(saiga_aligned_image_header_size, saiga_aligned_image_data_alignment);
+    header.write(strm);
+
+    std::vector<char> padding(header.data_offset - saiga_aligned_image_header_size, 0);
+    strm.write(padding.data(), padding.size());
+
+    // The rows are stored with pitch so the complete block can be written at once.
+    strm.write((const char*)data8(), size());
+    return strm.good();
+}
+
+bool Image::loadRawMapped(const std::string& path)
+{
+    clear();
+
+    auto file = std::make_shared<MemoryMappedFile>();
+    if (!file->open(path))
+    {
+        std::cout << "File not found " << path << std::endl;
+        return false;
+    }
+
+    RawImageHeader header;
+    if (!header.read(file->view()))
+    {
+        return false;
+    }
+
+    if (header.magic != saiga_aligned_image_magic_number)
+    {
+        // Compact or compressed files can not be used as storage directly.
+        return loadRaw(path);
+    }
+
+    width      = header.width;
+    height     = header.height;
+    type       = header.type;
+    pitchBytes = header.pitch;
+    SAIGA_ASSERT(type != TYPE_UNKNOWN);
+
+    if (header.data_offset + size() > file->size())
+    {
+        std::cout << "Truncated raw image " << path << std::endl;
+        clear();
+        return false;
+    }
+
+    mapped_file   = file;
+    mapped_offset = header.data_offset;
+    SAIGA_ASSERT(valid());
     return true;
 }
 
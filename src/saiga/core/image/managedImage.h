@@ -11,10 +11,14 @@
 #include "saiga/core/image/imageView.h"
 #include "saiga/core/util/DataStructures/ArrayView.h"
 
+#include <memory>
 #include <vector>
 
 namespace Saiga
 {
+class MemoryMappedFile;
+class ImageBufferPool;
+
 #define DEFAULT_ALIGNMENT 4
 /**
  * Note: The first scanline is at position data[0].
@@ -29,17 +33,37 @@ class SAIGA_CORE_API Image : public ImageBase
    protected:
     std::vector<byte_t> vdata;
 
+    // Optional external storage created by loadRawMapped().
+    // If set, the pixels are located at mapped_file->data() + mapped_offset and vdata is empty.
+    std::shared_ptr<MemoryMappedFile> mapped_file;
+    size_t mapped_offset = 0;
+
+    // Optional pool from which vdata is acquired and to which it is returned.
+    // See setBufferPool().
+    std::shared_ptr<ImageBufferPool> buffer_pool;
+
    public:
     Image() {}
     Image(ImageType type) : type(type) {}
     Image(int h, int w, ImageType type);
     Image(ImageDimensions dimensions, ImageType type);
+    Image(int h, int w, ImageType type, std::shared_ptr<ImageBufferPool> pool);
     Image(const std::string& file)
     {
         auto res = load(file);
         SAIGA_ASSERT(res);
     }
 
+    ~Image();
+
+    // Copies of a mapped image own their data. Moves keep the mapping.
+    // Copy construction and moves take the buffer pool of 'other'.
+    // Copy assignment to an image with a buffer pool keeps its pool.
+    Image(const Image& other);
+    Image& operator=(const Image& other);
+    Image(Image&& other) = default;
+    Image& operator=(Image&& other);
+
     // Note: This creates a copy of img
     template <typename T>
     Image(ImageView<T> img)
@@ -55,8 +79,20 @@ class SAIGA_CORE_API Image : public ImageBase
     void create(int h, int w, ImageType t);
     void create(int h, int w, int p, ImageType t);
 
+    // Resets the image to an empty state. The buffer pool is kept.
     void clear();
+    // Releases the pixel data. If a buffer pool is set, the memory is returned to the pool.
     void free();
+
+    /**
+     * @brief setBufferPool
+     * Attaches this image to a buffer pool. All following create() calls acquire their memory from the
+     * pool and the memory is returned to it on free(), clear(), reallocation and destruction.
+     * This removes the malloc/free churn of images that are recreated every frame.
+     */
+    void setBufferPool(std::shared_ptr<ImageBufferPool> pool) { buffer_pool = std::move(pool); }
+    const std::shared_ptr<ImageBufferPool>& bufferPool() const { return buffer_pool; }
+
     /**
      * @brief makeZero
      * Sets all data to 0.
@@ -69,11 +105,18 @@ class SAIGA_CORE_API Image : public ImageBase
      */
     bool valid() const;
 
-    void* data() { return vdata.data(); }
-    const void* data() const { return vdata.data(); }
+    void* data() { return data8(); }
+    const void* data() const { return data8(); }
+
+    uint8_t* data8() { return mapped_file ? mappedData() : vdata.data(); }
+    const uint8_t* data8() const { return mapped_file ? mappedData() : vdata.data(); }
 
-    uint8_t* data8() { return vdata.data(); }
-    const uint8_t* data8() const { return vdata.data(); }
+    /**
+     * @brief isMapped
+     * True if the pixel data references a memory mapped file instead of an owned buffer.
+     * See loadRawMapped().
+     */
+    bool isMapped() const { return mapped_file != nullptr; }
 
 
     template <typename T>
@@ -141,6 +184,19 @@ class SAIGA_CORE_API Image : public ImageBase
     bool loadRaw(const std::string& path);
     bool saveRaw(const std::string& path, bool compress = false) const;
 
+    // Page aligned variant of the raw format.
+    // The pixel data starts at a page boundary and the rows are stored with the image pitch.
+    // Files written by this function can be loaded with loadRawMapped() without copying any pixels.
+    // loadRaw() can read these files as well.
+    bool saveRawAligned(const std::string& path) const;
+
+    // Memory maps a raw image file and uses the mapping as pixel storage (zero-copy).
+    // The mapping is private: writing to the image does not change the file.
+    // The pages are shared with the OS page cache until they are modified.
+    // Files in the compact (or compressed) raw format are loaded with loadRaw() instead.
+    // Note: The file must not be truncated or overwritten while the image is alive.
+    bool loadRawMapped(const std::string& path);
+
     /**
      * Tries to convert the given image to a storable format.
      * For example:
@@ -153,6 +209,10 @@ class SAIGA_CORE_API Image : public ImageBase
     void decompress(std::vector<uint8_t> data);
 
     SAIGA_CORE_API friend std::ostream& operator<<(std::ostream& os, const Image& f);
+
+   private:
+    uint8_t* mappedData() const;
+    void releaseBuffer();
 };
 
 
@@ -22,6 +22,10 @@ class TemplatedImage : public Image
     TemplatedImage() : Image(TType::type) {}
     TemplatedImage(int h, int w) : Image(h, w, TType::type) {}
     TemplatedImage(ImageDimensions dimensions) : Image(dimensions, TType::type) {}
+    // The memory is acquired from the given pool. See Image::setBufferPool().
+    TemplatedImage(int h, int w, std::shared_ptr<ImageBufferPool> pool) : Image(h, w, TType::type, std::move(pool))
+    {
+    }
     TemplatedImage(const std::string& file)
     {
         auto res = load(file);
@@ -80,6 +84,25 @@ class TemplatedImage : public Image
         SAIGA_ASSERT(type == TType::type);
         return r;
     }
+
+    // Zero-copy load of an aligned raw image + type check.
+    // See Image::loadRawMapped.
+    bool loadRawMapped(const std::string& path)
+    {
+        auto r = Image::loadRawMapped(path);
+        if (!r)
+        {
+            return false;
+        }
+
+        if (type != TType::type)
+        {
+            std::cerr << "Image type does not match template argument!" << std::endl;
+            std::cerr << "Path:     " << path << std::endl;
+            SAIGA_EXIT_ERROR("Image Load failed!");
+        }
+        return r;
+    }
 };
 
 
@@ -12,6 +12,7 @@
 #include "internal/noGraphicsAPI.h"
 
 #include "model_loader_obj.h"
+#include "model_loader_off.h"
 #include "model_loader_ply.h"
 
 #ifdef SAIGA_USE_ASSIMP
@@ -38,18 +39,36 @@ UnifiedModel::UnifiedModel(const std::string& file_name)
 
     std::string type = fileEnding(file_name);
 
-    if (type == "obj")
+    if (type == "saiga_model")
     {
-        ObjModelLoader loader(full_file);
-        *this = loader.out_model;
-        for (auto& v : loader.outVertices)
+        if (!LoadBinary(full_file))
         {
-            position.push_back(v.position.head<3>());
-            normal.push_back(v.normal.head<3>());
-            texture_coordinates.push_back(v.texture);
+            throw std::runtime_error("Invalid binary model " + full_file);
         }
+        return;
+    }
+
+    if (binary_cache && LoadBinaryCache(full_file))
+    {
+        return;
+    }
+
+    if (type == "obj")
+    {
+        ObjModelLoader loader(full_file);
+        *this = std::move(loader.out_model);
         LocateTextures(full_file);
     }
+    else if (type == "ply")
+    {
+        PLYLoader loader(full_file);
+        *this = std::move(loader.model);
+    }
+    else if (type == "off")
+    {
+        OffModelLoader loader(full_file);
+        *this = std::move(loader.model);
+    }
 #ifdef SAIGA_USE_ASSIMP
     else
     {
@@ -65,6 +84,11 @@ UnifiedModel::UnifiedModel(const std::string& file_name)
             "\n You can compile saiga with Assimp to increase the number of supported file formats.");
     }
 #endif
+
+    if (binary_cache)
+    {
+        SaveBinaryCache(full_file);
+    }
 }
 
 
@@ -119,6 +143,32 @@ UnifiedModel& UnifiedModel::FlipNormals()
     return *this;
 }
 
+UnifiedModel& UnifiedModel::CalculateVertexNormals()
+{
+    normal.clear();
+    normal.resize(position.size(), vec3(0, 0, 0));
+
+    for (auto& t : triangles)
+    {
+        vec3 a = position[t(0)];
+        vec3 b = position[t(1)];
+        vec3 c = position[t(2)];
+        // Note: do not normalize here because the length is the surface area
+        vec3 n = cross(b - a, c - a);
+        normal[t(0)] += n;
+        normal[t(1)] += n;
+        normal[t(2)] += n;
+    }
+
+#pragma omp parallel for
+    for (int i = 0; i < (int)normal.size(); ++i)
+    {
+        float len = normal[i].norm();
+        normal[i] = len > 0 ? vec3(normal[i] / len) : vec3(0, 0, 0);
+    }
+    return *this;
+}
+
 UnifiedModel& UnifiedModel::Normalize(float dimensions)
 {
     auto box = BoundingBox();
@@ -58,6 +58,16 @@ class SAIGA_CORE_API UnifiedModel
 
     void Save(const std::string& file_name);
 
+    // Native binary format. Every array is stored as one aligned block, so that the file can also be memory mapped
+    // with UnifiedModelMapped. Textures and animations are not stored.
+    void SaveBinary(const std::string& file_name) const;
+    bool LoadBinary(const std::string& file_name);
+
+    // If enabled, the constructor stores a binary copy of every parsed model next to the source file
+    // (<file>.saiga_model). The next time, the copy is loaded instead, if size and modification time (or content
+    // hash) of the source file did not change.
+    static inline bool binary_cache = true;
+
     int NumVertices() const { return position.size(); }
     int NumFaces() const { return triangles.size(); }
 
@@ -100,6 +110,10 @@ class SAIGA_CORE_API UnifiedModel
 
     UnifiedModel& FlipNormals();
 
+    // Computes smooth vertex normals from the triangles.
+    // The face normals are weighted by the triangle area.
+    UnifiedModel& CalculateVertexNormals();
+
 
 
     UnifiedModel& Normalize(float dimensions = 2.0f);
@@ -162,6 +176,9 @@ class SAIGA_CORE_API UnifiedModel
 
    private:
     void LocateTextures(const std::string& base);
+
+    bool LoadBinaryCache(const std::string& source);
+    void SaveBinaryCache(const std::string& source) const;
 };
 
 
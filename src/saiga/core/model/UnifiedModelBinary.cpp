@@ -0,0 +1,428 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "UnifiedModelBinary.h"
+
+#include "saiga/core/util/Checksum.h"
+
+#include "internal/noGraphicsAPI.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <type_traits>
+
+namespace Saiga
+{
+// ================================= Binary format =================================
+//
+// File layout (little endian):
+//   BinaryModelHeader
+//   BinaryModelSection[num_sections]
+//   Section data, each section starts at a multiple of 16 bytes
+//
+// The vertex and face sections are the raw arrays of UnifiedModel. Because mmap returns page aligned memory, all
+// arrays are correctly aligned when the file is mapped. The materials are serialized into a byte section.
+namespace
+{
+constexpr char binary_magic[8]    = {'S', 'A', 'I', 'G', 'A', 'M', 'D', 'L'};
+constexpr uint32_t binary_version = 1;
+constexpr size_t section_alignment = 16;
+
+enum BinaryModelSectionId : uint32_t
+{
+    SECTION_NAME                = 0,
+    SECTION_POSITION            = 1,
+    SECTION_NORMAL              = 2,
+    SECTION_COLOR               = 3,
+    SECTION_TEXTURE_COORDINATES = 4,
+    SECTION_DATA                = 5,
+    SECTION_BONE_INFO           = 6,
+    SECTION_TRIANGLES           = 7,
+    SECTION_LINES               = 8,
+    SECTION_MATERIAL_GROUPS     = 9,
+    SECTION_MATERIALS           = 10,
+};
+
+struct BinaryModelHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    // Only set for cache files
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+};
+
+struct BinaryModelSection
+{
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t offset;
+    uint64_t count;
+    uint64_t checksum;
+};
+
+static_assert(std::is_trivially_copyable<BoneInfo>::value, "BoneInfo is stored as raw memory");
+static_assert(sizeof(UnifiedMaterialGroup) == 3 * sizeof(int), "UnifiedMaterialGroup is stored as raw memory");
+
+struct SourceInfo
+{
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+};
+
+bool GetSourceInfo(const std::string& file, SourceInfo& info)
+{
+    std::error_code ec;
+    info.size = std::filesystem::file_size(file, ec);
+    if (ec) return false;
+    info.mtime = std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+    return !ec;
+}
+
+uint64_t SourceHash(const std::string& file)
+{
+    MemoryMappedFile mapped(file);
+    return mapped.valid() ? Checksum64(mapped.data(), mapped.size()) : 0;
+}
+
+void AppendString(std::vector<char>& dst, const std::string& str)
+{
+    uint32_t len = str.size();
+    dst.insert(dst.end(), reinterpret_cast<const char*>(&len), reinterpret_cast<const char*>(&len) + sizeof(len));
+    dst.insert(dst.end(), str.begin(), str.end());
+}
+
+std::vector<char> SerializeMaterials(const std::vector<UnifiedMaterial>& materials)
+{
+    std::vector<char> result;
+    uint32_t count = materials.size();
+    result.insert(result.end(), reinterpret_cast<const char*>(&count),
+                  reinterpret_cast<const char*>(&count) + sizeof(count));
+    for (auto& m : materials)
+    {
+        for (auto* str : {&m.name, &m.texture_diffuse, &m.texture_normal, &m.texture_bump, &m.texture_alpha,
+                          &m.texture_emissive})
+        {
+            AppendString(result, *str);
+        }
+        for (auto* c : {&m.color_diffuse, &m.color_ambient, &m.color_specular, &m.color_emissive})
+        {
+            result.insert(result.end(), reinterpret_cast<const char*>(c->data()),
+                          reinterpret_cast<const char*>(c->data() + 4));
+        }
+    }
+    return result;
+}
+
+// Sequential reader with bounds checks for the material section
+struct ByteReader
+{
+    const char* ptr;
+    const char* end;
+
+    bool read(void* dst, size_t n)
+    {
+        if (size_t(end - ptr) < n) return false;
+        std::memcpy(dst, ptr, n);
+        ptr += n;
+        return true;
+    }
+
+    bool read(std::string& str)
+    {
+        uint32_t len;
+        if (!read(&len, sizeof(len)) || size_t(end - ptr) < len) return false;
+        str.assign(ptr, len);
+        ptr += len;
+        return true;
+    }
+};
+
+bool DeserializeMaterials(const char* data, size_t size, std::vector<UnifiedMaterial>& materials)
+{
+    ByteReader reader = {data, data + size};
+    uint32_t count    = 0;
+    if (size > 0 && !reader.read(&count, sizeof(count))) return false;
+    materials.resize(count);
+    for (auto& m : materials)
+    {
+        for (auto* str : {&m.name, &m.texture_diffuse, &m.texture_normal, &m.texture_bump, &m.texture_alpha,
+                          &m.texture_emissive})
+        {
+            if (!reader.read(*str)) return false;
+        }
+        for (auto* c : {&m.color_diffuse, &m.color_ambient, &m.color_specular, &m.color_emissive})
+        {
+            if (!reader.read(c->data(), 4 * sizeof(float))) return false;
+        }
+    }
+    return reader.ptr == reader.end;
+}
+
+template <typename T>
+std::vector<T> ToVector(ArrayView<const T> view)
+{
+    return std::vector<T>(view.data(), view.data() + view.size());
+}
+
+bool WriteBinary(const UnifiedModel& model, const std::string& file, const SourceInfo& source)
+{
+    struct Block
+    {
+        uint32_t id;
+        uint32_t element_size;
+        const char* data;
+        uint64_t count;
+    };
+
+    auto materials = SerializeMaterials(model.materials);
+
+    auto block = [](uint32_t id, const auto& v) {
+        using T = typename std::decay_t<decltype(v)>::value_type;
+        return Block{id, sizeof(T), reinterpret_cast<const char*>(v.data()), v.size()};
+    };
+
+    std::vector<Block> blocks = {
+        {SECTION_NAME, 1, model.name.data(), model.name.size()},
+        block(SECTION_POSITION, model.position),
+        block(SECTION_NORMAL, model.normal),
+        block(SECTION_COLOR, model.color),
+        block(SECTION_TEXTURE_COORDINATES, model.texture_coordinates),
+        block(SECTION_DATA, model.data),
+        block(SECTION_BONE_INFO, model.bone_info),
+        block(SECTION_TRIANGLES, model.triangles),
+        block(SECTION_LINES, model.lines),
+        block(SECTION_MATERIAL_GROUPS, model.material_groups),
+        {SECTION_MATERIALS, 1, materials.data(), materials.size()},
+    };
+
+    BinaryModelHeader header;
+    std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+    header.version      = binary_version;
+    header.num_sections = blocks.size();
+    header.source_size  = source.size;
+    header.source_mtime = source.mtime;
+    header.source_hash  = source.hash;
+
+    auto align = [](size_t offset) { return (offset + section_alignment - 1) / section_alignment * section_alignment; };
+
+    std::vector<BinaryModelSection> sections(blocks.size());
+    size_t offset = align(sizeof(BinaryModelHeader) + sizeof(BinaryModelSection) * blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        auto& b        = blocks[i];
+        size_t bytes   = b.count * b.element_size;
+        auto& s        = sections[i];
+        s.id           = b.id;
+        s.element_size = b.element_size;
+        s.offset       = offset;
+        s.count        = b.count;
+        s.checksum     = Checksum64(b.data, bytes);
+        offset         = align(offset + bytes);
+    }
+
+    std::ofstream strm(file, std::ios::binary);
+    if (!strm.is_open()) return false;
+
+    size_t written = 0;
+    auto write     = [&](const void* data, size_t size) {
+        strm.write(reinterpret_cast<const char*>(data), size);
+        written += size;
+    };
+    const char zeros[section_alignment] = {};
+
+    write(&header, sizeof(header));
+    write(sections.data(), sizeof(BinaryModelSection) * sections.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        write(zeros, sections[i].offset - written);
+        auto& b = blocks[i];
+        write(b.data, b.count * b.element_size);
+    }
+    return strm.good();
+}
+
+std::string CacheFile(const std::string& source)
+{
+    return source + ".saiga_model";
+}
+
+}  // namespace
+
+
+bool UnifiedModelMapped::open(const std::string& _file, bool verify)
+{
+    if (!file.open(_file)) return false;
+
+    const char* base = file.data();
+    size_t size      = file.size();
+
+    BinaryModelHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0 || header.version != binary_version)
+    {
+        return false;
+    }
+    if (size < sizeof(header) + sizeof(BinaryModelSection) * header.num_sections) return false;
+
+    source_size  = header.source_size;
+    source_mtime = header.source_mtime;
+    source_hash  = header.source_hash;
+
+    std::vector<BinaryModelSection> sections(header.num_sections);
+    std::memcpy(sections.data(), base + sizeof(header), sizeof(BinaryModelSection) * sections.size());
+
+    for (auto& s : sections)
+    {
+        if (s.element_size == 0 || s.count > size / s.element_size) return false;
+        size_t bytes = s.count * s.element_size;
+        if (s.offset > size || bytes > size - s.offset) return false;
+        if (s.offset % section_alignment != 0) return false;
+
+        const char* ptr = base + s.offset;
+        if (verify && Checksum64(ptr, bytes) != s.checksum)
+        {
+            std::cerr << "[UnifiedModelMapped] Checksum mismatch in " << _file << " section " << s.id << std::endl;
+            return false;
+        }
+
+        auto view = [&](auto& dst) {
+            using T = std::remove_const_t<typename std::decay_t<decltype(dst)>::value_type>;
+            if (s.element_size != sizeof(T)) return false;
+            dst = ArrayView<const T>(reinterpret_cast<const T*>(ptr), s.count);
+            return true;
+        };
+
+        bool ok = true;
+        switch (s.id)
+        {
+            case SECTION_NAME:
+                name.assign(ptr, s.count);
+                break;
+            case SECTION_POSITION:
+                ok = view(position);
+                break;
+            case SECTION_NORMAL:
+                ok = view(normal);
+                break;
+            case SECTION_COLOR:
+                ok = view(color);
+                break;
+            case SECTION_TEXTURE_COORDINATES:
+                ok = view(texture_coordinates);
+                break;
+            case SECTION_DATA:
+                ok = view(data);
+                break;
+            case SECTION_BONE_INFO:
+                ok = view(bone_info);
+                break;
+            case SECTION_TRIANGLES:
+                ok = view(triangles);
+                break;
+            case SECTION_LINES:
+                ok = view(lines);
+                break;
+            case SECTION_MATERIAL_GROUPS:
+            {
+                ArrayView<const UnifiedMaterialGroup> groups;
+                ok              = view(groups);
+                material_groups = ToVector(groups);
+                break;
+            }
+            case SECTION_MATERIALS:
+                ok = DeserializeMaterials(ptr, bytes, materials);
+                break;
+            default:
+                // Unknown sections of newer versions are ignored
+                break;
+        }
+        if (!ok) return false;
+    }
+
+    return true;
+}
+
+UnifiedModel UnifiedModelMapped::Model() const
+{
+    UnifiedModel model;
+    model.name                = name;
+    model.position            = ToVector(position);
+    model.normal              = ToVector(normal);
+    model.color               = ToVector(color);
+    model.texture_coordinates = ToVector(texture_coordinates);
+    model.data                = ToVector(data);
+    model.bone_info           = ToVector(bone_info);
+    model.triangles           = ToVector(triangles);
+    model.lines               = ToVector(lines);
+    model.materials           = materials;
+    model.material_groups     = material_groups;
+    return model;
+}
+
+
+void UnifiedModel::SaveBinary(const std::string& file_name) const
+{
+    if (!WriteBinary(*this, file_name, SourceInfo()))
+    {
+        throw std::runtime_error("Could not write file " + file_name);
+    }
+}
+
+bool UnifiedModel::LoadBinary(const std::string& file_name)
+{
+    UnifiedModelMapped mapped;
+    if (!mapped.open(file_name)) return false;
+    *this = mapped.Model();
+    return true;
+}
+
+bool UnifiedModel::LoadBinaryCache(const std::string& source)
+{
+    auto cache = CacheFile(source);
+    SourceInfo info;
+    if (!std::filesystem::exists(cache) || !GetSourceInfo(source, info)) return false;
+
+    UnifiedModelMapped mapped;
+    if (!mapped.open(cache) || mapped.source_size != info.size) return false;
+
+    // Same size but a different time stamp (for example after a checkout) -> compare the content
+    if (mapped.source_mtime != info.mtime && mapped.source_hash != SourceHash(source)) return false;
+
+    *this = mapped.Model();
+    return true;
+}
+
+void UnifiedModel::SaveBinaryCache(const std::string& source) const
+{
+    // Textures and animations are not part of the binary format
+    if (!textures.empty() || !animation_system.animations.empty()) return;
+
+    SourceInfo info;
+    if (!GetSourceInfo(source, info)) return;
+    info.hash = SourceHash(source);
+
+    // Write to a temporary file first, so that other processes never see a partial cache
+    auto cache = CacheFile(source);
+    auto tmp   = cache + ".tmp" + std::to_string(std::random_device()());
+    if (!WriteBinary(*this, tmp, info))
+    {
+        // For example a read-only model directory
+        std::filesystem::remove(tmp);
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, cache, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+}  // namespace Saiga
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/core/model/UnifiedModel.h"
+#include "saiga/core/util/DataStructures/ArrayView.h"
+#include "saiga/core/util/MemoryMappedFile.h"
+
+namespace Saiga
+{
+/**
+ * Read-only view of a model stored with UnifiedModel::SaveBinary.
+ *
+ * The vertex and face arrays point directly into the memory mapped file, so opening a model is independent of its
+ * size (except for the optional checksum test). Only the materials and material groups are copied.
+ * The arrays are valid as long as this object exists.
+ *
+ *   UnifiedModelMapped mapped;
+ *   if (mapped.open("bunny.obj.saiga_model"))
+ *   {
+ *       upload(mapped.position.data(), mapped.position.size());
+ *   }
+ */
+class SAIGA_CORE_API UnifiedModelMapped
+{
+   public:
+    // Returns false if the file is missing, has a different version or (with verify=true) is corrupted.
+    bool open(const std::string& file, bool verify = true);
+
+    // Copies the arrays into a UnifiedModel.
+    UnifiedModel Model() const;
+
+    int NumVertices() const { return position.size(); }
+    int NumFaces() const { return triangles.size(); }
+
+    std::string name;
+
+    ArrayView<const vec3> position;
+    ArrayView<const vec3> normal;
+    ArrayView<const vec4> color;
+    ArrayView<const vec2> texture_coordinates;
+    ArrayView<const vec4> data;
+    ArrayView<const BoneInfo> bone_info;
+    ArrayView<const ivec3> triangles;
+    ArrayView<const ivec2> lines;
+
+    std::vector<UnifiedMaterial> materials;
+    std::vector<UnifiedMaterialGroup> material_groups;
+
+    // Size, modification time and hash of the source file if this is a cache (see UnifiedModel::binary_cache).
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    uint64_t source_hash = 0;
+
+   private:
+    MemoryMappedFile file;
+};
+
+}  // namespace Saiga
@@ -8,6 +8,7 @@
 
 
 #include "UnifiedModel.h"
+#include "UnifiedModelBinary.h"
 
 #include "model_loader_obj.h"
 #include "model_loader_off.h"
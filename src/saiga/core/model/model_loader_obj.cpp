@@ -7,7 +7,9 @@
 #include "model_loader_obj.h"
 
 #include "saiga/core/math/String.h"
-#include "saiga/core/time/all.h"
+#include "saiga/core/util/FastTextParser.h"
+#include "saiga/core/util/MemoryMappedFile.h"
+#include "saiga/core/util/Thread/omp.h"
 #include "saiga/core/util/file.h"
 #include "saiga/core/util/fileChecker.h"
 #include "saiga/core/util/tostring.h"
@@ -15,15 +17,11 @@
 #include "internal/noGraphicsAPI.h"
 
 #include <algorithm>
-#include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 
 namespace Saiga
 {
 static StringViewParser lineParser = {"\t ,\n", true};
-static StringViewParser faceParser = {"/", false};
 
 
 struct ObjLine
@@ -128,31 +126,82 @@ std::vector<UnifiedMaterial> LoadMTL(const std::string& file)
 
 
 
+namespace
+{
+enum class ObjLineType
+{
+    Other,
+    Vertex,
+    TexCoord,
+    Normal,
+    Face,
+    MaterialLib,
+    UseMaterial,
+};
+
+inline ObjLineType objLineType(std::string_view key)
+{
+    if (key == "v") return ObjLineType::Vertex;
+    if (key == "vt") return ObjLineType::TexCoord;
+    if (key == "vn") return ObjLineType::Normal;
+    if (key == "f") return ObjLineType::Face;
+    if (key == "mtllib") return ObjLineType::MaterialLib;
+    if (key == "usemtl") return ObjLineType::UseMaterial;
+    return ObjLineType::Other;
+}
+
+// Number of elements in each chunk. After the prefix sum, the offset of each chunk in the output arrays.
+struct ObjChunkCount
+{
+    int vertices  = 0;
+    int texCoords = 0;
+    int normals   = 0;
+    int triangles = 0;
+};
+
+// mtllib and usemtl statements with the index of the following triangle
+struct ObjMaterialStatement
+{
+    int triangle;
+    ObjLineType type;
+    std::string name;
+};
+
 // parsing index vertex
 // examples:
 // v1/vt1/vn1        12/51/1
 // v1//vn1           51//4
-inline ObjModelLoader::IndexedVertex2 parseIV(std::string_view line)
+inline bool parseIV(std::string_view token, ObjModelLoader::IndexedVertex2& iv)
+{
+    const char* ptr = token.data();
+    const char* end = token.data() + token.size();
+    int* dst[3]     = {&iv.v, &iv.t, &iv.n};
+    for (int k = 0; k < 3 && ptr < end; ++k)
+    {
+        if (*ptr != '/')
+        {
+            auto result = std::from_chars(ptr, end, *dst[k]);
+            if (result.ec != std::errc()) return false;
+            ptr = result.ptr;
+        }
+        if (ptr < end)
+        {
+            if (*ptr != '/') return false;
+            ++ptr;
+        }
+    }
+    return ptr == end && iv.v != ObjModelLoader::INVALID_VERTEX_ID;
+}
+
+// OBJ indices start at 1. Negative indices are relative to the current end of the array.
+inline bool makeAbsolute(int& index, int count)
 {
-    ObjModelLoader::IndexedVertex2 iv;
-#if 0
-    std::vector<std::string> s = split(line, '/');
-    if (s.size() > 0 && s[0].size() > 0) iv.v = std::atoi(s[0].c_str()) - 1;
-    if (s.size() > 1 && s[1].size() > 0) iv.t = std::atoi(s[1].c_str()) - 1;
-    if (s.size() > 2 && s[2].size() > 0) iv.n = std::atoi(s[2].c_str()) - 1;
-#else
-    faceParser.set(line);
-    std::string_view tmp;
-    tmp = faceParser.next();
-    if (!tmp.empty()) iv.v = to_long(tmp) - 1;
-    tmp = faceParser.next();
-    if (!tmp.empty()) iv.t = to_long(tmp) - 1;
-    tmp = faceParser.next();
-    if (!tmp.empty()) iv.n = to_long(tmp) - 1;
-#endif
-    return iv;
+    if (index == ObjModelLoader::INVALID_VERTEX_ID) return true;
+    index = index < 0 ? count + index : index - 1;
+    return index >= 0 && index < count;
 }
 
+}  // namespace
 
 ObjModelLoader::ObjModelLoader(const std::string& file) : file(file)
 {
@@ -170,404 +219,316 @@ bool ObjModelLoader::loadFile(const std::string& _file)
         return false;
     }
 
-    //    std::ifstream stream(file, std::ios::in);
-    //    if (!stream.is_open())
-    //    {
-    //        throw std::runtime_error("Search Pathes broken!");
-    //    }
-
-
     std::cout << "[ObjModelLoader] Loading " << file << std::endl;
 
-    UnifiedMaterialGroup tg;
-    tg.startFace = 0;
-    tg.numFaces  = 0;
-    out_model.material_groups.push_back(tg);
-
-    std::vector<std::string> data;
-    {
-        //        SAIGA_BLOCK_TIMER();
-        data = File::loadFileStringArray(file);
-        File::removeWindowsLineEnding(data);
-    }
+    MemoryMappedFile mapped(file);
+    if (!mapped.valid())
     {
-        //        SAIGA_BLOCK_TIMER();
-        for (auto& line : data)
-        {
-            lineParser.set(line);
-            parseLine();
-        }
+        std::cerr << "Could not open file " << file << std::endl;
+        return false;
     }
+    mapped.adviseSequential();
 
-    // finish last group
-    UnifiedMaterialGroup& lastGroup = out_model.material_groups[out_model.material_groups.size() - 1];
-    lastGroup.numFaces              = faces.size() - lastGroup.startFace;
-
+    using namespace FastTextParser;
+    const char* begin = mapped.data();
+    const char* end   = mapped.data() + mapped.size();
 
-    // remove groups with 0 faces
-    out_model.material_groups.erase(std::remove_if(out_model.material_groups.begin(), out_model.material_groups.end(),
-                                                   [](const UnifiedMaterialGroup& otg) { return otg.numFaces == 0; }),
-                                    out_model.material_groups.end());
-
-    std::cout << "[ObjModelLoader] Done.  "
-              << "V " << vertices.size() << " N " << normals.size() << " T " << texCoords.size() << " F "
-              << faces.size() << " Material Groups " << out_model.material_groups.size() << std::endl;
-
-
-
-    //    std::cout<<"number of vertices "<<vertices.size()<<" number of faces "<<faces.size()<<endl;
-    createVertexIndexList();
-    //    std::cout<<"number of vertices "<<outVertices.size()<<" number of faces "<<outTriangles.size()<<endl;
-    separateVerticesByGroup();
-    //    std::cout<<"number of vertices "<<outVertices.size()<<" number of faces "<<outTriangles.size()<<endl;
-
-    calculateMissingNormals();
-
-    //    std::cout<<"objloader finished :)"<<endl;
-    return true;
-}
-
-void ObjModelLoader::separateVerticesByGroup()
-{
-    // make sure faces from different triangle groups do not reference the same vertex
-    // needs to be called after createVertexIndexList()
+    // Skip utf8 bom
+    if (mapped.size() >= 3 && (unsigned char)begin[0] == 0xEF && (unsigned char)begin[1] == 0xBB &&
+        (unsigned char)begin[2] == 0xBF)
+    {
+        begin += 3;
+    }
 
-    std::vector<int> vertexReference(outVertices.size(), INVALID_VERTEX_ID);
+    auto chunks    = SplitLines(begin, end, std::min<size_t>(4 * OMP::getMaxThreads(), mapped.size() / 65536 + 1));
+    int num_chunks = chunks.size() - 1;
 
-    for (int t = 0; t < (int)out_model.material_groups.size(); ++t)
-    {
-        UnifiedMaterialGroup& tg = out_model.material_groups[t];
-        for (int i = 0; i < tg.numFaces; ++i)
+    // The lines of a chunk are processed by this function in both passes
+    auto forEachLine = [&](int chunk, auto f) {
+        const char* ptr = chunks[chunk];
+        const char* e   = chunks[chunk + 1];
+        while (ptr < e)
         {
-            ivec3& face = out_model.triangles[i + tg.startFace];
+            const char* line_end = LineEnd(ptr, e);
+            auto key             = Token(ptr, line_end);
+            f(objLineType(key), ptr, line_end);
+            ptr = line_end + 1;
+        }
+    };
 
-            for (int j = 0; j < 3; ++j)
+    // Pass 1: Count the elements of each chunk
+    std::vector<ObjChunkCount> offsets(num_chunks + 1);
+    std::vector<std::vector<ObjMaterialStatement>> statements(num_chunks);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        ObjChunkCount& c = offsets[i + 1];
+        forEachLine(i, [&](ObjLineType type, const char* ptr, const char* line_end) {
+            switch (type)
             {
-                int index = face[j];
-                if (vertexReference[index] == INVALID_VERTEX_ID) vertexReference[index] = t;
-                if (vertexReference[index] != t)
+                case ObjLineType::Vertex:
+                    c.vertices++;
+                    break;
+                case ObjLineType::TexCoord:
+                    c.texCoords++;
+                    break;
+                case ObjLineType::Normal:
+                    c.normals++;
+                    break;
+                case ObjLineType::Face:
                 {
-                    // duplicate vertices
-                    VertexNT v   = outVertices[index];
-                    int newIndex = outVertices.size();
-                    outVertices.push_back(v);
-                    face[j] = newIndex;
-                    vertexReference.push_back(t);
-                    //                    SAIGA_ASSERT(0);
+                    int corners = 0;
+                    while (!Token(ptr, line_end).empty()) corners++;
+                    c.triangles += std::max(0, corners - 2);
+                    break;
                 }
+                case ObjLineType::MaterialLib:
+                case ObjLineType::UseMaterial:
+                    statements[i].push_back({c.triangles, type, std::string(Token(ptr, line_end))});
+                    break;
+                default:
+                    break;
             }
-        }
+        });
     }
-}
 
-void ObjModelLoader::calculateMissingNormals()
-{
-    for (auto tri : out_model.triangles)
+    for (int i = 0; i < num_chunks; ++i)
     {
-        auto& v1 = outVertices[tri[0]];
-        auto& v2 = outVertices[tri[1]];
-        auto& v3 = outVertices[tri[2]];
-
-        vec3 normal = normalize(cross(make_vec3(v3.position - v1.position), make_vec3(v2.position - v1.position)));
-
-        if (v1.normal == vec4(0, 0, 0, 0)) v1.normal = make_vec4(normal, 0);
-        if (v2.normal == vec4(0, 0, 0, 0)) v2.normal = make_vec4(normal, 0);
-        if (v3.normal == vec4(0, 0, 0, 0)) v3.normal = make_vec4(normal, 0);
+        for (auto& s : statements[i]) s.triangle += offsets[i].triangles;
+        offsets[i + 1].vertices += offsets[i].vertices;
+        offsets[i + 1].texCoords += offsets[i].texCoords;
+        offsets[i + 1].normals += offsets[i].normals;
+        offsets[i + 1].triangles += offsets[i].triangles;
     }
-}
 
-#if 0
-void ObjModelLoader::computeVertexColorAndData()
-{
-    vertexColors.resize(outVertices.size(), make_vec4(1));
-    vertexData.resize(outVertices.size(), make_vec4(0));
+    vertices.resize(offsets.back().vertices);
+    texCoords.resize(offsets.back().texCoords);
+    normals.resize(offsets.back().normals);
+    corners.resize(offsets.back().triangles * 3);
 
-    for (UnifiedMaterialGroup& tg : out_model.material_groups)
+    // Pass 2: Parse directly into the arrays
+    int errors = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : errors)
+    for (int i = 0; i < num_chunks; ++i)
     {
-        for (int i = 0; i < tg.numFaces; ++i)
-        {
-            ivec3& face = out_model.triangles[i + tg.startFace];
-            for (int f = 0; f < 3; ++f)
+        ObjChunkCount c = offsets[i];
+        forEachLine(i, [&](ObjLineType type, const char* ptr, const char* line_end) {
+            switch (type)
             {
-                int index            = face[f];
-                vertexColors[index]  = out_model.materials[tg.materialId].color_diffuse;
-                float spec           = dot(out_model.materials[tg.materialId].color_specular, make_vec4(1)) / 4.0f;
-                vertexData[index][0] = spec;
+                case ObjLineType::Vertex:
+                {
+                    vec3& v = vertices[c.vertices++];
+                    errors += !(Parse(ptr, line_end, v(0)) && Parse(ptr, line_end, v(1)) && Parse(ptr, line_end, v(2)));
+                    break;
+                }
+                case ObjLineType::TexCoord:
+                {
+                    vec2& v = texCoords[c.texCoords++];
+                    errors += !(Parse(ptr, line_end, v(0)) && Parse(ptr, line_end, v(1)));
+                    break;
+                }
+                case ObjLineType::Normal:
+                {
+                    vec3& v = normals[c.normals++];
+                    errors += !(Parse(ptr, line_end, v(0)) && Parse(ptr, line_end, v(1)) && Parse(ptr, line_end, v(2)));
+                    break;
+                }
+                case ObjLineType::Face:
+                {
+                    // Triangulate as fan: (0 1 2) (2 3 0) (3 4 0) ...
+                    IndexedVertex2 start, last;
+                    int k = 0;
+                    for (auto token = Token(ptr, line_end); !token.empty(); token = Token(ptr, line_end), ++k)
+                    {
+                        IndexedVertex2 iv;
+                        bool ok = parseIV(token, iv) && makeAbsolute(iv.v, c.vertices) &&
+                                  makeAbsolute(iv.t, c.texCoords) && makeAbsolute(iv.n, c.normals);
+                        if (!ok)
+                        {
+                            // Invalid triangles are removed in createVertexIndexList
+                            errors++;
+                            iv.v = INVALID_VERTEX_ID;
+                        }
+
+                        if (k == 2)
+                        {
+                            corners[c.triangles * 3 + 0] = start;
+                            corners[c.triangles * 3 + 1] = last;
+                            corners[c.triangles * 3 + 2] = iv;
+                            c.triangles++;
+                        }
+                        else if (k > 2)
+                        {
+                            corners[c.triangles * 3 + 0] = last;
+                            corners[c.triangles * 3 + 1] = iv;
+                            corners[c.triangles * 3 + 2] = start;
+                            c.triangles++;
+                        }
+                        if (k == 0) start = iv;
+                        last = iv;
+                    }
+                    if (k < 3)
+                    {
+                        // Degenerated face without triangles
+                        errors++;
+                    }
+                    break;
+                }
+                default:
+                    break;
             }
-        }
-    }
-}
-void ObjModelLoader::toTriangleMesh(TriangleMesh<VertexNC, uint32_t>& mesh)
-{
-    if (vertexColors.empty())
-    {
-        computeVertexColorAndData();
-    }
-
-    SAIGA_ASSERT(vertexColors.size() == outVertices.size());
-    mesh.faces.reserve( out_model.triangles.size());
-    for (ivec3& oj :  out_model.triangles)
-    {
-        mesh.addFace(oj(0), oj(1), oj(2));
-    }
-
-    mesh.vertices.reserve(outTriangles.size());
-    for (unsigned int i = 0; i < outVertices.size(); ++i)
-    {
-        auto& v = outVertices[i];
-        VertexNC vn;
-        vn.position = v.position;
-        vn.normal   = v.normal;
-        vn.color    = vertexColors[i];
-        vn.data     = vertexData[i];
-        mesh.addVertex(vn);
-    }
-}
-
-void ObjModelLoader::toTriangleMesh(TriangleMesh<VertexNTD, uint32_t>& mesh)
-{
-    //    SAIGA_ASSERT(texCoords.size() == outVertices.size());
-    if (vertexColors.empty())
-    {
-        computeVertexColorAndData();
+        });
     }
-    SAIGA_ASSERT(vertexData.size() == outVertices.size());
 
-    mesh.faces.reserve(outTriangles.size());
-    for (ivec3& oj : outTriangles)
+    if (errors > 0)
     {
-        mesh.addFace(oj(0), oj(1), oj(2));
+        std::cerr << "[ObjModelLoader] " << errors << " invalid statements in " << file << std::endl;
     }
 
-    mesh.vertices.reserve(outTriangles.size());
-    for (unsigned int i = 0; i < outVertices.size(); ++i)
-    {
-        auto& v = outVertices[i];
-        VertexNTD vn;
-        vn.position = v.position;
-        vn.normal   = v.normal;
-        vn.texture  = v.texture;
-        vn.data     = vertexData[i];
-        mesh.addVertex(vn);
-    }
-}
-#endif
-
-void ObjModelLoader::createVertexIndexList()
-{
-    std::vector<bool> vertices_used(vertices.size(), false);
-
-    outVertices.resize(vertices.size());
-
-    for (std::vector<IndexedVertex2>& f : faces)
+    // Material groups
+    UnifiedMaterialGroup tg;
+    tg.startFace = 0;
+    tg.numFaces  = 0;
+    out_model.material_groups.push_back(tg);
+    for (auto& chunk_statements : statements)
     {
-        ivec3 fa;
-        for (int i = 0; i < 3; i++)
+        for (auto& s : chunk_statements)
         {
-            IndexedVertex2& currentVertex = f[i];
-            int vert                      = currentVertex.v;
-            int norm                      = currentVertex.n;
-            int tex                       = currentVertex.t;
-
-            VertexNT verte;
-            if (vert >= 0)
-            {
-                SAIGA_ASSERT(vert < (int)vertices.size());
-                verte.position = make_vec4(vertices[vert], 1);
-            }
-            if (norm >= 0)
+            if (s.type == ObjLineType::MaterialLib)
             {
-                SAIGA_ASSERT(norm < (int)normals.size());
-                verte.normal = make_vec4(normals[norm], 0);
+                FileChecker fc;
+                std::string mtl_file = fc.getRelative(file, s.name);
+                auto materials       = LoadMTL(mtl_file);
+                out_model.materials.insert(out_model.materials.end(), materials.begin(), materials.end());
             }
-            if (tex >= 0)
-            {
-                SAIGA_ASSERT(tex < (int)texCoords.size());
-                verte.texture = texCoords[tex];
-            }
-
-
-            int index = INVALID_VERTEX_ID;
-            if (vertices_used[vert])
+            else
             {
-                if (verte == outVertices[vert])
+                // finish current group and create new one
+                UnifiedMaterialGroup& currentGroup = out_model.material_groups.back();
+                currentGroup.numFaces              = s.triangle - currentGroup.startFace;
+
+                UnifiedMaterialGroup newGroup;
+                newGroup.startFace  = s.triangle;
+                newGroup.materialId = -1;
+                for (size_t i = 0; i < out_model.materials.size(); ++i)
                 {
-                    index = vert;
+                    if (out_model.materials[i].name == s.name)
+                    {
+                        newGroup.materialId = i;
+                        break;
+                    }
                 }
+                out_model.material_groups.push_back(newGroup);
             }
-            else
-            {
-                outVertices[vert]   = verte;
-                index               = vert;
-                vertices_used[vert] = true;
-            }
-
-            if (index == INVALID_VERTEX_ID)
-            {
-                index = outVertices.size();
-                outVertices.push_back(verte);
-            }
-            fa[i] = index;
         }
-
-        out_model.triangles.push_back(fa);
     }
-}
 
-std::vector<std::vector<ObjModelLoader::IndexedVertex2>> ObjModelLoader::triangulateFace(
-    const std::vector<IndexedVertex2>& f)
-{
-    std::vector<std::vector<IndexedVertex2>> newFaces;
+    // finish last group
+    UnifiedMaterialGroup& lastGroup = out_model.material_groups.back();
+    lastGroup.numFaces              = corners.size() / 3 - lastGroup.startFace;
 
-    // more than 3 indices -> triangulate
-    std::vector<IndexedVertex2> face;
-    int cornerCount = 1;
-    IndexedVertex2 startVertex, lastVertex;
-    for (const IndexedVertex2& currentVertex : f)
-    {
-        if (cornerCount <= 3)
-        {
-            if (cornerCount == 1) startVertex = currentVertex;
-            face.push_back(currentVertex);
-            if (cornerCount == 3) newFaces.push_back(face);
-        }
-        else
-        {
-            face.resize(3);
-            face[0] = lastVertex;
-            face[1] = currentVertex;
-            face[2] = startVertex;
-            newFaces.push_back(face);
-        }
+    std::cout << "[ObjModelLoader] Done.  "
+              << "V " << vertices.size() << " N " << normals.size() << " T " << texCoords.size() << " F "
+              << corners.size() / 3 << " Material Groups " << out_model.material_groups.size() << std::endl;
 
-        lastVertex = currentVertex;
-        cornerCount++;
-    }
-    return newFaces;
+    createVertexIndexList();
+    calculateMissingNormals();
+
+    // remove groups with 0 faces
+    out_model.material_groups.erase(std::remove_if(out_model.material_groups.begin(), out_model.material_groups.end(),
+                                                   [](const UnifiedMaterialGroup& otg) { return otg.numFaces == 0; }),
+                                    out_model.material_groups.end());
+    return true;
 }
 
-void ObjModelLoader::parseLine()
+void ObjModelLoader::createVertexIndexList()
 {
-    auto header = lineParser.next();
-
-    if (header == "#")
-    {
-    }
-    else if (header == "usemtl")
+    // Output vertex i < vertices.size() is the first combination that was used with position i.
+    // Other combinations with the same position are appended and linked by 'next'.
+    // Faces from different material groups do not share vertices.
+    std::vector<IndexedVertex2> out_corner(vertices.size());
+    std::vector<int> out_group(vertices.size(), -1);
+    std::vector<int> next(vertices.size(), -1);
+
+    auto& triangles = out_model.triangles;
+    triangles.clear();
+    triangles.reserve(corners.size() / 3);
+
+    for (auto& tg : out_model.material_groups)
     {
-        // finish current group and create new one
-        if (!out_model.material_groups.empty())
+        int group          = &tg - out_model.material_groups.data();
+        int start_triangle = triangles.size();
+        for (int t = tg.startFace; t < tg.startFace + tg.numFaces; ++t)
         {
-            UnifiedMaterialGroup& currentGroup = out_model.material_groups[out_model.material_groups.size() - 1];
-            currentGroup.numFaces              = faces.size() - currentGroup.startFace;
-        }
-        UnifiedMaterialGroup newGroup;
-        newGroup.startFace = faces.size();
-
-        //         newGroup.material  = materialLoader.getMaterial(std::string(lineParser.next()));
-        //        newGroup.materialId = materialLoader.getMaterialId(std::string(lineParser.next()));
+            const IndexedVertex2* c = &corners[t * 3];
+            if (c[0].v == INVALID_VERTEX_ID || c[1].v == INVALID_VERTEX_ID || c[2].v == INVALID_VERTEX_ID) continue;
 
-        std::string mtl_name = std::string(lineParser.next());
-        int mtl_id           = -1;
-        for (size_t i = 0; i < out_model.materials.size(); ++i)
-        {
-            if (out_model.materials[i].name == mtl_name)
+            ivec3 fa;
+            for (int i = 0; i < 3; ++i)
             {
-                mtl_id = i;
-                break;
+                const IndexedVertex2& iv = c[i];
+
+                int index = iv.v;
+                if (out_group[index] == -1)
+                {
+                    out_corner[index] = iv;
+                    out_group[index]  = group;
+                }
+                else
+                {
+                    int last = index;
+                    while (index != -1 &&
+                           !(out_group[index] == group && out_corner[index].t == iv.t && out_corner[index].n == iv.n))
+                    {
+                        last  = index;
+                        index = next[index];
+                    }
+                    if (index == -1)
+                    {
+                        index      = out_corner.size();
+                        next[last] = index;
+                        out_corner.push_back(iv);
+                        out_group.push_back(group);
+                        next.push_back(-1);
+                    }
+                }
+                fa(i) = index;
             }
+            triangles.push_back(fa);
         }
-        newGroup.materialId = mtl_id;
-
-        out_model.material_groups.push_back(newGroup);
+        // Adjust the group to the removed (invalid) triangles
+        tg.startFace = start_triangle;
+        tg.numFaces  = triangles.size() - start_triangle;
     }
-    else if (header == "mtllib")
-    {
-        FileChecker fc;
 
-        std::string mtl_file = fc.getRelative(file, std::string(lineParser.next()));
+    int n = out_corner.size();
+    out_model.position.resize(n);
+    out_model.normal.resize(n);
+    out_model.texture_coordinates.resize(n);
 
-        out_model.materials = LoadMTL(mtl_file);
-    }
-    else if (header == "g")
-    {
-    }
-    else if (header == "o")
-    {
-    }
-    else if (header == "s")
-    {
-    }
-    else if (header == "v")
-    {
-        vec3 v;
-        v(0) = to_double(lineParser.next());
-        v(1) = to_double(lineParser.next());
-        v(2) = to_double(lineParser.next());
-        vertices.push_back(v);
-    }
-    else if (header == "vt")
-    {
-        vec2 v;
-        v(0) = to_double(lineParser.next());
-        v(1) = to_double(lineParser.next());
-        texCoords.push_back(v);
-    }
-    else if (header == "vn")
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
     {
-        vec3 v;
-        v(0) = to_double(lineParser.next());
-        v(1) = to_double(lineParser.next());
-        v(2) = to_double(lineParser.next());
-        normals.push_back(v);
-    }
-    else if (header == "f")
-    {
-        parseF();
+        const IndexedVertex2& iv = out_corner[i];
+        // Unused positions are kept, so that the vertex ids match the position ids of the file
+        out_model.position[i]            = i < (int)vertices.size() ? vertices[i] : vertices[iv.v];
+        out_model.normal[i]              = iv.n != INVALID_VERTEX_ID ? normals[iv.n] : vec3(0, 0, 0);
+        out_model.texture_coordinates[i] = iv.t != INVALID_VERTEX_ID ? texCoords[iv.t] : vec2(0, 0);
     }
 }
 
-
-
-void ObjModelLoader::parseF()
+void ObjModelLoader::calculateMissingNormals()
 {
-    ivs.clear();
-
-    std::string_view f = lineParser.next();
-    while (!f.empty())
-    {
-        ivs.push_back(parseIV(f));
-        f = lineParser.next();
-    }
-
-    auto nf = triangulateFace(ivs);
-
-    // relative indexing, when the index is negativ
-    for (auto& f : nf)
+    auto& position = out_model.position;
+    auto& normal   = out_model.normal;
+    for (auto tri : out_model.triangles)
     {
-        for (auto& i : f)
+        vec3 n = normalize(cross(vec3(position[tri[2]] - position[tri[0]]), vec3(position[tri[1]] - position[tri[0]])));
+        for (int i = 0; i < 3; ++i)
         {
-            if (i.v < 0 && i.v != INVALID_VERTEX_ID)
-            {
-                int absIndex = vertices.size() + i.v + 1;
-                i.v          = absIndex;
-            }
-            if (i.n < 0 && i.n != INVALID_VERTEX_ID)
-            {
-                int absIndex = normals.size() + i.n + 1;
-                i.n          = absIndex;
-            }
-            if (i.t < 0 && i.t != INVALID_VERTEX_ID)
-            {
-                int absIndex = texCoords.size() + i.t + 1;
-                i.t          = absIndex;
-            }
+            if (normal[tri[i]] == vec3(0, 0, 0)) normal[tri[i]] = n;
         }
     }
-
-    faces.insert(faces.end(), nf.begin(), nf.end());
 }
 
-
-
 }  // namespace Saiga
@@ -9,7 +9,6 @@
 #include "saiga/config.h"
 #include "saiga/core/geometry/triangle_mesh.h"
 #include "saiga/core/util/Align.h"
-#include "saiga/core/util/tostring.h"
 
 #include "UnifiedModel.h"
 
@@ -18,6 +17,17 @@ namespace Saiga
 SAIGA_CORE_API std::vector<UnifiedMaterial> LoadMTL(const std::string& file);
 
 
+/**
+ * Loads a Wavefront OBJ file into a UnifiedModel.
+ *
+ * The file is memory mapped and split into chunks at line boundaries. The chunks are parsed in parallel with
+ * std::from_chars directly into the output arrays. Only the material statements (mtllib, usemtl) are processed
+ * sequentially.
+ *
+ * OBJ has separate indices for positions, texture coordinates and normals. A vertex of the output model is created for
+ * each unique (position, texture coordinate, normal, material group) combination of the face corners. Polygons are
+ * triangulated as a fan.
+ */
 class SAIGA_CORE_API ObjModelLoader
 {
    public:
@@ -28,25 +38,9 @@ class SAIGA_CORE_API ObjModelLoader
     ObjModelLoader() {}
     ObjModelLoader(const std::string& file);
 
-
-
     bool loadFile(const std::string& file);
 
-    //    AlignedVector<vec4> vertexData;    // x: specular
-    //    AlignedVector<vec4> vertexColors;  // only when given by the material. Otherwise: white!
-    std::vector<VertexNT> outVertices;
-    // std::vector<ivec3> outTriangles;
-
     UnifiedModel out_model;
-    //    std::vector<UnifiedMaterialGroup> triangleGroups;
-    //    std::vector<UnifiedMaterial> materials;
-    void separateVerticesByGroup();
-    void calculateMissingNormals();
-    void computeVertexColorAndData();
-
-    //    void toTriangleMesh(TriangleMesh<VertexNC, uint32_t>& mesh);
-    //    void toTriangleMesh(TriangleMesh<VertexNTD, uint32_t>& mesh);
-
 
     static constexpr int INVALID_VERTEX_ID = -911365965;
     struct SAIGA_CORE_API IndexedVertex2
@@ -56,26 +50,17 @@ class SAIGA_CORE_API ObjModelLoader
         int t = INVALID_VERTEX_ID;
     };
 
-
    private:
     std::vector<vec3> vertices;
     std::vector<vec3> normals;
     std::vector<vec2> texCoords;
 
-    std::vector<std::vector<IndexedVertex2>> faces;
-
+    // 3 corners per triangle
+    std::vector<IndexedVertex2> corners;
 
+    // Creates the output vertices from the face corners
     void createVertexIndexList();
-
-    std::vector<std::vector<IndexedVertex2>> triangulateFace(const std::vector<IndexedVertex2>& face);
-
-
-    // ================== Parser Tmp Variables ================
-
-    std::vector<IndexedVertex2> ivs;
-    void parseLine();
-
-    void parseF();
+    void calculateMissingNormals();
 };
 
 }  // namespace Saiga
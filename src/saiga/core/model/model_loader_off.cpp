@@ -6,27 +6,18 @@
 
 #include "model_loader_off.h"
 
-#include "saiga/core/math/String.h"
-#include "saiga/core/time/all.h"
-#include "saiga/core/util/file.h"
+#include "saiga/core/util/FastTextParser.h"
+#include "saiga/core/util/MemoryMappedFile.h"
+#include "saiga/core/util/Thread/omp.h"
 #include "saiga/core/util/fileChecker.h"
-#include "saiga/core/util/tostring.h"
 
 #include "internal/noGraphicsAPI.h"
 
 #include <algorithm>
-#include <array>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 
 namespace Saiga
 {
-static StringViewParser lineParser = {" ", true};
-static StringViewParser faceParser = {"/", false};
-
-
-
 OffModelLoader::OffModelLoader(const std::string& file) : file(file)
 {
     loadFile(file);
@@ -35,6 +26,8 @@ OffModelLoader::OffModelLoader(const std::string& file) : file(file)
 
 bool OffModelLoader::loadFile(const std::string& _file)
 {
+    using namespace FastTextParser;
+
     this->file = SearchPathes::model(_file);
     if (file == "")
     {
@@ -45,99 +38,141 @@ bool OffModelLoader::loadFile(const std::string& _file)
 
     std::cout << "[OffModelLoader] Loading " << file << std::endl;
 
-    std::vector<std::string> data = File::loadFileStringArray(file);
-    File::removeWindowsLineEnding(data);
+    MemoryMappedFile mapped(file);
+    if (!mapped.valid())
+    {
+        std::cerr << "Could not map file " << file << std::endl;
+        return false;
+    }
+    mapped.adviseSequential();
 
-    int num_vertices = 0, num_faces = 0;
+    const char* ptr = mapped.data();
+    const char* end = mapped.data() + mapped.size();
 
-    for (auto& line : data)
+    // Header: 'OFF' followed by the vertex, face and edge count. The counts may be on the same line.
+    int num_vertices = -1, num_faces = -1;
+    bool found_off = false, found_counts = false;
+    while (ptr < end && !found_counts)
     {
-        if (state == ParsingState::HEADER)
+        const char* line_end = LineEnd(ptr, end);
+        const char* p        = SkipSpace(ptr, line_end);
+        ptr                  = line_end + 1;
+        if (p == line_end || *p == '#') continue;
+
+        if (!found_off)
         {
-            if (line == "OFF")
+            auto token = Token(p, line_end);
+            if (token != "OFF")
             {
-                state = ParsingState::COUNTS;
+                std::cerr << "[OffModelLoader] Missing OFF header in " << file << std::endl;
+                return false;
             }
+            found_off = true;
+            if (SkipSpace(p, line_end) == line_end) continue;
         }
-        else if (state == ParsingState::COUNTS)
-        {
-            StringViewParser lineParser = {" ", true};
-            lineParser.set(line);
-
-            num_vertices = to_long(lineParser.next());
-            num_faces    = to_long(lineParser.next());
-
 
-            mesh.vertices.reserve(num_vertices);
-            mesh.faces.reserve(num_faces);
-
-            state = ParsingState::VERTICES;
-        }
-        else if (state == ParsingState::VERTICES)
+        if (!Parse(p, line_end, num_vertices) || !Parse(p, line_end, num_faces))
         {
-            StringViewParser lineParser = {" ", true};
-            lineParser.set(line);
+            std::cerr << "[OffModelLoader] Invalid counts in " << file << std::endl;
+            return false;
+        }
+        found_counts = true;
+    }
+    if (!found_counts || num_vertices < 0 || num_faces < 0)
+    {
+        std::cout << "Parsing failed!" << std::endl;
+        return false;
+    }
+    ptr = std::min(ptr, end);
 
-            vec3 p;
-            p[0] = to_double(lineParser.next());
-            p[1] = to_double(lineParser.next());
-            p[2] = to_double(lineParser.next());
+    // The body is split into chunks which are parsed in parallel.
+    // Pass 1 counts the data lines and triangles of each chunk, so that pass 2 knows where to write.
+    auto chunks    = SplitLines(ptr, end, std::min<size_t>(4 * OMP::getMaxThreads(), (end - ptr) / 65536 + 1));
+    int num_chunks = chunks.size() - 1;
 
-            VertexNC v;
-            v.position = make_vec4(p, 1);
-            v.color    = make_vec4(1);
+    std::vector<size_t> first_line(num_chunks + 1, 0);
+    std::vector<size_t> first_triangle(num_chunks + 1, 0);
 
-            mesh.vertices.push_back(v);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        size_t count = 0;
+        ForEachLine(chunks[i], chunks[i + 1], [&](const char*, const char*) { count++; });
+        first_line[i + 1] = count;
+    }
+    for (int i = 0; i < num_chunks; ++i) first_line[i + 1] += first_line[i];
 
-            if ((int)mesh.vertices.size() == num_vertices)
-            {
-                state = ParsingState::FACES;
-            }
-        }
-        else if (state == ParsingState::FACES)
+    size_t face_begin = num_vertices, face_end = size_t(num_vertices) + num_faces;
+    if (first_line.back() < face_end)
+    {
+        std::cout << "Parsing failed!" << std::endl;
+        return false;
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        size_t line = first_line[i], triangles = 0;
+        if (line < face_end && first_line[i + 1] > face_begin)
         {
-            StringViewParser lineParser = {" ", true};
-            lineParser.set(line);
-            int count = to_long(lineParser.next());
+            ForEachLine(chunks[i], chunks[i + 1], [&](const char* p, const char* line_end) {
+                if (line >= face_begin && line < face_end)
+                {
+                    int n = 0;
+                    Parse(p, line_end, n);
+                    triangles += std::max(0, n - 2);
+                }
+                line++;
+            });
+        }
+        first_triangle[i + 1] = triangles;
+    }
+    for (int i = 0; i < num_chunks; ++i) first_triangle[i + 1] += first_triangle[i];
 
-            SAIGA_ASSERT(count == 3 || count == 4);
-            std::array<uint32_t, 4> indices;
-            for (int i = 0; i < count; ++i)
-            {
-                indices[i] = to_long(lineParser.next());
-            }
+    model.position.resize(num_vertices);
+    model.color.resize(num_vertices, make_vec4(1));
+    model.triangles.resize(first_triangle.back());
 
-            if (count == 3)
-            {
-                mesh.addFace(indices.data());
-            }
-            else if (count == 4)
+    int errors = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : errors)
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        size_t line = first_line[i], triangle = first_triangle[i];
+        if (line >= face_end) continue;
+        ForEachLine(chunks[i], chunks[i + 1], [&](const char* p, const char* line_end) {
+            if (line < face_begin)
             {
-                mesh.addQuad(indices.data());
+                vec3& v = model.position[line];
+                errors += !(Parse(p, line_end, v(0)) && Parse(p, line_end, v(1)) && Parse(p, line_end, v(2)));
             }
-
-
-            if ((int)mesh.faces.size() == num_faces)
+            else if (line < face_end)
             {
-                state = ParsingState::DONE;
+                int n = 0, first = 0, last = 0;
+                Parse(p, line_end, n);
+                for (int k = 0; k < n; ++k)
+                {
+                    int index = -1;
+                    errors += !Parse(p, line_end, index) || index < 0 || index >= num_vertices;
+                    if (k == 0) first = index;
+                    if (k >= 2) model.triangles[triangle++] = ivec3(first, last, index);
+                    last = index;
+                }
             }
-        }
+            line++;
+        });
     }
 
-    mesh.computePerVertexNormal();
-
-    if (state != ParsingState::DONE)
+    if (errors > 0)
     {
-        std::cout << "Parsing failed!" << std::endl;
+        std::cout << "Parsing failed! " << errors << " invalid values." << std::endl;
         return false;
     }
 
+    model.CalculateVertexNormals();
 
-    std::cout << "[OffModelLoader] Done. " << mesh << std::endl;
+    std::cout << "[OffModelLoader] Done. V " << model.NumVertices() << " F " << model.NumFaces() << std::endl;
 
     return true;
 }
 
-
-
 }  // namespace Saiga
@@ -7,12 +7,16 @@
 #pragma once
 
 #include "saiga/config.h"
-#include "saiga/core/geometry/triangle_mesh.h"
-#include "saiga/core/util/Align.h"
-#include "saiga/core/util/tostring.h"
+#include "saiga/core/model/UnifiedModel.h"
 
 namespace Saiga
 {
+/**
+ * Loader for the ascii OFF format.
+ *
+ * The file is memory mapped and the vertex and face lines are parsed in parallel. Polygons with more than 3 corners
+ * are triangulated as a fan. The vertex normals are computed from the triangles.
+ */
 class SAIGA_CORE_API OffModelLoader
 {
    public:
@@ -20,19 +24,10 @@ class SAIGA_CORE_API OffModelLoader
     OffModelLoader(const std::string& file);
     bool loadFile(const std::string& file);
 
-    // Output mesh
-    TriangleMesh<VertexNC, uint32_t> mesh;
+    // Output model
+    UnifiedModel model;
 
    private:
-    enum class ParsingState
-    {
-        HEADER,
-        COUNTS,
-        VERTICES,
-        FACES,
-        DONE
-    };
-    ParsingState state = ParsingState::HEADER;
     std::string file;
 };
 
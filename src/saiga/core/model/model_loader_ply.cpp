@@ -6,224 +6,512 @@
 
 #include "model_loader_ply.h"
 
-#include "saiga/core/util/color.h"
+#include "saiga/core/util/FastTextParser.h"
+#include "saiga/core/util/MemoryMappedFile.h"
+#include "saiga/core/util/Thread/omp.h"
 #include "saiga/core/util/fileChecker.h"
 
 #include "internal/noGraphicsAPI.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace Saiga
 {
-PLYLoader::PLYLoader(const std::string& _file)
+namespace
 {
-    auto file = SearchPathes::model(_file);
-    std::ifstream stream(file, std::ios::binary);
-
-    if (!stream.is_open())
-    {
-        std::cerr << "Could not open file " << file << std::endl;
-        throw std::runtime_error("invalid file: " + file + ", " + _file);
-    }
-
-    // open the file:
-    //         std::ifstream file(filename, std::ios::binary);
-
-    // read the data:
-    data = std::vector<char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
-
-    //         std::cout << "filesize: " << data.size() << std::endl;
+enum class PlyType
+{
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64,
+    UNKNOWN,
+};
+
+PlyType plyType(std::string_view t)
+{
+    if (t == "char" || t == "int8") return PlyType::INT8;
+    if (t == "uchar" || t == "uint8") return PlyType::UINT8;
+    if (t == "short" || t == "int16") return PlyType::INT16;
+    if (t == "ushort" || t == "uint16") return PlyType::UINT16;
+    if (t == "int" || t == "int32") return PlyType::INT32;
+    if (t == "uint" || t == "uint32") return PlyType::UINT32;
+    if (t == "float" || t == "float32") return PlyType::FLOAT32;
+    if (t == "double" || t == "float64") return PlyType::FLOAT64;
+    return PlyType::UNKNOWN;
+}
 
-    parseHeader();
-    parseMeshBinary();
+template <typename T>
+inline T readUnaligned(const char* ptr)
+{
+    T v;
+    std::memcpy(&v, ptr, sizeof(T));
+    return v;
 }
 
-int PLYLoader::sizeoftype(std::string t)
+inline double readBinary(const char* ptr, PlyType type)
 {
-    if (t == "float" || t == "int")
+    switch (type)
     {
-        return 4;
+        case PlyType::INT8:
+            return readUnaligned<int8_t>(ptr);
+        case PlyType::UINT8:
+            return readUnaligned<uint8_t>(ptr);
+        case PlyType::INT16:
+            return readUnaligned<int16_t>(ptr);
+        case PlyType::UINT16:
+            return readUnaligned<uint16_t>(ptr);
+        case PlyType::INT32:
+            return readUnaligned<int32_t>(ptr);
+        case PlyType::UINT32:
+            return readUnaligned<uint32_t>(ptr);
+        case PlyType::FLOAT32:
+            return readUnaligned<float>(ptr);
+        case PlyType::FLOAT64:
+            return readUnaligned<double>(ptr);
+        default:
+            return 0;
     }
-    if (t == "uchar")
+}
+
+// Vertex attributes of the UnifiedModel
+enum VertexTarget
+{
+    TARGET_NONE = -1,
+    TARGET_X    = 0,
+    TARGET_NX   = 3,
+    TARGET_RED  = 6,
+    TARGET_S    = 10,
+    TARGET_COUNT = 12,
+};
+
+int vertexTarget(const std::string& name)
+{
+    static const std::vector<std::vector<std::string>> names = {
+        {"x"},   {"y"},     {"z"},    {"nx"},    {"ny"}, {"nz"}, {"red", "r"}, {"green", "g"},
+        {"blue", "b"}, {"alpha", "a"}, {"s", "u", "texture_u"}, {"t", "v", "texture_v"}};
+    for (int i = 0; i < TARGET_COUNT; ++i)
     {
-        return 1;
+        for (auto& n : names[i])
+        {
+            if (n == name) return i;
+        }
     }
-    SAIGA_ASSERT(0);
-    return -1;
+    return TARGET_NONE;
 }
 
-void PLYLoader::parseHeader()
+struct VertexLayout
 {
-    // Note: the header is always in ascii and ends with the string end_header
-    std::string str2(data.begin(), data.end());
-    auto pos = str2.find("end_header");
+    std::vector<int> target;
+    std::vector<PlyType> type;
+    std::vector<int> offset;
+    int size       = 0;
+    bool has[TARGET_COUNT] = {};
+
+    bool hasNormal() const { return has[TARGET_NX] && has[TARGET_NX + 1] && has[TARGET_NX + 2]; }
+    bool hasColor() const { return has[TARGET_RED] && has[TARGET_RED + 1] && has[TARGET_RED + 2]; }
+    bool hasTC() const { return has[TARGET_S] && has[TARGET_S + 1]; }
+
+    // Writes the values of one vertex into the model
+    void store(UnifiedModel& model, int i, const double* values) const
+    {
+        model.position[i] = vec3(values[TARGET_X], values[TARGET_X + 1], values[TARGET_X + 2]);
+        if (hasNormal()) model.normal[i] = vec3(values[TARGET_NX], values[TARGET_NX + 1], values[TARGET_NX + 2]);
+        if (hasColor())
+        {
+            model.color[i] = vec4(values[TARGET_RED], values[TARGET_RED + 1], values[TARGET_RED + 2],
+                                  has[TARGET_RED + 3] ? values[TARGET_RED + 3] : color_scale);
+            model.color[i] /= color_scale;
+        }
+        if (hasTC()) model.texture_coordinates[i] = vec2(values[TARGET_S], values[TARGET_S + 1]);
+    }
 
-    SAIGA_ASSERT(pos != std::string::npos);
+    // uchar colors are in the range [0,255]
+    double color_scale = 1;
+};
 
-    dataStart = pos;
-    // go until next newline
-    while (data[dataStart] != '\n')
+VertexLayout makeLayout(const PLYLoader::Element& element)
+{
+    VertexLayout layout;
+    for (auto& p : element.properties)
     {
-        dataStart++;
+        SAIGA_ASSERT(!p.is_list, "List properties are not supported for vertices.");
+        int t = vertexTarget(p.name);
+        layout.target.push_back(t);
+        layout.type.push_back(plyType(p.type));
+        layout.offset.push_back(layout.size);
+        layout.size += PLYLoader::sizeoftype(p.type);
+        if (t != TARGET_NONE) layout.has[t] = true;
+        if (t == TARGET_RED && plyType(p.type) == PlyType::UINT8) layout.color_scale = 255;
     }
-    dataStart++;
-
-    std::string header(str2.begin(), str2.begin() + pos);
-    header.erase(std::remove(header.begin(), header.end(), '\r'), header.end());
+    SAIGA_ASSERT(layout.has[TARGET_X] && layout.has[TARGET_X + 1] && layout.has[TARGET_X + 2]);
+    return layout;
+}
 
-    std::vector<std::string> headerLines = split(header, '\n');
+}  // namespace
 
-    SAIGA_ASSERT(headerLines[0] == "ply");
+PLYLoader::PLYLoader(const std::string& _file)
+{
+    auto file = SearchPathes::model(_file);
 
-    int elementStatus = -1;
-    for (auto l : headerLines)
+    MemoryMappedFile mapped(file);
+    if (!mapped.valid())
     {
-        //        std::cout << l << std::endl;
-        std::vector<std::string> splitLine = split(l, ' ');
-
-        if (splitLine.size() == 0) continue;
+        std::cerr << "Could not open file " << file << std::endl;
+        throw std::runtime_error("invalid file: " + file + ", " + _file);
+    }
+    mapped.adviseSequential();
 
-        std::string& type = splitLine[0];
-        //            std::cout << "type " << type << std::endl;
+    using namespace FastTextParser;
+    const char* ptr = mapped.data();
+    const char* end = mapped.data() + mapped.size();
 
+    // Note: the header is always in ascii and ends with the line end_header
+    bool first_line = true;
+    while (true)
+    {
+        SAIGA_ASSERT(ptr < end, "PLY header without end_header");
+        const char* line_end = LineEnd(ptr, end);
+        const char* p        = ptr;
+        auto type            = Token(p, line_end);
+        ptr                  = line_end + 1;
 
-        if (type == "format")
+        if (first_line)
         {
-            SAIGA_ASSERT(splitLine[1] == "binary_little_endian");
+            SAIGA_ASSERT(type == "ply", "Not a ply file: " + file);
+            first_line = false;
         }
-
-        if (type == "element")
+        else if (type == "format")
         {
-            std::string& ident = splitLine[1];
-
-            if (ident == "vertex")
-            {
-                vertexCount   = to_int(splitLine[2]);
-                elementStatus = 1;
-            }
-            if (ident == "face")
-            {
-                faceCount     = to_int(splitLine[2]);
-                elementStatus = 2;
-            }
+            auto f = Token(p, line_end);
+            if (f == "ascii")
+                format = Format::ASCII;
+            else if (f == "binary_little_endian")
+                format = Format::BINARY_LITTLE_ENDIAN;
+            else if (f == "binary_big_endian")
+                format = Format::BINARY_BIG_ENDIAN;
+            else
+                SAIGA_EXIT_ERROR("Unknown PLY format " + std::string(f));
         }
-
-        if (type == "property")
+        else if (type == "element")
         {
-            SAIGA_ASSERT(elementStatus != -1);
-
-            if (elementStatus == 1)
+            Element e;
+            e.name = Token(p, line_end);
+            SAIGA_ASSERT(Parse(p, line_end, e.count));
+            elements.push_back(e);
+        }
+        else if (type == "property")
+        {
+            SAIGA_ASSERT(!elements.empty());
+            Property prop;
+            auto t = Token(p, line_end);
+            if (t == "list")
             {
-                // vertex property
-                VertexProperty vp;
-                vp.name = splitLine[2];
-                vp.type = splitLine[1];
-                vertexProperties.push_back(vp);
-            }
-            if (elementStatus == 2)
-            {
-                SAIGA_ASSERT(splitLine[1] == "list");
-                SAIGA_ASSERT(splitLine[4] == "vertex_indices");
-
-                faceVertexCountType = splitLine[2];
-                faceVertexIndexType = splitLine[3];
+                prop.is_list    = true;
+                prop.count_type = Token(p, line_end);
+                t               = Token(p, line_end);
             }
+            prop.type = t;
+            prop.name = Token(p, line_end);
+            SAIGA_ASSERT(sizeoftype(prop.type) > 0, "Unknown PLY type " + prop.type);
+            elements.back().properties.push_back(prop);
+        }
+        else if (type == "end_header")
+        {
+            break;
         }
     }
 
+    SAIGA_ASSERT(format != Format::BINARY_BIG_ENDIAN, "binary_big_endian PLY files are not supported.");
 
-    //    std::cout << std::endl;
-    //    std::cout << "V " << vertexCount << " F " << faceCount << std::endl;
-    //    std::cout << "Face: " << faceVertexCountType << " - " << faceVertexIndexType << std::endl;
-
-    offsetType.resize(6, std::pair<int, int>(0, -1));
-
-    vertexSize = 0;
-    for (auto vp : vertexProperties)
+    const Element* vertex_element = nullptr;
+    const Element* face_element   = nullptr;
+    for (auto& e : elements)
     {
-        int t = sizeoftype(vp.type);
-
-
-        if (vp.name == "x") offsetType[0] = std::make_pair(vertexSize, t);
-        if (vp.name == "y") offsetType[1] = std::make_pair(vertexSize, t);
-        if (vp.name == "z") offsetType[2] = std::make_pair(vertexSize, t);
-        if (vp.name == "red") offsetType[3] = std::make_pair(vertexSize, t);
-        if (vp.name == "green") offsetType[4] = std::make_pair(vertexSize, t);
-        if (vp.name == "blue") offsetType[5] = std::make_pair(vertexSize, t);
+        if (e.name == "vertex") vertex_element = &e;
+        if (e.name == "face") face_element = &e;
+    }
+    SAIGA_ASSERT(vertex_element, "PLY file without vertices: " + file);
+    vertexCount = vertex_element->count;
+    faceCount   = face_element ? face_element->count : 0;
 
-        //        std::cout << "Prop: " << vp.type << " " << vp.name << std::endl;
-        vertexSize += sizeoftype(vp.type);
+    // Index of the vertex index list in the face properties
+    int list_index = -1;
+    if (face_element)
+    {
+        for (int i = 0; i < (int)face_element->properties.size(); ++i)
+        {
+            auto& p = face_element->properties[i];
+            if (p.is_list && (p.name == "vertex_indices" || p.name == "vertex_index")) list_index = i;
+        }
+        SAIGA_ASSERT(list_index != -1, "PLY face element without vertex_indices");
     }
 
-    //    std::cout << "vertex size: " << vertexSize << std::endl;
+    auto layout = makeLayout(*vertex_element);
+    model.position.resize(vertexCount);
+    if (layout.hasNormal()) model.normal.resize(vertexCount);
+    if (layout.hasColor()) model.color.resize(vertexCount);
+    if (layout.hasTC()) model.texture_coordinates.resize(vertexCount);
 
+    // Number of triangles of each face (fan triangulation)
+    std::vector<int> face_triangles;
 
-    SAIGA_ASSERT(vertexCount > 0 && faceCount > 0);
-    //        std::cout << header << std::endl;
-}
-
-void PLYLoader::parseMeshBinary()
-{
-    for (int i = 0; i < vertexCount; ++i)
+    if (format == Format::BINARY_LITTLE_ENDIAN)
     {
-        char* start = data.data() + dataStart + i * vertexSize;
-
+        for (auto& e : elements)
+        {
+            if (&e == vertex_element)
+            {
+                SAIGA_ASSERT(ptr + size_t(e.count) * layout.size <= end, "Truncated PLY file " + file);
+                const char* data = ptr;
+#pragma omp parallel for
+                for (int i = 0; i < e.count; ++i)
+                {
+                    const char* v = data + size_t(i) * layout.size;
+                    double values[TARGET_COUNT];
+                    for (size_t k = 0; k < layout.target.size(); ++k)
+                    {
+                        if (layout.target[k] != TARGET_NONE)
+                            values[layout.target[k]] = readBinary(v + layout.offset[k], layout.type[k]);
+                    }
+                    layout.store(model, i, values);
+                }
+                ptr += size_t(e.count) * layout.size;
+            }
+            else if (&e == face_element && e.properties.size() == 1)
+            {
+                // Fast path: Only the index list and all faces are triangles -> fixed stride
+                PlyType count_type = plyType(e.properties[0].count_type);
+                PlyType index_type = plyType(e.properties[0].type);
+                int count_size     = sizeoftype(e.properties[0].count_type);
+                int index_size     = sizeoftype(e.properties[0].type);
+                size_t stride      = count_size + 3 * index_size;
+
+                bool all_triangles = ptr + stride * e.count <= end;
+                if (all_triangles)
+                {
+                    int non_triangles = 0;
+#pragma omp parallel for reduction(+ : non_triangles)
+                    for (int i = 0; i < e.count; ++i)
+                    {
+                        non_triangles += readBinary(ptr + stride * i, count_type) != 3;
+                    }
+                    all_triangles = non_triangles == 0;
+                }
+
+                if (all_triangles)
+                {
+                    model.triangles.resize(e.count);
+                    const char* data = ptr;
+#pragma omp parallel for
+                    for (int i = 0; i < e.count; ++i)
+                    {
+                        const char* f = data + stride * i + count_size;
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            model.triangles[i](k) = readBinary(f + k * index_size, index_type);
+                        }
+                    }
+                    ptr += stride * e.count;
+                }
+                else
+                {
+                    for (int i = 0; i < e.count; ++i)
+                    {
+                        SAIGA_ASSERT(ptr + count_size <= end, "Truncated PLY file " + file);
+                        int n = readBinary(ptr, count_type);
+                        ptr += count_size;
+                        SAIGA_ASSERT(ptr + size_t(n) * index_size <= end, "Truncated PLY file " + file);
+                        for (int k = 2; k < n; ++k)
+                        {
+                            model.triangles.emplace_back(readBinary(ptr, index_type),
+                                                         readBinary(ptr + (k - 1) * index_size, index_type),
+                                                         readBinary(ptr + k * index_size, index_type));
+                        }
+                        ptr += size_t(n) * index_size;
+                    }
+                }
+            }
+            else
+            {
+                // Sequential fallback for elements with lists (including unknown elements, which are skipped)
+                for (int i = 0; i < e.count; ++i)
+                {
+                    for (int pi = 0; pi < (int)e.properties.size(); ++pi)
+                    {
+                        auto& p = e.properties[pi];
+                        if (!p.is_list)
+                        {
+                            ptr += sizeoftype(p.type);
+                            continue;
+                        }
+                        SAIGA_ASSERT(ptr + sizeoftype(p.count_type) <= end, "Truncated PLY file " + file);
+                        int n = readBinary(ptr, plyType(p.count_type));
+                        ptr += sizeoftype(p.count_type);
+                        int index_size = sizeoftype(p.type);
+                        SAIGA_ASSERT(ptr + size_t(n) * index_size <= end, "Truncated PLY file " + file);
+                        if (&e == face_element && pi == list_index)
+                        {
+                            PlyType index_type = plyType(p.type);
+                            for (int k = 2; k < n; ++k)
+                            {
+                                model.triangles.emplace_back(readBinary(ptr, index_type),
+                                                             readBinary(ptr + (k - 1) * index_size, index_type),
+                                                             readBinary(ptr + k * index_size, index_type));
+                            }
+                        }
+                        ptr += size_t(n) * index_size;
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        // ASCII: One line per element. The chunks are parsed in parallel. The first pass counts the lines of each
+        // chunk, so that every line can be assigned to its element.
+        auto chunks    = SplitLines(ptr, end, std::min<size_t>(4 * OMP::getMaxThreads(), (end - ptr) / 65536 + 1));
+        int num_chunks = chunks.size() - 1;
 
+        size_t vertex_begin = 0, face_begin = 0, lines = 0;
+        for (auto& e : elements)
+        {
+            if (&e == vertex_element) vertex_begin = lines;
+            if (&e == face_element) face_begin = lines;
+            lines += e.count;
+        }
+        size_t face_end = face_begin + faceCount;
 
-        float* x = reinterpret_cast<float*>(start + offsetType[0].first);
-        vec3 pos(x[0], x[1], x[2]);
+        std::vector<size_t> first_line(num_chunks + 1, 0);
+        std::vector<size_t> first_triangle(num_chunks + 1, 0);
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < num_chunks; ++i)
+        {
+            size_t count = 0;
+            ForEachLine(
+                chunks[i], chunks[i + 1], [&](const char*, const char*) { count++; }, '\0');
+            first_line[i + 1] = count;
+        }
+        for (int i = 0; i < num_chunks; ++i) first_line[i + 1] += first_line[i];
+        SAIGA_ASSERT(first_line.back() >= lines, "Truncated PLY file " + file);
 
+        // Skips the properties in front of the index list
+        auto skipToList = [&](const char*& p, const char* line_end) {
+            for (int k = 0; k < list_index; ++k) Token(p, line_end);
+        };
 
-        vec3 color(1);
-        if (offsetType[3].second == 1)
+        // Triangles per chunk
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < num_chunks; ++i)
         {
-            unsigned char* c = reinterpret_cast<unsigned char*>(start + offsetType[3].first);
-            color            = vec3(c[0], c[1], c[2]);
-            color /= 255.0f;
+            size_t line = first_line[i], triangles = 0;
+            if (line < face_end && first_line[i + 1] > face_begin)
+            {
+                ForEachLine(
+                    chunks[i], chunks[i + 1],
+                    [&](const char* p, const char* line_end) {
+                        if (line >= face_begin && line < face_end)
+                        {
+                            int n = 0;
+                            skipToList(p, line_end);
+                            Parse(p, line_end, n);
+                            triangles += std::max(0, n - 2);
+                        }
+                        line++;
+                    },
+                    '\0');
+            }
+            first_triangle[i + 1] = triangles;
         }
-        else if (offsetType[3].second == 4)
+        for (int i = 0; i < num_chunks; ++i) first_triangle[i + 1] += first_triangle[i];
+        model.triangles.resize(first_triangle.back());
+
+        int errors = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : errors)
+        for (int i = 0; i < num_chunks; ++i)
         {
-            float* c = reinterpret_cast<float*>(start + offsetType[3].first);
-            color    = vec3(c[0], c[1], c[2]);
+            size_t line = first_line[i], triangle = first_triangle[i];
+            ForEachLine(
+                chunks[i], chunks[i + 1],
+                [&](const char* p, const char* line_end) {
+                    if (line >= vertex_begin && line < vertex_begin + vertexCount)
+                    {
+                        double values[TARGET_COUNT];
+                        for (size_t k = 0; k < layout.target.size(); ++k)
+                        {
+                            double v;
+                            errors += !Parse(p, line_end, v);
+                            if (layout.target[k] != TARGET_NONE) values[layout.target[k]] = v;
+                        }
+                        layout.store(model, line - vertex_begin, values);
+                    }
+                    else if (line >= face_begin && line < face_end)
+                    {
+                        int n = 0;
+                        skipToList(p, line_end);
+                        Parse(p, line_end, n);
+                        int first = 0, last = 0;
+                        for (int k = 0; k < n; ++k)
+                        {
+                            int index = 0;
+                            errors += !Parse(p, line_end, index);
+                            if (k == 0) first = index;
+                            if (k >= 2) model.triangles[triangle++] = ivec3(first, last, index);
+                            last = index;
+                        }
+                    }
+                    line++;
+                },
+                '\0');
         }
-
-
-        VertexNC v;
-        v.position = make_vec4(pos, 1);
-        v.color    = make_vec4(color, 1);
-        mesh.addVertex(v);
+        SAIGA_ASSERT(errors == 0, "Invalid values in PLY file " + file);
     }
 
-    int faceStart = dataStart + vertexCount * vertexSize;
-    char* start   = data.data() + faceStart;
-
-    int countSize = sizeoftype(faceVertexCountType);
-
-    for (int i = 0; i < faceCount; ++i)
+    // All face paths above store the indices unchecked
+    int invalid_indices = 0;
+#pragma omp parallel for reduction(+ : invalid_indices)
+    for (int i = 0; i < (int)model.triangles.size(); ++i)
     {
-        int c = 0;
-        if (countSize == 1)
-        {
-            c = *reinterpret_cast<unsigned char*>(start);
-        }
-        else if (countSize == 4)
+        for (int k = 0; k < 3; ++k)
         {
-            c = *reinterpret_cast<int*>(start);
+            int index = model.triangles[i](k);
+            invalid_indices += index < 0 || index >= vertexCount;
         }
-        start += countSize;
-
-        SAIGA_ASSERT(c == 3);
-
-        uint32_t* face = reinterpret_cast<uint32_t*>(start);
-        mesh.addFace(face);
+    }
+    SAIGA_ASSERT(invalid_indices == 0, "Invalid values in PLY file " + file);
 
-        start += sizeof(uint32_t) * c;
-        //            std::cout << c << std::endl;
+    if (!layout.hasNormal())
+    {
+        model.CalculateVertexNormals();
     }
 
-    mesh.computePerVertexNormal();
+    std::cout << "Loaded Ply mesh: V " << model.NumVertices() << " F " << model.NumFaces() << std::endl;
+}
 
-    std::cout << "Loaded Ply mesh: V " << mesh.vertices.size() << " F " << mesh.faces.size() << std::endl;
+int PLYLoader::sizeoftype(std::string_view t)
+{
+    switch (plyType(t))
+    {
+        case PlyType::INT8:
+        case PlyType::UINT8:
+            return 1;
+        case PlyType::INT16:
+        case PlyType::UINT16:
+            return 2;
+        case PlyType::INT32:
+        case PlyType::UINT32:
+        case PlyType::FLOAT32:
+            return 4;
+        case PlyType::FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
 }
 
 }  // namespace Saiga
@@ -6,11 +6,13 @@
 
 #pragma once
 #include "saiga/core/geometry/triangle_mesh.h"
+#include "saiga/core/model/UnifiedModel.h"
 #include "saiga/core/util/color.h"
 #include "saiga/core/util/tostring.h"
 
 #include <fstream>
 #include <iostream>
+#include <string_view>
 #include <vector>
 
 namespace Saiga
@@ -23,41 +25,51 @@ template <typename VertexType>
 static inline void write(char* ptr, VertexType v);
 };  // namespace PLYLoaderDetail
 
+/**
+ * Loads a PLY file (ascii or binary_little_endian) into a UnifiedModel.
+ *
+ * The file is memory mapped and the vertex and face elements are decoded in parallel. Supported vertex properties:
+ * x y z, nx ny nz, red green blue alpha, s t (or u v). Faces with more than 3 vertices are triangulated as a fan.
+ * If the file has no normals, area weighted vertex normals are computed.
+ */
 class SAIGA_CORE_API PLYLoader
 {
    public:
-    struct VertexProperty
+    enum class Format
     {
-        std::string name;
-        std::string type;
+        ASCII,
+        BINARY_LITTLE_ENDIAN,
+        BINARY_BIG_ENDIAN,
     };
 
+    struct Property
+    {
+        std::string name;
+        std::string type;
 
+        // Only for list properties
+        bool is_list = false;
+        std::string count_type;
+    };
 
-    std::vector<std::pair<int, int>> offsetType;
-
-
-    int vertexSize;
-    int dataStart;
-    std::vector<char> data;
-    std::vector<VertexProperty> vertexProperties;
+    struct Element
+    {
+        std::string name;
+        int count = 0;
+        std::vector<Property> properties;
+    };
 
-    std::string faceVertexCountType;
-    std::string faceVertexIndexType;
+    Format format = Format::ASCII;
+    std::vector<Element> elements;
 
-    TriangleMesh<VertexNC, uint32_t> mesh;
+    UnifiedModel model;
 
     int vertexCount = -1, faceCount = -1;
 
     PLYLoader(const std::string& file);
 
-
-    int sizeoftype(std::string t);
-
-    void parseHeader();
-
-    void parseMeshBinary();
-
+    // Size of a PLY type in bytes (0 for unknown types)
+    static int sizeoftype(std::string_view t);
 
     template <typename VertexType, typename IndexType>
     static void save(std::string file, TriangleMesh<VertexType, IndexType>& mesh)
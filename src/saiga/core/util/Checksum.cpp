@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "Checksum.h"
+
+#include <cstring>
+
+namespace Saiga
+{
+uint64_t Checksum64(const void* _data, size_t size)
+{
+    constexpr uint64_t p1 = 11400714785074694791ULL;
+    constexpr uint64_t p2 = 14029467366897019727ULL;
+    constexpr uint64_t p3 = 1609587929392839161ULL;
+
+    auto data  = static_cast<const char*>(_data);
+    auto rotl  = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto round = [&](uint64_t h, uint64_t w) { return rotl(h + w * p2, 31) * p1; };
+
+    // 4 independent lanes
+    uint64_t h[4] = {p1 + p2, p2, 0, p3};
+
+    auto block = [&](const char* ptr) {
+        for (int k = 0; k < 4; ++k)
+        {
+            uint64_t w;
+            std::memcpy(&w, ptr + 8 * k, 8);
+            h[k] = round(h[k], w);
+        }
+    };
+
+    size_t blocks = size / 32;
+    for (size_t i = 0; i < blocks; ++i) block(data + 32 * i);
+
+    // Zero padded tail
+    char tail[32] = {};
+    if (size > 32 * blocks) std::memcpy(tail, data + 32 * blocks, size - 32 * blocks);
+    block(tail);
+
+    uint64_t result = size;
+    for (int k = 0; k < 4; ++k) result = (result ^ round(0, h[k])) * p1 + p3;
+    result ^= result >> 33;
+    result *= p2;
+    result ^= result >> 29;
+    return result;
+}
+
+}  // namespace Saiga
@@ -0,0 +1,22 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Saiga
+{
+/**
+ * Fast non-cryptographic 64 bit hash of a memory block (similar to the main loop of xxHash64).
+ * Used to detect corrupted or outdated binary files. The result is independent of the alignment of 'data'.
+ */
+SAIGA_CORE_API uint64_t Checksum64(const void* data, size_t size);
+
+}  // namespace Saiga
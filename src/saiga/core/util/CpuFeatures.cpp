@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "CpuFeatures.h"
+
+#include <atomic>
+#include <iostream>
+
+#if defined(SAIGA_HAS_X86_SIMD) && defined(_MSC_VER)
+#    include <immintrin.h>
+#    include <intrin.h>
+#endif
+
+namespace Saiga
+{
+static CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures f;
+#if defined(SAIGA_HAS_X86_SIMD)
+#    if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    f.sse41   = __builtin_cpu_supports("sse4.1");
+    f.avx     = __builtin_cpu_supports("avx");
+    f.avx2    = __builtin_cpu_supports("avx2");
+    f.fma     = __builtin_cpu_supports("fma");
+    f.avx512f = __builtin_cpu_supports("avx512f");
+#    elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int max_id = info[0];
+
+    bool os_avx = false;
+    if (max_id >= 1)
+    {
+        __cpuid(info, 1);
+        f.sse41 = (info[2] & (1 << 19)) != 0;
+        f.fma   = (info[2] & (1 << 12)) != 0;
+        // osxsave + avx
+        bool cpu_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+        os_avx       = cpu_avx && ((_xgetbv(0) & 0x6) == 0x6);
+        f.avx        = os_avx;
+        f.fma        = f.fma && os_avx;
+    }
+    if (max_id >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        f.avx2    = os_avx && (info[1] & (1 << 5));
+        f.avx512f = os_avx && (info[1] & (1 << 16)) && ((_xgetbv(0) & 0xE6) == 0xE6);
+    }
+#    endif
+#endif
+    // The avx2 kernels are compiled with fma enabled
+    f.avx2 = f.avx2 && f.fma;
+    return f;
+}
+
+const CpuFeatures& cpuFeatures()
+{
+    static CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+static std::atomic<bool> simd_enabled = true;
+
+void setSimdEnabled(bool enabled)
+{
+    simd_enabled = enabled;
+}
+
+bool simdEnabled()
+{
+    return simd_enabled;
+}
+
+std::ostream& operator<<(std::ostream& strm, const CpuFeatures& f)
+{
+    strm << "[CpuFeatures] sse4.1 " << f.sse41 << " avx " << f.avx << " avx2 " << f.avx2 << " fma " << f.fma
+         << " avx512f " << f.avx512f;
+    return strm;
+}
+
+}  // namespace Saiga
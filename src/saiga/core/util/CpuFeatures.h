@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+
+#include <iosfwd>
+
+/**
+ * Runtime detection of x86 SIMD extensions.
+ *
+ * Kernels that use instructions beyond the compile target are marked with SAIGA_TARGET_AVX2 and
+ * are only called if cpuFeatures().avx2 is set. This way a binary compiled without -march=native
+ * still uses AVX2 on machines that support it.
+ *
+ * Usage:
+ *
+ *   SAIGA_TARGET_AVX2 void kernelAVX2(...) { ... }
+ *
+ *   if (useSimd(cpuFeatures().avx2)) kernelAVX2(...); else kernelScalar(...);
+ */
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__CUDACC__)
+#    define SAIGA_HAS_X86_SIMD
+#endif
+
+#if defined(SAIGA_HAS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#    define SAIGA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#    define SAIGA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#    define SAIGA_TARGET_SSE41
+#    define SAIGA_TARGET_AVX2
+#endif
+
+namespace Saiga
+{
+struct SAIGA_CORE_API CpuFeatures
+{
+    bool sse41   = false;
+    bool avx     = false;
+    bool avx2    = false;
+    bool fma     = false;
+    bool avx512f = false;
+};
+
+SAIGA_CORE_API std::ostream& operator<<(std::ostream& strm, const CpuFeatures& f);
+
+// Detected once on the first call.
+SAIGA_CORE_API const CpuFeatures& cpuFeatures();
+
+// Globally enables/disables all runtime dispatched SIMD kernels.
+// Only useful for testing and benchmarking against the scalar reference.
+SAIGA_CORE_API void setSimdEnabled(bool enabled);
+SAIGA_CORE_API bool simdEnabled();
+
+// Returns true if the given feature is available and SIMD is enabled.
+inline bool useSimd(bool feature)
+{
+    return feature && simdEnabled();
+}
+
+}  // namespace Saiga
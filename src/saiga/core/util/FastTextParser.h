@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace Saiga
+{
+/**
+ * Allocation free helpers to parse ASCII files in place, for example from a MemoryMappedFile.
+ *
+ * Large files are split into chunks at line boundaries, which can then be parsed in parallel.
+ * Numbers are converted with std::from_chars, which is locale independent and does not allocate.
+ *
+ *   const char* ptr = line_begin;
+ *   float x, y, z;
+ *   bool ok = FastTextParser::Parse(ptr, line_end, x) && FastTextParser::Parse(ptr, line_end, y) &&
+ *             FastTextParser::Parse(ptr, line_end, z);
+ */
+namespace FastTextParser
+{
+inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline const char* SkipSpace(const char* ptr, const char* end)
+{
+    while (ptr < end && IsSpace(*ptr)) ++ptr;
+    return ptr;
+}
+
+// Position of the next '\n' or end.
+inline const char* LineEnd(const char* ptr, const char* end)
+{
+    if (ptr >= end) return end;
+    auto result = static_cast<const char*>(std::memchr(ptr, '\n', end - ptr));
+    return result ? result : end;
+}
+
+// The next whitespace separated token. Returns an empty view at the end.
+inline std::string_view Token(const char*& ptr, const char* end)
+{
+    ptr             = SkipSpace(ptr, end);
+    const char* beg = ptr;
+    while (ptr < end && !IsSpace(*ptr)) ++ptr;
+    return std::string_view(beg, ptr - beg);
+}
+
+// Parses the next token as a number. Returns false if the token is not a valid number.
+template <typename T>
+inline bool Parse(const char*& ptr, const char* end, T& value)
+{
+    auto token = Token(ptr, end);
+    // from_chars does not accept a leading '+'
+    if (token.size() > 1 && token[0] == '+') token.remove_prefix(1);
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return !token.empty() && result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+// Calls f(line_begin, line_end) for every line in [begin, end). line_begin points to the first non-space character.
+// Empty lines and comments (lines starting with 'comment') are skipped.
+template <typename F>
+inline void ForEachLine(const char* begin, const char* end, F f, char comment = '#')
+{
+    while (begin < end)
+    {
+        const char* line_end = LineEnd(begin, end);
+        const char* ptr      = SkipSpace(begin, line_end);
+        if (ptr < line_end && *ptr != comment) f(ptr, line_end);
+        begin = line_end + 1;
+    }
+}
+
+// Splits [begin, end) into at most 'num_chunks' ranges of similar size.
+// Chunk i is [result[i], result[i+1]). Every chunk, except the first one, starts at the beginning of a line.
+inline std::vector<const char*> SplitLines(const char* begin, const char* end, int num_chunks)
+{
+    num_chunks = std::max(1, num_chunks);
+    std::vector<const char*> result(num_chunks + 1);
+    result[0]          = begin;
+    result[num_chunks] = end;
+    for (int i = 1; i < num_chunks; ++i)
+    {
+        const char* split = std::max(result[i - 1], begin + (end - begin) * i / num_chunks);
+        split             = LineEnd(split, end);
+        result[i]         = split < end ? split + 1 : end;
+    }
+    return result;
+}
+
+}  // namespace FastTextParser
+}  // namespace Saiga
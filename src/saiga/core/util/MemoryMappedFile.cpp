@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "MemoryMappedFile.h"
+
+#include "saiga/core/util/assert.h"
+
+#include <fstream>
+
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace Saiga
+{
+bool MemoryMappedFile::open(const std::string& file)
+{
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = st.st_size;
+    if (size_ > 0)
+    {
+        void* ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED)
+        {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_  = reinterpret_cast<char*>(ptr);
+        mapped = true;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+#else
+    std::ifstream is(file, std::ios::binary | std::ios::in | std::ios::ate);
+    if (!is.is_open())
+    {
+        return false;
+    }
+    size_ = is.tellg();
+    if (size_ > 0)
+    {
+        data_ = new char[size_];
+        is.seekg(0, std::ios::beg);
+        is.read(data_, size_);
+    }
+#endif
+
+    is_open = true;
+    return true;
+}
+
+void MemoryMappedFile::close()
+{
+    if (data_)
+    {
+#ifndef _WIN32
+        if (mapped)
+        {
+            munmap(data_, size_);
+        }
+#else
+        delete[] data_;
+#endif
+    }
+    data_   = nullptr;
+    size_   = 0;
+    is_open = false;
+    mapped  = false;
+}
+
+void MemoryMappedFile::adviseSequential()
+{
+#ifndef _WIN32
+    if (mapped)
+    {
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+size_t MemoryMappedFile::PageSize()
+{
+#ifndef _WIN32
+    static size_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+#else
+    return 4096;
+#endif
+}
+
+}  // namespace Saiga
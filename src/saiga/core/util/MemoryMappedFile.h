@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "saiga/config.h"
+#include "saiga/core/util/DataStructures/ArrayView.h"
+
+#include <string>
+
+namespace Saiga
+{
+/**
+ * A read-only view of a complete file on disk.
+ *
+ * On POSIX systems the file is mapped with mmap. The mapping is private (copy-on-write), so the
+ * memory can be written to without changing the file. Pages are shared with the OS page cache until
+ * they are modified. On other platforms the file is read into a heap buffer instead.
+ *
+ * Usage:
+ *
+ *   MemoryMappedFile file("data.bin");
+ *   if (file.valid())
+ *   {
+ *       ArrayView<const char> content = file.view();
+ *   }
+ */
+class SAIGA_CORE_API MemoryMappedFile
+{
+   public:
+    MemoryMappedFile() {}
+    MemoryMappedFile(const std::string& file) { open(file); }
+    ~MemoryMappedFile() { close(); }
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    /**
+     * Maps the complete file. Returns false if the file does not exist or could not be mapped.
+     * Empty files are valid with data() == nullptr.
+     */
+    bool open(const std::string& file);
+    void close();
+
+    bool valid() const { return is_open; }
+
+    // Tell the OS that the file will be read sequentially.
+    // Enables aggressive read-ahead. Has no effect if the file is not mapped.
+    void adviseSequential();
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    ArrayView<char> view() { return {data_, size_}; }
+    ArrayView<const char> view() const { return {data_, size_}; }
+
+    // The page size of the system. Offsets that are multiples of this value are page aligned.
+    static size_t PageSize();
+
+   private:
+    char* data_  = nullptr;
+    size_t size_ = 0;
+    bool is_open = false;
+    bool mapped  = false;
+};
+
+}  // namespace Saiga
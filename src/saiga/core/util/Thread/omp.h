@@ -50,6 +50,16 @@ inline int getNumThreads()
 #endif
 }
 
+// True inside an active parallel region.
+inline bool inParallel()
+{
+#ifdef SAIGA_HAS_OMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+}
+
 inline void setNumThreads(int t)
 {
 #ifdef SAIGA_HAS_OMP
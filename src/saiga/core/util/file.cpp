@@ -11,9 +11,18 @@
 #include "internal/noGraphicsAPI.h"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
+#ifdef SAIGA_USE_ZLIB
+#    include <zlib.h>
+#endif
+
+#ifdef SAIGA_USE_BZIP2
+#    include <bzlib.h>
+#endif
+
 namespace Saiga
 {
 namespace File
@@ -129,6 +138,132 @@ void removeWindowsLineEnding(std::vector<std::string>& file)
 }
 
 
+static bool isGzip(ArrayView<const char> data)
+{
+    return data.size() >= 2 && (unsigned char)data[0] == 0x1F && (unsigned char)data[1] == 0x8B;
+}
+
+static bool isBzip2(ArrayView<const char> data)
+{
+    return data.size() >= 3 && data[0] == 'B' && data[1] == 'Z' && data[2] == 'h';
+}
+
+bool isCompressed(ArrayView<const char> data)
+{
+    return isGzip(data) || isBzip2(data);
+}
+
+bool decompressStream(ArrayView<const char> data, std::vector<char>& result)
+{
+    result.clear();
+    constexpr size_t chunk_size = 1 << 20;
+
+    if (isGzip(data))
+    {
+#ifdef SAIGA_USE_ZLIB
+        z_stream strm;
+        std::memset(&strm, 0, sizeof(strm));
+        // 15 + 32: Maximum window size with automatic gzip/zlib header detection
+        if (inflateInit2(&strm, 15 + 32) != Z_OK) return false;
+
+        // avail_in is only 32 bit -> feed large inputs in multiple parts
+        size_t consumed = 0;
+        auto refill     = [&]() {
+            if (strm.avail_in > 0 || consumed == data.size()) return;
+            size_t n      = std::min<size_t>(data.size() - consumed, 1u << 30);
+            strm.next_in  = (Bytef*)data.data() + consumed;
+            strm.avail_in = n;
+            consumed += n;
+        };
+
+        int ret = Z_OK;
+        while (true)
+        {
+            refill();
+            size_t old_size = result.size();
+            result.resize(old_size + chunk_size);
+            strm.next_out  = (Bytef*)result.data() + old_size;
+            strm.avail_out = chunk_size;
+            ret            = inflate(&strm, Z_NO_FLUSH);
+            result.resize(result.size() - strm.avail_out);
+
+            if (ret == Z_STREAM_END)
+            {
+                // Concatenated gzip members
+                refill();
+                if (strm.avail_in == 0) break;
+                if (inflateReset(&strm) != Z_OK) break;
+            }
+            else if (ret != Z_OK || (strm.avail_in == 0 && consumed == data.size() && strm.avail_out > 0))
+            {
+                // Error or truncated input
+                break;
+            }
+        }
+        inflateEnd(&strm);
+        return ret == Z_STREAM_END;
+#else
+        std::cout << "Saiga was compiled without zlib. Could not decompress gzip stream." << std::endl;
+        return false;
+#endif
+    }
+
+    if (isBzip2(data))
+    {
+#ifdef SAIGA_USE_BZIP2
+        bz_stream strm;
+        std::memset(&strm, 0, sizeof(strm));
+        if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) return false;
+
+        size_t consumed = 0;
+        auto refill     = [&]() {
+            if (strm.avail_in > 0 || consumed == data.size()) return;
+            size_t n      = std::min<size_t>(data.size() - consumed, 1u << 30);
+            strm.next_in  = (char*)data.data() + consumed;
+            strm.avail_in = n;
+            consumed += n;
+        };
+
+        int ret = BZ_OK;
+        while (true)
+        {
+            refill();
+            size_t old_size = result.size();
+            result.resize(old_size + chunk_size);
+            strm.next_out  = result.data() + old_size;
+            strm.avail_out = chunk_size;
+            ret            = BZ2_bzDecompress(&strm);
+            result.resize(result.size() - strm.avail_out);
+
+            if (ret == BZ_STREAM_END)
+            {
+                // Concatenated bzip2 streams (for example created by pbzip2)
+                refill();
+                if (strm.avail_in == 0) break;
+                char* next_in     = strm.next_in;
+                unsigned avail_in = strm.avail_in;
+                BZ2_bzDecompressEnd(&strm);
+                std::memset(&strm, 0, sizeof(strm));
+                if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) return false;
+                strm.next_in  = next_in;
+                strm.avail_in = avail_in;
+            }
+            else if (ret != BZ_OK || (strm.avail_in == 0 && consumed == data.size() && strm.avail_out > 0))
+            {
+                // Error or truncated input
+                break;
+            }
+        }
+        BZ2_bzDecompressEnd(&strm);
+        return ret == BZ_STREAM_END;
+#else
+        std::cout << "Saiga was compiled without bzip2. Could not decompress bzip2 stream." << std::endl;
+        return false;
+#endif
+    }
+
+    return false;
+}
 
 }  // namespace File
 }  // namespace Saiga
@@ -27,5 +27,12 @@ SAIGA_CORE_API void removeWindowsLineEnding(std::vector<std::string>& file);
 
 
 SAIGA_CORE_API void saveFileBinary(const std::string& file, const void* data, size_t size);
+
+// True if the data starts with the magic bytes of a gzip or bzip2 stream.
+SAIGA_CORE_API bool isCompressed(ArrayView<const char> data);
+
+// Decompresses a complete gzip (requires zlib) or bzip2 (requires libbz2) stream. Concatenated streams are
+// supported. Returns false if the format is unknown, the library is missing, or the stream is corrupt.
+SAIGA_CORE_API bool decompressStream(ArrayView<const char> data, std::vector<char>& result);
 }  // namespace File
 }  // namespace Saiga
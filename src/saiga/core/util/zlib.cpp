@@ -9,6 +9,7 @@
 #include "saiga/core/util/assert.h"
 
 #ifdef SAIGA_USE_ZLIB
+#    include <cstring>
 #    include <zlib.h>
 namespace Saiga
 {
@@ -56,6 +57,27 @@ std::vector<unsigned char> uncompress(const void* data)
     return result;
 }
 
+bool uncompress(const void* data, size_t size, size_t expected_size, std::vector<unsigned char>& result)
+{
+    if (size < header_size) return false;
+
+    // The data may not be aligned
+    size_t header[3];
+    std::memcpy(header, data, header_size);
+    size_t compressed_data_size   = header[1];
+    size_t decompressed_data_size = header[2];
+    if (header[0] != magic_value || compressed_data_size > size - header_size ||
+        decompressed_data_size != expected_size)
+    {
+        return false;
+    }
+
+    result.resize(decompressed_data_size);
+    uLongf actual_out_size = decompressed_data_size;
+    int ret = ::uncompress(result.data(), &actual_out_size, (const Byte*)data + header_size, compressed_data_size);
+    return ret == Z_OK && actual_out_size == decompressed_data_size;
+}
+
 }  // namespace Saiga
 
 #endif
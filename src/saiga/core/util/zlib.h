@@ -8,6 +8,7 @@
 
 #include "saiga/config.h"
 
+#include <cstddef>
 #include <vector>
 
 #ifdef SAIGA_USE_ZLIB
@@ -26,6 +27,11 @@ namespace Saiga
 //
 SAIGA_CORE_API std::vector<unsigned char> compress(const void* data, size_t size);
 SAIGA_CORE_API std::vector<unsigned char> uncompress(const void* data);
+
+// Checked uncompress for untrusted input, for example a section of a file.
+// Returns false if the header does not fit into the 'size' bytes at 'data', the decompressed size stored in the header
+// is not 'expected_size', or zlib reports an error.
+SAIGA_CORE_API bool uncompress(const void* data, size_t size, size_t expected_size, std::vector<unsigned char>& result);
 }  // namespace Saiga
 
 #endif
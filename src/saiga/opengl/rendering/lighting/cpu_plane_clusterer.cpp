@@ -35,11 +35,29 @@ void CPUPlaneClusterer::clusterLightsInternal(Camera* cam, const ViewPort& viewP
     if (lightsDebug && updateLightsDebug) lightClustersDebug.lines.clear();
     if (!SAT)
     {
+        lightSpheres.resize(pointLightsClusterData.size());
         for (int i = 0; i < pointLightsClusterData.size(); ++i)
         {
             PointLightClusterData& plc = pointLightsClusterData[i];
-            vec3 sphereCenter          = cam->WorldToView(plc.world_center);
-            float sphereRadius         = plc.radius;
+            lightSpheres.set(i, Sphere(cam->WorldToView(plc.world_center), plc.radius));
+        }
+
+        // Lights outside of the complete grid can not intersect any cluster.
+        Frustum viewFrustum;
+        viewFrustum.planes = {planesZ.front().invert(), planesZ.back(),          planesY.back(),
+                              planesY.front().invert(), planesX.front().invert(), planesX.back()};
+        FrustumCullIndices(viewFrustum, lightSpheres, visibleLightIndices);
+
+        for (int i : visibleLightIndices)
+        {
+            Sphere lightSphere = lightSpheres.get(i);
+            vec3 sphereCenter  = lightSphere.pos;
+            float sphereRadius = lightSphere.r;
+
+            // Distances to all planes at once. The walks below only read them.
+            PlaneDistances(planeSoAZ, sphereCenter, distZ.data());
+            PlaneDistances(planeSoAY, sphereCenter, distY.data());
+            PlaneDistances(planeSoAX, sphereCenter, distX.data());
 
             int x0 = 0, x1 = planesX.size() - 1;
             int y0 = 0, y1 = planesY.size() - 1;
@@ -49,20 +67,20 @@ void CPUPlaneClusterer::clusterLightsInternal(Camera* cam, const ViewPort& viewP
             int centerOutsideY = 0;
 
 
-            while (z0 < z1 && planesZ[z0].distance(sphereCenter) >= sphereRadius)
+            while (z0 < z1 && distZ[z0] >= sphereRadius)
             {
                 z0++;
             }
-            if (--z0 < 0 && planesZ[0].distance(sphereCenter) < 0)
+            if (--z0 < 0 && distZ[0] < 0)
             {
                 centerOutsideZ--;  // Center is behind camera far plane.
             }
             z0 = std::max(0, z0);
-            while (z1 >= z0 && -planesZ[z1].distance(sphereCenter) >= sphereRadius)
+            while (z1 >= z0 && -distZ[z1] >= sphereRadius)
             {
                 --z1;
             }
-            if (++z1 > (int)planesZ.size() - 1 && planesZ[(int)planesZ.size() - 1].distance(sphereCenter) > 0)
+            if (++z1 > (int)planesZ.size() - 1 && distZ[(int)planesZ.size() - 1] > 0)
             {
                 centerOutsideZ++;  // Center is in front of camera near plane.
             }
@@ -73,20 +91,20 @@ void CPUPlaneClusterer::clusterLightsInternal(Camera* cam, const ViewPort& viewP
             }
 
 
-            while (y0 < y1 && planesY[y0].distance(sphereCenter) >= sphereRadius)
+            while (y0 < y1 && distY[y0] >= sphereRadius)
             {
                 y0++;
             }
-            if (--y0 < 0 && planesY[0].distance(sphereCenter) < 0)
+            if (--y0 < 0 && distY[0] < 0)
             {
                 centerOutsideY--;  // Center left outside frustum.
             }
             y0 = std::max(0, y0);
-            while (y1 >= y0 && -planesY[y1].distance(sphereCenter) >= sphereRadius)
+            while (y1 >= y0 && -distY[y1] >= sphereRadius)
             {
                 --y1;
             }
-            if (++y1 > (int)planesY.size() - 1 && planesY[(int)planesY.size() - 1].distance(sphereCenter) > 0)
+            if (++y1 > (int)planesY.size() - 1 && distY[(int)planesY.size() - 1] > 0)
             {
                 centerOutsideY++;  // Center right outside frustum.
             }
@@ -97,12 +115,12 @@ void CPUPlaneClusterer::clusterLightsInternal(Camera* cam, const ViewPort& viewP
             }
 
 
-            while (x0 < x1 && planesX[x0].distance(sphereCenter) >= sphereRadius)
+            while (x0 < x1 && distX[x0] >= sphereRadius)
             {
                 x0++;
             }
             x0 = std::max(0, --x0);
-            while (x1 >= x0 && -planesX[x1].distance(sphereCenter) >= sphereRadius)
+            while (x1 >= x0 && -distX[x1] >= sphereRadius)
             {
                 --x1;
             }
@@ -145,7 +163,7 @@ void CPUPlaneClusterer::clusterLightsInternal(Camera* cam, const ViewPort& viewP
                 int centerZ = cz / 2;
                 if (centerOutsideZ == 0 && cz % 2 == 0)
                 {
-                    float d0 = planesZ[centerZ].distance(sphereCenter);
+                    float d0 = distZ[centerZ];
                     if (d0 < 1e-5f) centerZ -= 1;
                 }
 
@@ -161,12 +179,10 @@ void CPUPlaneClusterer::clusterLightsInternal(Camera* cam, const ViewPort& viewP
                 int centerY = cy / 2;
                 if (centerOutsideY == 0 && cy % 2 == 0)
                 {
-                    float d0 = planesY[centerY].distance(sphereCenter);
+                    float d0 = distY[centerY];
                     if (d0 < 1e-5f) centerY -= 1;
                 }
 
-                Sphere lightSphere(sphereCenter, sphereRadius);
-
                 z0 = std::max(0, z0);
                 z1 = std::min(z1, (int)planesZ.size() - 1);
                 y0 = std::max(0, y0);
@@ -483,6 +499,13 @@ void CPUPlaneClusterer::buildClusters(Camera* cam)
         planesZ[z] = Plane(viewFarClusterBL, vec3(0, 0, 1));
     }
 
+    planeSoAX = PlaneSoA(planesX);
+    planeSoAY = PlaneSoA(planesY);
+    planeSoAZ = PlaneSoA(planesZ);
+    distX.resize(planeSoAX.paddedSize());
+    distY.resize(planeSoAY.paddedSize());
+    distZ.resize(planeSoAZ.paddedSize());
+
     if (SAT || clusterDebug || lightsDebug)
     {
         debugFrusta.resize(clusterCount);
@@ -5,6 +5,7 @@
  */
 
 #pragma once
+#include "saiga/core/geometry/BatchCulling.h"
 #include "saiga/opengl/rendering/lighting/light_clusterer.h"
 
 namespace Saiga
@@ -38,6 +39,16 @@ class SAIGA_OPENGL_API CPUPlaneClusterer : public Clusterer
     std::vector<Plane> planesY;
     std::vector<Plane> planesZ;
 
+    // The same planes as structure of arrays for the batched distance computation.
+    PlaneSoA planeSoAX;
+    PlaneSoA planeSoAY;
+    PlaneSoA planeSoAZ;
+    std::vector<float> distX, distY, distZ;
+
+    // View space light spheres. Lights outside of the view frustum are culled 4 at a time.
+    SphereSoA lightSpheres;
+    std::vector<int> visibleLightIndices;
+
     int avgAllowedItemsPerCluster = 128;
     std::vector<std::vector<int>> clusterCache;
 
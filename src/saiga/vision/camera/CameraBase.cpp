@@ -20,6 +20,8 @@ void DatasetParameters::fromConfigFile(const std::string& file)
     INI_GETADD_LONG(ini, group, maxFrames);
     INI_GETADD_BOOL(ini, group, multiThreadedLoad);
     INI_GETADD_BOOL(ini, group, preload);
+    INI_GETADD_LONG(ini, group, prefetch_frames);
+    INI_GETADD_LONG(ini, group, prefetch_threads);
     INI_GETADD_BOOL(ini, group, normalize_timestamps);
     INI_GETADD_DOUBLE(ini, group, ground_truth_time_offset);
     if (ini.changed()) ini.SaveFile(file.c_str());
@@ -38,6 +40,11 @@ DatasetCameraBase::DatasetCameraBase(const DatasetParameters& params) : params(p
     ResetTime();
 }
 
+DatasetCameraBase::~DatasetCameraBase()
+{
+    StopPrefetching();
+}
+
 void DatasetCameraBase::ResetTime()
 {
     timer.start();
@@ -69,9 +76,38 @@ void DatasetCameraBase::Load()
             loadingBar.addProgress(1);
         }
     }
+    else if (Prefetching())
+    {
+        prefetch_pool    = std::make_unique<ThreadPool>(std::max(1, params.prefetch_threads), "Prefetch");
+        next_prefetch_id = currentId;
+        FillPrefetchWindow();
+    }
     ResetTime();
 }
 
+void DatasetCameraBase::StopPrefetching()
+{
+    for (auto& p : prefetch_queue)
+    {
+        p.second.wait();
+    }
+    prefetch_queue.clear();
+    prefetch_pool.reset();
+}
+
+void DatasetCameraBase::FillPrefetchWindow()
+{
+    while (next_prefetch_id < (int)frames.size() && next_prefetch_id < this->currentId + params.prefetch_frames)
+    {
+        int id = next_prefetch_id++;
+        prefetch_queue.emplace_back(id, prefetch_pool->enqueue([this, id]() {
+            auto& frame = frames[id];
+            frame.SetBufferPool(globalImageBufferPool());
+            LoadImageData(frame);
+        }));
+    }
+}
+
 bool DatasetCameraBase::getImageSync(FrameData& data)
 {
     if (!this->isOpened())
@@ -99,12 +135,39 @@ bool DatasetCameraBase::getImageSync(FrameData& data)
 
     auto& img = frames[this->currentId];
     SAIGA_ASSERT(this->currentId == img.id);
-    if (!params.preload)
+    if (Prefetching())
     {
+        FillPrefetchWindow();
+        SAIGA_ASSERT(!prefetch_queue.empty() && prefetch_queue.front().first == this->currentId);
+
+        auto& loaded = prefetch_queue.front().second;
+        if (loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            double stall_time;
+            {
+                auto stall_timer = make_scoped_timer(stall_time);
+                loaded.wait();
+            }
+            io_stall_time_ms += stall_time;
+            stalled_frames++;
+        }
+        loaded.get();
+        prefetch_queue.pop_front();
+    }
+    else if (!params.preload)
+    {
+        img.SetBufferPool(globalImageBufferPool());
         LoadImageData(img);
     }
     this->currentId++;
+
+    // In streaming mode, the move assignment returns the images of the previous frame to the buffer pool.
     data = std::move(img);
+
+    if (Prefetching())
+    {
+        FillPrefetchWindow();
+    }
     return true;
 }
 
@@ -128,6 +191,7 @@ void DatasetCameraBase::saveGroundTruthTrajectory(const std::string& file)
 
 void DatasetCameraBase::eraseFrames(int from, int to)
 {
+    SAIGA_ASSERT(prefetch_queue.empty(), "Frames can not be erased while prefetching.");
     frames.erase(frames.begin() + from, frames.begin() + to);
     imuDataForFrame.erase(imuDataForFrame.begin() + from, imuDataForFrame.begin() + to);
 }
@@ -8,9 +8,11 @@
 #include "saiga/core/time/timer.h"
 #include "saiga/core/util/ProgressBar.h"
 #include "saiga/core/util/Thread/omp.h"
+#include "saiga/core/util/Thread/threadPool.h"
 
 #include "CameraData.h"
 
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <thread>
@@ -73,6 +75,13 @@ struct SAIGA_VISION_API DatasetParameters
     // Load all images to ram at the beginning.
     bool preload = true;
 
+    // Streaming mode. Only used if preload == false.
+    // If > 0, a pool of 'prefetch_threads' decoder threads loads the next 'prefetch_frames' frames in the
+    // background. The memory usage is bounded by this window and independent of the sequence length.
+    // If 0, the images are loaded synchronously in getImageSync.
+    int prefetch_frames  = 0;
+    int prefetch_threads = 2;
+
     // Subtract the timestamp of the first image from everything.
     bool normalize_timestamps = false;
 
@@ -92,6 +101,7 @@ class SAIGA_VISION_API DatasetCameraBase : public CameraBase
 {
    public:
     DatasetCameraBase(const DatasetParameters& params);
+    virtual ~DatasetCameraBase();
 
     void ResetTime();
 
@@ -129,9 +139,16 @@ class SAIGA_VISION_API DatasetCameraBase : public CameraBase
 
     void computeImuDataPerFrame();
 
-
+    // Statistics of the streaming mode.
+    // The total time getImageSync has waited for the prefetcher and the number of frames that were not ready.
+    double IOStallTime() const { return io_stall_time_ms; }
+    int StalledFrames() const { return stalled_frames; }
 
    protected:
+    // Waits for all background loads to finish and shuts down the decoder threads.
+    // Derived classes must call this in their destructor, because the decoder threads use LoadImageData.
+    void StopPrefetching();
+
     AlignedVector<FrameData> frames;
     DatasetParameters params;
     std::vector<Imu::Data> imuData;
@@ -144,6 +161,17 @@ class SAIGA_VISION_API DatasetCameraBase : public CameraBase
     tick_t timeStep;
     tick_t lastFrameTime;
     tick_t nextFrameTime;
+
+    // ==== Streaming mode ====
+    bool Prefetching() const { return !params.preload && params.prefetch_frames > 0; }
+    void FillPrefetchWindow();
+
+    std::unique_ptr<ThreadPool> prefetch_pool;
+    std::deque<std::pair<int, std::future<void>>> prefetch_queue;
+    int next_prefetch_id = 0;
+
+    double io_stall_time_ms = 0;
+    int stalled_frames      = 0;
 };
 
 
@@ -91,6 +91,16 @@ struct SAIGA_VISION_API FrameData : public FrameMetaData
         right_image.free();
         right_image_rgb.free();
     }
+
+    // All images of this frame acquire their memory from the given pool.
+    void SetBufferPool(const std::shared_ptr<ImageBufferPool>& pool)
+    {
+        image.setBufferPool(pool);
+        image_rgb.setBufferPool(pool);
+        depth_image.setBufferPool(pool);
+        right_image.setBufferPool(pool);
+        right_image_rgb.setBufferPool(pool);
+    }
 };
 
 
@@ -81,7 +81,6 @@ EuRoCDataset::EuRoCDataset(const DatasetParameters& _params, Sequence sequence)
 void EuRoCDataset::LoadImageData(FrameData& data)
 {
     //    std::cout << "EuRoCDataset::LoadImageData " << data.id << std::endl;
-    SAIGA_ASSERT(data.image.rows == 0);
     // Load if it's not loaded already
 
     data.image.load(data.image_file);
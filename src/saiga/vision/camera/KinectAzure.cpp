@@ -181,6 +181,7 @@ bool KinectCamera::Open()
 bool KinectCamera::getImageSync(FrameData& data)
 {
     data.id = currentId++;
+    data.SetBufferPool(globalImageBufferPool());
 
     k4a::capture capture;
 
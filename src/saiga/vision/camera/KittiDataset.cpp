@@ -267,7 +267,6 @@ int KittiDataset::LoadMetaData()
 
 void KittiDataset::LoadImageData(FrameData& data)
 {
-    SAIGA_ASSERT(data.image.rows == 0);
 
     data.image.load(data.image_file);
     if (!params.force_monocular)
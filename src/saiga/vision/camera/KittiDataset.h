@@ -19,6 +19,7 @@ class SAIGA_VISION_API KittiDataset : public DatasetCameraBase
 {
    public:
     KittiDataset(const DatasetParameters& params);
+    ~KittiDataset() { StopPrefetching(); }
 
     virtual int LoadMetaData() override;
     virtual void LoadImageData(FrameData& data) override;
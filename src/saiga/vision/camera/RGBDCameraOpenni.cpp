@@ -49,6 +49,8 @@ RGBDCameraOpenni::~RGBDCameraOpenni() {}
 
 bool RGBDCameraOpenni::getImageSync(FrameData& data)
 {
+    // Frames that are dropped by the caller return their memory to the pool.
+    data.SetBufferPool(globalImageBufferPool());
     data.image_rgb.create(intrinsics().imageSize.h, intrinsics().imageSize.w);
     data.depth_image.create(intrinsics().depthImageSize.h, intrinsics().depthImageSize.w);
     data.id = currentId++;
@@ -28,7 +28,10 @@ SaigaDataset::SaigaDataset(const DatasetParameters& _params, bool scale_down_dep
     Load();
 }
 
-SaigaDataset::~SaigaDataset() {}
+SaigaDataset::~SaigaDataset()
+{
+    StopPrefetching();
+}
 
 
 
@@ -40,9 +43,10 @@ void SaigaDataset::LoadImageData(FrameData& data)
 
     if (scale_down_depth)
     {
-        TemplatedImage<float> tmp(_intrinsics.depthImageSize);
+        TemplatedImage<float> tmp(_intrinsics.depthImageSize.h, _intrinsics.depthImageSize.w,
+                                  data.depth_image.bufferPool());
         DMPP::scaleDown2median(data.depth_image.getImageView(), tmp.getImageView());
-        data.depth_image = tmp;
+        data.depth_image = std::move(tmp);
     }
 }
 
@@ -34,8 +34,12 @@ void ScannetDataset::LoadImageData(FrameData& data)
     data.depth_image.create(intrinsics().depthImageSize.h, intrinsics().depthImageSize.w);
 
 
-    Image cimg(data.image_file);
-    Image dimg(data.depth_file);
+    // The decoded files are only temporary. In streaming mode they use the buffer pool of the frame.
+    Image cimg, dimg;
+    cimg.setBufferPool(data.image_rgb.bufferPool());
+    dimg.setBufferPool(data.depth_image.bufferPool());
+    auto loaded = cimg.load(data.image_file) && dimg.load(data.depth_file);
+    SAIGA_ASSERT(loaded);
 
     SAIGA_ASSERT(cimg.valid());
     SAIGA_ASSERT(dimg.valid());
@@ -44,7 +48,7 @@ void ScannetDataset::LoadImageData(FrameData& data)
     {
         if (scale_down_color)
         {
-            RGBImageType tmp(cimg.h, cimg.w);
+            RGBImageType tmp(cimg.h, cimg.w, data.image_rgb.bufferPool());
             ImageTransformation::addAlphaChannel(cimg.getImageView<ucvec3>(), tmp);
             ImageTransformation::ScaleDown2(tmp.getImageView(), data.image_rgb.getImageView());
         }
@@ -58,7 +62,7 @@ void ScannetDataset::LoadImageData(FrameData& data)
     {
         if (scale_down_color)
         {
-            RGBImageType tmp(cimg.h, cimg.w);
+            RGBImageType tmp(cimg.h, cimg.w, data.image_rgb.bufferPool());
             cimg.getImageView<ucvec4>().copyTo(tmp.getImageView());
             ImageTransformation::ScaleDown2(tmp.getImageView(), data.image_rgb.getImageView());
         }
@@ -78,7 +82,7 @@ void ScannetDataset::LoadImageData(FrameData& data)
     {
         if (scale_down_depth)
         {
-            DepthImageType tmp(dimg.h, dimg.w);
+            DepthImageType tmp(dimg.h, dimg.w, data.depth_image.bufferPool());
             dimg.getImageView<unsigned short>().copyTo(tmp.getImageView(), 1.0 / intrinsics().depthFactor);
             dmpp.scaleDown2median(tmp.getImageView(), data.depth_image.getImageView());
         }
@@ -55,7 +55,7 @@ class SAIGA_VISION_API ScannetDataset : public DatasetCameraBase
 {
    public:
     ScannetDataset(const DatasetParameters& params, bool scale_down_color = true, bool scale_down_depth = true);
-    virtual ~ScannetDataset() {}
+    virtual ~ScannetDataset() { StopPrefetching(); }
 
 
     RGBDIntrinsics intrinsics() { return _intrinsics; }
@@ -85,7 +85,10 @@ TumRGBDDataset::TumRGBDDataset(const DatasetParameters& _params, int freiburg)
     Load();
 }
 
-TumRGBDDataset::~TumRGBDDataset() {}
+TumRGBDDataset::~TumRGBDDataset()
+{
+    StopPrefetching();
+}
 
 
 SE3 TumRGBDDataset::getGroundTruth(int frame)
@@ -111,8 +114,16 @@ void TumRGBDDataset::saveRaw(const std::string& dir)
 
 void TumRGBDDataset::LoadImageData(FrameData& data)
 {
-    Image cimg(data.image_file);
-    Image dimg(data.depth_file);
+    // The images are created here (and not in LoadMetaData) so that the memory of not yet loaded frames is free.
+    data.image_rgb.create(intrinsics().imageSize.h, intrinsics().imageSize.w);
+    data.depth_image.create(intrinsics().depthImageSize.h, intrinsics().depthImageSize.w);
+
+    // The decoded files are only temporary. In streaming mode they use the buffer pool of the frame.
+    Image cimg, dimg;
+    cimg.setBufferPool(data.image_rgb.bufferPool());
+    dimg.setBufferPool(data.depth_image.bufferPool());
+    auto loaded = cimg.load(data.image_file) && dimg.load(data.depth_file);
+    SAIGA_ASSERT(loaded);
     if (cimg.type == UC3)
     {
         // convert to rgba
@@ -319,8 +330,6 @@ void TumRGBDDataset::load(const std::string& datasetDir, bool multithreaded)
             //            makeFrameData(f);
 
             f.id = i;
-            f.image_rgb.create(intrinsics().imageSize.h, intrinsics().imageSize.w);
-            f.depth_image.create(intrinsics().depthImageSize.h, intrinsics().depthImageSize.w);
             f.timeStamp  = d.rgb.timestamp;
             f.image_file       = datasetDir + "/" + d.rgb.img;
             f.depth_file = datasetDir + "/" + d.depth.img;
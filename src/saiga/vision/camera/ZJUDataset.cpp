@@ -33,21 +33,20 @@ ZJUDataset::ZJUDataset(const DatasetParameters& params) : DatasetCameraBase(para
 
 void ZJUDataset::LoadImageData(FrameData& data)
 {
-    SAIGA_ASSERT(data.image.rows == 0);
-
-    Image cimg(data.image_file);
+    Image cimg;
+    cimg.setBufferPool(data.image.bufferPool());
+    auto loaded = cimg.load(data.image_file);
+    SAIGA_ASSERT(loaded);
     if (cimg.type == UC1)
     {
-        //                frames[i] = std::move(cimg);
-        GrayImageType imgGray(cimg.h, cimg.w);
-        cimg.getImageView<unsigned char>().copyTo(imgGray.getImageView());
-        data.image = imgGray;
+        data.image.create(cimg.h, cimg.w);
+        cimg.getImageView<unsigned char>().copyTo(data.image.getImageView());
     }
     else if (cimg.type == UC3 || cimg.type == UC3)
     {
         // this is currently only the case for "black frames"
-        GrayImageType imgGray(cimg.h, cimg.w);
-        data.image = imgGray;
+        data.image.create(cimg.h, cimg.w);
+        data.image.makeZero();
     }
     else
     {
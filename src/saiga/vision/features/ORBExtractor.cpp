@@ -63,6 +63,7 @@
 
 #ifdef SAIGA_USE_OPENCV
 
+#    include "saiga/core/image/imageBufferPool.h"
 #    include "saiga/core/time/all.h"
 #    include "saiga/core/util/Thread/omp.h"
 #    include "saiga/vision/opencv/opencv.h"
@@ -236,7 +237,7 @@ void ORBExtractor::Detect(Saiga::ImageView<unsigned char> inputImage, std::vecto
 void ORBExtractor::AllocatePyramid(int rows, int cols)
 {
     SAIGA_ASSERT(!levels.empty());
-    if (levels.front().image.valid()) return;
+    if (levels.front().image.valid() && levels.front().image.rows == rows && levels.front().image.cols == cols) return;
 
     for (int level = 0; level < num_levels; ++level)
     {
@@ -249,6 +250,10 @@ void ORBExtractor::AllocatePyramid(int rows, int cols)
         int level_rows_with_border = level_rows + EDGE_THRESHOLD * 2;
         int level_cols_with_border = level_cols + EDGE_THRESHOLD * 2;
 
+        // Reallocations (new input size, new extractor) reuse the memory of previous pyramids.
+        level_data.image_with_border.setBufferPool(globalImageBufferPool());
+        level_data.image_gauss.setBufferPool(globalImageBufferPool());
+
         level_data.image_with_border.create(level_rows_with_border, level_cols_with_border);
         level_data.image = level_data.image_with_border.getImageView().subImageView(EDGE_THRESHOLD, EDGE_THRESHOLD,
                                                                                     level_rows, level_cols);
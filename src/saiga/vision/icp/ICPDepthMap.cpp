@@ -7,7 +7,9 @@
 
 #include "ICPDepthMap.h"
 
+#include "saiga/core/math/imath.h"
 #include "saiga/core/time/timer.h"
+#include "saiga/core/util/assert.h"
 
 namespace Saiga
 {
@@ -22,18 +24,39 @@ DepthMapExtended::DepthMapExtended(const DepthMap& depth, const Intrinsics4& cam
     Saiga::Depthmap::normalMap(points, normals);
 }
 
+DepthMapExtended::DepthMapExtended(const DepthMapExtended& finer, int downsampleFactor)
+    : points(iDivUp(finer.h(), downsampleFactor), iDivUp(finer.w(), downsampleFactor)),
+      normals(points.h, points.w),
+      camera(finer.camera),
+      pose(finer.pose)
+{
+    SAIGA_ASSERT(downsampleFactor >= 1);
+    // Pixel (i,j) of this level is pixel (i*f,j*f) of the finer level
+    camera.scale(1.0 / downsampleFactor);
+
+#pragma omp parallel for
+    for (int i = 0; i < points.h; ++i)
+    {
+        for (int j = 0; j < points.w; ++j)
+        {
+            points(i, j) = finer.points(i * downsampleFactor, j * downsampleFactor);
+        }
+    }
+    Saiga::Depthmap::normalMap(points, normals);
+}
+
 AlignedVector<Correspondence> projectiveCorrespondences(const DepthMapExtended& ref, const DepthMapExtended& src,
                                                         const ProjectiveCorrespondencesParams& params)
 {
     AlignedVector<Correspondence> result;
-    result.reserve(ref.depth.h * ref.depth.w);
+    result.reserve(ref.h() * ref.w());
 
 
     auto T = ref.pose.inverse() * src.pose;  // A <- B
 
-    for (int i = 0; i < src.depth.h; i += params.stride)
+    for (int i = 0; i < src.h(); i += params.stride)
     {
-        for (int j = 0; j < src.depth.w; j += params.stride)
+        for (int j = 0; j < src.w(); j += params.stride)
         {
             Vec3 p0 = src.points(i, j);
             Vec3 n0 = src.normals(i, j);
@@ -107,21 +130,152 @@ AlignedVector<Correspondence> projectiveCorrespondences(const DepthMapExtended&
     return result;
 }
 
-SE3 alignDepthMaps(DepthMap referenceDepthMap, DepthMap sourceDepthMap, const SE3& refPose, const SE3& srcPose,
-                   const Intrinsics4& camera, int iterations, ProjectiveCorrespondencesParams params)
+SE3 PointToPlaneSystem::update(const SE3& src) const
 {
-    DepthMapExtended ref(referenceDepthMap, camera, refPose);
-    DepthMapExtended src(sourceDepthMap, camera, srcPose);
+    SAIGA_ASSERT(correspondences >= 6);
+    Vec6 x = JtJ.selfadjointView<Eigen::Upper>().ldlt().solve(Jtb);
+    return SE3::exp(x) * src;
+}
+
+PointToPlaneSystem projectivePointToPlane(const DepthMapExtended& ref, const DepthMapExtended& src,
+                                          const ProjectiveCorrespondencesParams& params)
+{
+    // The system is accumulated in the reference frame and transformed to world space at the end.
+    // For a pose update of the form exp(x) * T the increments are related by
+    //      x_world = Adj(ref.pose) * x_ref
+    PointToPlaneSystem refSystem;
+
+    auto T     = ref.pose.inverse() * src.pose;  // A <- B
+    Mat3 R     = T.so3().matrix();
+    Vec3 t     = T.translation();
+    int S      = params.searchRadius;
+    auto refPC = ref.points.getConstImageView();
+    int rows   = iDivUp(src.h(), params.stride);
+
+#pragma omp parallel
+    {
+        PointToPlaneSystem local;
+
+#pragma omp for schedule(static) nowait
+        for (int r = 0; r < rows; ++r)
+        {
+            int i = r * params.stride;
+            for (int j = 0; j < src.w(); j += params.stride)
+            {
+                const Vec3& p0 = src.points(i, j);
+                const Vec3& n0 = src.normals(i, j);
+                if (!p0.allFinite() || !n0.allFinite()) continue;
+
+                // transform point and normal to reference frame
+                Vec3 p = R * p0 + t;
+                Vec3 n = R * n0;
+
+                // project point to reference to find correspondences
+                Vec2 ip = ref.camera.project(p).array().round();
+                int sx  = ip(0);
+                int sy  = ip(1);
+
+                // Same search as in projectiveCorrespondences (with squared distances)
+                double bestDist = std::numeric_limits<double>::infinity();
+                int bestX = 0, bestY = 0;
+                for (int dy = -S; dy <= S; ++dy)
+                {
+                    for (int dx = -S; dx <= S; ++dx)
+                    {
+                        int x = sx + dx;
+                        int y = sy + dy;
+                        if (!refPC.inImage(y, x)) continue;
+
+                        const Vec3& p2 = ref.points(y, x);
+                        const Vec3& n2 = ref.normals(y, x);
+                        if (!p2.allFinite() || !n2.allFinite()) continue;
+
+                        double distance = (p2 - p).squaredNorm();
+                        double disTh =
+                            params.scaleDistanceThresByDepth ? params.distanceThres * p2(2) : params.distanceThres;
+
+                        if (distance < bestDist && distance < disTh * disTh && n.dot(n2) > params.cosNormalThres)
+                        {
+                            bestDist = distance;
+                            bestX    = x;
+                            bestY    = y;
+                        }
+                    }
+                }
+                if (!std::isfinite(bestDist)) continue;
+
+                const Vec3& rp  = ref.points(bestY, bestX);
+                const Vec3& rn  = ref.normals(bestY, bestX);
+                double invDepth = 1.0 / rp(2);
+                double weight   = params.useInvDepthAsWeight ? invDepth * invDepth : 1;
+
+                // Same residual and jacobian as in pointToPlane, but in the reference frame
+                Vec6 row;
+                row.head<3>() = rn;
+                row.tail<3>() = p.cross(rn);
+                double res    = rn.dot(rp - p);
+
+                row *= weight;
+                res *= weight;
+
+                local.JtJ.noalias() += row * row.transpose();
+                local.Jtb += row * res;
+                local.chi2 += res * res;
+                local.correspondences++;
+            }
+        }
+
+#pragma omp critical
+        {
+            refSystem.JtJ += local.JtJ;
+            refSystem.Jtb += local.Jtb;
+            refSystem.chi2 += local.chi2;
+            refSystem.correspondences += local.correspondences;
+        }
+    }
 
+    // J_ref = J_world * Adj(ref.pose)  ->  J_world = J_ref * Adj(ref.pose^-1)
+    Eigen::Matrix<double, 6, 6> AdjInv = ref.pose.inverse().Adj();
+    Eigen::Matrix<double, 6, 6> JtJ    = refSystem.JtJ.selfadjointView<Eigen::Upper>();
 
-    AlignedVector<Correspondence> corrs;
+    PointToPlaneSystem result      = refSystem;
+    result.JtJ                     = AdjInv.transpose() * JtJ * AdjInv;
+    result.Jtb                     = AdjInv.transpose() * refSystem.Jtb;
+    return result;
+}
 
-    for (int k = 0; k < iterations; ++k)
+SE3 alignDepthMaps(DepthMap referenceDepthMap, DepthMap sourceDepthMap, const SE3& refPose, const SE3& srcPose,
+                   const Intrinsics4& camera, int iterations, ProjectiveCorrespondencesParams params,
+                   int pyramidLevels)
+{
+    SAIGA_ASSERT(pyramidLevels >= 1);
+
+    // Level 0 is the full resolution
+    AlignedVector<DepthMapExtended> refPyramid, srcPyramid;
+    refPyramid.reserve(pyramidLevels);
+    srcPyramid.reserve(pyramidLevels);
+    refPyramid.emplace_back(referenceDepthMap, camera, refPose);
+    srcPyramid.emplace_back(sourceDepthMap, camera, srcPose);
+    for (int l = 1; l < pyramidLevels; ++l)
     {
-        corrs    = Saiga::ICP::projectiveCorrespondences(ref, src, params);
-        src.pose = Saiga::ICP::pointToPlane(corrs, ref.pose, src.pose);
+        refPyramid.emplace_back(refPyramid.back(), 2);
+        srcPyramid.emplace_back(srcPyramid.back(), 2);
+    }
+
+    SE3 pose = srcPose;
+    for (int l = pyramidLevels - 1; l >= 0; --l)
+    {
+        auto& ref = refPyramid[l];
+        auto& src = srcPyramid[l];
+        for (int k = 0; k < iterations; ++k)
+        {
+            src.pose    = pose;
+            auto system = projectivePointToPlane(ref, src, params);
+            if (system.correspondences < 6) break;
+            pose = system.update(pose);
+        }
     }
-    return src.pose;
+    return pose;
 }
 
 
@@ -26,6 +26,16 @@ struct SAIGA_VISION_API DepthMapExtended
 
     DepthMapExtended(const Depthmap::DepthMap& depth, const Intrinsics4& camera, const SE3& pose);
 
+    /**
+     * Creates the next coarser pyramid level with half the resolution of 'finer'.
+     * Every second point of the finer point cloud is used and the normals are recomputed.
+     * Note: The coarse level has no depth image. Only the points and normals are used by the ICP.
+     */
+    explicit DepthMapExtended(const DepthMapExtended& finer, int downsampleFactor);
+
+    int h() const { return points.h; }
+    int w() const { return points.w; }
+
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
@@ -49,16 +59,48 @@ SAIGA_VISION_API AlignedVector<Correspondence> projectiveCorrespondences(const D
                                                                      const ProjectiveCorrespondencesParams& params);
 
 
+/**
+ * The normal equations of the point-to-plane ICP (see pointToPlane) for a single Gauss-Newton step.
+ * Only the upper triangle of JtJ is used by update().
+ */
+struct SAIGA_VISION_API PointToPlaneSystem
+{
+    Eigen::Matrix<double, 6, 6> JtJ = Eigen::Matrix<double, 6, 6>::Zero();
+    Vec6 Jtb                        = Vec6::Zero();
+    double chi2                     = 0;
+    int correspondences             = 0;
+
+    // Solves the system and applies the increment to the source pose.
+    SE3 update(const SE3& src) const;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * Fused version of projectiveCorrespondences() and pointToPlane().
+ * The correspondences are not stored. The residuals are directly accumulated into the normal equations. The rows of
+ * the source image are processed in parallel with one local system per thread, which are summed up at the end.
+ *
+ * The result is the same as pointToPlane(projectiveCorrespondences(ref, src, params), ref.pose, src.pose, 1), up to
+ * the floating point summation order.
+ */
+SAIGA_VISION_API PointToPlaneSystem projectivePointToPlane(const DepthMapExtended& ref, const DepthMapExtended& src,
+                                                           const ProjectiveCorrespondencesParams& params);
+
 /**
  * Aligns two depth images.
  * This function:
  *  - Computes the point clouds + normal maps
  *  - finds projective correspondences (function above) with default params
  *  - finds the rigid transformation between the point clouds with point-to-plane metric (see ICP align)
+ *
+ * With pyramidLevels > 1 the alignment is done coarse-to-fine. Each level has half the resolution of the previous
+ * level and 'iterations' Gauss-Newton steps are done on every level.
  */
 SAIGA_VISION_API SE3 alignDepthMaps(Depthmap::DepthMap referenceDepthMap, Depthmap::DepthMap sourceDepthMap,
                                 const SE3& refPose, const SE3& srcPose, const Intrinsics4& camera, int iterations,
-                                ProjectiveCorrespondencesParams params = ProjectiveCorrespondencesParams());
+                                ProjectiveCorrespondencesParams params = ProjectiveCorrespondencesParams(),
+                                int pyramidLevels = 1);
 
 }  // namespace ICP
 }  // namespace Saiga
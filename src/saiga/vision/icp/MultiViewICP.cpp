@@ -20,6 +20,11 @@
 #endif
 #include "saiga/core/time/timer.h"
 #include "saiga/core/util/assert.h"
+#include "saiga/vision/recursive/GraphStructure.h"
+#include "saiga/vision/recursive/Recursive.h"
+
+#include <algorithm>
+#include <memory>
 
 namespace Saiga
 {
@@ -195,5 +200,126 @@ void multiViewICP(const std::vector<Depthmap::DepthMap>& depthMaps, AlignedVecto
 
 
 
+int multiViewICPGlobal(const std::vector<Depthmap::DepthMap>& depthMaps, AlignedVector<SE3>& guesses,
+                       const Intrinsics4& camera, const MultiViewICPParams& params)
+{
+    using Block  = Eigen::Matrix<double, 6, 6>;
+    using Vector = Eigen::Matrix<double, 6, 1>;
+    using SType  = Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<Block>, Eigen::RowMajor>;
+    using BType  = Eigen::Matrix<Eigen::Recursive::MatrixScalar<Vector>, -1, 1>;
+
+    int N = depthMaps.size();
+    SAIGA_ASSERT((int)guesses.size() == N);
+
+    // Point clouds and normals of all views
+    std::vector<std::unique_ptr<DepthMapExtended>> views(N);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < N; ++i)
+    {
+        views[i] = std::make_unique<DepthMapExtended>(depthMaps[i], camera, guesses[i]);
+        if (params.downsampleFactor > 1)
+        {
+            views[i] = std::make_unique<DepthMapExtended>(*views[i], params.downsampleFactor);
+        }
+    }
+
+    // Candidate pairs from the initial guess
+    std::vector<std::pair<int, int>> candidates;
+    for (int i = 0; i < N; ++i)
+    {
+        for (int j = i + 1; j < N; ++j)
+        {
+            double distance = (guesses[i].translation() - guesses[j].translation()).norm();
+            double angle    = std::acos(std::clamp(
+                (guesses[i].so3() * Vec3(0, 0, 1)).dot(guesses[j].so3() * Vec3(0, 0, 1)), -1.0, 1.0));
+            if (distance < params.maxCameraDistance && angle < params.maxViewAngle) candidates.emplace_back(i, j);
+        }
+    }
+
+    GraphStructure structure;
+    SType S;
+    BType b(N), x(N);
+    Eigen::Recursive::MixedSymmetricRecursiveSolver<SType, BType> solver;
+    Eigen::Recursive::LinearSolverOptions loptions;
+    loptions.solverType = Eigen::Recursive::LinearSolverOptions::SolverType::Direct;
+
+    AlignedVector<PointToPlaneSystem> systems(candidates.size());
+    int usedPairs = 0;
+
+    for (int it = 0; it < params.iterations; ++it)
+    {
+        for (int i = 0; i < N; ++i) views[i]->pose = guesses[i];
+
+        // The pairs are processed in parallel. Each projectivePointToPlane call runs sequentially inside.
+#pragma omp parallel for schedule(dynamic)
+        for (int k = 0; k < (int)candidates.size(); ++k)
+        {
+            auto [i, j] = candidates[k];
+            systems[k]  = projectivePointToPlane(*views[i], *views[j], params.correspondences);
+        }
+
+        std::vector<std::pair<int, int>> pairs;
+        std::vector<int> pairSystem;
+        for (int k = 0; k < (int)candidates.size(); ++k)
+        {
+            if (systems[k].correspondences < params.minCorrespondences) continue;
+            pairs.push_back(candidates[k]);
+            pairSystem.push_back(k);
+        }
+        usedPairs = pairs.size();
+        if (pairs.empty()) break;
+
+        auto change = structure.compute(N, pairs, S);
+        if (change == GraphStructure::Change::Appended)
+            solver.Init(true);
+        else if (change == GraphStructure::Change::Changed)
+            solver.Init();
+
+        // The residual of a pair only depends on the relative pose. With the update exp(x) * T the jacobian
+        // of the reference view is the negative jacobian of the source view.
+        for (int i = 0; i < N; ++i)
+        {
+            S.valuePtr()[S.outerIndexPtr()[i]].get().setZero();
+            b(i).get().setZero();
+        }
+        std::vector<bool> connected(N, false);
+        for (int e = 0; e < (int)pairs.size(); ++e)
+        {
+            auto [i, j]  = pairs[e];
+            auto& system = systems[pairSystem[e]];
+            Block H      = system.JtJ.selfadjointView<Eigen::Upper>();
+
+            S.valuePtr()[structure.edgeOffsets[e]].get() = -H;
+            S.valuePtr()[S.outerIndexPtr()[i]].get() += H;
+            S.valuePtr()[S.outerIndexPtr()[j]].get() += H;
+            b(i).get() -= system.Jtb;
+            b(j).get() += system.Jtb;
+            connected[i] = connected[j] = true;
+        }
+
+        // Constant views: identity diagonal block and no coupling -> zero update
+        // Note: Only the upper triangle is stored and the column of the first view contains only the diagonal.
+        for (int i = 0; i < N; ++i)
+        {
+            if ((params.fixFirst && i == 0) || !connected[i])
+            {
+                for (int k = S.outerIndexPtr()[i]; k < S.outerIndexPtr()[i + 1]; ++k)
+                {
+                    S.valuePtr()[k].get().setZero();
+                }
+                S.valuePtr()[S.outerIndexPtr()[i]].get().setIdentity();
+                b(i).get().setZero();
+            }
+        }
+        solver.solve(S, x, b, loptions);
+
+        for (int i = 0; i < N; ++i)
+        {
+            guesses[i] = SE3::exp(x(i).get()) * guesses[i];
+        }
+    }
+    return usedPairs;
+}
+
 }  // namespace ICP
 }  // namespace Saiga
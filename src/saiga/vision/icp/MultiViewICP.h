@@ -32,5 +32,40 @@ SAIGA_VISION_API void multiViewICPSimple(const std::vector<Depthmap::DepthMap>&
                                          ProjectiveCorrespondencesParams params = ProjectiveCorrespondencesParams());
 
 
+struct MultiViewICPParams
+{
+    ProjectiveCorrespondencesParams correspondences;
+    int iterations = 5;
+
+    // The depth maps are subsampled by this factor (see DepthMapExtended). Reduces the memory and the time for many
+    // views.
+    int downsampleFactor = 1;
+
+    // Two views are aligned to each other if the distance of the camera centers and the angle between the viewing
+    // directions (in radians) of the initial guess are smaller than these thresholds.
+    double maxCameraDistance = 1.0;
+    double maxViewAngle      = 0.8;
+
+    // Pairs with fewer projective correspondences are ignored in the current iteration.
+    int minCorrespondences = 100;
+
+    // The first pose is kept constant to fix the gauge freedom.
+    bool fixFirst = true;
+};
+
+/**
+ * Global multi-view point-to-plane ICP.
+ *
+ * In each iteration the projective correspondences of all overlapping view pairs are computed in parallel and
+ * directly reduced into a block-sparse normal equation (see projectivePointToPlane). All poses are then updated
+ * jointly with one Gauss-Newton step. The sparse system is solved with the recursive LDLT and the symbolic
+ * factorization is reused as long as the set of valid pairs does not change.
+ *
+ * Returns the number of view pairs used in the last iteration.
+ */
+SAIGA_VISION_API int multiViewICPGlobal(const std::vector<Depthmap::DepthMap>& depthMaps, AlignedVector<SE3>& guesses,
+                                        const Intrinsics4& camera,
+                                        const MultiViewICPParams& params = MultiViewICPParams());
+
 }  // namespace ICP
 }  // namespace Saiga
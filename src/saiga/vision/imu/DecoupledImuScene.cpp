@@ -7,6 +7,8 @@
 
 #include "saiga/vision/util/Random.h"
 
+#include <numeric>
+
 namespace Saiga::Imu
 {
 void DecoupledImuScene::MakeRandom(int N, int K, double dt)
@@ -95,11 +97,34 @@ void DecoupledImuScene::MakeRandom(int N, int K, double dt)
     //        e.data->AddNoise(0.1, 0.1);
 }
 
+void DecoupledImuScene::PreintAll()
+{
+    std::vector<int> edge_ids(edges.size());
+    std::iota(edge_ids.begin(), edge_ids.end(), 0);
+    PreintEdges(edge_ids);
+}
+
+void DecoupledImuScene::PreintEdges(const std::vector<int>& edge_ids)
+{
+    // The edges are independent of each other and only read the states.
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < (int)edge_ids.size(); ++k)
+    {
+        auto& e  = edges[edge_ids[k]];
+        auto& s1 = states[e.from];
+
+        *e.preint = Imu::Preintegration(s1.velocity_and_bias);
+        e.preint->IntegrateMidPoint(*e.data, true);
+    }
+}
+
 double DecoupledImuScene::chi2() const
 {
     double sum = 0;
-    for (auto& e : edges)
+#pragma omp parallel for reduction(+ : sum) schedule(dynamic)
+    for (int k = 0; k < (int)edges.size(); ++k)
     {
+        auto& e  = edges[k];
         auto& s1 = states[e.from];
         auto& s2 = states[e.to];
 
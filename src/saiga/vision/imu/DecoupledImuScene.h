@@ -57,9 +57,16 @@ class SAIGA_VISION_API DecoupledImuScene
         bool use_global_bias = false;
         int max_its          = 3;
 
+        // Small bias changes are applied to the preintegrated values with the first order approximation of the
+        // stored bias jacobians (see Preintegration::ImuError). Only if the change of a state exceeds this threshold
+        // its bias is updated and the outgoing edges are integrated again.
         double bias_recompute_delta_squared = 0.01;
 
         bool final_recompute = true;
+
+        // Use the block tridiagonal solver of DecoupledImuSolver if the states form a chain.
+        // Otherwise (or if this is false) the generic sparse LDLT is used.
+        bool block_tridiagonal = true;
     };
 
     Vec3 global_bias_gyro = Vec3::Zero();
@@ -91,16 +98,11 @@ class SAIGA_VISION_API DecoupledImuScene
     Vec3 WeightPVR() { return Vec3(weight_P, weight_V, weight_R); }
 
 
-    void PreintAll()
-    {
-        for (auto& e : edges)
-        {
-            auto& s1 = states[e.from];
+    // Integrates all edges in parallel with the current bias of the 'from' state as linearization point.
+    void PreintAll();
 
-            *e.preint = Imu::Preintegration(s1.velocity_and_bias);
-            e.preint->IntegrateMidPoint(*e.data, true);
-        }
-    }
+    // Same as above, but only for the given edges.
+    void PreintEdges(const std::vector<int>& edge_ids);
 
     void SanityCheck()
     {
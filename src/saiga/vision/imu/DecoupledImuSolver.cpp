@@ -114,20 +114,21 @@ void DecoupledImuSolver::init()
         if (!has_preint[i]) states_without_preint.push_back(i);
     }
 
-    solver.Init();
+    recomputed_preints = 0;
+
+    chain_structure = !scene.edges.empty();
+    for (auto& e : scene.edges)
+    {
+        if (e.to != e.from + 1) chain_structure = false;
+    }
+
+    if (!UseBlockTridiagonal()) solver.Init();
 }
 
-double DecoupledImuSolver::computeQuadraticForm()
+void DecoupledImuSolver::LinearizeEdge(int edge_id, EdgeBlocks& blocks)
 {
     auto& scene = *_scene;
 
-    b.setZero();
-
-    for (int i = 0; i < non_zeros; ++i)
-    {
-        S.valuePtr()[i].get().setZero();
-    }
-
     Matrix<double, 9, 3> _J_biasa, _J_biasg;
     Matrix<double, 9, 3> _J_v1, _J_v2;
     Matrix<double, 9, 1> _J_scale;
@@ -141,175 +142,215 @@ double DecoupledImuSolver::computeQuadraticForm()
 
     Matrix<double, 6, 6> J_a_g_i, J_a_g_j;
 
-    double chi2 = 0;
-    for (int edge_id = 0; edge_id < scene.edges.size(); ++edge_id)
-    {
-        auto& e = scene.edges[edge_id];
+    auto& e = scene.edges[edge_id];
 
-        int i = e.from;
-        int j = e.to;
+    int i = e.from;
+    int j = e.to;
 
-        auto& s1 = scene.states[i];
-        auto& s2 = scene.states[j];
+    auto& s1 = scene.states[i];
+    auto& s2 = scene.states[j];
 
 
-        Matrix<double, 9, 3>* J_biasa = (!s1.constant && (params.solver_flags & IMU_SOLVE_BA)) ? &_J_biasa : nullptr;
-        Matrix<double, 9, 3>* J_biasg = (!s1.constant && (params.solver_flags & IMU_SOLVE_BG)) ? &_J_biasg : nullptr;
-        Matrix<double, 9, 3>* J_v1    = (!s1.constant && (params.solver_flags & IMU_SOLVE_VELOCITY)) ? &_J_v1 : nullptr;
-        Matrix<double, 9, 3>* J_v2    = (!s2.constant && (params.solver_flags & IMU_SOLVE_VELOCITY)) ? &_J_v2 : nullptr;
+    Matrix<double, 9, 3>* J_biasa = (!s1.constant && (params.solver_flags & IMU_SOLVE_BA)) ? &_J_biasa : nullptr;
+    Matrix<double, 9, 3>* J_biasg = (!s1.constant && (params.solver_flags & IMU_SOLVE_BG)) ? &_J_biasg : nullptr;
+    Matrix<double, 9, 3>* J_v1    = (!s1.constant && (params.solver_flags & IMU_SOLVE_VELOCITY)) ? &_J_v1 : nullptr;
+    Matrix<double, 9, 3>* J_v2    = (!s2.constant && (params.solver_flags & IMU_SOLVE_VELOCITY)) ? &_J_v2 : nullptr;
 
 
-        auto& Vi = s1.velocity_and_bias.velocity;
-        auto& Vj = s2.velocity_and_bias.velocity;
-        auto& p1 = s1.pose;
-        auto& p2 = s2.pose;
+    auto& Vi = s1.velocity_and_bias.velocity;
+    auto& Vj = s2.velocity_and_bias.velocity;
+    auto& p1 = s1.pose;
+    auto& p2 = s2.pose;
 
 
-        Vec9 res = e.preint->ImuError(s1.delta_bias, Vi, p1, Vj, p2, scene.gravity, scene.scale,
-                                      scene.WeightPVR() * e.weight_pvr, J_biasa, J_biasg, J_v1, J_v2, nullptr, nullptr,
-                                      J_scale, J_g);
+    Vec9 res = e.preint->ImuError(s1.delta_bias, Vi, p1, Vj, p2, scene.gravity, scene.scale,
+                                  scene.WeightPVR() * e.weight_pvr, J_biasa, J_biasg, J_v1, J_v2, nullptr, nullptr,
+                                  J_scale, J_g);
 
 
-        Matrix<double, 9, 9> J1, J2;
-        J1.setZero();
-        J2.setZero();
+    Matrix<double, 9, 9> J1, J2;
+    J1.setZero();
+    J2.setZero();
 
 
 
-        if (J_biasa) J1.block<9, 3>(0, 0) = *J_biasa;
-        if (J_biasg) J1.block<9, 3>(0, 3) = *J_biasg;
+    if (J_biasa) J1.block<9, 3>(0, 0) = *J_biasa;
+    if (J_biasg) J1.block<9, 3>(0, 3) = *J_biasg;
 
-        if (J_v1) J1.block<9, 3>(0, 6) = *J_v1;
-        if (J_v2) J2.block<9, 3>(0, 6) = *J_v2;
+    if (J_v1) J1.block<9, 3>(0, 6) = *J_v1;
+    if (J_v2) J2.block<9, 3>(0, 6) = *J_v2;
 
-        int offset_i = i + 1;
-        int offset_j = j + 1;
+    auto& target_ii = blocks.ii;
+    auto& target_jj = blocks.jj;
+    auto& target_ij = blocks.ij;
+    auto& target_ir = blocks.ir;
+    auto& target_jr = blocks.jr;
 
-        SAIGA_ASSERT(offset_i < b.rows());
-        SAIGA_ASSERT(offset_j < b.rows());
+    target_ii = J1.transpose() * J1;
+    target_jj = J2.transpose() * J2;
+    target_ij = J1.transpose() * J2;
 
-        SAIGA_ASSERT(offset_i >= 0 && offset_i < S.outerSize());
-        SAIGA_ASSERT(offset_j >= 0 && offset_j < S.outerSize());
-        SAIGA_ASSERT(edgeOffsets[edge_id] >= 0 && edgeOffsets[edge_id] < S.nonZeros());
+    target_ir = -J1.transpose() * res;
+    target_jr = -J2.transpose() * res;
 
-        auto& target_ii = S.valuePtr()[S.outerIndexPtr()[offset_i]].get();
-        auto& target_jj = S.valuePtr()[S.outerIndexPtr()[offset_j]].get();
-        auto& target_ij = S.valuePtr()[edgeOffsets[edge_id]].get();
-        auto& target_ir = b(offset_i).get();
-        auto& target_jr = b(offset_j).get();
+    // The gravity and scale rows of S(0,0), S(0,i), S(0,j) and b(0)
+    blocks.gg.setZero();
+    blocks.gi.setZero();
+    blocks.gj.setZero();
+    blocks.gr.setZero();
 
+    if (J_g)
+    {
+        auto target_gg = blocks.gg.block<3, 3>(0, 0);
+        target_gg += (*J_g).transpose() * (*J_g);
 
-        target_ii += J1.transpose() * J1;
-        target_jj += J2.transpose() * J2;
-        target_ij += J1.transpose() * J2;
+        auto target_gr = blocks.gr.segment<3>(0);
+        target_gr -= (*J_g).transpose() * (res);
+        if (J_scale)
+        {
+            auto target_gs = blocks.gg.block<3, 1>(0, 3);
+            target_gs += (*J_g).transpose() * (*J_scale);
+        }
 
-        target_ir -= J1.transpose() * res;
-        target_jr -= J2.transpose() * res;
+        if (J_biasa)
+        {
+            auto target_gba = blocks.gi.block<3, 3>(0, 0);
+            target_gba += (*J_g).transpose() * (*J_biasa);
+        }
+        if (J_biasg)
+        {
+            auto target_gbg = blocks.gi.block<3, 3>(0, 3);
+            target_gbg += (*J_g).transpose() * (*J_biasg);
+        }
 
+        if (J_v1)
+        {
+            auto target_gv1 = blocks.gi.block<3, 3>(0, 6);
+            target_gv1 += (*J_g).transpose() * (*J_v1);
+        }
 
-        if (J_g)
+        if (J_v2)
         {
-            auto target_gg = S.valuePtr()[0].get().block<3, 3>(0, 0);
-            target_gg += (*J_g).transpose() * (*J_g);
-
-            auto target_gr = b(0).get().segment<3>(0, 0);
-            target_gr -= (*J_g).transpose() * (res);
-            if (J_scale)
-            {
-                auto target_gs = S.valuePtr()[0].get().block<3, 1>(0, 3);
-                target_gs += (*J_g).transpose() * (*J_scale);
-            }
-
-            if (J_biasa)
-            {
-                auto target_gba = S.valuePtr()[offset_i].get().block<3, 3>(0, 0);
-                target_gba += (*J_g).transpose() * (*J_biasa);
-            }
-            if (J_biasg)
-            {
-                auto target_gbg = S.valuePtr()[offset_i].get().block<3, 3>(0, 3);
-                target_gbg += (*J_g).transpose() * (*J_biasg);
-            }
-
-            if (J_v1)
-            {
-                auto target_gv1 = S.valuePtr()[offset_i].get().block<3, 3>(0, 6);
-                target_gv1 += (*J_g).transpose() * (*J_v1);
-            }
-
-            if (J_v2)
-            {
-                auto target_gv2 = S.valuePtr()[offset_j].get().block<3, 3>(0, 6);
-                target_gv2 += (*J_g).transpose() * (*J_v2);
-            }
+            auto target_gv2 = blocks.gj.block<3, 3>(0, 6);
+            target_gv2 += (*J_g).transpose() * (*J_v2);
         }
-        if (J_scale)
+    }
+    if (J_scale)
+    {
+        auto target_ss = blocks.gg.block<1, 1>(3, 3);
+        target_ss += (*J_scale).transpose() * (*J_scale);
+
+        auto target_sr = blocks.gr.segment<1>(3);
+        target_sr -= (*J_scale).transpose() * (res);
+
+        if (J_biasa)
+        {
+            auto target_sba = blocks.gi.block<1, 3>(3, 0);
+            target_sba += (*J_scale).transpose() * (*J_biasa);
+        }
+        if (J_biasg)
         {
-            auto target_ss = S.valuePtr()[0].get().block<1, 1>(3, 3);
-            target_ss += (*J_scale).transpose() * (*J_scale);
-
-            auto target_sr = b(0).get().segment<1>(3);
-            target_sr -= (*J_scale).transpose() * (res);
-
-            if (J_biasa)
-            {
-                auto target_sba = S.valuePtr()[offset_i].get().block<1, 3>(3, 0);
-                target_sba += (*J_scale).transpose() * (*J_biasa);
-            }
-            if (J_biasg)
-            {
-                auto target_sbg = S.valuePtr()[offset_i].get().block<1, 3>(3, 3);
-                target_sbg += (*J_scale).transpose() * (*J_biasg);
-            }
-
-            if (J_v1)
-            {
-                auto target_sv1 = S.valuePtr()[offset_i].get().block<1, 3>(3, 6);
-                target_sv1 += (*J_scale).transpose() * (*J_v1);
-            }
-
-            if (J_v2)
-            {
-                auto target_sv2 = S.valuePtr()[offset_j].get().block<1, 3>(3, 6);
-                target_sv2 += (*J_scale).transpose() * (*J_v2);
-            }
+            auto target_sbg = blocks.gi.block<1, 3>(3, 3);
+            target_sbg += (*J_scale).transpose() * (*J_biasg);
         }
 
-        double r = res.squaredNorm();
-        SAIGA_ASSERT(std::isfinite(r));
+        if (J_v1)
+        {
+            auto target_sv1 = blocks.gi.block<1, 3>(3, 6);
+            target_sv1 += (*J_scale).transpose() * (*J_v1);
+        }
 
-        if ((params.solver_flags & IMU_SOLVE_BA) || (params.solver_flags & IMU_SOLVE_BG))
+        if (J_v2)
         {
-            Vec6 res_bias_change = e.preint->BiasChangeError(
-                s1.velocity_and_bias, s1.delta_bias, s2.velocity_and_bias, s2.delta_bias,
-                scene.weight_change_a * e.weight_bias(0), scene.weight_change_g * e.weight_bias(1), &J_a_g_i, &J_a_g_j);
-
-
-            if (!s1.constant)
-            {
-                target_ii.block<6, 6>(0, 0) += J_a_g_i.transpose() * J_a_g_i;
-                target_ir.segment<6>(0) -= J_a_g_i.transpose() * res_bias_change;
-            }
-            if (!s2.constant)
-            {
-                target_jj.block<6, 6>(0, 0) += J_a_g_j.transpose() * J_a_g_j;
-                target_jr.segment<6>(0) -= J_a_g_j.transpose() * res_bias_change;
-            }
-            if (!s1.constant && !s2.constant)
-            {
-                target_ij.block<6, 6>(0, 0) += J_a_g_i.transpose() * J_a_g_j;
-            }
+            auto target_sv2 = blocks.gj.block<1, 3>(3, 6);
+            target_sv2 += (*J_scale).transpose() * (*J_v2);
+        }
+    }
 
+    double r = res.squaredNorm();
+    SAIGA_ASSERT(std::isfinite(r));
 
-            r += res_bias_change.squaredNorm();
-            SAIGA_ASSERT(std::isfinite(r));
+    if ((params.solver_flags & IMU_SOLVE_BA) || (params.solver_flags & IMU_SOLVE_BG))
+    {
+        Vec6 res_bias_change = e.preint->BiasChangeError(
+            s1.velocity_and_bias, s1.delta_bias, s2.velocity_and_bias, s2.delta_bias,
+            scene.weight_change_a * e.weight_bias(0), scene.weight_change_g * e.weight_bias(1), &J_a_g_i, &J_a_g_j);
+
+
+        if (!s1.constant)
+        {
+            target_ii.block<6, 6>(0, 0) += J_a_g_i.transpose() * J_a_g_i;
+            target_ir.segment<6>(0) -= J_a_g_i.transpose() * res_bias_change;
+        }
+        if (!s2.constant)
+        {
+            target_jj.block<6, 6>(0, 0) += J_a_g_j.transpose() * J_a_g_j;
+            target_jr.segment<6>(0) -= J_a_g_j.transpose() * res_bias_change;
+        }
+        if (!s1.constant && !s2.constant)
+        {
+            target_ij.block<6, 6>(0, 0) += J_a_g_i.transpose() * J_a_g_j;
         }
 
 
+        r += res_bias_change.squaredNorm();
+        SAIGA_ASSERT(std::isfinite(r));
+    }
+
+    blocks.chi2 = r;
+}
+
+double DecoupledImuSolver::computeQuadraticForm()
+{
+    auto& scene = *_scene;
 
-        chi2 += r;
+    b.setZero();
+
+    for (int i = 0; i < non_zeros; ++i)
+    {
+        S.valuePtr()[i].get().setZero();
     }
 
+    // The edges are linearized in parallel into their own blocks. The blocks are then added to S in the order of the
+    // edges, therefore the result does not depend on the number of threads.
+    edge_blocks.resize(scene.edges.size());
+#pragma omp parallel for schedule(static)
+    for (int edge_id = 0; edge_id < (int)scene.edges.size(); ++edge_id)
+    {
+        LinearizeEdge(edge_id, edge_blocks[edge_id]);
+    }
+
+    double chi2 = 0;
+    for (int edge_id = 0; edge_id < scene.edges.size(); ++edge_id)
+    {
+        auto& e      = scene.edges[edge_id];
+        auto& blocks = edge_blocks[edge_id];
+
+        int offset_i = e.from + 1;
+        int offset_j = e.to + 1;
+
+        SAIGA_ASSERT(offset_i < b.rows());
+        SAIGA_ASSERT(offset_j < b.rows());
+        SAIGA_ASSERT(edgeOffsets[edge_id] >= 0 && edgeOffsets[edge_id] < S.nonZeros());
+
+        S.valuePtr()[S.outerIndexPtr()[offset_i]].get() += blocks.ii;
+        S.valuePtr()[S.outerIndexPtr()[offset_j]].get() += blocks.jj;
+        S.valuePtr()[edgeOffsets[edge_id]].get() += blocks.ij;
+        b(offset_i).get() += blocks.ir;
+        b(offset_j).get() += blocks.jr;
+
+        S.valuePtr()[0].get().block<4, 4>(0, 0) += blocks.gg;
+        S.valuePtr()[offset_i].get().block<4, 9>(0, 0) += blocks.gi;
+        S.valuePtr()[offset_j].get().block<4, 9>(0, 0) += blocks.gj;
+        b(0).get().segment<4>(0) += blocks.gr;
+
+        chi2 += blocks.chi2;
+    }
+
+    // Only the upper triangle of the gravity-scale coupling was added above
+    PGOBlock G            = S.valuePtr()[0].get().selfadjointView<Eigen::Upper>();
+    S.valuePtr()[0].get() = G;
+
 
 #if 0
     auto JtJ = expand(S);
@@ -352,36 +393,43 @@ void DecoupledImuSolver::addLambda(double lambda)
 void DecoupledImuSolver::RecomputePreint(bool always)
 {
     //    SAIGA_BLOCK_TIMER();
-    int rec     = 0;
     auto& scene = *_scene;
-    for (int i = 0; i < scene.edges.size(); ++i)
-    {
-        auto& e = scene.edges[i];
-        auto& s = scene.states[e.from];
 
+    // Move the bias delta of a state into its linearization point. This is done for all states if the delta is too
+    // large for the first order approximation. States without outgoing edge can always be updated.
+    std::vector<bool> rebased(scene.states.size(), false);
+    for (int i = 0; i < scene.states.size(); ++i)
+    {
+        auto& s = scene.states[i];
         if (always || s.delta_bias.acc_bias.squaredNorm() > params.bias_recompute_delta_squared ||
             s.delta_bias.gyro_bias.squaredNorm() > params.bias_recompute_delta_squared)
         {
-            s.velocity_and_bias.acc_bias += s.delta_bias.acc_bias;
-            s.velocity_and_bias.gyro_bias += s.delta_bias.gyro_bias;
-            s.delta_bias = VelocityAndBias();
-
-            *e.preint = Imu::Preintegration(s.velocity_and_bias);
-            e.preint->IntegrateMidPoint(*e.data, true);
-            rec++;
+            rebased[i] = true;
         }
     }
-
-
     for (auto is : states_without_preint)
     {
-        auto& s = scene.states[is];
+        rebased[is] = true;
+    }
 
+    for (int i = 0; i < scene.states.size(); ++i)
+    {
+        if (!rebased[i]) continue;
+        auto& s = scene.states[i];
         s.velocity_and_bias.acc_bias += s.delta_bias.acc_bias;
         s.velocity_and_bias.gyro_bias += s.delta_bias.gyro_bias;
         s.delta_bias = VelocityAndBias();
     }
-    //    std::cout << "Recomputed " << rec << " / " << scene.edges.size() << std::endl;
+
+    // All edges starting at a rebased state are integrated again (in parallel).
+    std::vector<int> edge_ids;
+    for (int i = 0; i < scene.edges.size(); ++i)
+    {
+        if (rebased[scene.edges[i].from]) edge_ids.push_back(i);
+    }
+    scene.PreintEdges(edge_ids);
+    recomputed_preints += edge_ids.size();
+    //    std::cout << "Recomputed " << edge_ids.size() << " / " << scene.edges.size() << std::endl;
 }
 
 
@@ -457,16 +505,98 @@ void DecoupledImuSolver::solveLinearSystem()
                               : LinearSolverOptions::SolverType::Iterative;
     loptions.cholmod = true;
 
+    if (UseBlockTridiagonal())
+    {
+        SolveBlockTridiagonal();
+    }
+    else
+    {
+        solver.solve(S, x, b, loptions);
+    }
+}
 
-    solver.solve(S, x, b, loptions);
+bool DecoupledImuSolver::UseBlockTridiagonal() const
+{
+    return chain_structure && params.block_tridiagonal &&
+           optimizationOptions.solverType == OptimizationOptions::SolverType::Direct;
 }
 
-double DecoupledImuSolver::computeCost()
+void DecoupledImuSolver::SolveBlockTridiagonal()
 {
     auto& scene = *_scene;
 
-    double chi2 = 0;
+    // State k has the row/column k+1 in S.
+    //
+    //     | G   C^T |          T = tridiag(U_{k-1}^T, D_k, U_k)
+    // S = |         |          C_k = S(0,k+1)^T
+    //     | C   T   |
+    //
+    // With the block LDLT of T (P = diagonal blocks, W_k = P_{k-1}^-1 U_{k-1}) we solve
+    // T Y = [b_s, C] and reduce the system to the Schur complement of G. Only the first 4 global parameters (gravity
+    // and scale) are coupled to the states, therefore C has only 4 columns.
+    tri_P.resize(N);
+    tri_W.resize(N);
+    tri_Y.resize(N);
+
+    for (auto& W : tri_W) W.setZero();
     for (int edge_id = 0; edge_id < scene.edges.size(); ++edge_id)
+    {
+        tri_W[scene.edges[edge_id].to] += S.valuePtr()[edgeOffsets[edge_id]].get();
+    }
+
+    // Factorization and forward substitution
+    for (int k = 0; k < N; ++k)
+    {
+        PGOBlock D       = S.valuePtr()[S.outerIndexPtr()[k + 1]].get();
+        auto& Y          = tri_Y[k];
+        Y.col(0)         = b(k + 1).get();
+        Y.rightCols<4>() = S.valuePtr()[k + 1].get().topRows<4>().transpose();
+
+        if (k > 0)
+        {
+            PGOBlock U = tri_W[k];
+            tri_W[k].noalias() = tri_P[k - 1] * U;
+            D.noalias() -= U.transpose() * tri_W[k];
+            Y.noalias() -= tri_W[k].transpose() * tri_Y[k - 1];
+        }
+        tri_P[k] = D.llt().solve(PGOBlock::Identity());
+    }
+
+    // Backward substitution
+    for (int k = N - 1; k >= 0; --k)
+    {
+        tri_Y[k] = tri_P[k] * tri_Y[k];
+        if (k < N - 1) tri_Y[k].noalias() -= tri_W[k + 1] * tri_Y[k + 1];
+    }
+
+    // Schur complement of the global parameters
+    Eigen::Matrix<double, 4, 4> G = S.valuePtr()[0].get().topLeftCorner<4, 4>();
+    Eigen::Matrix<double, 4, 1> g = b(0).get().head<4>();
+    for (int k = 0; k < N; ++k)
+    {
+        auto C_k = S.valuePtr()[k + 1].get().topRows<4>();
+        G.noalias() -= C_k * tri_Y[k].rightCols<4>();
+        g.noalias() -= C_k * tri_Y[k].col(0);
+    }
+    Eigen::Matrix<double, 4, 1> x_g = G.ldlt().solve(g);
+
+    // The unused global parameters only have a diagonal entry
+    x(0).get().head<4>() = x_g;
+    x(0).get().tail<5>() = b(0).get().tail<5>().cwiseQuotient(S.valuePtr()[0].get().diagonal().tail<5>());
+    for (int k = 0; k < N; ++k)
+    {
+        x(k + 1).get() = tri_Y[k].col(0) - tri_Y[k].rightCols<4>() * x_g;
+    }
+}
+
+double DecoupledImuSolver::computeCost()
+{
+    auto& scene = *_scene;
+
+    // Summed in the order of the edges (see computeQuadraticForm)
+    edge_costs.resize(scene.edges.size());
+#pragma omp parallel for schedule(static)
+    for (int edge_id = 0; edge_id < (int)scene.edges.size(); ++edge_id)
     {
         auto& e = scene.edges[edge_id];
 
@@ -497,8 +627,11 @@ double DecoupledImuSolver::computeCost()
             r += res_bias_change.squaredNorm();
         }
         SAIGA_ASSERT(std::isfinite(r));
-        chi2 += r;
+        edge_costs[edge_id] = r;
     }
+
+    double chi2 = 0;
+    for (auto r : edge_costs) chi2 += r;
     return chi2;
 }
 
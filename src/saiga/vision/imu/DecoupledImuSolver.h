@@ -22,6 +22,10 @@ class SAIGA_VISION_API DecoupledImuSolver : public LMOptimizer
         this->params = params;
     }
 
+    // Number of edges that were integrated again during the last solve.
+    // See DecoupledImuScene::SolverOptions::bias_recompute_delta_squared.
+    int RecomputedPreints() const { return recomputed_preints; }
+
    private:
     // ======== Constants ========
     static const int params_per_state = 9;
@@ -34,6 +38,7 @@ class SAIGA_VISION_API DecoupledImuSolver : public LMOptimizer
     int num_params;
     int non_zeros;
     std::vector<int> edgeOffsets;
+    int recomputed_preints = 0;
     DecoupledImuScene* _scene;
     DecoupledImuScene::SolverOptions params;
 
@@ -50,6 +55,34 @@ class SAIGA_VISION_API DecoupledImuSolver : public LMOptimizer
     PBType b;
     PGOSolver solver;
 
+    // The contribution of a single edge to S and b
+    struct EdgeBlocks
+    {
+        PGOBlock ii, jj, ij;
+        PGOVector ir, jr;
+
+        // Gravity (3) and scale (1) rows of the global blocks
+        Eigen::Matrix<double, 4, 4> gg;
+        Eigen::Matrix<double, 4, 9> gi, gj;
+        Eigen::Matrix<double, 4, 1> gr;
+        double chi2;
+    };
+    AlignedVector<EdgeBlocks> edge_blocks;
+    std::vector<double> edge_costs;
+
+    void LinearizeEdge(int edge_id, EdgeBlocks& blocks);
+
+    // If all edges connect consecutive states, S is a block tridiagonal matrix with one additional dense row and
+    // column for the global parameters. This system is solved directly with a block LDLT of the tridiagonal part and
+    // the Schur complement of the global block.
+    bool chain_structure = false;
+    AlignedVector<PGOBlock> tri_P;  // inverse of the diagonal blocks
+    AlignedVector<PGOBlock> tri_W;
+    AlignedVector<Eigen::Matrix<double, params_per_state, 5>> tri_Y;
+
+    bool UseBlockTridiagonal() const;
+    void SolveBlockTridiagonal();
+
     //    Eigen::Matrix<double, -1, 1> x;
     PBType x;
 
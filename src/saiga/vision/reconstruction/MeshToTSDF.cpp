@@ -8,6 +8,7 @@
 #include "saiga/core/geometry/all.h"
 #include "saiga/core/geometry/kdtree.h"
 #include "saiga/core/imgui/imgui.h"
+#include "saiga/core/util/Thread/omp.h"
 #include "saiga/core/util/discreteProbabilityDistribution.h"
 #include "saiga/vision/util/Random.h"
 
@@ -15,6 +16,7 @@
 #include "fstream"
 
 #include <algorithm>
+#include <array>
 namespace Saiga
 {
 std::vector<vec3> MeshToPointCloud(const std::vector<Triangle>& _triangles, int N)
@@ -169,143 +171,179 @@ float Distance(const std::vector<Triangle>& triangles, const vec3& p)
 }
 
 
-std::shared_ptr<SparseTSDF> MeshToTSDF(const std::vector<Triangle>& triangles, float voxel_size, int r)
+MeshSignedDistance::MeshSignedDistance(const std::vector<Triangle>& triangles)
+    : triangles(triangles), normals(triangles.size()), bvh(triangles)
 {
-    std::shared_ptr<SparseTSDF> tsdf = std::make_shared<SparseTSDF>(voxel_size);
+    int n = triangles.size();
 
+    // Merge vertices with the same position
+    std::vector<std::pair<std::array<float, 3>, int>> corners(n * 3);
+    for (int i = 0; i < n; ++i)
     {
-        auto points = MeshToPointCloud(triangles, 1000000);
-        ProgressBar bar(std::cout, "M2TSDF Allocate V", triangles.size());
-        for (auto& t : triangles)
+        const vec3* v[3] = {&triangles[i].a, &triangles[i].b, &triangles[i].c};
+        for (int j = 0; j < 3; ++j)
         {
-            tsdf->AllocateAroundPoint(t.a, 1);
-            tsdf->AllocateAroundPoint(t.b, 1);
-            tsdf->AllocateAroundPoint(t.c, 1);
-            bar.addProgress(1);
+            corners[i * 3 + j] = {{v[j]->x(), v[j]->y(), v[j]->z()}, i * 3 + j};
         }
-        ProgressBar bar2(std::cout, "M2TSDF Allocate P1", points.size());
-        for (auto& p : points)
+    }
+    std::sort(corners.begin(), corners.end());
+    std::vector<int> vertex_id(n * 3);
+    int num_vertices = 0;
+    for (int i = 0; i < n * 3; ++i)
+    {
+        if (i > 0 && corners[i].first != corners[i - 1].first) num_vertices++;
+        vertex_id[corners[i].second] = num_vertices;
+    }
+    num_vertices++;
+
+    // Angle weighted vertex normals and edge normals (sum of the two adjacent faces)
+    std::vector<vec3> vertex_normals(num_vertices, vec3(0, 0, 0));
+    std::vector<std::pair<uint64_t, int>> edges(n * 3);
+    for (int i = 0; i < n; ++i)
+    {
+        auto& t         = triangles[i];
+        vec3 c          = cross(t.b - t.a, t.c - t.a);
+        float l         = c.norm();
+        vec3 fn         = l > 0 ? vec3(c / l) : vec3(0, 0, 0);
+        normals[i].face = fn;
+        for (int j = 0; j < 3; ++j)
         {
-            tsdf->AllocateAroundPoint(p, 1);
-            bar2.addProgress(1);
+            float angle = l > 0 ? t.angleAtCorner(j) : 0;
+            vertex_normals[vertex_id[i * 3 + j]] += angle * fn;
+
+            // edge j is opposite of corner j
+            uint64_t v0      = vertex_id[i * 3 + (j + 1) % 3];
+            uint64_t v1      = vertex_id[i * 3 + (j + 2) % 3];
+            edges[i * 3 + j] = {(std::min(v0, v1) << 32) | std::max(v0, v1), i * 3 + j};
         }
     }
-
+    std::sort(edges.begin(), edges.end());
+    for (int i = 0; i < n * 3;)
     {
-        for (int i = 0; i < r - 1; ++i)
+        int j   = i;
+        vec3 en = vec3(0, 0, 0);
+        for (; j < n * 3 && edges[j].first == edges[i].first; ++j)
         {
-            std::vector<ivec3> current_blocks;
-            for (auto bi = 0; bi < tsdf->current_blocks; ++bi)
-            {
-                current_blocks.push_back(tsdf->blocks[bi].index);
-            }
-            ProgressBar bar(std::cout, "M2TSDF Expand", current_blocks.size());
+            en += normals[edges[j].second / 3].face;
+        }
+        for (; i < j; ++i)
+        {
+            normals[edges[i].second / 3].edge[edges[i].second % 3] = en;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            normals[i].vertex[j] = vertex_normals[vertex_id[i * 3 + j]];
+        }
+    }
+}
 
-            for (auto block_id : current_blocks)
+float MeshSignedDistance::Distance(const vec3& p, int& hint) const
+{
+    auto [dis, id] = bvh.ClosestPoint(p, hint);
+    hint           = id;
+    if (id < 0) return dis;
+
+    vec3 bc;
+    vec3 q = triangles[id].ClosestPoint(p, bc);
+
+    // The feature of the closest point
+    auto& n  = normals[id];
+    int zero = (bc.x() == 0) + (bc.y() == 0) + (bc.z() == 0);
+    vec3 normal;
+    if (zero == 0)
+    {
+        normal = n.face;
+    }
+    else if (zero == 1)
+    {
+        normal = n.edge[bc.x() == 0 ? 0 : (bc.y() == 0 ? 1 : 2)];
+    }
+    else
+    {
+        normal = n.vertex[bc.x() != 0 ? 0 : (bc.y() != 0 ? 1 : 2)];
+    }
+    return dot(p - q, normal) < 0 ? -dis : dis;
+}
+
+std::shared_ptr<SparseTSDF> MeshToTSDF(const std::vector<Triangle>& triangles, float voxel_size, int r)
+{
+    std::shared_ptr<SparseTSDF> tsdf = std::make_shared<SparseTSDF>(voxel_size);
+
+    {
+        // Blocks intersecting the surface. The triangles are sampled with a spacing of at most one block.
+        float block_size = voxel_size * tsdf->VOXEL_BLOCK_SIZE;
+        std::vector<std::vector<ivec3>> thread_blocks(OMP::getMaxThreads());
+#pragma omp parallel for schedule(dynamic, 256)
+        for (int i = 0; i < (int)triangles.size(); ++i)
+        {
+            auto& t          = triangles[i];
+            auto& local      = thread_blocks[OMP::getThreadNum()];
+            vec3 ab          = t.b - t.a;
+            vec3 ac          = t.c - t.a;
+            float max_length = std::max({ab.norm(), ac.norm(), (t.c - t.b).norm()});
+            int steps        = std::ceil(max_length / block_size);
+            for (int x = 0; x <= steps; ++x)
             {
-                for (int z = -1; z <= 1; ++z)
+                for (int y = 0; x + y <= steps; ++y)
                 {
-                    for (int y = -1; y <= 1; ++y)
-                    {
-                        for (int x = -1; x <= 1; ++x)
-                        {
-                            ivec3 current_id = ivec3(x, y, z) + block_id;
-                            tsdf->InsertBlock(current_id);
-                        }
-                    }
+                    float u = steps == 0 ? 0 : float(x) / steps;
+                    float v = steps == 0 ? 0 : float(y) / steps;
+                    local.push_back(tsdf->GetBlockIndex(vec3(t.a + u * ab + v * ac)));
                 }
-                bar.addProgress(1);
             }
         }
-        std::cout << "Allocated blocks = " << tsdf->current_blocks << std::endl;
-    }
-
-
 
-    AccelerationStructure::ObjectMedianBVH bvh(triangles);
-    bvh.triangle_epsilon = 0;
-    {
-        ProgressBar bar(std::cout, "M2TSDF Compute Unsigned Distance", tsdf->current_blocks);
-#pragma omp parallel for schedule(dynamic)
-        for (int i = 0; i < tsdf->current_blocks; ++i)
+        std::vector<ivec3> surface_blocks;
+        for (auto& local : thread_blocks)
         {
-            auto& b = tsdf->blocks[i];
-            for (int i = 0; i < tsdf->VOXEL_BLOCK_SIZE; ++i)
+            surface_blocks.insert(surface_blocks.end(), local.begin(), local.end());
+            local = {};
+        }
+        auto less = [](const ivec3& a, const ivec3& b) {
+            return std::tie(a.x(), a.y(), a.z()) < std::tie(b.x(), b.y(), b.z());
+        };
+        std::sort(surface_blocks.begin(), surface_blocks.end(), less);
+        surface_blocks.erase(std::unique(surface_blocks.begin(), surface_blocks.end()), surface_blocks.end());
+
+        ProgressBar bar(std::cout, "M2TSDF Allocate", surface_blocks.size());
+        for (auto& block_id : surface_blocks)
+        {
+            for (int z = -r; z <= r; ++z)
             {
-                for (int j = 0; j < tsdf->VOXEL_BLOCK_SIZE; ++j)
+                for (int y = -r; y <= r; ++y)
                 {
-                    for (int k = 0; k < tsdf->VOXEL_BLOCK_SIZE; ++k)
+                    for (int x = -r; x <= r; ++x)
                     {
-                        vec3 global_pos = tsdf->GlobalPosition(b.index, i, j, k);
-
-                        //                        float dis  = Distance(triangles, global_pos);
-                        float dis = bvh.ClosestPoint(global_pos).first;
-
-                        // SAIGA_ASSERT(dis == dis2);
-                        //                        if (dis != dis2)
-                        //                        {
-                        //                            std::cout << ":o " << dis << " " << dis2 << std::endl;
-                        //                        }
-
-                        b.data[i][j][k].distance = -dis;
-                        b.data[i][j][k].weight   = 1;
+                        tsdf->InsertBlock(ivec3(x, y, z) + block_id);
                     }
                 }
             }
             bar.addProgress(1);
         }
+        std::cout << "Allocated blocks = " << tsdf->current_blocks << std::endl;
     }
 
-
-    //    auto triangles_cpy = triangles;
-    //    for (auto& t : triangles_cpy)
-    //    {
-    //        t.ScaleUniform(1.000125);
-    //    }
-
-
-
+    MeshSignedDistance sdf(triangles);
     {
-        std::vector<Vec3> directions = {Vec3(1, 0, 0),  Vec3(0, 1, 0),  Vec3(0, 0, 1),
-                                        Vec3(-1, 0, 0), Vec3(0, -1, 0), Vec3(0, 0, -1)};
-
-        for (int i = 0; i < 100; ++i)
-        {
-            Vec3 d   = Random::MatrixUniform<Vec3>(-1, 1);
-            double l = d.norm();
-
-            if (l > 0.01)
-            {
-                directions.push_back(d / l);
-            }
-        }
-
-        ProgressBar bar(std::cout, "M2TSDF Compute Sign", tsdf->current_blocks);
+        ProgressBar bar(std::cout, "M2TSDF Compute Distance", tsdf->current_blocks);
 #pragma omp parallel for schedule(dynamic)
-        for (int i = 0; i < tsdf->current_blocks; ++i)
+        for (int bi = 0; bi < tsdf->current_blocks; ++bi)
         {
-            auto& b = tsdf->blocks[i];
-            auto id = b.index;
+            auto& b = tsdf->blocks[bi];
+            // Neighbouring voxels usually have the same closest triangle
+            int hint = -1;
             for (int i = 0; i < tsdf->VOXEL_BLOCK_SIZE; ++i)
             {
                 for (int j = 0; j < tsdf->VOXEL_BLOCK_SIZE; ++j)
                 {
                     for (int k = 0; k < tsdf->VOXEL_BLOCK_SIZE; ++k)
                     {
-                        Vec3 global_pos = tsdf->GlobalPosition(id, i, j, k).cast<double>();
-                        auto& cell      = b.data[i][j][k];
-
-                        for (auto& d : directions)
-                        {
-                            Ray r;
-                            r.direction = d.cast<float>();
-                            r.origin    = global_pos.cast<float>();
-                            if (bvh.getAll(r).empty())
-                            {
-                                cell.distance = std::abs(cell.distance);
-                                break;
-                            }
-                        }
+                        vec3 global_pos          = tsdf->GlobalPosition(b.index, i, j, k);
+                        b.data[i][j][k].distance = sdf.Distance(global_pos, hint);
+                        b.data[i][j][k].weight   = 1;
                     }
                 }
             }
@@ -313,7 +351,6 @@ std::shared_ptr<SparseTSDF> MeshToTSDF(const std::vector<Triangle>& triangles, f
         }
     }
 
-
     return tsdf;
 }
 
@@ -23,10 +23,47 @@ SAIGA_VISION_API std::vector<vec3> MeshToPointCloudPoissonDisc(const std::vector
 SAIGA_VISION_API std::vector<vec3> MeshToPointCloudPoissonDisc2(const std::vector<Triangle>& triangles, int max_samples, float radius);
 
 
+// Brute force unsigned distance. Only useful as a reference for small meshes.
 SAIGA_VISION_API float Distance(const std::vector<Triangle>& triangles, const vec3& p);
 
-// Convert a list of triangles to a block-sparse TSDF
-// This method is slow, because it computes the point-surface distances analytically.
+/**
+ * Signed distance to a closed triangle mesh.
+ *
+ * The closest triangle is found with a BVH4. The sign is computed with the angle weighted pseudo normal of the
+ * closest feature (face, edge or vertex) [Baerentzen and Aanaes 2005]. Vertices with the same position are merged, so
+ * a triangle soup of a closed mesh works as well. The distance is positive outside, i.e. on the side of the
+ * counter-clockwise face normals.
+ */
+class SAIGA_VISION_API MeshSignedDistance
+{
+   public:
+    MeshSignedDistance(const std::vector<Triangle>& triangles);
+
+    // 'hint' is the closest triangle of a nearby point, or -1. It is set to the closest triangle of p.
+    float Distance(const vec3& p, int& hint) const;
+    float Distance(const vec3& p) const
+    {
+        int hint = -1;
+        return Distance(p, hint);
+    }
+
+   private:
+    // The pseudo normals of the 7 features of a triangle
+    struct PseudoNormals
+    {
+        vec3 face;
+        vec3 vertex[3];
+        // edge i is opposite of vertex i
+        vec3 edge[3];
+    };
+    std::vector<Triangle> triangles;
+    std::vector<PseudoNormals> normals;
+    AccelerationStructure::BVH4 bvh;
+};
+
+// Convert a list of triangles to a block-sparse TSDF.
+// All blocks within r blocks of the surface are allocated. The voxels store the signed distance of MeshSignedDistance.
+// The voxels of a block are processed in order, so the closest triangle of the previous voxel is a good initial guess.
 SAIGA_VISION_API std::shared_ptr<SparseTSDF> MeshToTSDF(const std::vector<Triangle>& triangles, float voxel_size,
                                                         int r);
 }  // namespace Saiga
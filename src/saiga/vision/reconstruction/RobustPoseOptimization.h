@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "saiga/core/util/DataStructures/ArrayView.h"
 #include "saiga/core/util/Range.h"
 #include "saiga/core/util/Thread/omp.h"
 #include "saiga/vision/VisionTypes.h"
@@ -14,6 +15,7 @@
 
 #include "PoseOptimizationScene.h"
 
+#include <limits>
 #include <vector>
 
 namespace Saiga
@@ -92,6 +94,39 @@ struct SAIGA_ALIGN_CACHE RobustPoseOptimization
         chi2Stereo       = chi1Stereo * chi1Stereo;
     }
 
+    struct SAIGA_ALIGN_CACHE ThreadLocalData
+    {
+        JType JtJ;
+        BType Jtb;
+        T chi2;
+        int inliers;
+    };
+
+    /**
+     * Temporary data of optimizePoseRobust.
+     * The observations are copied into a structure of arrays, which is evaluated with SIMD instructions. The memory is
+     * only allocated if a problem is larger than all previous problems solved with this workspace.
+     */
+    struct Workspace
+    {
+        // World points, image points, right image point (stereo), weight, stereo mask (0 or 1)
+        std::vector<T> wx, wy, wz, u, v, ur, w, stereo;
+
+        AlignedVector<ThreadLocalData, SAIGA_CACHE_LINE_SIZE> locals;
+
+        // Shared state of the threads
+        SE3Type lastGuess;
+        T lastChi2sum;
+        T deltaChi;
+        int inliers;
+        bool stop;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    // Problems with at least this many observations per thread use multiple threads in the inner loop.
+    int minObservationsPerThread = 1000;
+
     int optimizePoseRobust(PoseOptimizationScene<T>& scene)
     {
         return optimizePoseRobust(scene.wps, scene.obs, scene.outlier, scene.pose, scene.K);
@@ -100,17 +135,68 @@ struct SAIGA_ALIGN_CACHE RobustPoseOptimization
     int optimizePoseRobust(const AlignedVector<Vec3>& wps, const AlignedVector<Obs>& obs, AlignedVector<int>& outlier,
                            SE3Type& guess, const CameraType& camera)
     {
-        constexpr int threads = 1;
-        locals.resize(threads);
+        return optimizePoseRobust(wps, obs, outlier, guess, camera, workspace);
+    }
+
+    /**
+     * Optimizes many independent problems in parallel. For example, the candidate poses of a relocalization.
+     * Every thread uses its own workspace and the inner loop of each problem runs single threaded.
+     */
+    void optimizePoseRobustBatch(ArrayView<PoseOptimizationScene<T>> scenes, ArrayView<int> inliers)
+    {
+        SAIGA_ASSERT(scenes.size() == inliers.size());
+        batchWorkspaces.resize(OMP::getMaxThreads());
+
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < (int)scenes.size(); ++i)
+        {
+            auto& scene = scenes[i];
+            inliers[i]  = optimizePoseRobust(scene.wps, scene.obs, scene.outlier, scene.pose, scene.K,
+                                            batchWorkspaces[OMP::getThreadNum()]);
+        }
+    }
+
+    int optimizePoseRobust(const AlignedVector<Vec3>& wps, const AlignedVector<Obs>& obs, AlignedVector<int>& outlier,
+                           SE3Type& guess, const CameraType& camera, Workspace& ws) const
+    {
         int N = wps.size();
+        SAIGA_ASSERT((int)obs.size() == N && (int)outlier.size() >= N);
 
-        //#pragma omp parallel num_threads(threads)
+        // Structure of arrays
+        for (auto v : {&ws.wx, &ws.wy, &ws.wz, &ws.u, &ws.v, &ws.ur, &ws.w, &ws.stereo}) v->resize(N);
+        for (int i = 0; i < N; ++i)
         {
+            auto& o      = obs[i];
+            ws.wx[i]     = wps[i](0);
+            ws.wy[i]     = wps[i](1);
+            ws.wz[i]     = wps[i](2);
+            ws.u[i]      = o.ip(0);
+            ws.v[i]      = o.ip(1);
+            ws.w[i]      = o.weight;
+            ws.stereo[i] = o.stereo() ? 1 : 0;
+            ws.ur[i]     = o.stereo() ? o.ip(0) - camera.bf / o.depth : 0;
+        }
+
+        int threads = std::max(1, std::min(OMP::getMaxThreads(), N / std::max(1, minObservationsPerThread)));
+        if (OMP::inParallel()) threads = 1;
+        ws.locals.resize(threads);
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+        {
+            int tid   = OMP::getThreadNum();
+            int nt    = OMP::getNumThreads();
+            int begin = int((int64_t(N) * tid) / nt);
+            int end   = int((int64_t(N) * (tid + 1)) / nt);
+
             for (auto outerIt : Range(0, maxOuterIts))
             {
                 bool robust = outerIt < (maxOuterIts - 1);
-                lastChi2sum = std::numeric_limits<T>::infinity();
-                lastGuess   = guess;
+
+#pragma omp single
+                {
+                    ws.lastChi2sum = std::numeric_limits<T>::infinity();
+                    ws.lastGuess   = guess;
+                }
 
                 auto chi2s = chi2Stereo;
                 auto chi2m = chi2Mono;
@@ -122,127 +208,46 @@ struct SAIGA_ALIGN_CACHE RobustPoseOptimization
 
                 for (auto innerIt : Range(0, maxInnerIts))
                 {
-                    {
-                        StereoJ JrowS;
-                        MonoJ JrowM;
-
-
-
-                        auto& local = locals[OMP::getThreadNum()];
-                        local.JtJ.setZero();
-                        local.Jtb.setZero();
-                        local.chi2    = 0;
-                        local.inliers = 0;
+                    evaluate(ws, outlier, guess, camera, begin, end, outerIt > 0 && innerIt == 0, robust, chi2m,
+                             chi2s, ws.locals[tid]);
+#pragma omp barrier
 
-                        //#pragma omp for
-                        for (int i = 0; i < N; ++i)
-                        {
-                            if (outlier[i]) continue;
-
-                            auto& o  = obs[i];
-                            auto& wp = wps[i];
-
-                            if (o.stereo())
-                            {
-                                auto stereo_point = o.ip(0) - camera.bf / o.depth;
-                                auto [res, depth] = BundleAdjustmentStereo(camera, o.ip, stereo_point, guess, wp,
-                                                                           o.weight, o.weight, &JrowS, nullptr);
-                                auto res_2        = res.squaredNorm();
-
-
-                                // Remove outliers
-                                if (outerIt > 0 && innerIt == 0)
-                                {
-                                    if (res_2 > chi2s || depth < 0)
-                                    {
-                                        outlier[i] = true;
-                                        continue;
-                                    }
-                                }
-                                T loss_weight = 1.0;
-                                if (robust)
-                                {
-                                    auto rw     = Kernel::Loss(loss_function, chi1Stereo, res_2);
-                                    res_2       = rw(0);
-                                    loss_weight = rw(1);
-                                }
-                                local.chi2 += res_2;
-                                local.JtJ += loss_weight * (JrowS.transpose() * JrowS);
-                                local.Jtb -= loss_weight * JrowS.transpose() * res;
-                                local.inliers++;
-                            }
-                            else
-                            {
-                                auto [res, depth] =
-                                    BundleAdjustment(camera, o.ip, guess, wp, o.weight, &JrowM, nullptr);
-                                auto res_2 = res.squaredNorm();
-                                // Remove outliers
-                                if (outerIt > 0 && innerIt == 0)
-                                {
-                                    if (res_2 > chi2m || depth < 0)
-                                    {
-                                        outlier[i] = true;
-                                        continue;
-                                    }
-                                }
-
-                                T loss_weight = 1.0;
-                                if (robust)
-                                {
-                                    auto rw     = Kernel::Loss(loss_function, chi1Mono, res_2);
-                                    res_2       = rw(0);
-                                    loss_weight = rw(1);
-                                }
-
-                                local.chi2 += res_2;
-                                local.JtJ += loss_weight * (JrowM.transpose() * JrowM);
-                                local.Jtb -= loss_weight * JrowM.transpose() * res;
-                                local.inliers++;
-                            }
-                        }
-                    }
-
-                    //#pragma omp single
+#pragma omp single
                     {
-                        auto& JtJ = locals[0].JtJ;
-                        auto& Jtb = locals[0].Jtb;
-
-                        // sum up everything into the first local
-                        for (int i = 1; i < threads; ++i)
+                        // sum up everything into the first local (in a fixed order)
+                        auto& local = ws.locals[0];
+                        for (int i = 1; i < nt; ++i)
                         {
-                            locals[0].JtJ += locals[i].JtJ;
-                            locals[0].Jtb += locals[i].Jtb;
-                            locals[0].chi2 += locals[i].chi2;
-                            locals[0].inliers += locals[i].inliers;
+                            local.JtJ += ws.locals[i].JtJ;
+                            local.Jtb += ws.locals[i].Jtb;
+                            local.chi2 += ws.locals[i].chi2;
+                            local.inliers += ws.locals[i].inliers;
                         }
-                        inliers = locals[0].inliers;
+                        ws.inliers = local.inliers;
 
 
-                        deltaChi    = lastChi2sum - locals[0].chi2;
-                        lastChi2sum = locals[0].chi2;
+                        ws.deltaChi    = ws.lastChi2sum - local.chi2;
+                        ws.lastChi2sum = local.chi2;
 
-                        if (deltaChi < 0)
+                        if (ws.deltaChi < 0)
                         {
                             // the error got worse :(
                             // -> discard step
-                            guess = lastGuess;
+                            guess = ws.lastGuess;
                         }
                         else
                         {
-                            lastGuess = guess;
-                            XType x   = JtJ.ldlt().solve(Jtb);
-                            guess     = Sophus::se3_expd(x) * guess;
+                            ws.lastGuess = guess;
+                            XType x      = local.JtJ.template selfadjointView<Eigen::Upper>().ldlt().solve(local.Jtb);
+                            guess        = Sophus::se3_expd(x.template cast<double>()).template cast<T>() * guess;
                         }
-                    }
 
-                    if (deltaChi < 0)
-                    {
-                        break;
+                        // early termination if the error doesn't change
+                        // normalize by number of inliers
+                        ws.stop = ws.deltaChi < 0 || ws.deltaChi < deltaChi2Epsilon * ws.inliers;
                     }
 
-                    // early termination if the error doesn't change
-                    // normalize by number of inliers
-                    if (deltaChi < deltaChi2Epsilon * inliers)
+                    if (ws.stop)
                     {
                         break;
                     }
@@ -250,17 +255,9 @@ struct SAIGA_ALIGN_CACHE RobustPoseOptimization
             }
         }
         // We don't really need this check because the last iteration is without the robust kernel anyways
-        return inliers;
+        return ws.inliers;
     }
 
-    struct SAIGA_ALIGN_CACHE ThreadLocalData
-    {
-        JType JtJ;
-        BType Jtb;
-        T chi2;
-        int inliers;
-    };
-
    private:
     T chi2Mono;
     T chi2Stereo;
@@ -271,14 +268,139 @@ struct SAIGA_ALIGN_CACHE RobustPoseOptimization
     int maxOuterIts;
     int maxInnerIts;
 
-    // Tmp variables for OMP implementation
-    AlignedVector<ThreadLocalData, SAIGA_CACHE_LINE_SIZE> locals;
-    int N;
-    int inliers;
-    T deltaChi;
-    SE3Type lastGuess;
-    T lastChi2sum;
+    Workspace workspace;
+    AlignedVector<Workspace> batchWorkspaces;
 
+    /**
+     * Linearizes the observations [begin, end) at the current guess. The residuals, jacobians and the normal equation
+     * are computed in a single vectorized pass without storing the jacobians.
+     * The jacobian is the same as in BundleAdjustment/BundleAdjustmentStereo (kernels/BA.h).
+     */
+    void evaluate(Workspace& ws, AlignedVector<int>& outlier, const SE3Type& guess, const CameraType& camera,
+                  int begin, int end, bool removeOutliers, bool robust, T chi2m, T chi2s, ThreadLocalData& local) const
+    {
+        Eigen::Matrix<T, 3, 3> R = guess.so3().matrix();
+        Vec3 t                   = guess.translation();
+
+        const T r00 = R(0, 0), r01 = R(0, 1), r02 = R(0, 2);
+        const T r10 = R(1, 0), r11 = R(1, 1), r12 = R(1, 2);
+        const T r20 = R(2, 0), r21 = R(2, 1), r22 = R(2, 2);
+        const T t0 = t(0), t1 = t(1), t2 = t(2);
+        const T fx = camera.fx, fy = camera.fy, cx = camera.cx, cy = camera.cy, bf = camera.bf;
+        const T c1m = chi1Mono, c1s = chi1Stereo;
+
+        const T* wx     = ws.wx.data();
+        const T* wy     = ws.wy.data();
+        const T* wz     = ws.wz.data();
+        const T* u      = ws.u.data();
+        const T* v      = ws.v.data();
+        const T* ur     = ws.ur.data();
+        const T* w      = ws.w.data();
+        const T* stereo = ws.stereo.data();
+        int* out        = outlier.data();
+
+        // Upper triangle of JtJ (21), Jtb (6), chi2
+        T acc[28]   = {};
+        int inliers = 0;
+
+#pragma omp simd reduction(+ : acc[:28], inliers)
+        for (int i = begin; i < end; ++i)
+        {
+            T x = r00 * wx[i] + r01 * wy[i] + r02 * wz[i] + t0;
+            T y = r10 * wx[i] + r11 * wy[i] + r12 * wz[i] + t1;
+            T z = r20 * wx[i] + r21 * wy[i] + r22 * wz[i] + t2;
+
+            // Points at z == 0 and points with a non-finite residual are skipped in this pass.
+            bool valid_z = std::abs(z) > std::numeric_limits<T>::epsilon();
+            T zinv       = valid_z ? 1 / z : T(0);
+            T zzinv      = zinv * zinv;
+            T pu         = fx * x * zinv + cx;
+            T st         = stereo[i];
+            T wi         = w[i];
+
+            T res[3];
+            res[0]  = (pu - u[i]) * wi;
+            res[1]  = (fy * y * zinv + cy - v[i]) * wi;
+            res[2]  = (ur[i] - (pu - bf * zinv)) * wi * st;
+            T res_2 = res[0] * res[0] + res[1] * res[1] + res[2] * res[2];
+            // false for inf and NaN
+            bool finite = valid_z && res_2 <= std::numeric_limits<T>::max();
+
+            int is_outlier = out[i];
+            if (removeOutliers)
+            {
+                T th       = st > 0 ? chi2s : chi2m;
+                is_outlier = is_outlier || res_2 > th || z < 0;
+                out[i]     = is_outlier;
+            }
+
+            T loss_weight = 1;
+            if (robust)
+            {
+                auto rw     = Kernel::Loss(loss_function, st > 0 ? c1s : c1m, res_2);
+                res_2       = rw(0);
+                loss_weight = rw(1);
+            }
+            // Select instead of multiplying with 0, so that inf and NaN of inactive lanes do not propagate.
+            bool is_active = !is_outlier && finite;
+            loss_weight    = is_active ? loss_weight : T(0);
+            res_2          = is_active ? res_2 : T(0);
+            for (int r = 0; r < 3; ++r) res[r] = is_active ? res[r] : T(0);
+
+            T J[3][6];
+            J[0][0] = fx * zinv;
+            J[0][1] = 0;
+            J[0][2] = -fx * x * zzinv;
+            J[0][3] = -fx * y * x * zzinv;
+            J[0][4] = fx * (1 + (x * x) * zzinv);
+            J[0][5] = -fx * y * zinv;
+            J[1][0] = 0;
+            J[1][1] = fy * zinv;
+            J[1][2] = -fy * y * zzinv;
+            J[1][3] = fy * (-1 - (y * y) * zzinv);
+            J[1][4] = fy * x * y * zzinv;
+            J[1][5] = fy * x * zinv;
+            J[2][0] = -J[0][0];
+            J[2][1] = 0;
+            J[2][2] = -J[0][2] - bf * zzinv;
+            J[2][3] = -J[0][3] - bf * y * zzinv;
+            J[2][4] = -J[0][4] + bf * x * zzinv;
+            J[2][5] = -J[0][5];
+            for (int c = 0; c < 6; ++c)
+            {
+                J[0][c] = is_active ? J[0][c] * wi : T(0);
+                J[1][c] = is_active ? J[1][c] * wi : T(0);
+                J[2][c] = is_active ? J[2][c] * wi * st : T(0);
+            }
+
+            int n = 0;
+            for (int a = 0; a < 6; ++a)
+            {
+                for (int b = a; b < 6; ++b)
+                {
+                    acc[n++] += loss_weight * (J[0][a] * J[0][b] + J[1][a] * J[1][b] + J[2][a] * J[2][b]);
+                }
+            }
+            for (int a = 0; a < 6; ++a)
+            {
+                acc[21 + a] -= loss_weight * (J[0][a] * res[0] + J[1][a] * res[1] + J[2][a] * res[2]);
+            }
+            acc[27] += res_2;
+            inliers += is_active;
+        }
+
+        int n = 0;
+        for (int a = 0; a < 6; ++a)
+        {
+            for (int b = a; b < 6; ++b)
+            {
+                local.JtJ(a, b) = acc[n++];
+            }
+            local.Jtb(a) = acc[21 + a];
+        }
+        local.chi2    = acc[27];
+        local.inliers = inliers;
+    }
 };  // namespace Saiga
 
 
@@ -6,6 +6,7 @@
 
 #include "SparseTSDF.h"
 
+#include "saiga/core/util/Algorithm.h"
 #include "saiga/core/util/file.h"
 #include "saiga/core/util/zlib.h"
 namespace Saiga
@@ -64,7 +65,8 @@ std::vector<std::vector<SparseTSDF::Triangle>> SparseTSDF::ExtractSurface(double
                     auto* read_block = GetBlock(read_block_id);
 
 
-                    vec3 p = GlobalPosition(block.index, i, j, k);
+                    // Position relative to the owning block -> bitwise identical in all neighbouring blocks
+                    vec3 p = GlobalPosition(read_block_id, li, lj, lk);
 
                     if (read_block)
                     {
@@ -142,25 +144,35 @@ TriangleMesh<VertexNC, uint32_t> SparseTSDF::CreateMesh(const std::vector<std::v
 {
     TriangleMesh<VertexNC, uint32_t> mesh;
 
-    for (auto& v : triangles)
+    // Offset of the first triangle of each block
+    std::vector<int> offset(triangles.size());
+    for (int i = 0; i < (int)triangles.size(); ++i) offset[i] = triangles[i].size();
+    int num_triangles = Saiga::exclusive_scan(offset.begin(), offset.end(), offset.begin(), 0);
+
+    mesh.vertices.resize(num_triangles * 3);
+    mesh.faces.resize(num_triangles);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int b = 0; b < (int)triangles.size(); ++b)
     {
-        for (auto& t : v)
+        for (int k = 0; k < (int)triangles[b].size(); ++k)
         {
-            VertexNC tri[3];
+            auto& t = triangles[b][k];
+            int f   = offset[b] + k;
             for (int i = 0; i < 3; ++i)
             {
-                tri[i].position.head<3>() = t[i].cast<float>();
-                tri[i].color              = vec4(1, 1, 1, 1);
+                auto& v              = mesh.vertices[f * 3 + i];
+                v.position.head<3>() = t[i].cast<float>();
+                v.color              = vec4(1, 1, 1, 1);
             }
-            mesh.addTriangle(tri);
+            mesh.faces[f] = {f * 3, f * 3 + 1, f * 3 + 2};
         }
     }
 
     if (post_process)
     {
-        mesh.sortVerticesByPosition();
-        mesh.removeSubsequentDuplicates();
-        mesh.removeDegenerateFaces();
+        // Shared vertices have bitwise identical positions (see above) -> exact welding is enough
+        mesh.weldVertices(0);
         mesh.computePerVertexNormal();
     }
 
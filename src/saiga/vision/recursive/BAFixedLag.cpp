@@ -0,0 +1,491 @@
+﻿/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+#include "BAFixedLag.h"
+
+#include "saiga/vision/kernels/BA.h"
+#include "saiga/vision/kernels/Robust.h"
+#include "saiga/vision/util/LM.h"
+
+namespace Saiga
+{
+void BAFixedLag::create(Scene& scene)
+{
+    SAIGA_ASSERT(windowSize > 0);
+    _scene = &scene;
+    slots  = windowSize;
+
+    window.clear();
+    window.resize(slots);
+    order.clear();
+    freeSlots.clear();
+    for (int i = slots - 1; i >= 0; --i) freeSlots.push_back(i);
+
+    points.clear();
+    freePoints.clear();
+    pointToWindow.clear();
+    activePoints          = 0;
+    marginalizedKeyframes = 0;
+
+    int N = slots * blockSizeCamera;
+    S.resize(N, N);
+    Sred.resize(N, N);
+    rhs.resize(N);
+    rhsRed.resize(N);
+    dx.resize(N);
+    priorH.setZero(N, N);
+    priorB.setZero(N);
+    priorD.setZero(N);
+    priorConstant = 0;
+}
+
+std::vector<int> BAFixedLag::keyframes() const
+{
+    std::vector<int> result;
+    for (auto s : order) result.push_back(window[s].imageId);
+    return result;
+}
+
+void BAFixedLag::addKeyframe(int imageId)
+{
+    SAIGA_ASSERT(_scene);
+    Scene& scene = *_scene;
+    SAIGA_ASSERT(imageId >= 0 && imageId < (int)scene.images.size());
+
+    if (freeSlots.empty())
+    {
+        marginalizeOldest();
+    }
+
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    order.push_back(slot);
+
+    auto& img   = scene.images[imageId];
+    auto& kf    = window[slot];
+    kf.imageId  = imageId;
+    kf.constant = img.constant || (fixFirstKeyframe && marginalizedKeyframes == 0 && order.size() == 1);
+    kf.x        = img.se3;
+    kf.x0       = img.se3;
+    kf.hostedPoints.clear();
+
+    if (pointToWindow.size() < scene.worldPoints.size())
+    {
+        pointToWindow.resize(scene.worldPoints.size(), -1);
+    }
+
+    // Append the observations to the existing structure
+    for (int i = 0; i < (int)img.stereoPoints.size(); ++i)
+    {
+        auto& ip = img.stereoPoints[i];
+        if (ip.wp == -1) continue;
+
+        int pid = pointToWindow[ip.wp];
+        if (pid == -2) continue;
+
+        if (pid == -1)
+        {
+            if (freePoints.empty())
+            {
+                pid = points.size();
+                points.emplace_back();
+            }
+            else
+            {
+                pid = freePoints.back();
+                freePoints.pop_back();
+            }
+            auto& wp      = points[pid];
+            wp.worldPoint = ip.wp;
+            wp.host       = slot;
+            wp.x          = scene.worldPoints[ip.wp].p;
+            wp.observations.clear();
+            kf.hostedPoints.push_back(pid);
+            pointToWindow[ip.wp] = pid;
+            activePoints++;
+        }
+
+        Observation obs;
+        obs.slot       = slot;
+        obs.imagePoint = i;
+        obs.W.setZero();
+        points[pid].observations.push_back(obs);
+    }
+}
+
+bool BAFixedLag::linearize(int slot, int imagePoint, const Vec3& point, Residual& res, bool jacobians)
+{
+    Scene& scene = *_scene;
+    auto& kf     = window[slot];
+    auto& img    = scene.images[kf.imageId];
+    auto& ip     = img.stereoPoints[imagePoint];
+    if (ip.outlier) return false;
+
+    auto& camera = scene.intrinsics[img.intr];
+    double w     = ip.weight * scene.scale();
+
+    double huber;
+    if (ip.IsStereoOrDepth())
+    {
+        StereoCamera4 scam(camera, scene.bf);
+        auto stereo_point = ip.GetStereoPoint(scene.bf);
+        auto [r, depth]   = BundleAdjustmentStereo(scam, ip.point, stereo_point, kf.x, point, w,
+                                                 w * scene.stereo_weight, jacobians ? &res.Jc : nullptr,
+                                                 jacobians ? &res.Jp : nullptr);
+        res.r             = r;
+        huber             = baOptions.huberStereo;
+    }
+    else
+    {
+        // Mono observations only use the first two rows
+        Matrix<double, 2, 6> JrowPose;
+        Matrix<double, 2, 3> JrowPoint;
+        auto [r, depth] = BundleAdjustment(camera, ip.point, kf.x, point, w, jacobians ? &JrowPose : nullptr,
+                                           jacobians ? &JrowPoint : nullptr);
+        res.r           = Vec3(r(0), r(1), 0);
+        if (jacobians)
+        {
+            res.Jc.setZero();
+            res.Jp.setZero();
+            res.Jc.topRows<2>() = JrowPose;
+            res.Jp.topRows<2>() = JrowPoint;
+        }
+        huber = baOptions.huberMono;
+    }
+
+    res.chi2       = res.r.squaredNorm();
+    res.lossWeight = 1;
+    if (huber > 0)
+    {
+        auto rw        = Kernel::HuberLoss<double>(huber, res.chi2);
+        res.chi2       = rw(0);
+        res.lossWeight = rw(1);
+    }
+    return true;
+}
+
+void BAFixedLag::computePriorDelta()
+{
+    priorD.setZero();
+    for (auto s : order)
+    {
+        if (!isActive(s)) continue;
+        auto& kf = window[s];
+        priorD.segment<blockSizeCamera>(s * blockSizeCamera) = Sophus::se3_logd(kf.x * kf.x0.inverse());
+    }
+}
+
+double BAFixedLag::priorCost()
+{
+    if (marginalizedKeyframes == 0) return 0;
+    computePriorDelta();
+    return priorConstant - 2.0 * priorB.dot(priorD) + priorD.dot(priorH * priorD);
+}
+
+void BAFixedLag::removePoint(int pointId)
+{
+    Scene& scene = *_scene;
+    auto& wp     = points[pointId];
+
+    // The point is not optimized anymore. Write back the final position.
+    scene.worldPoints[wp.worldPoint].p = wp.x;
+    pointToWindow[wp.worldPoint]       = -2;
+
+    wp.worldPoint = -1;
+    wp.host       = -1;
+    wp.observations.clear();
+    freePoints.push_back(pointId);
+    activePoints--;
+}
+
+void BAFixedLag::marginalizeOldest()
+{
+    SAIGA_ASSERT(!order.empty());
+    Scene& scene = *_scene;
+
+    int k    = order.front();
+    auto& kf = window[k];
+
+    // The new prior is linearized at the current estimate.
+    // The old prior is moved to this linearization point first.
+    computePriorDelta();
+    S   = priorH;
+    rhs = priorB - priorH * priorD;
+    double c =
+        (marginalizedKeyframes == 0) ? 0.0 : priorConstant - 2.0 * priorB.dot(priorD) + priorD.dot(priorH * priorD);
+
+    // Add all observations of the hosted points and eliminate the points (Schur complement on V)
+    Residual res;
+    for (auto pid : kf.hostedPoints)
+    {
+        auto& wp = points[pid];
+        wp.V.setZero();
+        wp.b.setZero();
+        for (auto& obs : wp.observations)
+        {
+            if (!linearize(obs.slot, obs.imagePoint, wp.x, res, true))
+            {
+                obs.W.setZero();
+                continue;
+            }
+            c += res.chi2;
+            wp.V += res.lossWeight * res.Jp.transpose() * res.Jp;
+            wp.b -= res.lossWeight * res.Jp.transpose() * res.r;
+            if (!isActive(obs.slot))
+            {
+                obs.W.setZero();
+                continue;
+            }
+            int o = obs.slot * blockSizeCamera;
+            obs.W = res.lossWeight * res.Jc.transpose() * res.Jp;
+            S.block<blockSizeCamera, blockSizeCamera>(o, o) += res.lossWeight * res.Jc.transpose() * res.Jc;
+            rhs.segment<blockSizeCamera>(o) -= res.lossWeight * res.Jc.transpose() * res.r;
+        }
+
+        // V is singular for points without depth information (only one mono observation)
+        // -> use the pseudo inverse
+        Eigen::SelfAdjointEigenSolver<PointDiag> es(wp.V);
+        Vec3 ev = es.eigenvalues();
+        for (int i = 0; i < 3; ++i) ev(i) = ev(i) > 1e-10 * ev(2) ? 1.0 / ev(i) : 0.0;
+        wp.Vinv = es.eigenvectors() * ev.asDiagonal() * es.eigenvectors().transpose();
+
+        c -= wp.b.dot(wp.Vinv * wp.b);
+        for (auto& o1 : wp.observations)
+        {
+            if (!isActive(o1.slot)) continue;
+            WElem WVinv = o1.W * wp.Vinv;
+            rhs.segment<blockSizeCamera>(o1.slot * blockSizeCamera) -= WVinv * wp.b;
+            for (auto& o2 : wp.observations)
+            {
+                if (!isActive(o2.slot)) continue;
+                S.block<blockSizeCamera, blockSizeCamera>(o1.slot * blockSizeCamera, o2.slot * blockSizeCamera) -=
+                    WVinv * o2.W.transpose();
+            }
+        }
+    }
+
+    // Eliminate the camera
+    int o = k * blockSizeCamera;
+    if (isActive(k))
+    {
+        Eigen::LDLT<CameraDiag> kldlt(S.block<blockSizeCamera, blockSizeCamera>(o, o));
+        if (kldlt.info() == Eigen::Success && kldlt.isPositive())
+        {
+            Eigen::Matrix<double, blockSizeCamera, -1> Hkr = S.middleRows<blockSizeCamera>(o);
+            Eigen::Matrix<double, blockSizeCamera, 1> bk   = rhs.segment<blockSizeCamera>(o);
+            Eigen::Matrix<double, blockSizeCamera, -1> HkkInvHkr = kldlt.solve(Hkr);
+            S -= Hkr.transpose() * HkkInvHkr;
+            rhs -= HkkInvHkr.transpose() * bk;
+            c -= bk.dot(kldlt.solve(bk));
+        }
+    }
+    S.middleRows<blockSizeCamera>(o).setZero();
+    S.middleCols<blockSizeCamera>(o).setZero();
+    rhs.segment<blockSizeCamera>(o).setZero();
+
+    // Store the new prior
+    priorH        = S;
+    priorB        = rhs;
+    priorConstant = c;
+    for (auto s : order)
+    {
+        window[s].x0 = window[s].x;
+    }
+
+    // Remove the hosted points and the keyframe from the window
+    for (auto pid : kf.hostedPoints)
+    {
+        removePoint(pid);
+    }
+    auto& img = scene.images[kf.imageId];
+    if (!kf.constant) img.se3 = kf.x;
+
+    kf.hostedPoints.clear();
+    kf.imageId  = -1;
+    kf.constant = false;
+    order.erase(order.begin());
+    freeSlots.push_back(k);
+    marginalizedKeyframes++;
+}
+
+void BAFixedLag::init()
+{
+    Scene& scene = *_scene;
+    // The structure is already up to date. Only read the current estimate from the scene.
+    for (auto s : order)
+    {
+        auto& kf = window[s];
+        kf.x     = scene.images[kf.imageId].se3;
+    }
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        wp.x = scene.worldPoints[wp.worldPoint].p;
+    }
+}
+
+double BAFixedLag::computeQuadraticForm()
+{
+    S.setZero();
+    rhs.setZero();
+    double chi2 = 0;
+
+    Residual res;
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        wp.V.setZero();
+        wp.b.setZero();
+        for (auto& obs : wp.observations)
+        {
+            obs.W.setZero();
+            if (!linearize(obs.slot, obs.imagePoint, wp.x, res, true)) continue;
+            chi2 += res.chi2;
+            wp.V += res.lossWeight * res.Jp.transpose() * res.Jp;
+            wp.b -= res.lossWeight * res.Jp.transpose() * res.r;
+            if (!isActive(obs.slot)) continue;
+            int o = obs.slot * blockSizeCamera;
+            obs.W = res.lossWeight * res.Jc.transpose() * res.Jp;
+            S.block<blockSizeCamera, blockSizeCamera>(o, o) += res.lossWeight * res.Jc.transpose() * res.Jc;
+            rhs.segment<blockSizeCamera>(o) -= res.lossWeight * res.Jc.transpose() * res.r;
+        }
+    }
+
+    if (marginalizedKeyframes > 0)
+    {
+        computePriorDelta();
+        S += priorH;
+        rhs += priorB - priorH * priorD;
+        chi2 += priorConstant - 2.0 * priorB.dot(priorD) + priorD.dot(priorH * priorD);
+    }
+    return chi2;
+}
+
+void BAFixedLag::addLambda(double lambda)
+{
+    applyLMDiagonalInner(S, lambda);
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        applyLMDiagonalInner(wp.V, lambda);
+    }
+}
+
+void BAFixedLag::solveLinearSystem()
+{
+    Sred   = S;
+    rhsRed = rhs;
+
+    // Schur complement on the points
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        wp.Vinv = wp.V.inverse();
+        for (auto& o1 : wp.observations)
+        {
+            if (!isActive(o1.slot)) continue;
+            WElem WVinv = o1.W * wp.Vinv;
+            rhsRed.segment<blockSizeCamera>(o1.slot * blockSizeCamera) -= WVinv * wp.b;
+            for (auto& o2 : wp.observations)
+            {
+                if (!isActive(o2.slot)) continue;
+                Sred.block<blockSizeCamera, blockSizeCamera>(o1.slot * blockSizeCamera, o2.slot * blockSizeCamera) -=
+                    WVinv * o2.W.transpose();
+            }
+        }
+    }
+
+    // Unused slots and constant keyframes are removed from the system
+    for (int s = 0; s < slots; ++s)
+    {
+        if (isActive(s)) continue;
+        int o = s * blockSizeCamera;
+        Sred.middleRows<blockSizeCamera>(o).setZero();
+        Sred.middleCols<blockSizeCamera>(o).setZero();
+        Sred.block<blockSizeCamera, blockSizeCamera>(o, o).setIdentity();
+        rhsRed.segment<blockSizeCamera>(o).setZero();
+    }
+
+    // The size of the reduced system is constant -> no reallocation
+    ldlt.compute(Sred);
+    dx = ldlt.solve(rhsRed);
+
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        Vec3 tmp = wp.b;
+        for (auto& obs : wp.observations)
+        {
+            tmp -= obs.W.transpose() * dx.segment<blockSizeCamera>(obs.slot * blockSizeCamera);
+        }
+        wp.delta = wp.Vinv * tmp;
+    }
+}
+
+bool BAFixedLag::addDelta()
+{
+    for (auto s : order)
+    {
+        auto& kf = window[s];
+        kf.oldx  = kf.x;
+        if (!isActive(s)) continue;
+        Vec6 t = dx.segment<blockSizeCamera>(s * blockSizeCamera);
+        kf.x   = Sophus::se3_expd(t) * kf.x;
+    }
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        wp.oldx = wp.x;
+        wp.x += wp.delta;
+    }
+    return true;
+}
+
+void BAFixedLag::revertDelta()
+{
+    for (auto s : order)
+    {
+        window[s].x = window[s].oldx;
+    }
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        wp.x = wp.oldx;
+    }
+}
+
+double BAFixedLag::computeCost()
+{
+    double chi2 = 0;
+    Residual res;
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        for (auto& obs : wp.observations)
+        {
+            if (!linearize(obs.slot, obs.imagePoint, wp.x, res, false)) continue;
+            chi2 += res.chi2;
+        }
+    }
+    return chi2 + priorCost();
+}
+
+void BAFixedLag::finalize()
+{
+    Scene& scene = *_scene;
+    for (auto s : order)
+    {
+        auto& kf = window[s];
+        if (kf.constant) continue;
+        scene.images[kf.imageId].se3 = kf.x;
+    }
+    for (auto& wp : points)
+    {
+        if (wp.worldPoint < 0) continue;
+        scene.worldPoints[wp.worldPoint].p = wp.x;
+    }
+}
+
+}  // namespace Saiga
@@ -0,0 +1,166 @@
+﻿/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+
+#pragma once
+#include "saiga/vision/ba/BABase.h"
+#include "saiga/vision/scene/Scene.h"
+
+#include "Recursive.h"
+
+namespace Saiga
+{
+/**
+ * Incremental fixed-lag bundle adjustment (sliding window smoother).
+ *
+ * In contrast to BARec, the problem structure is not rebuilt from the scene on every solve. Keyframes are added one
+ * by one with addKeyframe(). The new observations are appended to the existing window and new world points are
+ * created on the fly. If the window is full, the oldest keyframe is marginalized together with all world points
+ * hosted by it (the points which were first observed by this keyframe). The information of these observations is
+ * kept as a dense prior on the remaining keyframes (Schur complement).
+ * Observations of already marginalized world points are ignored.
+ *
+ * The reduced camera system always has the size 6*windowSize x 6*windowSize and a keyframe keeps its slot until it
+ * is marginalized. Therefore no symbolic analysis is required and the latency per keyframe only depends on the
+ * window size and not on the size of the map.
+ *
+ * Usage:
+ *    BAFixedLag ba;
+ *    ba.create(scene);
+ *    for (...)
+ *    {
+ *        // Track new frame and add it to the scene
+ *        ba.addKeyframe(imageId);
+ *        ba.initAndSolve();
+ *    }
+ */
+class SAIGA_VISION_API BAFixedLag : public BABase, public LMOptimizer
+{
+   public:
+    static constexpr int blockSizeCamera = 6;
+    static constexpr int blockSizePoint  = 3;
+
+    using CameraDiag = Eigen::Matrix<double, blockSizeCamera, blockSizeCamera>;
+    using PointDiag  = Eigen::Matrix<double, blockSizePoint, blockSizePoint>;
+    using WElem      = Eigen::Matrix<double, blockSizeCamera, blockSizePoint>;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    BAFixedLag() : BABase("Fixed Lag BA") {}
+    virtual ~BAFixedLag() {}
+
+    // Sets the scene and clears the window (including the prior).
+    virtual void create(Scene& scene) override;
+
+    /**
+     * Adds an image of the scene to the window.
+     * If the window is already full, the oldest keyframe is marginalized first.
+     */
+    void addKeyframe(int imageId);
+
+    // Marginalizes the oldest keyframe and the world points hosted by it.
+    void marginalizeOldest();
+
+    // Maximum number of keyframes in the window. Changes only take effect after create().
+    int windowSize = 10;
+
+    // Keeps the first added keyframe constant until it is marginalized to fix the gauge freedom.
+    bool fixFirstKeyframe = true;
+
+    // Scene image ids of the window, oldest first.
+    std::vector<int> keyframes() const;
+    int numPoints() const { return activePoints; }
+    int numMarginalizedKeyframes() const { return marginalizedKeyframes; }
+
+    // Cost of the prior at the current estimate. Included in the chi2 of the optimizer.
+    double priorCost();
+
+   private:
+    Scene* _scene = nullptr;
+
+    struct Keyframe
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        int imageId   = -1;
+        bool constant = false;
+        SE3 x, oldx;
+        // Linearization point of the prior
+        SE3 x0;
+        // Window points hosted by this keyframe
+        std::vector<int> hostedPoints;
+    };
+
+    struct Observation
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        int slot;
+        // index into the stereoPoints of the image
+        int imagePoint;
+        WElem W;
+    };
+
+    struct WindowPoint
+    {
+        int worldPoint = -1;
+        int host       = -1;
+        Vec3 x, oldx, delta;
+        PointDiag V, Vinv;
+        Vec3 b;
+        AlignedVector<Observation> observations;
+    };
+
+    struct Residual
+    {
+        Vec3 r;
+        Eigen::Matrix<double, 3, blockSizeCamera> Jc;
+        Eigen::Matrix<double, 3, blockSizePoint> Jp;
+        double chi2;
+        double lossWeight;
+    };
+
+    int slots = 0;
+    AlignedVector<Keyframe> window;
+    // slot ids of the window, oldest first
+    std::vector<int> order;
+    std::vector<int> freeSlots;
+
+    std::vector<WindowPoint> points;
+    std::vector<int> freePoints;
+    // world point -> window point. -1 if not in the window, -2 if marginalized
+    std::vector<int> pointToWindow;
+    int activePoints          = 0;
+    int marginalizedKeyframes = 0;
+
+    // Reduced camera system
+    Eigen::MatrixXd S, Sred;
+    Eigen::VectorXd rhs, rhsRed, dx;
+    Eigen::LDLT<Eigen::MatrixXd> ldlt;
+
+    // Dense prior: E(d) = priorConstant - 2 * priorB^T d + d^T priorH d
+    // with d_i = log(x_i * x0_i^-1)
+    Eigen::MatrixXd priorH;
+    Eigen::VectorXd priorB, priorD;
+    double priorConstant = 0;
+
+    bool isActive(int slot) const { return window[slot].imageId >= 0 && !window[slot].constant; }
+    void removePoint(int pointId);
+    bool linearize(int slot, int imagePoint, const Vec3& point, Residual& res, bool jacobians);
+    void computePriorDelta();
+
+    // ============== LM Functions ==============
+
+    virtual void init() override;
+    virtual double computeQuadraticForm() override;
+    virtual void addLambda(double lambda) override;
+    virtual bool addDelta() override;
+    virtual void revertDelta() override;
+    virtual void solveLinearSystem() override;
+    virtual double computeCost() override;
+    virtual void finalize() override;
+};
+
+
+}  // namespace Saiga
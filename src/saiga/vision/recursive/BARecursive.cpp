@@ -23,7 +23,8 @@
 
 namespace Saiga
 {
-void BARec::reserve(int n, int m)
+template <typename BlockScalar>
+void BARecursive<BlockScalar>::reserve(int n, int m)
 {
     validImages.reserve(n);
     validPoints.reserve(m);
@@ -44,7 +45,8 @@ void BARec::reserve(int n, int m)
     oldx_v.reserve(n);
 }
 
-void BARec::init()
+template <typename BlockScalar>
+void BARecursive<BlockScalar>::init()
 {
     //    OMP::setWaitPolicy(OMP::WaitPolicy::Active);
     //    threads = 4;
@@ -233,6 +235,13 @@ void BARec::init()
     // Setup the linear solver and anlyze the pattern
     loptions.maxIterativeIterations = optimizationOptions.maxIterativeIterations;
     loptions.iterativeTolerance     = optimizationOptions.iterativeTolerance;
+    loptions.cholmod                = optimizationOptions.cholmod;
+    loptions.supernodal             = optimizationOptions.supernodal;
+    loptions.preconditioner         = RecursivePreconditioner(optimizationOptions.preconditioner);
+    loptions.ssorOmega              = optimizationOptions.ssorOmega;
+    loptions.icFillLevel            = optimizationOptions.icFillLevel;
+    loptions.clusterSize            = optimizationOptions.clusterSize;
+    loptions.refinementSteps        = optimizationOptions.refinementSteps;
     loptions.solverType             = (optimizationOptions.solverType == OptimizationOptions::SolverType::Direct)
                               ? Eigen::Recursive::LinearSolverOptions::SolverType::Direct
                               : Eigen::Recursive::LinearSolverOptions::SolverType::Iterative;
@@ -339,13 +348,15 @@ void BARec::init()
     }
 }
 
-double BARec::computeQuadraticForm()
+template <typename BlockScalar>
+double BARecursive<BlockScalar>::computeQuadraticForm()
 {
     Scene& scene = *_scene;
 
     //    SAIGA_OPTIONAL_BLOCK_TIMER(RECURSIVE_BA_USE_TIMERS && optimizationOptions.debugOutput);
 
-    using T = BlockBAScalar;
+    // The residuals, Jacobians and robust kernels are always evaluated in double precision
+    using T = double;
     //    using KernelType = Saiga::Kernel::BAPosePointMono<T>;
 
 
@@ -415,15 +426,12 @@ double BARec::computeQuadraticForm()
 
 
 
-            if (!constant)
-            {
-                // each thread can direclty right into A.u and b.u because
-                // we parallize over images
-                auto& targetPosePose = A.u.diagonal()(actualOffset).get();
-                auto& targetPoseRes  = b.u(actualOffset).get();
-                targetPosePose.setZero();
-                targetPoseRes.setZero();
-            }
+            // The camera blocks are accumulated in double and written to A.u and b.u at the end.
+            // Each thread can direclty write into A.u and b.u because we parallize over images.
+            Eigen::Matrix<double, blockSizeCamera, blockSizeCamera> targetPosePose;
+            Eigen::Matrix<double, blockSizeCamera, 1> targetPoseRes;
+            targetPosePose.setZero();
+            targetPoseRes.setZero();
 
             for (auto& ip : img.stereoPoints)
             {
@@ -437,7 +445,7 @@ double BARec::computeQuadraticForm()
                     }
                     continue;
                 }
-                BlockBAScalar w = ip.weight * scene.scale();
+                double w        = ip.weight * scene.scale();
                 int j           = pointToValidMap[ip.wp];
 
 
@@ -473,14 +481,12 @@ double BARec::computeQuadraticForm()
 
                     if (!constant)
                     {
-                        auto& targetPosePose = A.u.diagonal()(actualOffset).get();
-                        auto& targetPoseRes  = b.u(actualOffset).get();
                         targetPosePose += loss_weight * JrowPose.transpose() * JrowPose;
-                        targetPosePoint = loss_weight * JrowPose.transpose() * JrowPoint;
+                        targetPosePoint = (loss_weight * JrowPose.transpose() * JrowPoint).template cast<BlockScalar>();
                         targetPoseRes -= loss_weight * JrowPose.transpose() * res;
                     }
-                    targetPointPoint += loss_weight * JrowPoint.transpose() * JrowPoint;
-                    targetPointRes -= loss_weight * JrowPoint.transpose() * res;
+                    targetPointPoint += (loss_weight * JrowPoint.transpose() * JrowPoint).template cast<BlockScalar>();
+                    targetPointRes -= (loss_weight * JrowPoint.transpose() * res).template cast<BlockScalar>();
                 }
                 else
                 {
@@ -502,14 +508,12 @@ double BARec::computeQuadraticForm()
                     //                    if (!valid_depth) loss_weight = 0;
                     if (!constant)
                     {
-                        auto& targetPosePose = A.u.diagonal()(actualOffset).get();
-                        auto& targetPoseRes  = b.u(actualOffset).get();
                         targetPosePose += loss_weight * JrowPose.transpose() * JrowPose;
-                        targetPosePoint = loss_weight * JrowPose.transpose() * JrowPoint;
+                        targetPosePoint = (loss_weight * JrowPose.transpose() * JrowPoint).template cast<BlockScalar>();
                         targetPoseRes -= loss_weight * JrowPose.transpose() * res;
                     }
-                    targetPointPoint += loss_weight * JrowPoint.transpose() * JrowPoint;
-                    targetPointRes -= loss_weight * JrowPoint.transpose() * res;
+                    targetPointPoint += (loss_weight * JrowPoint.transpose() * JrowPoint).template cast<BlockScalar>();
+                    targetPointRes -= (loss_weight * JrowPoint.transpose() * res).template cast<BlockScalar>();
                 }
 
                 if (!constant)
@@ -518,6 +522,12 @@ double BARec::computeQuadraticForm()
                     ++k;
                 }
             }
+
+            if (!constant)
+            {
+                A.u.diagonal()(actualOffset).get() = targetPosePose.template cast<BlockScalar>();
+                b.u(actualOffset).get()            = targetPoseRes.template cast<BlockScalar>();
+            }
         }
 
 #pragma omp for
@@ -542,7 +552,8 @@ double BARec::computeQuadraticForm()
     return chi2_sum;
 }
 
-bool BARec::addDelta()
+template <typename BlockScalar>
+bool BARecursive<BlockScalar>::addDelta()
 {
     //#pragma omp parallel num_threads(baOptions.helper_threads)
     {
@@ -558,7 +569,7 @@ bool BARec::addDelta()
 
 
 
-            auto t = delta_x.u(offset).get();
+            Vec6 t = delta_x.u(offset).get().template cast<double>();
 
             x_u[id] = Sophus::se3_expd(t) * x_u[id];
 
@@ -571,14 +582,15 @@ bool BARec::addDelta()
         for (int i = 0; i < m; ++i)
         {
             oldx_v[i] = x_v[i];
-            auto t    = delta_x.v(i).get();
+            Vec3 t    = delta_x.v(i).get().template cast<double>();
             x_v[i] += t;
         }
     }
     return true;
 }
 
-void BARec::revertDelta()
+template <typename BlockScalar>
+void BARecursive<BlockScalar>::revertDelta()
 {
     //#pragma omp parallel num_threads(threads)
     //#pragma omp parallel num_threads(baOptions.helper_threads)
@@ -602,7 +614,8 @@ void BARec::revertDelta()
     //    x_u = oldx_u;
     //    x_v = oldx_v;
 }
-void BARec::finalize()
+template <typename BlockScalar>
+void BARecursive<BlockScalar>::finalize()
 {
     Scene& scene = *_scene;
 
@@ -623,7 +636,6 @@ void BARec::finalize()
 #pragma omp for
         for (int i = 0; i < (int)validPoints.size(); ++i)
         {
-            Eigen::Matrix<BlockBAScalar, 3, 1> t;
             auto id = validPoints[i];
             auto& p = scene.worldPoints[id].p;
             p       = x_v[i];
@@ -632,7 +644,8 @@ void BARec::finalize()
 }
 
 
-void BARec::addLambda(double lambda)
+template <typename BlockScalar>
+void BARecursive<BlockScalar>::addLambda(double lambda)
 {
     //    if (1 == 1)
     //    {
@@ -652,13 +665,15 @@ void BARec::addLambda(double lambda)
 
 
 
-void BARec::solveLinearSystem()
+template <typename BlockScalar>
+void BARecursive<BlockScalar>::solveLinearSystem()
 {
     SAIGA_OPTIONAL_BLOCK_TIMER(RECURSIVE_BA_USE_TIMERS && optimizationOptions.debugOutput);
 
     if (baOptions.solver_threads == 1)
     {
         solver.solve(A, delta_x, b, loptions);
+        linearSolverIterations += solver.iterations();
     }
     else
     {
@@ -670,13 +685,14 @@ void BARec::solveLinearSystem()
     //#pragma omp single
 }
 
-double BARec::computeCost()
+template <typename BlockScalar>
+double BARecursive<BlockScalar>::computeCost()
 {
     Scene& scene = *_scene;
 
     SAIGA_OPTIONAL_BLOCK_TIMER(RECURSIVE_BA_USE_TIMERS && optimizationOptions.debugOutput);
 
-    using T = BlockBAScalar;
+    using T = double;
 
 #pragma omp parallel num_threads(baOptions.helper_threads)
     {
@@ -700,7 +716,7 @@ double BARec::computeCost()
             for (auto& ip : img.stereoPoints)
             {
                 if (!ip) continue;
-                BlockBAScalar w = ip.weight * scene.scale();
+                double w        = ip.weight * scene.scale();
                 int j           = pointToValidMap[ip.wp];
                 SAIGA_ASSERT(j >= 0);
                 auto& wp = x_v[j];
@@ -746,4 +762,7 @@ double BARec::computeCost()
 
     return chi2_sum;
 }
+template class BARecursive<double>;
+template class BARecursive<float>;
+
 }  // namespace Saiga
@@ -13,13 +13,25 @@
 
 namespace Saiga
 {
-class SAIGA_VISION_API BARec : public BABase, public LMOptimizer
+/**
+ * Recursive bundle adjustment.
+ *
+ * The template parameter is the scalar type of the matrix blocks of the linear system.
+ *   - BARec (double): Everything in double precision.
+ *   - BARecMixed (float): Mixed precision. The blocks of U, V, W and the Schur complement are stored and multiplied in
+ *     float, which halves the memory bandwidth of the linear solver. The Jacobians, residuals and chi2 are computed
+ *     in double and the per camera sums (and the CG dot products) are accumulated in double.
+ *     Set OptimizationOptions::refinementSteps > 0 to improve the accuracy of the direct linear solve. The refinement
+ *     residual is computed in double.
+ */
+template <typename _BlockBAScalar>
+class SAIGA_VISION_API BARecursive : public BABase, public LMOptimizer
 {
    public:
     // ============== Recusrive Matrix Types ==============
     static constexpr int blockSizeCamera = 6;
     static constexpr int blockSizePoint  = 3;
-    using BlockBAScalar                  = double;
+    using BlockBAScalar                  = _BlockBAScalar;
 
     using ADiag  = Eigen::Matrix<BlockBAScalar, blockSizeCamera, blockSizeCamera, Eigen::RowMajor>;
     using BDiag  = Eigen::Matrix<BlockBAScalar, blockSizePoint, blockSizePoint, Eigen::RowMajor>;
@@ -49,8 +61,8 @@ class SAIGA_VISION_API BARec : public BABase, public LMOptimizer
    public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-    BARec() : BABase("Recursive BA") {}
-    virtual ~BARec() {}
+    BARecursive() : BABase(std::is_same_v<BlockBAScalar, double> ? "Recursive BA" : "Recursive BA (mixed)") {}
+    virtual ~BARecursive() {}
     virtual void create(Scene& scene) override { _scene = &scene; }
 
     // resserve space for n cameras and m points
@@ -132,5 +144,7 @@ class SAIGA_VISION_API BARec : public BABase, public LMOptimizer
     virtual void finalize() override;
 };
 
+using BARec      = BARecursive<double>;
+using BARecMixed = BARecursive<float>;
 
 }  // namespace Saiga
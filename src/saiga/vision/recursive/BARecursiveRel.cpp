@@ -350,6 +350,13 @@ void BARecRel::init()
     // Setup the linear solver and anlyze the pattern
     loptions.maxIterativeIterations = optimizationOptions.maxIterativeIterations;
     loptions.iterativeTolerance     = optimizationOptions.iterativeTolerance;
+    loptions.cholmod                = optimizationOptions.cholmod;
+    loptions.supernodal             = optimizationOptions.supernodal;
+    loptions.preconditioner         = RecursivePreconditioner(optimizationOptions.preconditioner);
+    loptions.ssorOmega              = optimizationOptions.ssorOmega;
+    loptions.icFillLevel            = optimizationOptions.icFillLevel;
+    loptions.clusterSize            = optimizationOptions.clusterSize;
+    loptions.refinementSteps        = optimizationOptions.refinementSteps;
     loptions.solverType             = (optimizationOptions.solverType == OptimizationOptions::SolverType::Direct)
                               ? Eigen::Recursive::LinearSolverOptions::SolverType::Direct
                               : Eigen::Recursive::LinearSolverOptions::SolverType::Iterative;
@@ -828,6 +835,7 @@ void BARecRel::solveLinearSystem()
 
 
     solver.solve(A, delta_x, b, loptions);
+    linearSolverIterations += solver.iterations();
 }
 
 double BARecRel::computeCost()
@@ -11,7 +11,9 @@
 
 #include "Cholesky/CG.h"
 #include "Cholesky/Cholesky.h"
+#include "Cholesky/Preconditioner.h"
 #include "Cholesky/RecursiveSimplicialCholesky.h"
 #include "Cholesky/RecursiveSimplicialCholesky2.h"
 #include "Cholesky/SparseCholesky.h"
 #include "Cholesky/SparseTriangular.h"
+#include "Cholesky/SupernodalLDLT.h"
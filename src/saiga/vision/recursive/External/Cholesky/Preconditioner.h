@@ -0,0 +1,756 @@
+﻿/**
+ * This file is part of the Eigen Recursive Matrix Extension (ERME).
+ *
+ * Copyright (c) 2019 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "../Core.h"
+#include "Eigen/Cholesky"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <vector>
+
+/**
+ * Preconditioners for recursive_conjugate_gradient (see CG.h) on sparse block matrices of the form
+ * SparseMatrix<MatrixScalar<Block>>. Only the upper triangle of the matrix is referenced. This is the same
+ * format as used by the Schur complement of BA and the PGO/ARAP systems.
+ *
+ *  - RecursiveSSORPreconditioner: Block SSOR. omega = 1 is the symmetric block Gauss-Seidel method.
+ *  - RecursiveIncompleteCholeskyPreconditioner: Block incomplete LDLT with level of fill k (IC(k)).
+ *  - RecursiveClusterJacobiPreconditioner: Block Jacobi on clusters of unknowns. For the Schur complement of BA
+ *    the cameras are clustered by their covisibility and the cluster blocks are computed without building S.
+ *
+ * The interface is the same as RecursiveDiagonalPreconditioner:
+ *
+ *   RecursiveSSORPreconditioner<SType> P;
+ *   P.compute(S);
+ *   recursive_conjugate_gradient(applyS, b, x, P, iters, tol);
+ */
+namespace Eigen::Recursive
+{
+// Calls f(row, col, valueIndex) for all stored blocks in the upper triangle of A.
+template <typename MatrixType, typename F>
+inline void forEachUpperBlock(const MatrixType& A, F f)
+{
+    for (Index k = 0; k < A.outerSize(); ++k)
+    {
+        Index begin = A.outerIndexPtr()[k];
+        Index end   = A.isCompressed() ? A.outerIndexPtr()[k + 1] : begin + A.innerNonZeroPtr()[k];
+        for (Index p = begin; p < end; ++p)
+        {
+            int inner = A.innerIndexPtr()[p];
+            int row   = MatrixType::IsRowMajor ? k : inner;
+            int col   = MatrixType::IsRowMajor ? inner : k;
+            if (row <= col) f(row, col, p);
+        }
+    }
+}
+
+template <typename _MatrixType>
+class RecursiveSSORPreconditioner
+{
+   public:
+    using MatrixType   = _MatrixType;
+    using StorageIndex = typename MatrixType::StorageIndex;
+    using Block        = typename MatrixType::Scalar::M;
+    using Scalar       = typename Block::Scalar;
+    using BlockVector  = std::vector<Block, Eigen::aligned_allocator<Block>>;
+    enum
+    {
+        ColsAtCompileTime    = Eigen::Dynamic,
+        MaxColsAtCompileTime = Eigen::Dynamic
+    };
+
+    // 0 < omega < 2
+    double omega = 1.0;
+
+    Eigen::Index rows() const { return n; }
+    Eigen::Index cols() const { return n; }
+
+    template <typename MatType>
+    RecursiveSSORPreconditioner& analyzePattern(const MatType&)
+    {
+        return *this;
+    }
+
+    RecursiveSSORPreconditioner& factorize(const MatrixType& A)
+    {
+        n = A.rows();
+        rowPtr.assign(n + 1, 0);
+        forEachUpperBlock(A, [&](int row, int col, Index) {
+            if (row != col) rowPtr[row + 1]++;
+        });
+        for (int i = 0; i < n; ++i) rowPtr[i + 1] += rowPtr[i];
+        colIdx.resize(rowPtr[n]);
+        values.resize(rowPtr[n]);
+        D.resize(n);
+        Dinv.resize(n);
+        for (auto& d : D) d.setIdentity();
+
+        std::vector<int> pos(rowPtr.begin(), rowPtr.end() - 1);
+        forEachUpperBlock(A, [&](int row, int col, Index p) {
+            if (row == col)
+            {
+                D[row] = A.valuePtr()[p].get();
+            }
+            else
+            {
+                colIdx[pos[row]] = col;
+                values[pos[row]] = A.valuePtr()[p].get();
+                pos[row]++;
+            }
+        });
+        for (int i = 0; i < n; ++i) Dinv[i] = D[i].inverse();
+        m_isInitialized = true;
+        return *this;
+    }
+
+    RecursiveSSORPreconditioner& compute(const MatrixType& A) { return factorize(A); }
+
+    /**
+     * M^-1 b = (2-w)/w * (D/w + U)^-1 * D * (D/w + L)^-1 * b
+     * The forward substitution is computed in scatter form, because only the upper triangle is stored.
+     */
+    template <typename Rhs, typename Dest>
+    void _solve_impl(const Rhs& b, Dest& x) const
+    {
+        x = b;
+        for (int i = 0; i < n; ++i)
+        {
+            x(i).get() = omega * (Dinv[i] * x(i).get());
+            for (int p = rowPtr[i]; p < rowPtr[i + 1]; ++p)
+            {
+                x(colIdx[p]).get() -= values[p].transpose() * x(i).get();
+            }
+        }
+
+        Scalar c = (2 - omega) / omega;
+        for (int i = n - 1; i >= 0; --i)
+        {
+            auto s = (c * (D[i] * x(i).get())).eval();
+            for (int p = rowPtr[i]; p < rowPtr[i + 1]; ++p)
+            {
+                s -= values[p] * x(colIdx[p]).get();
+            }
+            x(i).get() = omega * (Dinv[i] * s);
+        }
+    }
+
+    template <typename Rhs>
+    inline const Eigen::Solve<RecursiveSSORPreconditioner, Rhs> solve(const Eigen::MatrixBase<Rhs>& b) const
+    {
+        eigen_assert(m_isInitialized && "RecursiveSSORPreconditioner is not initialized.");
+        eigen_assert(n == b.rows());
+        return Eigen::Solve<RecursiveSSORPreconditioner, Rhs>(*this, b.derived());
+    }
+
+    Eigen::ComputationInfo info() { return Eigen::Success; }
+
+   protected:
+    int n                = 0;
+    bool m_isInitialized = false;
+
+    // Strictly upper part in CSR format
+    std::vector<int> rowPtr, colIdx;
+    BlockVector values;
+    BlockVector D, Dinv;
+};
+
+
+/**
+ * Block incomplete LDLT factorization. The sparsity pattern of L is computed with the level-of-fill
+ * rule of ILU(k):
+ *
+ *   level(i,j) = 0                                      if A(i,j) != 0
+ *   level(i,j) = min_k level(i,k) + level(j,k) + 1      otherwise
+ *
+ * All entries with level <= fillLevel are kept. fillLevel = 0 is the classic IC(0) with the pattern of A.
+ *
+ * If a diagonal block becomes indefinite, the factorization is restarted with a scaled diagonal
+ * A + shift * diag(A) (Manteuffel shift). The shift is doubled until the factorization succeeds.
+ */
+template <typename _MatrixType>
+class RecursiveIncompleteCholeskyPreconditioner
+{
+   public:
+    using MatrixType   = _MatrixType;
+    using StorageIndex = typename MatrixType::StorageIndex;
+    using Block        = typename MatrixType::Scalar::M;
+    using Scalar       = typename Block::Scalar;
+    using BlockVector  = std::vector<Block, Eigen::aligned_allocator<Block>>;
+    enum
+    {
+        ColsAtCompileTime    = Eigen::Dynamic,
+        MaxColsAtCompileTime = Eigen::Dynamic
+    };
+
+    int fillLevel       = 0;
+    double initialShift = 1e-3;
+
+    Eigen::Index rows() const { return n; }
+    Eigen::Index cols() const { return n; }
+
+    // The shift that was required for a successful factorization
+    double shift() const { return m_shift; }
+    // Number of blocks in the strictly lower part of L
+    Index nonZeros() const { return colIdx.size(); }
+
+    // Symbolic factorization
+    RecursiveIncompleteCholeskyPreconditioner& analyzePattern(const MatrixType& A);
+
+    // Numeric factorization. Recomputes the pattern if the structure of A has changed.
+    RecursiveIncompleteCholeskyPreconditioner& factorize(const MatrixType& A);
+
+    RecursiveIncompleteCholeskyPreconditioner& compute(const MatrixType& A) { return factorize(A); }
+
+    template <typename Rhs, typename Dest>
+    void _solve_impl(const Rhs& b, Dest& x) const
+    {
+        // L y = b
+        x = b;
+        for (int i = 0; i < n; ++i)
+        {
+            for (int p = rowPtr[i]; p < rowPtr[i + 1]; ++p)
+            {
+                x(i).get() -= L[p] * x(colIdx[p]).get();
+            }
+        }
+
+        // D z = y
+        for (int i = 0; i < n; ++i) x(i).get() = Dinv[i] * x(i).get();
+
+        // L^T x = z (scatter form)
+        for (int i = n - 1; i >= 0; --i)
+        {
+            for (int p = rowPtr[i]; p < rowPtr[i + 1]; ++p)
+            {
+                x(colIdx[p]).get() -= L[p].transpose() * x(i).get();
+            }
+        }
+    }
+
+    template <typename Rhs>
+    inline const Eigen::Solve<RecursiveIncompleteCholeskyPreconditioner, Rhs> solve(
+        const Eigen::MatrixBase<Rhs>& b) const
+    {
+        eigen_assert(m_isInitialized && "RecursiveIncompleteCholeskyPreconditioner is not initialized.");
+        eigen_assert(n == b.rows());
+        return Eigen::Solve<RecursiveIncompleteCholeskyPreconditioner, Rhs>(*this, b.derived());
+    }
+
+    Eigen::ComputationInfo info() { return m_info; }
+
+   protected:
+    int n                       = 0;
+    Index nnzA                  = -1;
+    int analyzedFillLevel       = -1;
+    bool m_isInitialized        = false;
+    double m_shift              = 0;
+    Eigen::ComputationInfo m_info = Eigen::Success;
+
+    // Strictly lower part of L in CSR format (sorted columns)
+    std::vector<int> rowPtr, colIdx;
+    // Index of the corresponding (transposed) block in the value array of A or -1 for fill-in
+    std::vector<Index> valueIdx;
+    std::vector<Index> diagIdx;
+
+    BlockVector L, LD, Dinv;
+
+    bool numericFactorization(const MatrixType& A, double shift);
+};
+
+template <typename _MatrixType>
+RecursiveIncompleteCholeskyPreconditioner<_MatrixType>&
+RecursiveIncompleteCholeskyPreconditioner<_MatrixType>::analyzePattern(const MatrixType& A)
+{
+    n                 = A.rows();
+    nnzA              = A.nonZeros();
+    analyzedFillLevel = fillLevel;
+
+    // Lower pattern of A by rows: (col, value index)
+    std::vector<int> aPtr(n + 1, 0);
+    diagIdx.assign(n, -1);
+    forEachUpperBlock(A, [&](int row, int col, Index) {
+        if (row != col) aPtr[col + 1]++;
+    });
+    for (int i = 0; i < n; ++i) aPtr[i + 1] += aPtr[i];
+    std::vector<std::pair<int, Index>> aLower(aPtr[n]);
+    {
+        std::vector<int> pos(aPtr.begin(), aPtr.end() - 1);
+        forEachUpperBlock(A, [&](int row, int col, Index p) {
+            if (row == col)
+                diagIdx[row] = p;
+            else
+                aLower[pos[col]++] = {row, p};
+        });
+    }
+
+    // Symbolic ILU(k), row by row.
+    // colLists[k] contains (i, level(i,k)) for all finished rows i > k with L(i,k) != 0.
+    std::vector<std::vector<std::pair<int, int>>> colLists(n);
+    std::vector<int> mark(n, -1), level(n, 0);
+    std::priority_queue<int, std::vector<int>, std::greater<int>> queue;
+    std::vector<int> row;
+
+    rowPtr.assign(n + 1, 0);
+    colIdx.clear();
+    for (int i = 0; i < n; ++i)
+    {
+        for (int p = aPtr[i]; p < aPtr[i + 1]; ++p)
+        {
+            int j = aLower[p].first;
+            if (mark[j] != i)
+            {
+                mark[j]  = i;
+                level[j] = 0;
+                queue.push(j);
+            }
+        }
+
+        row.clear();
+        while (!queue.empty())
+        {
+            int k = queue.top();
+            queue.pop();
+            row.push_back(k);
+            for (auto [j, lev] : colLists[k])
+            {
+                int newLevel = level[k] + lev + 1;
+                if (newLevel > fillLevel) continue;
+                if (mark[j] != i)
+                {
+                    mark[j]  = i;
+                    level[j] = newLevel;
+                    queue.push(j);
+                }
+                else
+                {
+                    level[j] = std::min(level[j], newLevel);
+                }
+            }
+        }
+
+        for (auto k : row)
+        {
+            colIdx.push_back(k);
+            colLists[k].emplace_back(i, level[k]);
+        }
+        rowPtr[i + 1] = colIdx.size();
+    }
+
+    // Map the entries of A into L
+    valueIdx.assign(colIdx.size(), -1);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int p = rowPtr[i]; p < rowPtr[i + 1]; ++p) mark[colIdx[p]] = p + n;
+        for (int p = aPtr[i]; p < aPtr[i + 1]; ++p) valueIdx[mark[aLower[p].first] - n] = aLower[p].second;
+        for (int p = rowPtr[i]; p < rowPtr[i + 1]; ++p) mark[colIdx[p]] = -1;
+    }
+
+    L.resize(colIdx.size());
+    LD.resize(colIdx.size());
+    Dinv.resize(n);
+    return *this;
+}
+
+template <typename _MatrixType>
+RecursiveIncompleteCholeskyPreconditioner<_MatrixType>&
+RecursiveIncompleteCholeskyPreconditioner<_MatrixType>::factorize(const MatrixType& A)
+{
+    if (A.rows() != n || A.nonZeros() != nnzA || fillLevel != analyzedFillLevel) analyzePattern(A);
+
+    m_shift = 0;
+    m_info  = Eigen::Success;
+    for (int attempt = 0; !numericFactorization(A, m_shift); ++attempt)
+    {
+        if (attempt == 30)
+        {
+            m_info = Eigen::NumericalIssue;
+            break;
+        }
+        m_shift = m_shift == 0 ? initialShift : m_shift * 2;
+    }
+    m_isInitialized = true;
+    return *this;
+}
+
+template <typename _MatrixType>
+bool RecursiveIncompleteCholeskyPreconditioner<_MatrixType>::numericFactorization(const MatrixType& A, double shift)
+{
+    const auto* values = A.valuePtr();
+    for (int i = 0; i < n; ++i)
+    {
+        const int rowEnd = rowPtr[i + 1];
+        for (int q = rowPtr[i]; q < rowEnd; ++q)
+        {
+            // L(i,j) D(j) = A(i,j) - sum_k L(i,k) D(k) L(j,k)^T
+            int j   = colIdx[q];
+            Block s = valueIdx[q] >= 0 ? Block(values[valueIdx[q]].get().transpose()) : Block(Block::Zero());
+
+            int a = rowPtr[i], b = rowPtr[j];
+            while (a < q && b < rowPtr[j + 1])
+            {
+                if (colIdx[a] == colIdx[b])
+                {
+                    s.noalias() -= LD[a] * L[b].transpose();
+                    ++a;
+                    ++b;
+                }
+                else if (colIdx[a] < colIdx[b])
+                {
+                    ++a;
+                }
+                else
+                {
+                    ++b;
+                }
+            }
+            LD[q] = s;
+            L[q]  = s * Dinv[j];
+        }
+
+        Block d = diagIdx[i] >= 0 ? Block(values[diagIdx[i]].get()) : Block(Block::Identity());
+        d.diagonal() *= Scalar(1 + shift);
+        for (int q = rowPtr[i]; q < rowEnd; ++q) d.noalias() -= LD[q] * L[q].transpose();
+
+        Eigen::LLT<Block> llt(d);
+        if (llt.info() != Eigen::Success) return false;
+        Dinv[i] = llt.solve(Block::Identity());
+    }
+    return true;
+}
+
+
+/**
+ * Block Jacobi preconditioner on clusters of unknowns. Each cluster is a dense diagonal block of A, which is
+ * factorized with a dense LDLT.
+ *
+ * For the reduced camera system S = U - W V^-1 W^T of BA the cameras are clustered by covisibility (the number of
+ * shared points) and the cluster blocks of S are computed directly from U, W and Y = W V^-1. Therefore this also
+ * works with the implicit Schur complement. See "Visibility Based Preconditioning for Bundle Adjustment"
+ * (Kushal, Agarwal 2012).
+ *
+ * A cluster size of 1 is the same as the block Jacobi (RecursiveDiagonalPreconditioner).
+ */
+template <typename _Scalar>
+class RecursiveClusterJacobiPreconditioner
+{
+   public:
+    using Block        = typename _Scalar::M;
+    using Scalar       = typename Block::Scalar;
+    using StorageIndex = int;
+    using DenseMatrix  = Eigen::Matrix<Scalar, -1, -1>;
+    using DenseVector  = Eigen::Matrix<Scalar, -1, 1>;
+
+    static constexpr int BlockSize = Block::RowsAtCompileTime;
+
+    enum
+    {
+        ColsAtCompileTime    = Eigen::Dynamic,
+        MaxColsAtCompileTime = Eigen::Dynamic
+    };
+
+    int maxClusterSize = 8;
+
+    Eigen::Index rows() const { return n; }
+    Eigen::Index cols() const { return n; }
+
+    int numClusters() const { return clusterPtr.size() - 1; }
+    const std::vector<int>& clusterIds() const { return clusterOf; }
+
+    // Clusters the cameras (rows of W) by the number of shared points (columns of W).
+    template <typename WType>
+    void clusterByVisibility(const WType& W)
+    {
+        static_assert(WType::IsRowMajor, "W must be row major.");
+        n = W.rows();
+
+        // Point -> (camera, value index)
+        int m = W.cols();
+        pointPtr.assign(m + 1, 0);
+        for (int i = 0; i < n; ++i)
+        {
+            for (Index p = W.outerIndexPtr()[i]; p < W.outerIndexPtr()[i + 1]; ++p) pointPtr[W.innerIndexPtr()[p] + 1]++;
+        }
+        for (int j = 0; j < m; ++j) pointPtr[j + 1] += pointPtr[j];
+        pointObs.resize(pointPtr[m]);
+        {
+            std::vector<int> pos(pointPtr.begin(), pointPtr.end() - 1);
+            for (int i = 0; i < n; ++i)
+            {
+                for (Index p = W.outerIndexPtr()[i]; p < W.outerIndexPtr()[i + 1]; ++p)
+                {
+                    pointObs[pos[W.innerIndexPtr()[p]]++] = {i, p};
+                }
+            }
+        }
+
+        // Camera-camera edges weighted by the number of shared points
+        std::vector<std::pair<int, int>> pairs;
+        for (int j = 0; j < m; ++j)
+        {
+            for (int a = pointPtr[j]; a < pointPtr[j + 1]; ++a)
+            {
+                for (int b = a + 1; b < pointPtr[j + 1]; ++b)
+                {
+                    int c1 = pointObs[a].first, c2 = pointObs[b].first;
+                    pairs.emplace_back(std::min(c1, c2), std::max(c1, c2));
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        std::vector<Edge> edges;
+        for (size_t i = 0; i < pairs.size();)
+        {
+            size_t j = i;
+            while (j < pairs.size() && pairs[j] == pairs[i]) ++j;
+            edges.push_back({pairs[i].first, pairs[i].second, int(j - i)});
+            i = j;
+        }
+        buildClusters(edges);
+    }
+
+    // Clusters the unknowns of a sparse block matrix by its graph. Used if no visibility information is available.
+    template <typename MatType>
+    void clusterByGraph(const MatType& A)
+    {
+        n = A.rows();
+        pointPtr.clear();
+        pointObs.clear();
+        std::vector<Edge> edges;
+        forEachUpperBlock(A, [&](int row, int col, Index) {
+            if (row != col) edges.push_back({row, col, 1});
+        });
+        buildClusters(edges);
+    }
+
+    // Explicit matrix (upper triangle)
+    template <typename MatType>
+    RecursiveClusterJacobiPreconditioner& factorize(const MatType& A)
+    {
+        if (clusterOf.size() != size_t(A.rows())) clusterByGraph(A);
+        initClusterMatrices();
+        forEachUpperBlock(A, [&](int row, int col, Index p) {
+            int c = clusterOf[row];
+            if (c != clusterOf[col]) return;
+            auto& M = clusterMatrices[c];
+            M.template block<BlockSize, BlockSize>(localIdx[row] * BlockSize, localIdx[col] * BlockSize) =
+                A.valuePtr()[p].get();
+            M.template block<BlockSize, BlockSize>(localIdx[col] * BlockSize, localIdx[row] * BlockSize) =
+                A.valuePtr()[p].get().transpose();
+        });
+        factorizeClusters();
+        return *this;
+    }
+
+    template <typename MatType>
+    RecursiveClusterJacobiPreconditioner& compute(const MatType& A)
+    {
+        return factorize(A);
+    }
+
+    template <typename MatType>
+    RecursiveClusterJacobiPreconditioner& analyzePattern(const MatType& A)
+    {
+        clusterByGraph(A);
+        return *this;
+    }
+
+    /**
+     * Implicit Schur complement S = U - Y * W^T with Y = W * V^-1.
+     * U is block diagonal. Y and W must have the same structure.
+     * clusterByVisibility(W) must be called before.
+     */
+    template <typename UType, typename WType>
+    RecursiveClusterJacobiPreconditioner& factorizeSchur(const UType& U, const WType& Y, const WType& W)
+    {
+        eigen_assert(!pointPtr.empty() && U.rows() == n && Y.nonZeros() == W.nonZeros());
+        initClusterMatrices();
+
+        int numClusters = clusterPtr.size() - 1;
+#pragma omp parallel for schedule(dynamic)
+        for (int c = 0; c < numClusters; ++c)
+        {
+            auto& M = clusterMatrices[c];
+            for (int t = clusterPtr[c]; t < clusterPtr[c + 1]; ++t)
+            {
+                int i = clusterCams[t];
+                M.template block<BlockSize, BlockSize>(localIdx[i] * BlockSize, localIdx[i] * BlockSize) =
+                    U.diagonal()(i).get();
+            }
+
+            // Visit all points of the cameras in this cluster. Each point adds the products of all observation
+            // pairs (i,j) with i,j in this cluster. To count every pair once, only the first camera of the
+            // cluster, which observes the point, adds the products.
+            for (int t = clusterPtr[c]; t < clusterPtr[c + 1]; ++t)
+            {
+                int i = clusterCams[t];
+                for (Index p = W.outerIndexPtr()[i]; p < W.outerIndexPtr()[i + 1]; ++p)
+                {
+                    int point = W.innerIndexPtr()[p];
+                    int first = -1;
+                    for (int a = pointPtr[point]; a < pointPtr[point + 1]; ++a)
+                    {
+                        if (clusterOf[pointObs[a].first] == c)
+                        {
+                            first = pointObs[a].first;
+                            break;
+                        }
+                    }
+                    if (first != i) continue;
+
+                    for (int a = pointPtr[point]; a < pointPtr[point + 1]; ++a)
+                    {
+                        int ci = pointObs[a].first;
+                        if (clusterOf[ci] != c) continue;
+                        for (int b = a; b < pointPtr[point + 1]; ++b)
+                        {
+                            int cj = pointObs[b].first;
+                            if (clusterOf[cj] != c) continue;
+                            Block prod = Y.valuePtr()[pointObs[a].second].get() *
+                                         W.valuePtr()[pointObs[b].second].get().transpose();
+                            M.template block<BlockSize, BlockSize>(localIdx[ci] * BlockSize,
+                                                                   localIdx[cj] * BlockSize) -= prod;
+                            if (ci != cj)
+                            {
+                                M.template block<BlockSize, BlockSize>(localIdx[cj] * BlockSize,
+                                                                       localIdx[ci] * BlockSize) -= prod.transpose();
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        factorizeClusters();
+        return *this;
+    }
+
+    template <typename Rhs, typename Dest>
+    void _solve_impl(const Rhs& b, Dest& x) const
+    {
+        int numClusters = clusterPtr.size() - 1;
+        for (int c = 0; c < numClusters; ++c)
+        {
+            auto seg = tmp.segment(Index(clusterPtr[c]) * BlockSize, Index(clusterSize(c)) * BlockSize);
+            for (int t = clusterPtr[c]; t < clusterPtr[c + 1]; ++t)
+            {
+                seg.template segment<BlockSize>((t - clusterPtr[c]) * BlockSize) = b(clusterCams[t]).get();
+            }
+            clusterLDLT[c].solveInPlace(seg);
+            for (int t = clusterPtr[c]; t < clusterPtr[c + 1]; ++t)
+            {
+                x(clusterCams[t]).get() = seg.template segment<BlockSize>((t - clusterPtr[c]) * BlockSize);
+            }
+        }
+    }
+
+    template <typename Rhs>
+    inline const Eigen::Solve<RecursiveClusterJacobiPreconditioner, Rhs> solve(const Eigen::MatrixBase<Rhs>& b) const
+    {
+        eigen_assert(!clusterLDLT.empty() && "RecursiveClusterJacobiPreconditioner is not initialized.");
+        eigen_assert(n == b.rows());
+        return Eigen::Solve<RecursiveClusterJacobiPreconditioner, Rhs>(*this, b.derived());
+    }
+
+    Eigen::ComputationInfo info() { return Eigen::Success; }
+
+   protected:
+    struct Edge
+    {
+        int a, b, weight;
+    };
+
+    int n = 0;
+
+    // Cluster c contains the unknowns clusterCams[clusterPtr[c] ... clusterPtr[c+1]]
+    std::vector<int> clusterOf, localIdx, clusterPtr, clusterCams;
+
+    // Observations of each point: (camera, value index in W)
+    std::vector<int> pointPtr;
+    std::vector<std::pair<int, Index>> pointObs;
+
+    std::vector<DenseMatrix> clusterMatrices;
+    std::vector<Eigen::LDLT<DenseMatrix>> clusterLDLT;
+    mutable DenseVector tmp;
+
+    int clusterSize(int c) const { return clusterPtr[c + 1] - clusterPtr[c]; }
+
+    // Greedy agglomerative clustering: The edges are merged in order of decreasing weight as long as the merged
+    // cluster has at most maxClusterSize elements.
+    void buildClusters(std::vector<Edge>& edges)
+    {
+        std::stable_sort(edges.begin(), edges.end(), [](const Edge& e1, const Edge& e2) { return e1.weight > e2.weight; });
+
+        std::vector<int> parent(n), size(n, 1);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int i) {
+            while (parent[i] != i)
+            {
+                parent[i] = parent[parent[i]];
+                i         = parent[i];
+            }
+            return i;
+        };
+        for (auto& e : edges)
+        {
+            int r1 = find(e.a), r2 = find(e.b);
+            if (r1 == r2 || size[r1] + size[r2] > maxClusterSize) continue;
+            if (size[r1] < size[r2]) std::swap(r1, r2);
+            parent[r2] = r1;
+            size[r1] += size[r2];
+        }
+
+        // Number the clusters in order of their first element
+        clusterOf.assign(n, -1);
+        std::vector<int> rootId(n, -1);
+        int numClusters = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            int r = find(i);
+            if (rootId[r] == -1) rootId[r] = numClusters++;
+            clusterOf[i] = rootId[r];
+        }
+
+        clusterPtr.assign(numClusters + 1, 0);
+        for (int i = 0; i < n; ++i) clusterPtr[clusterOf[i] + 1]++;
+        for (int c = 0; c < numClusters; ++c) clusterPtr[c + 1] += clusterPtr[c];
+        clusterCams.resize(n);
+        localIdx.resize(n);
+        std::vector<int> pos(clusterPtr.begin(), clusterPtr.end() - 1);
+        for (int i = 0; i < n; ++i)
+        {
+            localIdx[i]                    = pos[clusterOf[i]] - clusterPtr[clusterOf[i]];
+            clusterCams[pos[clusterOf[i]]++] = i;
+        }
+
+        clusterMatrices.resize(numClusters);
+        clusterLDLT.resize(numClusters);
+        tmp.resize(Index(n) * BlockSize);
+    }
+
+    void initClusterMatrices()
+    {
+        for (int c = 0; c < numClusters(); ++c)
+        {
+            clusterMatrices[c].setZero(clusterSize(c) * BlockSize, clusterSize(c) * BlockSize);
+        }
+    }
+
+    void factorizeClusters()
+    {
+        int numClusters = clusterPtr.size() - 1;
+#pragma omp parallel for schedule(dynamic)
+        for (int c = 0; c < numClusters; ++c)
+        {
+            clusterLDLT[c].compute(clusterMatrices[c]);
+        }
+    }
+};
+
+}  // namespace Eigen::Recursive
@@ -0,0 +1,742 @@
+﻿/**
+ * This file is part of the Eigen Recursive Matrix Extension (ERME).
+ *
+ * Copyright (c) 2019 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#pragma once
+
+#include "../Core.h"
+#include "Eigen/OrderingMethods"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#if defined(_OPENMP)
+#    include <omp.h>
+#endif
+
+namespace Eigen::Recursive
+{
+/**
+ * A supernodal LDLT factorization for sparse block matrices of the form SparseMatrix<MatrixScalar<Block>>.
+ * The blocks must have a fixed size.
+ *
+ * analyzePattern:
+ *   - AMD ordering on the block pattern. The blocks are never split up by the ordering.
+ *   - Elimination tree + postorder on the block level.
+ *   - Fundamental supernodes + relaxed amalgamation (similar to CHOLMOD). Every supernode is stored as a dense
+ *     column major panel, which contains the diagonal block and all rows below it.
+ *
+ * factorize:
+ *   - Left looking. The updates from the descendants and the factorization of the panel itself are dense matrix
+ *     products (Eigen's GEMM), instead of the many small block products of the simplicial factorization.
+ *   - The supernodal elimination tree is processed level by level. The supernodes of one level are independent
+ *     and factorized in parallel with OpenMP. Levels with only one supernode (the root of the tree) use Eigen's
+ *     parallel GEMM instead.
+ *
+ * The interface is the same as the one of RecursiveSimplicialLDLT:
+ *
+ *   SupernodalLDLT<SparseMatrix<MatrixScalar<Matrix<double, 6, 6>>>, Eigen::Upper> ldlt;
+ *   ldlt.compute(A);
+ *   x = ldlt.solve(b);
+ *
+ *   // Same structure, new values
+ *   ldlt.factorize(A);
+ *
+ */
+template <typename _MatrixType, int _UpLo = Eigen::Upper>
+class SupernodalLDLT
+{
+   public:
+    using MatrixType   = _MatrixType;
+    using BlockScalar  = typename MatrixType::Scalar;
+    using BlockType    = typename BlockScalar::M;
+    using Scalar       = typename BlockType::Scalar;
+    using StorageIndex = typename MatrixType::StorageIndex;
+
+    using DenseMatrix = Eigen::Matrix<Scalar, -1, -1>;
+    using DenseVector = Eigen::Matrix<Scalar, -1, 1>;
+    using PanelMap    = Eigen::Map<DenseMatrix>;
+
+    static constexpr int BlockSize = BlockType::RowsAtCompileTime;
+    static constexpr int UpLo      = _UpLo;
+    static_assert(BlockSize > 0 && BlockSize == BlockType::ColsAtCompileTime,
+                  "Only fixed size square blocks are supported.");
+
+    // A column major block inside a panel
+    using PanelBlock = Eigen::Map<Eigen::Matrix<Scalar, BlockSize, BlockSize>, 0, Eigen::OuterStride<>>;
+
+    SupernodalLDLT() {}
+    SupernodalLDLT(const MatrixType& A) { compute(A); }
+
+    void compute(const MatrixType& A)
+    {
+        analyzePattern(A);
+        factorize(A);
+    }
+
+    // Computes the ordering, the supernodes and the memory layout of L.
+    void analyzePattern(const MatrixType& A);
+
+    // Same as above, but uses the given fill reducing ordering instead of computing AMD.
+    // ordering[i] is the row of A, which is eliminated in step i. Usually this is the ordering() of a previous
+    // factorization, for example after new rows and entries have been added to A.
+    void analyzePattern(const MatrixType& A, const std::vector<int>& ordering);
+
+    // The (postordered) fill reducing ordering of the last analyzePattern.
+    const std::vector<int>& ordering() const { return perm; }
+
+    // Numerical factorization. A must have the same structure as in analyzePattern.
+    void factorize(const MatrixType& A);
+
+    // Solves A x = b. The vector type is a block vector, for example Matrix<MatrixScalar<Vector6d>, -1, 1>.
+    template <typename VectorType>
+    VectorType solve(const VectorType& b) const;
+
+    // NumericalIssue if a zero or non-finite pivot was replaced by 1 during factorize. solve() then still returns a
+    // finite, but inaccurate result.
+    ComputationInfo info() const { return m_info; }
+
+    // Number of supernodes after amalgamation
+    int supernodes() const { return nsuper; }
+    // Number of scalars stored in the panels of L (including the explicit zeros of the amalgamation)
+    Index nonZeros() const { return values.size(); }
+
+    // Relaxed amalgamation parameters in scalar columns (see CHOLMOD: nrelax and zrelax).
+    // A child supernode is merged into its parent if the merged supernode has less than relaxColumns[i] columns
+    // and the fraction of explicit zeros is less than relaxZeros[i].
+    bool relaxedAmalgamation = true;
+    int relaxColumns[3]      = {4, 16, 48};
+    double relaxZeros[3]     = {0.8, 0.1, 0.05};
+
+   private:
+    struct AssemblyEntry
+    {
+        Index value;
+        Index offset;
+        bool transposed;
+    };
+
+    // The rows [begin, end) of the source supernode contribute to the columns of the target supernode.
+    // The rows [begin, rows(src).end) are updated.
+    struct Update
+    {
+        int src;
+        int begin, end;
+    };
+
+    struct Workspace
+    {
+        std::vector<int> relpos;
+        std::vector<Scalar> buffer;
+    };
+
+    ComputationInfo m_info   = Success;
+    bool m_analysisIsOk      = false;
+    bool m_factorizationIsOk = false;
+
+    // Number of block rows, number of supernodes and number of entries in A
+    int n = 0, nsuper = 0;
+    Index nnzA = 0;
+
+    // perm[i] is the row of A, which is eliminated in step i
+    std::vector<int> perm;
+
+    // Supernode s contains the block columns [snStart[s], snStart[s+1]).
+    // Its block rows are snRows[snRowPtr[s] ... snRowPtr[s+1]], including the diagonal.
+    std::vector<int> snStart, snRowPtr, snRows;
+    std::vector<Index> panelPtr;
+    std::vector<Scalar> values;
+
+    std::vector<int> updatePtr;
+    std::vector<Update> updates;
+
+    std::vector<int> assemblyPtr;
+    std::vector<AssemblyEntry> assembly;
+
+    // Supernodes grouped by their height in the supernodal elimination tree
+    std::vector<int> levelPtr, levelNodes;
+
+    int maxBelow = 0;
+    std::vector<Workspace> workspaces;
+
+    template <typename F>
+    static void forEachEntry(const MatrixType& A, F f);
+
+    void eliminationTree(const std::vector<int>& rowPtr, const std::vector<int>& rowIdx,
+                         std::vector<int>& parent) const;
+    void analyzePatternOrdered(const MatrixType& A, std::vector<int> amdPerm);
+    bool factorizeSupernode(int s, const BlockScalar* A, Workspace& ws);
+    bool denseLDLT(PanelMap& P, Workspace& ws);
+
+    int cols(int s) const { return snStart[s + 1] - snStart[s]; }
+    int rows(int s) const { return snRowPtr[s + 1] - snRowPtr[s]; }
+    PanelMap panel(int s)
+    {
+        return PanelMap(values.data() + panelPtr[s], rows(s) * BlockSize, cols(s) * BlockSize);
+    }
+    Eigen::Map<const DenseMatrix> panel(int s) const
+    {
+        return Eigen::Map<const DenseMatrix>(values.data() + panelPtr[s], rows(s) * BlockSize, cols(s) * BlockSize);
+    }
+};
+
+template <typename _MatrixType, int _UpLo>
+template <typename F>
+void SupernodalLDLT<_MatrixType, _UpLo>::forEachEntry(const MatrixType& A, F f)
+{
+    // Calls f(row, col, valueIndex) for all stored blocks in the referenced triangle.
+    for (Index k = 0; k < A.outerSize(); ++k)
+    {
+        Index begin = A.outerIndexPtr()[k];
+        Index end   = A.isCompressed() ? A.outerIndexPtr()[k + 1] : begin + A.innerNonZeroPtr()[k];
+        for (Index p = begin; p < end; ++p)
+        {
+            int inner = A.innerIndexPtr()[p];
+            int row   = MatrixType::IsRowMajor ? k : inner;
+            int col   = MatrixType::IsRowMajor ? inner : k;
+            if ((UpLo == Upper && row <= col) || (UpLo == Lower && row >= col))
+            {
+                f(row, col, p);
+            }
+        }
+    }
+}
+
+template <typename _MatrixType, int _UpLo>
+void SupernodalLDLT<_MatrixType, _UpLo>::eliminationTree(const std::vector<int>& rowPtr,
+                                                         const std::vector<int>& rowIdx,
+                                                         std::vector<int>& parent) const
+{
+    // Liu's algorithm with path compression. rowIdx contains the strictly lower pattern of each row.
+    std::vector<int> ancestor(n, -1);
+    parent.assign(n, -1);
+    for (int k = 0; k < n; ++k)
+    {
+        for (int p = rowPtr[k]; p < rowPtr[k + 1]; ++p)
+        {
+            int i = rowIdx[p];
+            while (i != -1 && i < k)
+            {
+                int next    = ancestor[i];
+                ancestor[i] = k;
+                if (next == -1) parent[i] = k;
+                i = next;
+            }
+        }
+    }
+}
+
+template <typename _MatrixType, int _UpLo>
+void SupernodalLDLT<_MatrixType, _UpLo>::analyzePattern(const MatrixType& A)
+{
+    eigen_assert(A.rows() == A.cols());
+    int size = A.rows();
+
+    // ============ Fill reducing ordering on the block pattern ============
+    std::vector<int> amdPerm(size);
+    {
+        std::vector<Eigen::Triplet<double, StorageIndex>> triplets;
+        triplets.reserve(2 * A.nonZeros() + size);
+        for (int i = 0; i < size; ++i) triplets.emplace_back(i, i, 1);
+        forEachEntry(A, [&](int row, int col, Index) {
+            if (row == col) return;
+            triplets.emplace_back(row, col, 1);
+            triplets.emplace_back(col, row, 1);
+        });
+        Eigen::SparseMatrix<double, Eigen::ColMajor, StorageIndex> pattern(size, size);
+        pattern.setFromTriplets(triplets.begin(), triplets.end());
+
+        // Note: The ordering methods compute the inverse permutation
+        Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, StorageIndex> pinv;
+        Eigen::AMDOrdering<StorageIndex> amd;
+        amd(pattern, pinv);
+        for (int i = 0; i < size; ++i) amdPerm[i] = pinv.indices()(i);
+    }
+    analyzePatternOrdered(A, amdPerm);
+}
+
+template <typename _MatrixType, int _UpLo>
+void SupernodalLDLT<_MatrixType, _UpLo>::analyzePattern(const MatrixType& A, const std::vector<int>& ordering)
+{
+    eigen_assert(A.rows() == A.cols());
+    eigen_assert((int)ordering.size() == A.rows());
+    analyzePatternOrdered(A, ordering);
+}
+
+template <typename _MatrixType, int _UpLo>
+void SupernodalLDLT<_MatrixType, _UpLo>::analyzePatternOrdered(const MatrixType& A, std::vector<int> amdPerm)
+{
+    n                   = A.rows();
+    nnzA                = A.nonZeros();
+    m_info              = Success;
+    m_analysisIsOk      = false;
+    m_factorizationIsOk = false;
+
+    // Strictly lower pattern of P A P^T stored by rows.
+    std::vector<int> rowPtr, rowIdx, iperm(n);
+    auto buildRows = [&](const std::vector<int>& p) {
+        for (int i = 0; i < n; ++i) iperm[p[i]] = i;
+        rowPtr.assign(n + 1, 0);
+        forEachEntry(A, [&](int row, int col, Index) {
+            if (row != col) rowPtr[std::max(iperm[row], iperm[col]) + 1]++;
+        });
+        for (int i = 0; i < n; ++i) rowPtr[i + 1] += rowPtr[i];
+        rowIdx.resize(rowPtr[n]);
+        std::vector<int> pos(rowPtr.begin(), rowPtr.end() - 1);
+        forEachEntry(A, [&](int row, int col, Index) {
+            if (row == col) return;
+            int a = iperm[row], b = iperm[col];
+            rowIdx[pos[std::max(a, b)]++] = std::min(a, b);
+        });
+    };
+
+    // ============ Elimination tree + postorder ============
+    std::vector<int> parent;
+    buildRows(amdPerm);
+    eliminationTree(rowPtr, rowIdx, parent);
+    {
+        // Postorder the tree. This makes the columns of a supernode and of every subtree contiguous.
+        std::vector<int> head(n, -1), next(n, -1), stack;
+        for (int j = n - 1; j >= 0; --j)
+        {
+            if (parent[j] == -1) continue;
+            next[j]         = head[parent[j]];
+            head[parent[j]] = j;
+        }
+        perm.clear();
+        perm.reserve(n);
+        for (int root = 0; root < n; ++root)
+        {
+            if (parent[root] != -1) continue;
+            stack.push_back(root);
+            while (!stack.empty())
+            {
+                int p     = stack.back();
+                int child = head[p];
+                if (child == -1)
+                {
+                    stack.pop_back();
+                    perm.push_back(amdPerm[p]);
+                }
+                else
+                {
+                    head[p] = next[child];
+                    stack.push_back(child);
+                }
+            }
+        }
+        eigen_assert((int)perm.size() == n);
+    }
+    buildRows(perm);
+    eliminationTree(rowPtr, rowIdx, parent);
+
+    // ============ Column structure of L (row subtrees) ============
+    std::vector<std::vector<int>> colStruct(n);
+    std::vector<int> mark(n, -1), numChildren(n, 0);
+    for (int k = 0; k < n; ++k)
+    {
+        mark[k] = k;
+        for (int p = rowPtr[k]; p < rowPtr[k + 1]; ++p)
+        {
+            for (int i = rowIdx[p]; mark[i] != k; i = parent[i])
+            {
+                colStruct[i].push_back(k);
+                mark[i] = k;
+            }
+        }
+        if (parent[k] != -1) numChildren[parent[k]]++;
+    }
+
+    // ============ Fundamental supernodes ============
+    std::vector<int> fundamental;
+    for (int j = 0; j < n; ++j)
+    {
+        bool extend = j > 0 && parent[j - 1] == j && colStruct[j - 1].size() == colStruct[j].size() + 1 &&
+                      numChildren[j] == 1;
+        if (!extend) fundamental.push_back(j);
+    }
+    fundamental.push_back(n);
+    int nfund = fundamental.size() - 1;
+
+    // ============ Relaxed amalgamation ============
+    // A child is merged into its parent if it is the supernode directly in front of the parent. The supernodes are
+    // traversed backwards, so the parent may already contain previously merged supernodes.
+    std::vector<Index> snCols(nfund), snRowsCount(nfund);
+    std::vector<double> snZeros(nfund, 0);
+    std::vector<char> absorbed(nfund, false);
+    auto denseEntries = [](double k, double m) { return k * (k + 1) / 2 + k * (m - k); };
+    for (int s = 0; s < nfund; ++s)
+    {
+        snCols[s]      = fundamental[s + 1] - fundamental[s];
+        snRowsCount[s] = colStruct[fundamental[s]].size() + 1;
+    }
+    if (relaxedAmalgamation)
+    {
+        for (int s = nfund - 2; s >= 0; --s)
+        {
+            int lastCol = fundamental[s + 1] - 1;
+            if (parent[lastCol] != fundamental[s + 1]) continue;
+
+            Index k      = snCols[s] + snCols[s + 1];
+            Index m      = snCols[s] + snRowsCount[s + 1];
+            double total = denseEntries(k, m);
+            double zeros = total - (denseEntries(snCols[s], snRowsCount[s]) - snZeros[s]) -
+                           (denseEntries(snCols[s + 1], snRowsCount[s + 1]) - snZeros[s + 1]);
+
+            Index scalarCols = k * BlockSize;
+            double fraction  = zeros / total;
+            bool merge       = scalarCols <= relaxColumns[0] || (scalarCols <= relaxColumns[1] && fraction < relaxZeros[0]) ||
+                         (scalarCols <= relaxColumns[2] && fraction < relaxZeros[1]) || fraction < relaxZeros[2];
+            if (merge)
+            {
+                snCols[s]        = k;
+                snRowsCount[s]   = m;
+                snZeros[s]       = zeros;
+                absorbed[s + 1] = true;
+            }
+        }
+    }
+
+    snStart.clear();
+    for (int s = 0; s < nfund; ++s)
+    {
+        if (!absorbed[s]) snStart.push_back(fundamental[s]);
+    }
+    snStart.push_back(n);
+    nsuper = snStart.size() - 1;
+
+    std::vector<int> col2sn(n);
+    for (int s = 0; s < nsuper; ++s)
+    {
+        for (int j = snStart[s]; j < snStart[s + 1]; ++j) col2sn[j] = s;
+    }
+
+    // ============ Row structure of the supernodes ============
+    std::fill(mark.begin(), mark.end(), -1);
+    snRowPtr.assign(nsuper + 1, 0);
+    snRows.clear();
+    maxBelow = 0;
+    for (int s = 0; s < nsuper; ++s)
+    {
+        int end = snStart[s + 1];
+        for (int j = snStart[s]; j < end; ++j) snRows.push_back(j);
+        auto belowBegin = snRows.size();
+        for (int j = snStart[s]; j < end; ++j)
+        {
+            for (auto r : colStruct[j])
+            {
+                if (r >= end && mark[r] != s)
+                {
+                    mark[r] = s;
+                    snRows.push_back(r);
+                }
+            }
+        }
+        std::sort(snRows.begin() + belowBegin, snRows.end());
+        snRowPtr[s + 1] = snRows.size();
+        maxBelow        = std::max<int>(maxBelow, snRows.size() - belowBegin);
+    }
+    colStruct.clear();
+
+    panelPtr.resize(nsuper + 1);
+    panelPtr[0] = 0;
+    for (int s = 0; s < nsuper; ++s)
+    {
+        panelPtr[s + 1] = panelPtr[s] + Index(rows(s)) * BlockSize * Index(cols(s)) * BlockSize;
+    }
+    values.resize(panelPtr[nsuper]);
+
+    // ============ Descendant updates ============
+    // The rows of a supernode are sorted, therefore all rows, which belong to one ancestor, are contiguous.
+    std::vector<Update> tmpUpdates;
+    for (int d = 0; d < nsuper; ++d)
+    {
+        int p   = snRowPtr[d] + cols(d);
+        int end = snRowPtr[d + 1];
+        while (p < end)
+        {
+            int target = col2sn[snRows[p]];
+            int begin  = p;
+            while (p < end && col2sn[snRows[p]] == target) ++p;
+            tmpUpdates.push_back({d, begin - snRowPtr[d], p - snRowPtr[d]});
+        }
+    }
+    updatePtr.assign(nsuper + 1, 0);
+    for (auto& u : tmpUpdates) updatePtr[col2sn[snRows[snRowPtr[u.src] + u.begin]] + 1]++;
+    for (int s = 0; s < nsuper; ++s) updatePtr[s + 1] += updatePtr[s];
+    updates.resize(tmpUpdates.size());
+    {
+        std::vector<int> pos(updatePtr.begin(), updatePtr.end() - 1);
+        for (auto& u : tmpUpdates) updates[pos[col2sn[snRows[snRowPtr[u.src] + u.begin]]]++] = u;
+    }
+
+    // ============ Assembly map: A -> panels ============
+    for (int i = 0; i < n; ++i) iperm[perm[i]] = i;
+    std::vector<AssemblyEntry> tmpAssembly;
+    std::vector<int> tmpTarget;
+    forEachEntry(A, [&](int row, int col, Index p) {
+        int a = iperm[row], b = iperm[col];
+        int r = std::max(a, b), c = std::min(a, b);
+        int s = col2sn[c];
+
+        auto rowBegin = snRows.begin() + snRowPtr[s];
+        auto rowEnd   = snRows.begin() + snRowPtr[s + 1];
+        Index lr      = std::lower_bound(rowBegin, rowEnd, r) - rowBegin;
+        Index lc      = c - snStart[s];
+        eigen_assert(lr < rows(s) && *(rowBegin + lr) == r);
+
+        Index ld = Index(rows(s)) * BlockSize;
+        tmpAssembly.push_back({p, panelPtr[s] + lc * BlockSize * ld + lr * BlockSize, a < b});
+        tmpTarget.push_back(s);
+    });
+    assemblyPtr.assign(nsuper + 1, 0);
+    for (auto s : tmpTarget) assemblyPtr[s + 1]++;
+    for (int s = 0; s < nsuper; ++s) assemblyPtr[s + 1] += assemblyPtr[s];
+    assembly.resize(tmpAssembly.size());
+    {
+        std::vector<int> pos(assemblyPtr.begin(), assemblyPtr.end() - 1);
+        for (size_t i = 0; i < tmpAssembly.size(); ++i) assembly[pos[tmpTarget[i]]++] = tmpAssembly[i];
+    }
+
+    // ============ Level sets of the supernodal elimination tree ============
+    // Children have a smaller index than their parent (postorder).
+    std::vector<int> level(nsuper, 0);
+    int numLevels = nsuper > 0 ? 1 : 0;
+    for (int s = 0; s < nsuper; ++s)
+    {
+        if (rows(s) == cols(s)) continue;
+        int sparent    = col2sn[snRows[snRowPtr[s] + cols(s)]];
+        level[sparent] = std::max(level[sparent], level[s] + 1);
+        numLevels      = std::max(numLevels, level[sparent] + 1);
+    }
+    levelPtr.assign(numLevels + 1, 0);
+    for (int s = 0; s < nsuper; ++s) levelPtr[level[s] + 1]++;
+    for (int l = 0; l < numLevels; ++l) levelPtr[l + 1] += levelPtr[l];
+    levelNodes.resize(nsuper);
+    {
+        std::vector<int> pos(levelPtr.begin(), levelPtr.end() - 1);
+        for (int s = 0; s < nsuper; ++s) levelNodes[pos[level[s]]++] = s;
+    }
+
+    m_analysisIsOk = true;
+}
+
+template <typename _MatrixType, int _UpLo>
+void SupernodalLDLT<_MatrixType, _UpLo>::factorize(const MatrixType& A)
+{
+    eigen_assert(m_analysisIsOk && "You must first call analyzePattern()");
+    eigen_assert(A.rows() == n && A.nonZeros() == nnzA);
+
+#if defined(_OPENMP)
+    int threads = omp_get_max_threads();
+#else
+    int threads = 1;
+#endif
+    workspaces.resize(threads);
+    for (auto& ws : workspaces) ws.relpos.resize(n);
+
+    std::atomic<bool> ok = true;
+    const BlockScalar* a = A.valuePtr();
+    for (size_t l = 0; l + 1 < levelPtr.size(); ++l)
+    {
+        int begin = levelPtr[l];
+        int count = levelPtr[l + 1] - begin;
+        if (count == 1)
+        {
+            // Let Eigen parallelize the dense operations of this supernode
+            if (!factorizeSupernode(levelNodes[begin], a, workspaces[0])) ok = false;
+            continue;
+        }
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < count; ++i)
+        {
+#if defined(_OPENMP)
+            auto& ws = workspaces[omp_get_thread_num()];
+#else
+            auto& ws = workspaces[0];
+#endif
+            if (!factorizeSupernode(levelNodes[begin + i], a, ws)) ok = false;
+        }
+    }
+
+    m_info              = ok ? Success : NumericalIssue;
+    m_factorizationIsOk = true;
+}
+
+template <typename _MatrixType, int _UpLo>
+bool SupernodalLDLT<_MatrixType, _UpLo>::factorizeSupernode(int s, const BlockScalar* A, Workspace& ws)
+{
+    const int f  = snStart[s];
+    const int* R = snRows.data() + snRowPtr[s];
+    PanelMap P   = panel(s);
+    const Index M = P.rows();
+
+    // Assemble the entries of A
+    P.setZero();
+    for (int i = assemblyPtr[s]; i < assemblyPtr[s + 1]; ++i)
+    {
+        auto& e = assembly[i];
+        PanelBlock dst(values.data() + e.offset, Eigen::OuterStride<>(M));
+        if (e.transposed)
+            dst = A[e.value].get().transpose();
+        else
+            dst = A[e.value].get();
+    }
+
+    for (int t = 0; t < rows(s); ++t) ws.relpos[R[t]] = t;
+
+    // Updates from all descendants: P -= L_d * D_d * L_d^T
+    for (int i = updatePtr[s]; i < updatePtr[s + 1]; ++i)
+    {
+        auto& u          = updates[i];
+        const int* DR    = snRows.data() + snRowPtr[u.src];
+        PanelMap Ld      = panel(u.src);
+        const Index Kd   = Ld.cols();
+        const int nc     = u.end - u.begin;
+        const int nr     = rows(u.src) - u.begin;
+        const Index size = Index(nc) * BlockSize * Kd + Index(nr) * BlockSize * nc * BlockSize;
+        if ((Index)ws.buffer.size() < size) ws.buffer.resize(size);
+
+        PanelMap W(ws.buffer.data(), nc * BlockSize, Kd);
+        PanelMap U(ws.buffer.data() + W.size(), nr * BlockSize, nc * BlockSize);
+        W.noalias() = Ld.block(u.begin * BlockSize, 0, nc * BlockSize, Kd) * Ld.diagonal().asDiagonal();
+        U.noalias() = Ld.block(u.begin * BlockSize, 0, nr * BlockSize, Kd) * W.transpose();
+
+        // Scatter the lower part of U into the panel
+        for (int q = 0; q < nc; ++q)
+        {
+            int lc = DR[u.begin + q] - f;
+            for (int t = q; t < nr; ++t)
+            {
+                int lr = ws.relpos[DR[u.begin + t]];
+                P.template block<BlockSize, BlockSize>(lr * BlockSize, lc * BlockSize) -=
+                    U.template block<BlockSize, BlockSize>(t * BlockSize, q * BlockSize);
+            }
+        }
+    }
+
+    return denseLDLT(P, ws);
+}
+
+template <typename _MatrixType, int _UpLo>
+bool SupernodalLDLT<_MatrixType, _UpLo>::denseLDLT(PanelMap& P, Workspace& ws)
+{
+    // Blocked right looking LDLT without pivoting of the dense panel
+    //   [A11]   [L11]
+    //   [A21] = [L21] D L11^T
+    // D is stored on the diagonal. Only the lower triangle of A11 is referenced.
+    const Index M   = P.rows();
+    const Index K   = P.cols();
+    constexpr int nb = 32;
+    bool ok         = true;
+
+    for (Index jb = 0; jb < K; jb += nb)
+    {
+        const Index w = std::min<Index>(nb, K - jb);
+
+        // Unblocked factorization of the columns [jb, jb+w)
+        for (Index j = jb; j < jb + w; ++j)
+        {
+            Scalar d = P(j, j);
+            if (d == Scalar(0) || !std::isfinite(d))
+            {
+                // Continue with a unit pivot, so that the trailing update and solve() stay finite.
+                ok      = false;
+                d       = Scalar(1);
+                P(j, j) = d;
+            }
+            for (Index c = j + 1; c < jb + w; ++c)
+            {
+                Scalar factor = P(c, j) / d;
+                P.col(c).segment(c, M - c) -= factor * P.col(j).segment(c, M - c);
+            }
+            P.col(j).tail(M - j - 1) /= d;
+        }
+
+        // Rank w update of the trailing columns
+        const Index r0 = jb + w;
+        if (r0 < K)
+        {
+            if ((Index)ws.buffer.size() < (K - r0) * w) ws.buffer.resize((K - r0) * w);
+            PanelMap W(ws.buffer.data(), K - r0, w);
+            auto Lw     = P.block(r0, jb, M - r0, w);
+            W.noalias() = Lw.topRows(K - r0) * P.diagonal().segment(jb, w).asDiagonal();
+
+            P.block(r0, r0, K - r0, K - r0).template triangularView<Eigen::Lower>() -=
+                Lw.topRows(K - r0) * W.transpose();
+            if (M > K) P.block(K, r0, M - K, K - r0).noalias() -= Lw.bottomRows(M - K) * W.transpose();
+        }
+    }
+    return ok;
+}
+
+template <typename _MatrixType, int _UpLo>
+template <typename VectorType>
+VectorType SupernodalLDLT<_MatrixType, _UpLo>::solve(const VectorType& b) const
+{
+    eigen_assert(m_factorizationIsOk && "The matrix should be factorized first");
+    eigen_assert(b.rows() == n);
+
+    DenseVector y(Index(n) * BlockSize);
+    DenseVector tmp(Index(maxBelow) * BlockSize);
+    for (int i = 0; i < n; ++i) y.template segment<BlockSize>(i * BlockSize) = b(perm[i]).get();
+
+    // L y = b
+    for (int s = 0; s < nsuper; ++s)
+    {
+        auto L    = panel(s);
+        Index K   = L.cols();
+        Index B   = L.rows() - K;
+        auto xs   = y.segment(Index(snStart[s]) * BlockSize, K);
+        const int* R = snRows.data() + snRowPtr[s] + cols(s);
+
+        L.topLeftCorner(K, K).template triangularView<Eigen::UnitLower>().solveInPlace(xs);
+        if (B == 0) continue;
+        auto t      = tmp.head(B);
+        t.noalias() = L.bottomRows(B) * xs;
+        for (int i = 0; i < B / BlockSize; ++i)
+        {
+            y.template segment<BlockSize>(R[i] * BlockSize) -= t.template segment<BlockSize>(i * BlockSize);
+        }
+    }
+
+    // D y = y
+    for (int s = 0; s < nsuper; ++s)
+    {
+        auto L = panel(s);
+        y.segment(Index(snStart[s]) * BlockSize, L.cols()).array() /= L.diagonal().array();
+    }
+
+    // L^T y = y
+    for (int s = nsuper - 1; s >= 0; --s)
+    {
+        auto L    = panel(s);
+        Index K   = L.cols();
+        Index B   = L.rows() - K;
+        auto xs   = y.segment(Index(snStart[s]) * BlockSize, K);
+        const int* R = snRows.data() + snRowPtr[s] + cols(s);
+
+        if (B > 0)
+        {
+            auto t = tmp.head(B);
+            for (int i = 0; i < B / BlockSize; ++i)
+            {
+                t.template segment<BlockSize>(i * BlockSize) = y.template segment<BlockSize>(R[i] * BlockSize);
+            }
+            xs.noalias() -= L.bottomRows(B).transpose() * t;
+        }
+        L.topLeftCorner(K, K).transpose().template triangularView<Eigen::UnitUpper>().solveInPlace(xs);
+    }
+
+    VectorType x(n);
+    for (int i = 0; i < n; ++i) x(perm[i]).get() = y.template segment<BlockSize>(i * BlockSize);
+    return x;
+}
+
+}  // namespace Eigen::Recursive
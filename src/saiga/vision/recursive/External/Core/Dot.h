@@ -38,11 +38,13 @@ struct DotImpl<double>
     static double get(double a, double b) { return a * b; }
 };
 
+// Float vectors are accumulated in double precision. This keeps the CG iteration of the mixed precision solvers
+// (float blocks) stable for large systems.
 template <>
 struct DotImpl<float>
 {
-    using BaseType = float;
-    static float get(float a, float b) { return a * b; }
+    using BaseType = double;
+    static double get(float a, float b) { return double(a) * double(b); }
 };
 
 template <typename G>
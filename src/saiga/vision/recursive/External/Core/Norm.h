@@ -41,11 +41,12 @@ struct SquaredNormImpl<double>
     static double get(double d) { return d * d; }
 };
 
+// Accumulated in double precision (see DotImpl<float>)
 template <>
 struct SquaredNormImpl<float>
 {
-    using BaseType = float;
-    static float get(float d) { return d * d; }
+    using BaseType = double;
+    static double get(float d) { return double(d) * double(d); }
 };
 
 template <typename G>
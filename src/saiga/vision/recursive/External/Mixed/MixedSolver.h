@@ -24,6 +24,27 @@ struct LinearSolverOptions
     int maxIterativeIterations = 50;
     double iterativeTolerance  = 1e-5;
 
+    // Preconditioner of the iterative solver (see Cholesky/Preconditioner.h).
+    // SSOR and IncompleteCholesky require an explicit (Schur) matrix. ClusterJacobi clusters the cameras by their
+    // covisibility and also works with the implicit Schur complement.
+    enum class PreconditionerType : int
+    {
+        BlockJacobi        = 0,
+        SSOR               = 1,
+        IncompleteCholesky = 2,
+        ClusterJacobi      = 3
+    };
+    PreconditionerType preconditioner = PreconditionerType::BlockJacobi;
+    double ssorOmega                  = 1.0;
+    int icFillLevel                   = 0;
+    int clusterSize                   = 8;
+
+    // Iterative refinement steps after the solve: r = b - Ax, solve A dx = r, x += dx.
+    // The direct solvers reuse the factorization and compute r and x in double precision (see iterativeRefinement),
+    // which makes the refinement useful for float blocks (BARecMixed, PGORecMixed). The CG solver is restarted from
+    // the current solution, which recomputes the (drifted) residual in the precision of the blocks.
+    int refinementSteps = 0;
+
     // Schur complement options (not used by every solver)
     bool buildExplizitSchur = false;
 
@@ -31,6 +52,10 @@ struct LinearSolverOptions
     // -> Maybe in the future when I have implemented a supernodal recursive factorization
     //      I switch it back to false ;)
     bool cholmod = true;
+
+    // Sparse direct solves without cholmod: SupernodalLDLT (true) or RecursiveSimplicialLDLT (false).
+    // The supernodal factorization is much faster for larger systems with a lot of fill-in (BA, PGO with loops).
+    bool supernodal = true;
 };
 
 /**
@@ -42,5 +67,58 @@ struct MixedSymmetricRecursiveSolver
 {
 };
 
+/**
+ * Iterative refinement of the solution x of A x = b. A is a symmetric sparse block matrix of which only the upper
+ * triangle is used. solve(r, dx) approximately solves A dx = r, for example with an existing factorization.
+ *
+ * The residual r = b - A x and the solution x are computed in double, also if A, b and x have float blocks.
+ * Otherwise the refinement of a float system could not get below the accuracy of float.
+ */
+template <typename MatrixType, typename VectorType, typename SolveFunction>
+void iterativeRefinement(const MatrixType& A, const VectorType& b, VectorType& x, int steps, SolveFunction&& solve)
+{
+    if (steps <= 0) return;
+
+    using Block             = typename VectorType::Scalar::M;
+    using Scalar            = typename Block::Scalar;
+    constexpr int BlockSize = Block::RowsAtCompileTime;
+
+    const int n = A.rows();
+    Eigen::Matrix<double, -1, 1> xd(Index(n) * BlockSize), rd(Index(n) * BlockSize);
+    for (int i = 0; i < n; ++i) xd.template segment<BlockSize>(i * BlockSize) = x(i).get().template cast<double>();
+
+    VectorType r(n), dx(n);
+    for (int k = 0; k < steps; ++k)
+    {
+        for (int i = 0; i < n; ++i) rd.template segment<BlockSize>(i * BlockSize) = b(i).get().template cast<double>();
+
+        for (int i = 0; i < A.outerSize(); ++i)
+        {
+            for (typename MatrixType::InnerIterator it(A, i); it; ++it)
+            {
+                const int row = it.row();
+                const int col = it.col();
+                if (row > col) continue;
+                Eigen::Matrix<double, BlockSize, BlockSize> Ab = it.value().get().template cast<double>();
+                rd.template segment<BlockSize>(row * BlockSize) -= Ab * xd.template segment<BlockSize>(col * BlockSize);
+                if (row != col)
+                {
+                    rd.template segment<BlockSize>(col * BlockSize) -=
+                        Ab.transpose() * xd.template segment<BlockSize>(row * BlockSize);
+                }
+            }
+        }
+
+        for (int i = 0; i < n; ++i) r(i).get() = rd.template segment<BlockSize>(i * BlockSize).template cast<Scalar>();
+        solve(r, dx);
+        for (int i = 0; i < n; ++i)
+        {
+            xd.template segment<BlockSize>(i * BlockSize) += dx(i).get().template cast<double>();
+        }
+    }
+
+    for (int i = 0; i < n; ++i) x(i).get() = xd.template segment<BlockSize>(i * BlockSize).template cast<Scalar>();
+}
+
 
 }  // namespace Eigen::Recursive
@@ -59,8 +59,9 @@ class MixedSymmetricRecursiveSolver<
     using S1Type = Eigen::SparseMatrix<UBlock, Eigen::RowMajor>;
     using S2Type = Eigen::SparseMatrix<VBlock, Eigen::RowMajor>;
 
-    using LDLT         = Eigen::RecursiveSimplicialLDLT<S1Type, Eigen::Upper>;
-    using InnerSolver1 = MixedSymmetricRecursiveSolver<S1Type, XUType>;
+    using LDLT           = Eigen::RecursiveSimplicialLDLT<S1Type, Eigen::Upper>;
+    using SupernodalLDLT = Eigen::Recursive::SupernodalLDLT<S1Type, Eigen::Upper>;
+    using InnerSolver1   = MixedSymmetricRecursiveSolver<S1Type, XUType>;
 
 
     void resize(int n, int m)
@@ -87,6 +88,7 @@ class MixedSymmetricRecursiveSolver<
             hasWT         = true;
             explizitSchur = true;
             ldlt          = nullptr;
+            sldlt         = nullptr;
         }
         else
         {
@@ -96,6 +98,12 @@ class MixedSymmetricRecursiveSolver<
                 explizitSchur = true;
             else
                 explizitSchur = false;
+
+            if (solverOptions.preconditioner == LinearSolverOptions::PreconditionerType::ClusterJacobi)
+            {
+                clusterP.maxClusterSize = solverOptions.clusterSize;
+                clusterP.clusterByVisibility(A.w);
+            }
         }
 
         if (hasWT)
@@ -151,34 +159,79 @@ class MixedSymmetricRecursiveSolver<
         if (solverOptions.solverType == LinearSolverOptions::SolverType::Direct)
         {
             // Direct recusive ldlt solver
-            if (!ldlt)
+            if (solverOptions.supernodal)
             {
-                ldlt = std::make_unique<LDLT>();
-                ldlt->compute(S1);
+                if (!sldlt)
+                {
+                    sldlt = std::make_unique<SupernodalLDLT>();
+                    sldlt->compute(S1);
+                }
+                else
+                {
+                    sldlt->factorize(S1);
+                }
             }
             else
             {
-                ldlt->factorize(S1);
+                if (!ldlt)
+                {
+                    ldlt = std::make_unique<LDLT>();
+                    ldlt->compute(S1);
+                }
+                else
+                {
+                    ldlt->factorize(S1);
+                }
             }
-            da = ldlt->solve(ej);
+            solveFactorized(ej, da, solverOptions);
+
+            // Iterative refinement with the existing factorization
+            iterativeRefinement(S1, ej, da, solverOptions.refinementSteps,
+                                [&](const XUType& r, XUType& dx) { solveFactorized(r, dx, solverOptions); });
         }
         else
         {
-            P.compute(S1);
-
             da.setZero();
 
             // Iterative CG solver
-            Eigen::Index iters = solverOptions.maxIterativeIterations;
-            double tol         = solverOptions.iterativeTolerance;
-            //            XUType tmp(n);
+            // Each refinement step restarts CG from the current solution
+            auto cg = [&](const auto& precond) {
+                cgIterations = 0;
+                for (int k = 0; k <= solverOptions.refinementSteps; ++k)
+                {
+                    Eigen::Index iters = solverOptions.maxIterativeIterations;
+                    double tol         = solverOptions.iterativeTolerance;
+                    recursive_conjugate_gradient(
+                        [&](const XUType& v, XUType& result) {
+                            // x = U * p - Y * WT * p
+                            result = S1.template selfadjointView<Eigen::Upper>() * v;
+                        },
+                        ej, da, precond, iters, tol);
+                    cgIterations += iters;
+                }
+            };
 
-            recursive_conjugate_gradient(
-                [&](const XUType& v, XUType& result) {
-                    // x = U * p - Y * WT * p
-                    result = S1.template selfadjointView<Eigen::Upper>() * v;
-                },
-                ej, da, P, iters, tol);
+            switch (solverOptions.preconditioner)
+            {
+                case LinearSolverOptions::PreconditionerType::SSOR:
+                    ssorP.omega = solverOptions.ssorOmega;
+                    ssorP.compute(S1);
+                    cg(ssorP);
+                    break;
+                case LinearSolverOptions::PreconditionerType::IncompleteCholesky:
+                    icP.fillLevel = solverOptions.icFillLevel;
+                    icP.compute(S1);
+                    cg(icP);
+                    break;
+                case LinearSolverOptions::PreconditionerType::ClusterJacobi:
+                    clusterP.factorize(S1);
+                    cg(clusterP);
+                    break;
+                default:
+                    P.compute(S1);
+                    cg(P);
+                    break;
+            }
         }
 
 
@@ -198,7 +251,19 @@ class MixedSymmetricRecursiveSolver<
 
 
 
+    // Number of CG iterations of the last iterative solve
+    int iterations() const { return cgIterations; }
+
    private:
+    // Solve S * x = rhs with the current factorization
+    void solveFactorized(const XUType& rhs, XUType& result, const LinearSolverOptions& solverOptions)
+    {
+        if (solverOptions.supernodal)
+            result = sldlt->solve(rhs);
+        else
+            result = ldlt->solve(rhs);
+    }
+
     int n, m;
 
     // ==== Solver tmps ====
@@ -212,14 +277,19 @@ class MixedSymmetricRecursiveSolver<
     AWTType WT;
 
     RecursiveDiagonalPreconditioner<UBlock> P;
+    RecursiveSSORPreconditioner<S1Type> ssorP;
+    RecursiveIncompleteCholeskyPreconditioner<S1Type> icP;
+    RecursiveClusterJacobiPreconditioner<UBlock> clusterP;
     S1Type S1;
     //    InnerSolver1 solver1;
 
     std::unique_ptr<LDLT> ldlt;
+    std::unique_ptr<SupernodalLDLT> sldlt;
 
     bool patternAnalyzed = false;
     bool hasWT           = true;
     bool explizitSchur   = true;
+    int cgIterations     = 0;
 };
 
 
@@ -268,8 +338,9 @@ class MixedSymmetricRecursiveSolver<
     using S1Type = Eigen::SparseMatrix<UBlock, Eigen::RowMajor>;
     using S2Type = Eigen::SparseMatrix<VBlock, Eigen::RowMajor>;
 
-    using LDLT         = Eigen::RecursiveSimplicialLDLT<S1Type, Eigen::Upper>;
-    using InnerSolver1 = MixedSymmetricRecursiveSolver<S1Type, XUType>;
+    using LDLT           = Eigen::RecursiveSimplicialLDLT<S1Type, Eigen::Upper>;
+    using SupernodalLDLT = Eigen::Recursive::SupernodalLDLT<S1Type, Eigen::Upper>;
+    using InnerSolver1   = MixedSymmetricRecursiveSolver<S1Type, XUType>;
 
 
     void resize(int n, int m)
@@ -297,6 +368,7 @@ class MixedSymmetricRecursiveSolver<
             hasWT         = true;
             explizitSchur = true;
             ldlt          = nullptr;
+            sldlt         = nullptr;
         }
         else
         {
@@ -306,6 +378,17 @@ class MixedSymmetricRecursiveSolver<
                 explizitSchur = true;
             else
                 explizitSchur = false;
+
+            // SSOR and IC need the off-diagonal blocks of S
+            using PT = LinearSolverOptions::PreconditionerType;
+            if (solverOptions.preconditioner == PT::SSOR || solverOptions.preconditioner == PT::IncompleteCholesky)
+                explizitSchur = true;
+
+            if (solverOptions.preconditioner == PT::ClusterJacobi)
+            {
+                clusterP.maxClusterSize = solverOptions.clusterSize;
+                clusterP.clusterByVisibility(A.w);
+            }
         }
 
         if (hasWT)
@@ -364,61 +447,106 @@ class MixedSymmetricRecursiveSolver<
         if (solverOptions.solverType == LinearSolverOptions::SolverType::Direct)
         {
             // Direct recusive ldlt solver
-            if (!ldlt)
+            if (solverOptions.supernodal)
             {
-                ldlt = std::make_unique<LDLT>();
-                ldlt->compute(S1);
+                if (!sldlt)
+                {
+                    sldlt = std::make_unique<SupernodalLDLT>();
+                    sldlt->compute(S1);
+                }
+                else
+                {
+                    sldlt->factorize(S1);
+                }
             }
             else
             {
-                ldlt->factorize(S1);
+                if (!ldlt)
+                {
+                    ldlt = std::make_unique<LDLT>();
+                    ldlt->compute(S1);
+                }
+                else
+                {
+                    ldlt->factorize(S1);
+                }
             }
-            da = ldlt->solve(ej);
+            solveFactorized(ej, da, solverOptions);
+
+            // Iterative refinement with the existing factorization
+            iterativeRefinement(S1, ej, da, solverOptions.refinementSteps,
+                                [&](const XUType& r, XUType& dx) { solveFactorized(r, dx, solverOptions); });
         }
         else
         {
-            if (explizitSchur)
-            {
-                P.compute(S1);
-            }
-            else
-            {
-                P.compute(Sdiag);
-            }
             da.setZero();
 
             // Iterative CG solver
-            Eigen::Index iters = solverOptions.maxIterativeIterations;
-            double tol         = solverOptions.iterativeTolerance;
-            //            XUType tmp(n);
-
-            recursive_conjugate_gradient(
-                [&](const XUType& v, XUType& result) {
-                    // x = U * p - Y * WT * p
-                    if (explizitSchur)
+            auto applyS = [&](const XUType& v, XUType& result) {
+                // x = U * p - Y * WT * p
+                if (explizitSchur)
+                {
+                    //                    if constexpr (denseSchur)
+                    //                        denseMV(S1, v, result);
+                    //                    else
+                    result = S1.template selfadjointView<Eigen::Upper>() * v;
+                    //                    std::cout << expand(result) << std::endl << std::endl;
+                }
+                else
+                {
+                    if (hasWT)
                     {
-                        //                    if constexpr (denseSchur)
-                        //                        denseMV(S1, v, result);
-                        //                    else
-                        result = S1.template selfadjointView<Eigen::Upper>() * v;
-                        //                    std::cout << expand(result) << std::endl << std::endl;
+                        tmp = Y * (WT * v);
                     }
                     else
                     {
-                        if (hasWT)
-                        {
-                            tmp = Y * (WT * v);
-                        }
-                        else
-                        {
-                            multSparseRowTransposedVector(W, v, q);
-                            tmp = Y * q;
-                        }
-                        result = (U.diagonal().array() * v.array()) - tmp.array();
-                        //                    std::cout << expand(result) << std::endl << std::endl;
+                        multSparseRowTransposedVector(W, v, q);
+                        tmp = Y * q;
                     }
-                },
-                ej, da, P, iters, tol);
+                    result = (U.diagonal().array() * v.array()) - tmp.array();
+                    //                    std::cout << expand(result) << std::endl << std::endl;
+                }
+            };
+
+            // Each refinement step restarts CG from the current solution
+            auto cg = [&](const auto& precond) {
+                cgIterations = 0;
+                for (int k = 0; k <= solverOptions.refinementSteps; ++k)
+                {
+                    Eigen::Index iters = solverOptions.maxIterativeIterations;
+                    double tol         = solverOptions.iterativeTolerance;
+                    recursive_conjugate_gradient(applyS, ej, da, precond, iters, tol);
+                    cgIterations += iters;
+                }
+            };
+
+            switch (solverOptions.preconditioner)
+            {
+                case LinearSolverOptions::PreconditionerType::SSOR:
+                    ssorP.omega = solverOptions.ssorOmega;
+                    ssorP.compute(S1);
+                    cg(ssorP);
+                    break;
+                case LinearSolverOptions::PreconditionerType::IncompleteCholesky:
+                    icP.fillLevel = solverOptions.icFillLevel;
+                    icP.compute(S1);
+                    cg(icP);
+                    break;
+                case LinearSolverOptions::PreconditionerType::ClusterJacobi:
+                    if (explizitSchur)
+                        clusterP.factorize(S1);
+                    else
+                        clusterP.factorizeSchur(U, Y, W);
+                    cg(clusterP);
+                    break;
+                default:
+                    if (explizitSchur)
+                        P.compute(S1);
+                    else
+                        P.compute(Sdiag);
+                    cg(P);
+                    break;
+            }
         }
 
 
@@ -544,7 +672,19 @@ class MixedSymmetricRecursiveSolver<
         multDiagVector_omp(Vinv, q, db);
     }
 
+    // Number of CG iterations of the last iterative solve
+    int iterations() const { return cgIterations; }
+
    private:
+    // Solve S * x = rhs with the current factorization
+    void solveFactorized(const XUType& rhs, XUType& result, const LinearSolverOptions& solverOptions)
+    {
+        if (solverOptions.supernodal)
+            result = sldlt->solve(rhs);
+        else
+            result = ldlt->solve(rhs);
+    }
+
     int n, m;
 
     // ==== Solver tmps ====
@@ -559,14 +699,19 @@ class MixedSymmetricRecursiveSolver<
     AWTType WT;
 
     RecursiveDiagonalPreconditioner<UBlock> P;
+    RecursiveSSORPreconditioner<S1Type> ssorP;
+    RecursiveIncompleteCholeskyPreconditioner<S1Type> icP;
+    RecursiveClusterJacobiPreconditioner<UBlock> clusterP;
     S1Type S1;
     //    InnerSolver1 solver1;
 
     std::unique_ptr<LDLT> ldlt;
+    std::unique_ptr<SupernodalLDLT> sldlt;
 
     bool patternAnalyzed = false;
     bool hasWT           = true;
     bool explizitSchur   = true;
+    int cgIterations     = 0;
 };
 
 
@@ -29,8 +29,10 @@ class MixedSymmetricRecursiveSolver<Eigen::SparseMatrix<Eigen::Recursive::Matrix
    public:
     using AType = typename Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<T>, _Options>;
     using LDLT  = Eigen::RecursiveSimplicialLDLT<AType, Eigen::Upper>;
+    using SupernodalLDLT = Eigen::Recursive::SupernodalLDLT<AType, Eigen::Upper>;
 
-    using ExpandedType = Eigen::SparseMatrix<typename T::Scalar, Eigen::RowMajor>;
+    // Cholmod only supports double precision
+    using ExpandedType = Eigen::SparseMatrix<double, Eigen::RowMajor>;
 #ifdef SOLVER_USE_CHOLMOD
     using CholmodLDLT = Eigen::CholmodSupernodalLLT<ExpandedType, Eigen::Upper>;
     //        using CholmodLDLT = Eigen::CholmodSimplicialLDLT<ExpandedType, Eigen::Upper>;
@@ -38,9 +40,32 @@ class MixedSymmetricRecursiveSolver<Eigen::SparseMatrix<Eigen::Recursive::Matrix
     //    using CholmodLDLT = Eigen::SimplicialLLT<ExpandedType, Eigen::Upper>;
 #endif
 
-    void Init()
+    /**
+     * Drops the factorization. The next solve does a full analysis of A.
+     *
+     * With keepOrdering=true the fill reducing ordering of the current factorization is stored and used for the next
+     * analysis. This is useful if A has grown (new rows and new entries) but the old rows still exist, for example
+     * after new vertices and edges have been added to a pose graph. The new rows are eliminated last. The ordering
+     * computation (AMD) is skipped, but the symbolic factorization is recomputed.
+     * Note: Cholmod always computes its own ordering.
+     */
+    void Init(bool keepOrdering = false)
     {
-        ldlt = nullptr;
+        ordering.clear();
+        if (keepOrdering)
+        {
+            if (supernodalldlt)
+            {
+                ordering = supernodalldlt->ordering();
+            }
+            else if (ldlt)
+            {
+                auto& pinv = ldlt->permutationPinv().indices();
+                ordering.assign(pinv.data(), pinv.data() + pinv.size());
+            }
+        }
+        ldlt           = nullptr;
+        supernodalldlt = nullptr;
 #ifdef SOLVER_USE_CHOLMOD
         cholmodldlt = nullptr;
 #endif
@@ -59,7 +84,6 @@ class MixedSymmetricRecursiveSolver<Eigen::SparseMatrix<Eigen::Recursive::Matrix
             {
                 if (!expandS) expandS = std::make_unique<ExpandedType>();
                 sparseBlockToFlatMatrix(A, *expandS);
-                auto eb = expand(b);
                 if (!cholmodldlt)
                 {
                     // Create cholesky solver and do a full compute
@@ -71,15 +95,33 @@ class MixedSymmetricRecursiveSolver<Eigen::SparseMatrix<Eigen::Recursive::Matrix
                     // This line computes the factorization without analyzing the structure again
                     cholmodldlt->factorize(*expandS);
                 }
-                Eigen::Matrix<double, -1, 1> ex = cholmodldlt->solve(eb);
-                // convert back to block x
-                for (int i = 0; i < x.rows(); ++i)
+                solveFactorized(b, x, solverOptions);
+            }
+            else
+#endif
+                if (solverOptions.supernodal)
+            {
+                if (!supernodalldlt)
                 {
-                    x(i).get() = ex.segment(i * T::RowsAtCompileTime, T::RowsAtCompileTime);
+                    supernodalldlt = std::make_unique<SupernodalLDLT>();
+                    if (extendOrdering(n))
+                    {
+                        supernodalldlt->analyzePattern(A, ordering);
+                        supernodalldlt->factorize(A);
+                    }
+                    else
+                    {
+                        supernodalldlt->compute(A);
+                    }
+                }
+                else
+                {
+                    // Reuses the ordering and the supernodes of the first call
+                    supernodalldlt->factorize(A);
                 }
+                solveFactorized(b, x, solverOptions);
             }
             else
-#endif
             {
                 if (!ldlt)
                 {
@@ -123,7 +165,12 @@ class MixedSymmetricRecursiveSolver<Eigen::SparseMatrix<Eigen::Recursive::Matrix
                     ldlt->analyzePattern(A);
                     ldlt->factorize(A);
 #else
-
+                    if (extendOrdering(n))
+                    {
+                        // The ordering methods compute the inverse permutation
+                        ldlt->m_Pinv.resize(n);
+                        for (int i = 0; i < n; ++i) ldlt->m_Pinv.indices()[i] = ordering[i];
+                    }
                     ldlt->compute(A);
 #endif
                 }
@@ -133,27 +180,113 @@ class MixedSymmetricRecursiveSolver<Eigen::SparseMatrix<Eigen::Recursive::Matrix
                     ldlt->factorize(A);
                 }
                 //                std::cout << "ldlt compute" << std::endl;
-                x = ldlt->solve(b);
+                solveFactorized(b, x, solverOptions);
             }
+
+            // Iterative refinement with the existing factorization
+            iterativeRefinement(A, b, x, solverOptions.refinementSteps,
+                                [&](const XType& r, XType& dx) { solveFactorized(r, dx, solverOptions); });
         }
         else
         {
             x.setZero();
-            RecursiveDiagonalPreconditioner<MatrixScalar<T>> P;
-            Eigen::Index iters = solverOptions.maxIterativeIterations;
-            double tol         = solverOptions.iterativeTolerance;
 
-            P.compute(A);
+            auto applyA = [&](const XType& v, XType& result) {
+                result = A.template selfadjointView<Eigen::Upper>() * v;
+            };
 
-            XType tmp(n);
-            recursive_conjugate_gradient(
-                [&](const XType& v, XType& result) { result = A.template selfadjointView<Eigen::Upper>() * v; }, b, x,
-                P, iters, tol);
+            // Each refinement step restarts CG from the current solution
+            auto cg = [&](const auto& precond) {
+                cgIterations = 0;
+                for (int k = 0; k <= solverOptions.refinementSteps; ++k)
+                {
+                    Eigen::Index iters = solverOptions.maxIterativeIterations;
+                    double tol         = solverOptions.iterativeTolerance;
+                    recursive_conjugate_gradient(applyA, b, x, precond, iters, tol);
+                    cgIterations += iters;
+                }
+            };
+
+            switch (solverOptions.preconditioner)
+            {
+                case LinearSolverOptions::PreconditionerType::SSOR:
+                    ssorP.omega = solverOptions.ssorOmega;
+                    ssorP.compute(A);
+                    cg(ssorP);
+                    break;
+                case LinearSolverOptions::PreconditionerType::IncompleteCholesky:
+                    // The symbolic factorization is reused as long as the structure of A doesn't change
+                    icP.fillLevel = solverOptions.icFillLevel;
+                    icP.compute(A);
+                    cg(icP);
+                    break;
+                case LinearSolverOptions::PreconditionerType::ClusterJacobi:
+                    // No visibility information -> cluster by the graph of A
+                    if (clusterP.maxClusterSize != solverOptions.clusterSize || clusterP.rows() != n)
+                    {
+                        clusterP.maxClusterSize = solverOptions.clusterSize;
+                        clusterP.clusterByGraph(A);
+                    }
+                    clusterP.factorize(A);
+                    cg(clusterP);
+                    break;
+                default:
+                {
+                    RecursiveDiagonalPreconditioner<MatrixScalar<T>> P;
+                    P.compute(A);
+                    cg(P);
+                    break;
+                }
+            }
         }
     }
 
+    // Number of CG iterations of the last iterative solve
+    int iterations() const { return cgIterations; }
+
    private:
+    // Appends the rows, which were added since the ordering has been stored.
+    // Returns false if there is no valid ordering for a matrix of size n.
+    bool extendOrdering(int n)
+    {
+        int oldN = ordering.size();
+        if (oldN == 0 || oldN > n) return false;
+        ordering.resize(n);
+        for (int i = oldN; i < n; ++i) ordering[i] = i;
+        return true;
+    }
+
+    // Solve with the current factorization
+    void solveFactorized(const XType& rhs, XType& result, const LinearSolverOptions& solverOptions)
+    {
+#ifdef SOLVER_USE_CHOLMOD
+        if (solverOptions.cholmod)
+        {
+            Eigen::Matrix<double, -1, 1> eb = expand(rhs).template cast<double>();
+            Eigen::Matrix<double, -1, 1> ex = cholmodldlt->solve(eb);
+            // convert back to block x
+            for (int i = 0; i < result.rows(); ++i)
+            {
+                result(i).get() =
+                    ex.segment(i * T::RowsAtCompileTime, T::RowsAtCompileTime).template cast<typename T::Scalar>();
+            }
+            return;
+        }
+#endif
+        if (solverOptions.supernodal)
+            result = supernodalldlt->solve(rhs);
+        else
+            result = ldlt->solve(rhs);
+    }
+
     std::unique_ptr<LDLT> ldlt;
+    std::unique_ptr<SupernodalLDLT> supernodalldlt;
+    RecursiveSSORPreconditioner<AType> ssorP;
+    RecursiveIncompleteCholeskyPreconditioner<AType> icP;
+    RecursiveClusterJacobiPreconditioner<MatrixScalar<T>> clusterP;
+    int cgIterations = 0;
+    // Fill reducing ordering of a previous factorization. See Init().
+    std::vector<int> ordering;
     Eigen::PermutationMatrix<-1> permFull;
     std::vector<int> orderingFull;
 #ifdef SOLVER_USE_CHOLMOD
@@ -0,0 +1,129 @@
+﻿/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+
+#pragma once
+
+#include "saiga/core/util/Algorithm.h"
+#include "saiga/core/util/assert.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Saiga
+{
+/**
+ * The block structure of the normal equations of a graph optimization problem (PGO, ARAP, ...).
+ *
+ * S is the upper triangular part of a symmetric sparse block matrix in row major order. Every row starts with the
+ * diagonal element followed by one element per edge (i,j) with i < j.
+ *
+ * The structure is cached between calls to compute(). If the graph has not changed, S is left untouched. This allows
+ * the LM optimizers to skip the structure computation and to reuse the symbolic factorization of the linear solver
+ * when the same graph is optimized multiple times. If new vertices and edges were only added, the solver can still
+ * reuse the fill reducing ordering (see MixedSymmetricRecursiveSolver::Init).
+ */
+class GraphStructure
+{
+   public:
+    enum class Change
+    {
+        // Same vertices and edges as in the previous call
+        None,
+        // The previous graph is a subgraph of the new graph
+        Appended,
+        // Vertices or edges were removed or this is the first call
+        Changed,
+    };
+
+    // Offset of each edge in the value array of S
+    std::vector<int> edgeOffsets;
+
+    // Drops the cached structure. The next call to compute() returns Change::Changed.
+    void clear()
+    {
+        n = 0;
+        edges.clear();
+        edgeOffsets.clear();
+    }
+
+    /**
+     * Computes the structure of S for a graph with _n vertices.
+     * The edges are given as (i,j) pairs with i < j.
+     */
+    template <typename SType>
+    Change compute(int _n, const std::vector<std::pair<int, int>>& newEdges, SType& S)
+    {
+        Change change = compare(_n, newEdges);
+        if (change == Change::None && S.rows() == _n) return change;
+
+        n     = _n;
+        edges = newEdges;
+
+        S.resize(n, n);
+        S.setZero();
+        int N = edges.size() + n;
+        S.reserve(N);
+
+        // Compute outer structure pointer
+        // Note: the row is smaller than the column, which means we are in the upper right part of the matrix.
+        for (auto& e : edges)
+        {
+            SAIGA_ASSERT(e.first < e.second);
+            S.outerIndexPtr()[e.first]++;
+        }
+
+        // make room for the diagonal element
+        for (int i = 0; i < n; ++i)
+        {
+            S.outerIndexPtr()[i]++;
+        }
+
+        exclusive_scan(S.outerIndexPtr(), S.outerIndexPtr() + S.outerSize(), S.outerIndexPtr(), 0);
+        S.outerIndexPtr()[S.outerSize()] = N;
+
+        // insert diagonal index
+        for (int i = 0; i < n; ++i)
+        {
+            int offseti                = S.outerIndexPtr()[i];
+            S.innerIndexPtr()[offseti] = i;
+        }
+
+        // Precompute the offset in the sparse matrix for every edge
+        edgeOffsets.clear();
+        edgeOffsets.reserve(edges.size());
+        std::vector<int> localOffsets(n, 1);
+        for (auto& e : edges)
+        {
+            int offseti                = S.outerIndexPtr()[e.first] + localOffsets[e.first]++;
+            S.innerIndexPtr()[offseti] = e.second;
+            edgeOffsets.emplace_back(offseti);
+        }
+        return change;
+    }
+
+   private:
+    int n = 0;
+    std::vector<std::pair<int, int>> edges;
+
+    Change compare(int _n, const std::vector<std::pair<int, int>>& newEdges) const
+    {
+        if (n == 0 || _n < n) return Change::Changed;
+        if (_n == n && newEdges == edges) return Change::None;
+        if (newEdges.size() < edges.size()) return Change::Changed;
+
+        // Every old edge must still exist
+        auto oldSorted = edges;
+        auto newSorted = newEdges;
+        std::sort(oldSorted.begin(), oldSorted.end());
+        std::sort(newSorted.begin(), newSorted.end());
+        return std::includes(newSorted.begin(), newSorted.end(), oldSorted.begin(), oldSorted.end())
+                   ? Change::Appended
+                   : Change::Changed;
+    }
+};
+
+}  // namespace Saiga
@@ -15,7 +15,8 @@
 
 namespace Saiga
 {
-void PGORec::init()
+template <typename BlockScalar>
+void PGORecursive<BlockScalar>::init()
 {
     auto& scene = *_scene;
 
@@ -34,59 +35,21 @@ void PGORec::init()
     }
 
     // Compute structure of S
-    S.resize(n, n);
-    S.setZero();
-    int N = scene.edges.size() + n;
-    S.reserve(N);
-
-    // Compute outer structure pointer
-    // Note: the row is smaller than the column, which means we are in the upper right part of the matrix.
+    // The structure and the symbolic factorization are reused if the graph has not changed since the last solve.
+    if (!reuseStructure) structure.clear();
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(scene.edges.size());
     for (auto& e : scene.edges)
     {
-        int i = e.from;
-        int j = e.to;
-        SAIGA_ASSERT(i != j);
-        SAIGA_ASSERT(i < j);
-        S.outerIndexPtr()[i]++;
-    }
-
-    // make room for the diagonal element
-    for (int i = 0; i < n; ++i)
-    {
-        S.outerIndexPtr()[i]++;
+        SAIGA_ASSERT(e.from != e.to);
+        edges.emplace_back(e.from, e.to);
     }
+    structureChange = structure.compute(n, edges, S);
 
-    exclusive_scan(S.outerIndexPtr(), S.outerIndexPtr() + S.outerSize(), S.outerIndexPtr(), 0);
-    S.outerIndexPtr()[S.outerSize()] = N;
-
-
-    // insert diagonal index
-    for (int i = 0; i < n; ++i)
-    {
-        int offseti                = S.outerIndexPtr()[i];
-        S.innerIndexPtr()[offseti] = i;
-    }
-
-    // Precompute the offset in the sparse matrix for every edge
-    edgeOffsets.clear();
-    edgeOffsets.reserve(scene.edges.size());
-    std::vector<int> localOffsets(n, 1);
-    for (auto& e : scene.edges)
-    {
-        int i = e.from;
-        int j = e.to;
-
-        int li = localOffsets[i]++;
-
-        int offseti = S.outerIndexPtr()[i] + li;
-
-        S.innerIndexPtr()[offseti] = j;
-
-
-        edgeOffsets.emplace_back(offseti);
-    }
-
-    solver.Init();
+    if (structureChange == GraphStructure::Change::Appended)
+        solver.Init(true);
+    else if (structureChange == GraphStructure::Change::Changed)
+        solver.Init();
 
     // Create a sparsity histogram
     if (false && optimizationOptions.debugOutput)
@@ -105,13 +68,11 @@ void PGORec::init()
     }
 }
 
-double PGORec::computeQuadraticForm()
+template <typename BlockScalar>
+double PGORecursive<BlockScalar>::computeQuadraticForm()
 {
     auto& scene = *_scene;
 
-
-    b.setZero();
-
     // set diagonal elements of S to zero
     for (int i = 0; i < S.rows(); ++i)
     {
@@ -121,18 +82,20 @@ double PGORec::computeQuadraticForm()
     double chi2 = 0;
     //#pragma omp parallel
 
-    //        auto b2 = b;
-    AlignedVector<PGOBlock> diagBlocks(n);
+    // The diagonal blocks and the right hand side are accumulated in double
+    AlignedVector<Eigen::Matrix<double, 6, 6>> diagBlocks(n);
+    AlignedVector<Vec6> resBlocks(n);
     for (int i = 0; i < n; ++i)
     {
         diagBlocks[i].setZero();
+        resBlocks[i].setZero();
     }
     double chi2local = 0;
     //#pragma omp for
     for (size_t k = 0; k < scene.edges.size(); ++k)
     {
         auto& e       = scene.edges[k];
-        auto& offsets = edgeOffsets[k];
+        auto& offsets = structure.edgeOffsets[k];
         int i         = e.from;
         int j         = e.to;
 
@@ -141,8 +104,8 @@ double PGORec::computeQuadraticForm()
         //            auto& target_jj = S.valuePtr()[S.outerIndexPtr()[j]].get();
         auto& target_ii = diagBlocks[i];
         auto& target_jj = diagBlocks[j];
-        auto& target_ir = b(i).get();
-        auto& target_jr = b(j).get();
+        auto& target_ir = resBlocks[i];
+        auto& target_jr = resBlocks[j];
 
         {
             Eigen::Matrix<double, 6, 6> Jrowi, Jrowj;
@@ -154,7 +117,7 @@ double PGORec::computeQuadraticForm()
             auto c = res.squaredNorm();
 
             // JtJ
-            target_ij = Jrowi.transpose() * Jrowj;
+            target_ij = (Jrowi.transpose() * Jrowj).template cast<BlockScalar>();
 
             target_ii += Jrowi.transpose() * Jrowi;
             target_jj += Jrowj.transpose() * Jrowj;
@@ -178,7 +141,8 @@ double PGORec::computeQuadraticForm()
     for (int i = 0; i < n; ++i)
     {
         //#pragma omp critical
-        S.valuePtr()[S.outerIndexPtr()[i]].get() += diagBlocks[i];
+        S.valuePtr()[S.outerIndexPtr()[i]].get() += diagBlocks[i].template cast<BlockScalar>();
+        b(i).get() = resBlocks[i].template cast<BlockScalar>();
     }
 
 
@@ -188,7 +152,8 @@ double PGORec::computeQuadraticForm()
 }
 
 
-double PGORec::computeCost()
+template <typename BlockScalar>
+double PGORecursive<BlockScalar>::computeCost()
 {
     auto& scene = *_scene;
 
@@ -222,7 +187,8 @@ double PGORec::computeCost()
     return chi2;
 }
 
-void PGORec::addLambda(double lambda)
+template <typename BlockScalar>
+void PGORecursive<BlockScalar>::addLambda(double lambda)
 {
     // apply lm
     for (int i = 0; i < n; ++i)
@@ -232,7 +198,8 @@ void PGORec::addLambda(double lambda)
     }
 }
 
-bool PGORec::addDelta()
+template <typename BlockScalar>
+bool PGORecursive<BlockScalar>::addDelta()
 {
     auto& scene = *_scene;
     oldx_u      = x_u;
@@ -240,7 +207,7 @@ bool PGORec::addDelta()
     for (int i = 0; i < n; ++i)
     {
         if (scene.vertices[i].constant) continue;
-        auto t = delta_x(i).get();
+        Vec6 t = delta_x(i).get().template cast<double>();
         //#ifdef PGO_SIM3
         //        if (scene.fixScale) t[6] = 0;
         //#endif
@@ -254,7 +221,8 @@ bool PGORec::addDelta()
     return true;
 }
 
-void PGORec::solveLinearSystem()
+template <typename BlockScalar>
+void PGORecursive<BlockScalar>::solveLinearSystem()
 {
     using namespace Eigen::Recursive;
 
@@ -262,6 +230,13 @@ void PGORec::solveLinearSystem()
 
     loptions.maxIterativeIterations = optimizationOptions.maxIterativeIterations;
     loptions.iterativeTolerance     = optimizationOptions.iterativeTolerance;
+    loptions.cholmod                = optimizationOptions.cholmod;
+    loptions.supernodal             = optimizationOptions.supernodal;
+    loptions.preconditioner         = RecursivePreconditioner(optimizationOptions.preconditioner);
+    loptions.ssorOmega              = optimizationOptions.ssorOmega;
+    loptions.icFillLevel            = optimizationOptions.icFillLevel;
+    loptions.clusterSize            = optimizationOptions.clusterSize;
+    loptions.refinementSteps        = optimizationOptions.refinementSteps;
 
     loptions.solverType = (optimizationOptions.solverType == OptimizationOptions::SolverType::Direct)
                               ? LinearSolverOptions::SolverType::Direct
@@ -269,13 +244,16 @@ void PGORec::solveLinearSystem()
 
 
     solver.solve(S, delta_x, b, loptions);
+    linearSolverIterations += solver.iterations();
 }
 
-void PGORec::revertDelta()
+template <typename BlockScalar>
+void PGORecursive<BlockScalar>::revertDelta()
 {
     x_u = oldx_u;
 }
-void PGORec::finalize()
+template <typename BlockScalar>
+void PGORecursive<BlockScalar>::finalize()
 {
     auto& scene = *_scene;
 
@@ -289,4 +267,7 @@ void PGORec::finalize()
     }
 }
 
+template class PGORecursive<double>;
+template class PGORecursive<float>;
+
 }  // namespace Saiga
@@ -9,18 +9,25 @@
 
 #include "saiga/vision/pgo/PGOBase.h"
 
+#include "GraphStructure.h"
 #include "Recursive.h"
 
 namespace Saiga
 {
-class SAIGA_VISION_API PGORec : public PGOBase, public LMOptimizer
+/**
+ * Recursive pose graph optimization.
+ *
+ * The template parameter is the scalar type of the matrix blocks. See BARecursive for the mixed precision mode.
+ */
+template <typename _BlockPGOScalar>
+class SAIGA_VISION_API PGORecursive : public PGOBase, public LMOptimizer
 {
    public:
     using PGOTransformation = SE3;
     // ============== Recusrive Matrix Types ==============
 
     static constexpr int pgoBlockSizeCamera = PGOTransformation::DoF;
-    using BlockPGOScalar                    = double;
+    using BlockPGOScalar                    = _BlockPGOScalar;
 
     using PGOBlock   = Eigen::Matrix<BlockPGOScalar, pgoBlockSizeCamera, pgoBlockSizeCamera>;
     using PGOVector  = Eigen::Matrix<BlockPGOScalar, pgoBlockSizeCamera, 1>;
@@ -32,10 +39,20 @@ class SAIGA_VISION_API PGORec : public PGOBase, public LMOptimizer
 
    public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-    PGORec() : PGOBase("recursive PGO") {}
-    virtual ~PGORec() {}
+    PGORecursive() : PGOBase(std::is_same_v<BlockPGOScalar, double> ? "recursive PGO" : "recursive PGO (mixed)") {}
+    virtual ~PGORecursive() {}
     virtual void create(PoseGraph& scene) override { _scene = &scene; }
 
+    /**
+     * Reuse the structure of S and the factorization ordering of the previous solve.
+     * If the pose graph is optimized multiple times (for example in a SLAM system after new keyframes and loop
+     * closures have been added), only the parts which have changed are recomputed. The optimization itself is always
+     * warm started from the current poses of the graph, which is the result of the previous solve.
+     */
+    bool reuseStructure = true;
+
+    // How the structure has changed in the last initialization.
+    GraphStructure::Change lastStructureChange() const { return structureChange; }
 
    private:
     int n;
@@ -49,7 +66,8 @@ class SAIGA_VISION_API PGORec : public PGOBase, public LMOptimizer
     AlignedVector<PGOTransformation> x_u, oldx_u;
 
 
-    std::vector<int> edgeOffsets;
+    GraphStructure structure;
+    GraphStructure::Change structureChange = GraphStructure::Change::Changed;
     PoseGraph* _scene;
 
     // ============== LM Functions ==============
@@ -64,4 +82,7 @@ class SAIGA_VISION_API PGORec : public PGOBase, public LMOptimizer
     virtual void finalize() override;
 };
 
+using PGORec      = PGORecursive<double>;
+using PGORecMixed = PGORecursive<float>;
+
 }  // namespace Saiga
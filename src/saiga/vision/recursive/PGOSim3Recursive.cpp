@@ -34,56 +34,21 @@ void PGOSim3Rec::init()
     }
 
     // Compute structure of S
-    S.resize(n, n);
-    S.setZero();
-    int N = scene.edges.size() + n;
-    S.reserve(N);
-
-    // Compute outer structure pointer
+    // The structure and the symbolic factorization are reused if the graph has not changed since the last solve.
+    if (!reuseStructure) structure.clear();
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(scene.edges.size());
     for (auto& e : scene.edges)
     {
-        int i = e.from;
-        int j = e.to;
-        SAIGA_ASSERT(i != j);
-        SAIGA_ASSERT(i < j);
-
-        S.outerIndexPtr()[i]++;
-    }
-
-    // make room for the diagonal element
-    for (int i = 0; i < n; ++i)
-    {
-        S.outerIndexPtr()[i]++;
-    }
-
-    exclusive_scan(S.outerIndexPtr(), S.outerIndexPtr() + S.outerSize(), S.outerIndexPtr(), 0);
-    S.outerIndexPtr()[S.outerSize()] = N;
-
-
-    // insert diagonal index
-    for (int i = 0; i < n; ++i)
-    {
-        int offseti                = S.outerIndexPtr()[i];
-        S.innerIndexPtr()[offseti] = i;
+        SAIGA_ASSERT(e.from != e.to);
+        edges.emplace_back(e.from, e.to);
     }
+    structureChange = structure.compute(n, edges, S);
 
-    // Precompute the offset in the sparse matrix for every edge
-    edgeOffsets.reserve(scene.edges.size());
-    std::vector<int> localOffsets(n, 1);
-    for (auto& e : scene.edges)
-    {
-        int i = e.from;
-        int j = e.to;
-
-        int li = localOffsets[i]++;
-
-        int offseti = S.outerIndexPtr()[i] + li;
-
-        S.innerIndexPtr()[offseti] = j;
-
-
-        edgeOffsets.emplace_back(offseti);
-    }
+    if (structureChange == GraphStructure::Change::Appended)
+        solver.Init(true);
+    else if (structureChange == GraphStructure::Change::Changed)
+        solver.Init();
 
     // Create a sparsity histogram
     if (false && optimizationOptions.debugOutput)
@@ -133,7 +98,7 @@ double PGOSim3Rec::computeQuadraticForm()
     for (size_t k = 0; k < scene.edges.size(); ++k)
     {
         auto& e       = scene.edges[k];
-        auto& offsets = edgeOffsets[k];
+        auto& offsets = structure.edgeOffsets[k];
         int i         = e.from;
         int j         = e.to;
 
@@ -256,6 +221,13 @@ void PGOSim3Rec::solveLinearSystem()
 
     loptions.maxIterativeIterations = optimizationOptions.maxIterativeIterations;
     loptions.iterativeTolerance     = optimizationOptions.iterativeTolerance;
+    loptions.cholmod                = optimizationOptions.cholmod;
+    loptions.supernodal             = optimizationOptions.supernodal;
+    loptions.preconditioner         = RecursivePreconditioner(optimizationOptions.preconditioner);
+    loptions.ssorOmega              = optimizationOptions.ssorOmega;
+    loptions.icFillLevel            = optimizationOptions.icFillLevel;
+    loptions.clusterSize            = optimizationOptions.clusterSize;
+    loptions.refinementSteps        = optimizationOptions.refinementSteps;
 
     loptions.solverType = (optimizationOptions.solverType == OptimizationOptions::SolverType::Direct)
                               ? LinearSolverOptions::SolverType::Direct
@@ -263,6 +235,7 @@ void PGOSim3Rec::solveLinearSystem()
 
 
     solver.solve(S, delta_x, b, loptions);
+    linearSolverIterations += solver.iterations();
 }
 
 void PGOSim3Rec::revertDelta()
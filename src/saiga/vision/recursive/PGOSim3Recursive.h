@@ -9,6 +9,7 @@
 
 #include "saiga/vision/pgo/PGOBase.h"
 
+#include "GraphStructure.h"
 #include "Recursive.h"
 
 namespace Saiga
@@ -36,6 +37,10 @@ class SAIGA_VISION_API PGOSim3Rec : public PGOBase, public LMOptimizer
     virtual ~PGOSim3Rec() {}
     virtual void create(PoseGraph& scene) override { _scene = &scene; }
 
+    // Reuse the structure of S and the factorization ordering of the previous solve. See PGORecursive.
+    bool reuseStructure = true;
+    GraphStructure::Change lastStructureChange() const { return structureChange; }
+
 
    private:
     int n;
@@ -49,7 +54,8 @@ class SAIGA_VISION_API PGOSim3Rec : public PGOBase, public LMOptimizer
     AlignedVector<PGOTransformation> x_u, oldx_u;
 
 
-    std::vector<int> edgeOffsets;
+    GraphStructure structure;
+    GraphStructure::Change structureChange = GraphStructure::Change::Changed;
     PoseGraph* _scene;
 
     // ============== LM Functions ==============
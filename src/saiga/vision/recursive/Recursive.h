@@ -8,6 +8,7 @@
 #pragma once
 
 #include "saiga/saiga_modules.h"
+#include "saiga/vision/util/Optimizer.h"
 
 // Sophus is a header only library which is not so common. Therefore we include it here, but
 // only use it if cmake cannot find an installed version.
@@ -16,3 +17,25 @@
 #else
 #    include "External/All.h"
 #endif
+
+namespace Saiga
+{
+// Maps the preconditioner of the optimizer options to the one of the recursive linear solvers.
+inline Eigen::Recursive::LinearSolverOptions::PreconditionerType RecursivePreconditioner(
+    OptimizationOptions::PreconditionerType type)
+{
+    using PT = Eigen::Recursive::LinearSolverOptions::PreconditionerType;
+    switch (type)
+    {
+        case OptimizationOptions::PreconditionerType::BlockJacobi:
+            return PT::BlockJacobi;
+        case OptimizationOptions::PreconditionerType::SSOR:
+            return PT::SSOR;
+        case OptimizationOptions::PreconditionerType::IncompleteCholesky:
+            return PT::IncompleteCholesky;
+        case OptimizationOptions::PreconditionerType::ClusterJacobi:
+            return PT::ClusterJacobi;
+    }
+    return PT::BlockJacobi;
+}
+}  // namespace Saiga
@@ -37,57 +37,21 @@ void RecursiveArap::init()
     }
 
     // Compute structure of S
-    S.resize(n, n);
-    S.setZero();
-    int N = scene.constraints.size() + n;
-    S.reserve(N);
-
-#if 1
-    // Compute outer structure pointer
+    // The structure and the symbolic factorization are reused if the graph has not changed since the last solve.
+    if (!reuseStructure) structure.clear();
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(scene.constraints.size());
     for (auto& e : scene.constraints)
     {
-        int i = e.ids.first;
-        int j = e.ids.second;
-        SAIGA_ASSERT(i != j);
-        SAIGA_ASSERT(i < j);
-
-        S.outerIndexPtr()[i]++;
-    }
-
-    // make room for the diagonal element
-    for (int i = 0; i < n; ++i)
-    {
-        S.outerIndexPtr()[i]++;
-    }
-
-    exclusive_scan(S.outerIndexPtr(), S.outerIndexPtr() + S.outerSize(), S.outerIndexPtr(), 0);
-    S.outerIndexPtr()[S.outerSize()] = N;
-
-
-    // insert diagonal index
-    for (int i = 0; i < n; ++i)
-    {
-        int offseti                = S.outerIndexPtr()[i];
-        S.innerIndexPtr()[offseti] = i;
+        SAIGA_ASSERT(e.ids.first != e.ids.second);
+        edges.emplace_back(e.ids.first, e.ids.second);
     }
+    structureChange = structure.compute(n, edges, S);
 
-    // Precompute the offset in the sparse matrix for every edge
-    edgeOffsets.reserve(scene.constraints.size());
-    std::vector<int> localOffsets(n, 1);
-    for (auto& e : scene.constraints)
-    {
-        int i = e.ids.first;
-        int j = e.ids.second;
-
-        int li = localOffsets[i]++;
-
-        int offseti = S.outerIndexPtr()[i] + li;
-
-        S.innerIndexPtr()[offseti] = j;
-
-
-        edgeOffsets.emplace_back(offseti);
-    }
+    if (structureChange == GraphStructure::Change::Appended)
+        solver.Init(true);
+    else if (structureChange == GraphStructure::Change::Changed)
+        solver.Init();
 
     // Create a sparsity histogram
     if (false && optimizationOptions.debugOutput)
@@ -104,7 +68,6 @@ void RecursiveArap::init()
         }
         img.writeBinary("arap.png");
     }
-#endif
 }
 
 double RecursiveArap::computeQuadraticForm()
@@ -156,7 +119,7 @@ double RecursiveArap::computeQuadraticForm()
     for (size_t k = 0; k < scene.constraints.size(); ++k)
     {
         auto& e       = scene.constraints[k];
-        auto& offsets = edgeOffsets[k];
+        auto& offsets = structure.edgeOffsets[k];
         int i         = e.ids.first;
         int j         = e.ids.second;
 
@@ -263,6 +226,13 @@ void RecursiveArap::solveLinearSystem()
 
     loptions.maxIterativeIterations = optimizationOptions.maxIterativeIterations;
     loptions.iterativeTolerance     = optimizationOptions.iterativeTolerance;
+    loptions.cholmod                = optimizationOptions.cholmod;
+    loptions.supernodal             = optimizationOptions.supernodal;
+    loptions.preconditioner         = RecursivePreconditioner(optimizationOptions.preconditioner);
+    loptions.ssorOmega              = optimizationOptions.ssorOmega;
+    loptions.icFillLevel            = optimizationOptions.icFillLevel;
+    loptions.clusterSize            = optimizationOptions.clusterSize;
+    loptions.refinementSteps        = optimizationOptions.refinementSteps;
 
     loptions.solverType = (optimizationOptions.solverType == OptimizationOptions::SolverType::Direct)
                               ? LinearSolverOptions::SolverType::Direct
@@ -271,6 +241,7 @@ void RecursiveArap::solveLinearSystem()
 
 
     solver.solve(S, delta_x, b, loptions);
+    linearSolverIterations += solver.iterations();
 }
 
 double RecursiveArap::computeCost()
@@ -9,6 +9,7 @@
 #include "saiga/vision/arap/ArapProblem.h"
 #include "saiga/vision/util/Optimizer.h"
 
+#include "GraphStructure.h"
 #include "Recursive.h"
 namespace Saiga
 {
@@ -32,6 +33,10 @@ class SAIGA_VISION_API RecursiveArap : public ArapBase, public LMOptimizer
     RecursiveArap() : ArapBase("Recursive") {}
     virtual void create(ArapProblem& scene) override { arap = &scene; }
 
+    // Reuse the structure of S and the factorization ordering of the previous solve. See PGORecursive.
+    bool reuseStructure = true;
+    GraphStructure::Change lastStructureChange() const { return structureChange; }
+
    protected:
     virtual void init() override;
     virtual double computeQuadraticForm() override;
@@ -49,7 +54,8 @@ class SAIGA_VISION_API RecursiveArap : public ArapBase, public LMOptimizer
     PBType delta_x;
     Eigen::Recursive::MixedSymmetricRecursiveSolver<PSType, PBType> solver;
     AlignedVector<SE3> x_u, oldx_u;
-    std::vector<int> edgeOffsets;
+    GraphStructure structure;
+    GraphStructure::Change structureChange = GraphStructure::Change::Changed;
 };
 
 }  // namespace Saiga
@@ -6,11 +6,13 @@
 
 #include "BALDataset.h"
 
+#include "saiga/core/util/FastTextParser.h"
+#include "saiga/core/util/MemoryMappedFile.h"
+#include "saiga/core/util/Thread/omp.h"
 #include "saiga/core/util/assert.h"
 #include "saiga/core/util/file.h"
-#include "saiga/core/util/tostring.h"
 
-#include <fstream>
+#include <algorithm>
 
 #ifdef SAIGA_USE_CERES
 #    include "saiga/vision/ceres/CeresBAL.h"
@@ -24,72 +26,152 @@ BALDataset::BALDataset(const std::string& file)
 {
     std::cout << "> Loading BALDataset " << file << std::endl;
 
-    auto data = File::loadFileStringArray(file);
+    // The file is mapped and parsed in place. Compressed files (.gz/.bz2) are decompressed into memory first.
+    MemoryMappedFile mapped(file);
+    if (!mapped.valid())
+    {
+        std::cerr << "Could not open " << file << std::endl;
+        return;
+    }
+    mapped.adviseSequential();
+
+    std::vector<char> decompressed;
+    ArrayView<const char> text = mapped.view();
+    if (File::isCompressed(text))
+    {
+        bool decompress_ok = File::decompressStream(text, decompressed);
+        if (!decompress_ok)
+        {
+            std::cerr << "Could not decompress " << file << std::endl;
+            return;
+        }
+        mapped.close();
+        text = decompressed;
+    }
+
+    const char* ptr = text.data();
+    const char* end = text.data() + text.size();
 
-    int num_cameras, num_points, num_observations;
+    int num_cameras = 0, num_points = 0, num_observations = 0;
+    bool header_ok  = FastTextParser::Parse(ptr, end, num_cameras) && FastTextParser::Parse(ptr, end, num_points) &&
+                     FastTextParser::Parse(ptr, end, num_observations) && num_cameras >= 0 && num_points >= 0 &&
+                     num_observations >= 0;
+    if (!header_ok)
+    {
+        std::cerr << "Invalid BAL header in " << file << std::endl;
+        return;
+    }
 
-    std::stringstream in(data.front());
-    in >> num_cameras >> num_points >> num_observations;
+    // All tokens after the header:
+    //   num_observations x (camera_index point_index x y)
+    //   num_cameras x (r[3] t[3] f k1 k2)
+    //   num_points x (x y z)
+    size_t observation_tokens = size_t(num_observations) * 4;
+    size_t camera_tokens      = size_t(num_cameras) * 9;
+    size_t total_tokens       = observation_tokens + camera_tokens + size_t(num_points) * 3;
+
+    // Split the remaining text into chunks at line boundaries.
+    // The first pass counts the tokens of each chunk, so that every chunk knows the index of its first token.
+    int num_chunks = std::max<size_t>(1, std::min<size_t>(4 * OMP::getMaxThreads(), (end - ptr) / (1 << 16) + 1));
+    std::vector<const char*> chunk_begin = FastTextParser::SplitLines(ptr, end, num_chunks);
+
+    std::vector<size_t> chunk_token_offset(num_chunks + 1, 0);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        const char* p = chunk_begin[i];
+        size_t tokens = 0;
+        while (!FastTextParser::Token(p, chunk_begin[i + 1]).empty()) ++tokens;
+        chunk_token_offset[i + 1] = tokens;
+    }
+    for (int i = 0; i < num_chunks; ++i) chunk_token_offset[i + 1] += chunk_token_offset[i];
+    if (chunk_token_offset.back() < total_tokens)
+    {
+        std::cerr << "Unexpected end of file in " << file << std::endl;
+        return;
+    }
 
     cameras.resize(num_cameras);
     observations.resize(num_observations);
     points.resize(num_points);
+    std::vector<double> camera_params(camera_tokens);
 
+    int errors = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : errors)
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        const char* p    = chunk_begin[i];
+        const char* e    = chunk_begin[i + 1];
+        size_t token     = chunk_token_offset[i];
+        size_t token_end = std::min(chunk_token_offset[i + 1], total_tokens);
 
+        for (; token < token_end; ++token)
+        {
+            bool ok;
+            if (token < observation_tokens)
+            {
+                auto& o = observations[token / 4];
+                switch (token % 4)
+                {
+                    case 0:
+                        ok = FastTextParser::Parse(p, e, o.camera_index);
+                        break;
+                    case 1:
+                        ok = FastTextParser::Parse(p, e, o.point_index);
+                        break;
+                    default:
+                        ok = FastTextParser::Parse(p, e, o.point(token % 4 - 2));
+                        break;
+                }
+            }
+            else if (token < observation_tokens + camera_tokens)
+            {
+                ok = FastTextParser::Parse(p, e, camera_params[token - observation_tokens]);
+            }
+            else
+            {
+                size_t k = token - observation_tokens - camera_tokens;
+                ok       = FastTextParser::Parse(p, e, points[k / 3].point(k % 3));
+            }
+            errors += !ok;
+        }
+    }
 
-    int start = 1;
-#pragma omp parallel for
+#pragma omp parallel for reduction(+ : errors)
     for (int i = 0; i < num_observations; ++i)
     {
-        std::stringstream in(data[start + i]);
-        BALObservation o;
-        in >> o.camera_index >> o.point_index >> o.point[0] >> o.point[1];
-        observations[i] = (o);
+        auto& o = observations[i];
+        errors += o.camera_index < 0 || o.camera_index >= num_cameras || o.point_index < 0 ||
+                  o.point_index >= num_points;
+    }
+    if (errors > 0)
+    {
+        std::cerr << "Invalid number or index in " << file << std::endl;
+        cameras.clear();
+        observations.clear();
+        points.clear();
+        return;
     }
 
-    start += num_observations;
 #pragma omp parallel for
     for (int i = 0; i < num_cameras; ++i)
     {
-        BALCamera c;
-        Vec3 r;
-        Vec3 t;
-
-
-        r(0) = Saiga::to_double(data[start + i * 9 + 0]);
-        r(1) = Saiga::to_double(data[start + i * 9 + 1]);
-        r(2) = Saiga::to_double(data[start + i * 9 + 2]);
-
-        t(0) = Saiga::to_double(data[start + i * 9 + 3]);
-        t(1) = Saiga::to_double(data[start + i * 9 + 4]);
-        t(2) = Saiga::to_double(data[start + i * 9 + 5]);
+        const double* params = camera_params.data() + i * 9;
+        BALCamera& c         = cameras[i];
 
-        c.f  = Saiga::to_double(data[start + i * 9 + 6]);
-        c.k1 = Saiga::to_double(data[start + i * 9 + 7]);
-        c.k2 = Saiga::to_double(data[start + i * 9 + 8]);
+        Vec3 r(params[0], params[1], params[2]);
+        Vec3 t(params[3], params[4], params[5]);
+        c.f  = params[6];
+        c.k1 = params[7];
+        c.k2 = params[8];
 
         auto angle           = r.norm();
         Eigen::Vector3d axis = angle > 0.00001 ? r / angle : Eigen::Vector3d(0, 1, 0);
         Eigen::AngleAxis<double> a(angle, axis);
-        c.se3      = SE3((Quat)a, t);
-        cameras[i] = (c);
+        c.se3 = SE3((Quat)a, t);
     }
-    start += num_cameras * 9;
-
-#pragma omp parallel for
-    for (int i = 0; i < num_points; ++i)
-    {
-        BALPoint p;
-
-        p.point(0) = Saiga::to_double(data[start + i * 3 + 0]);
-        p.point(1) = Saiga::to_double(data[start + i * 3 + 1]);
-        p.point(2) = Saiga::to_double(data[start + i * 3 + 2]);
-
-
-        points[i] = (p);
-    }
-
 
+    loaded = true;
     undistortAll();
     std::cout << "> Done. num_cameras " << num_cameras << " num_points " << num_points << " num_observations "
               << num_observations << " Rms: " << rms() << std::endl;
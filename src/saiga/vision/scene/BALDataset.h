@@ -117,16 +117,20 @@ class SAIGA_VISION_API BALDataset
         }
     };
 
+    // Prints an error and leaves the dataset empty if the file could not be read or parsed. See valid().
     BALDataset(const std::string& file);
+    bool valid() const { return loaded; }
     void undistortAll();
     double rms();
 
     Scene makeScene();
 
-   private:
     AlignedVector<BALObservation> observations;
     AlignedVector<BALCamera> cameras;
     AlignedVector<BALPoint> points;
+
+   private:
+    bool loaded = false;
 };
 
 }  // namespace Saiga
@@ -253,8 +253,15 @@ class SAIGA_VISION_API Scene
 
     // returns true if the scene was changed by a user action
     bool imgui();
+    // Human readable text format. load() also accepts binary scene files.
     void save(const std::string& file);
     void load(const std::string& file);
+
+    // Versioned binary format with one checksummed section per array (intrinsics, extrinsics, image points, world
+    // points). If 'compress' is set, every section is compressed with zlib.
+    // The file is memory mapped during load and the sections are decoded in parallel.
+    void saveBinary(const std::string& file, bool compress = false);
+    bool loadBinary(const std::string& file);
     double chi2Huber(double huber);
 };
 
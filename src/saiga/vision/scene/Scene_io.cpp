@@ -6,14 +6,89 @@
 
 #include "saiga/core/imgui/imgui.h"
 #include "saiga/core/util/assert.h"
+#include "saiga/core/util/Checksum.h"
+#include "saiga/core/util/MemoryMappedFile.h"
 #include "saiga/core/util/fileChecker.h"
+#include "saiga/core/util/zlib.h"
 #include "saiga/vision/util/Random.h"
 
 #include "Scene.h"
 
+#include <cstring>
 #include <fstream>
 namespace Saiga
 {
+// ================================= Binary format =================================
+//
+// File layout (little endian):
+//   BinarySceneHeader
+//   BinarySceneSection[num_sections]
+//   Section data, each section starts at a multiple of 8 bytes
+//
+// The sections are stored as structure of arrays. The doubles of each section come first, so that all arrays are
+// aligned when the file is mapped into memory. The checksum is computed over the uncompressed section.
+namespace
+{
+constexpr char binary_magic[8]    = {'S', 'A', 'I', 'G', 'A', 'S', 'C', 'N'};
+constexpr uint32_t binary_version = 1;
+
+enum BinarySceneSectionId : uint32_t
+{
+    SECTION_INTRINSICS   = 0,  // fx, fy, cx, cy
+    SECTION_EXTRINSICS   = 1,  // se3[7], velocity[7] | intr, num_points | constant
+    SECTION_IMAGE_POINTS = 2,  // depth, point[2] | wp, weight
+    SECTION_WORLD_POINTS = 3,  // p[3]
+    SECTION_COUNT        = 4,
+};
+
+struct BinarySceneHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    uint64_t num_intrinsics;
+    uint64_t num_images;
+    uint64_t num_image_points;
+    uint64_t num_world_points;
+    double bf;
+    double globalScale;
+    double stereo_weight;
+};
+
+struct BinarySceneSection
+{
+    uint32_t id;
+    uint32_t compressed;
+    uint64_t offset;
+    uint64_t stored_size;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+template <typename T>
+void AppendArray(std::vector<char>& dst, const T* src, size_t n)
+{
+    size_t old_size = dst.size();
+    dst.resize(old_size + n * sizeof(T));
+    if (n > 0) std::memcpy(dst.data() + old_size, src, n * sizeof(T));
+}
+
+// Sequential typed access to the arrays of a section
+struct SectionReader
+{
+    const char* ptr;
+
+    template <typename T>
+    const T* take(size_t n)
+    {
+        auto result = reinterpret_cast<const T*>(ptr);
+        ptr += n * sizeof(T);
+        return result;
+    }
+};
+
+}  // namespace
+
 bool Scene::imgui()
 {
     ImGui::PushID(473441235);
@@ -132,6 +207,22 @@ void Scene::load(const std::string& file)
         return;
     }
 
+    {
+        // Binary files are detected by their magic number
+        char magic[sizeof(binary_magic)] = {};
+        std::ifstream test(f, std::ios::binary);
+        test.read(magic, sizeof(magic));
+        if (std::memcmp(magic, binary_magic, sizeof(magic)) == 0)
+        {
+            if (!loadBinary(f))
+            {
+                std::cout << "Failed to load binary scene " << f << "." << std::endl;
+                (*this) = Scene();
+            }
+            return;
+        }
+    }
+
     std::ifstream strm(f);
     SAIGA_ASSERT(strm.is_open());
 
@@ -199,6 +290,375 @@ void Scene::load(const std::string& file)
     SAIGA_ASSERT(valid());
 }
 
+void Scene::saveBinary(const std::string& file, bool compress)
+{
+    SAIGA_ASSERT(valid());
+    std::cout << "Saving binary scene to " << file << "." << std::endl;
+
+#ifndef SAIGA_USE_ZLIB
+    if (compress)
+    {
+        std::cout << "Saiga was compiled without zlib. Saving the scene uncompressed." << std::endl;
+        compress = false;
+    }
+#endif
+
+    size_t N = images.size();
+
+    // Offset of the first image point of each image
+    std::vector<size_t> point_offsets(N + 1, 0);
+    for (size_t i = 0; i < N; ++i) point_offsets[i + 1] = point_offsets[i] + images[i].stereoPoints.size();
+    size_t M = point_offsets.back();
+
+    BinarySceneHeader header;
+    std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+    header.version          = binary_version;
+    header.num_sections     = SECTION_COUNT;
+    header.num_intrinsics   = intrinsics.size();
+    header.num_images       = N;
+    header.num_image_points = M;
+    header.num_world_points = worldPoints.size();
+    header.bf               = bf;
+    header.globalScale      = globalScale;
+    header.stereo_weight    = stereo_weight;
+
+    std::vector<std::vector<char>> data(SECTION_COUNT);
+    std::vector<BinarySceneSection> sections(SECTION_COUNT);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < SECTION_COUNT; ++s)
+    {
+        auto& d = data[s];
+        switch (s)
+        {
+            case SECTION_INTRINSICS:
+            {
+                std::vector<double> coeffs(intrinsics.size() * 4);
+                for (size_t i = 0; i < intrinsics.size(); ++i)
+                {
+                    Eigen::Map<Vec4>(coeffs.data() + 4 * i) = intrinsics[i].coeffs();
+                }
+                AppendArray(d, coeffs.data(), coeffs.size());
+                break;
+            }
+            case SECTION_EXTRINSICS:
+            {
+                constexpr int P = SE3::num_parameters;
+                std::vector<double> poses(N * P), velocities(N * P);
+                std::vector<int32_t> intr(N), num_points(N);
+                std::vector<uint8_t> constant(N);
+                for (size_t i = 0; i < N; ++i)
+                {
+                    auto& img = images[i];
+                    std::copy(img.se3.data(), img.se3.data() + P, poses.data() + P * i);
+                    std::copy(img.velocity.data(), img.velocity.data() + P, velocities.data() + P * i);
+                    intr[i]       = img.intr;
+                    num_points[i] = img.stereoPoints.size();
+                    constant[i]   = img.constant;
+                }
+                AppendArray(d, poses.data(), poses.size());
+                AppendArray(d, velocities.data(), velocities.size());
+                AppendArray(d, intr.data(), intr.size());
+                AppendArray(d, num_points.data(), num_points.size());
+                AppendArray(d, constant.data(), constant.size());
+                break;
+            }
+            case SECTION_IMAGE_POINTS:
+            {
+                std::vector<double> depth(M), point(2 * M);
+                std::vector<int32_t> wp(M);
+                std::vector<float> weight(M);
+                for (size_t i = 0; i < N; ++i)
+                {
+                    size_t offset = point_offsets[i];
+                    for (auto& ip : images[i].stereoPoints)
+                    {
+                        depth[offset]         = ip.depth;
+                        point[2 * offset + 0] = ip.point(0);
+                        point[2 * offset + 1] = ip.point(1);
+                        wp[offset]            = ip.wp;
+                        weight[offset]        = ip.weight;
+                        offset++;
+                    }
+                }
+                AppendArray(d, depth.data(), depth.size());
+                AppendArray(d, point.data(), point.size());
+                AppendArray(d, wp.data(), wp.size());
+                AppendArray(d, weight.data(), weight.size());
+                break;
+            }
+            case SECTION_WORLD_POINTS:
+            {
+                std::vector<double> p(worldPoints.size() * 3);
+                for (size_t i = 0; i < worldPoints.size(); ++i)
+                {
+                    Eigen::Map<Vec3>(p.data() + 3 * i) = worldPoints[i].p;
+                }
+                AppendArray(d, p.data(), p.size());
+                break;
+            }
+        }
+
+        auto& section      = sections[s];
+        section.id         = s;
+        section.compressed = compress;
+        section.size       = d.size();
+        section.checksum   = Checksum64(d.data(), d.size());
+#ifdef SAIGA_USE_ZLIB
+        if (compress)
+        {
+            auto compressed = Saiga::compress(d.data(), d.size());
+            d.assign(compressed.begin(), compressed.end());
+        }
+#endif
+        section.stored_size = d.size();
+    }
+
+    // Place the sections behind the header with 8 byte alignment
+    auto align8     = [](uint64_t x) { return (x + 7) & ~uint64_t(7); };
+    uint64_t offset = align8(sizeof(BinarySceneHeader) + sizeof(BinarySceneSection) * SECTION_COUNT);
+    for (auto& section : sections)
+    {
+        section.offset = offset;
+        offset         = align8(offset + section.stored_size);
+    }
+
+    std::ofstream strm(file, std::ios::binary);
+    SAIGA_ASSERT(strm.is_open());
+    strm.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    strm.write(reinterpret_cast<const char*>(sections.data()), sizeof(BinarySceneSection) * sections.size());
+    for (int s = 0; s < SECTION_COUNT; ++s)
+    {
+        char zeros[8] = {};
+        strm.write(zeros, sections[s].offset - strm.tellp());
+        strm.write(data[s].data(), data[s].size());
+    }
+    SAIGA_ASSERT(strm.good());
+}
+
+bool Scene::loadBinary(const std::string& file)
+{
+    std::cout << "Loading binary scene from " << file << "." << std::endl;
+
+    (*this)       = Scene();
+    std::string f = SearchPathes::data(file);
+    if (f.empty())
+    {
+        std::cout << "could not find file " << file << std::endl;
+        return false;
+    }
+
+    MemoryMappedFile mapped(f);
+    if (!mapped.valid() || mapped.size() < sizeof(BinarySceneHeader))
+    {
+        std::cout << "could not read file " << f << std::endl;
+        return false;
+    }
+
+    BinarySceneHeader header;
+    std::memcpy(&header, mapped.data(), sizeof(header));
+    if (std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0)
+    {
+        std::cout << f << " is not a binary scene file." << std::endl;
+        return false;
+    }
+    if (header.version != binary_version)
+    {
+        std::cout << "Unsupported binary scene version " << header.version << " (expected " << binary_version << ")."
+                  << std::endl;
+        return false;
+    }
+
+    size_t table_end = sizeof(BinarySceneHeader) + sizeof(BinarySceneSection) * header.num_sections;
+    if (table_end > mapped.size())
+    {
+        std::cout << "Truncated binary scene file " << f << std::endl;
+        return false;
+    }
+
+    // Sections with unknown ids are ignored
+    std::vector<BinarySceneSection> sections(SECTION_COUNT);
+    std::vector<bool> found(SECTION_COUNT, false);
+    for (uint32_t i = 0; i < header.num_sections; ++i)
+    {
+        BinarySceneSection section;
+        std::memcpy(&section, mapped.data() + sizeof(BinarySceneHeader) + sizeof(BinarySceneSection) * i,
+                    sizeof(section));
+        if (section.id < SECTION_COUNT)
+        {
+            sections[section.id] = section;
+            found[section.id]    = true;
+        }
+    }
+
+    size_t N = header.num_images;
+    size_t M = header.num_image_points;
+    size_t P = SE3::num_parameters;
+
+    std::vector<size_t> expected_size(SECTION_COUNT);
+    expected_size[SECTION_INTRINSICS]   = header.num_intrinsics * 4 * sizeof(double);
+    expected_size[SECTION_EXTRINSICS]   = N * (2 * P * sizeof(double) + 2 * sizeof(int32_t) + sizeof(uint8_t));
+    expected_size[SECTION_IMAGE_POINTS] = M * (3 * sizeof(double) + sizeof(int32_t) + sizeof(float));
+    expected_size[SECTION_WORLD_POINTS] = header.num_world_points * 3 * sizeof(double);
+
+    // Decompress and verify all sections in parallel.
+    // Uncompressed sections are used directly from the mapped file.
+    std::vector<std::vector<unsigned char>> decompressed(SECTION_COUNT);
+    std::vector<const char*> data(SECTION_COUNT, nullptr);
+    std::vector<std::string> errors(SECTION_COUNT);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < SECTION_COUNT; ++s)
+    {
+        auto& section = sections[s];
+        if (!found[s])
+        {
+            errors[s] = "missing";
+            continue;
+        }
+        if (section.size != expected_size[s])
+        {
+            errors[s] = "invalid size";
+            continue;
+        }
+        if (section.offset > mapped.size() || section.stored_size > mapped.size() - section.offset)
+        {
+            errors[s] = "truncated";
+            continue;
+        }
+
+        const char* ptr = mapped.data() + section.offset;
+        if (section.compressed)
+        {
+#ifdef SAIGA_USE_ZLIB
+            if (!Saiga::uncompress(ptr, section.stored_size, section.size, decompressed[s]))
+            {
+                errors[s] = "corrupt compressed data";
+                continue;
+            }
+            ptr = reinterpret_cast<const char*>(decompressed[s].data());
+#else
+            errors[s] = "compressed, but Saiga was compiled without zlib";
+            continue;
+#endif
+        }
+        else if (section.stored_size != section.size)
+        {
+            errors[s] = "invalid size";
+            continue;
+        }
+
+        if (Checksum64(ptr, section.size) != section.checksum)
+        {
+            errors[s] = "checksum mismatch";
+            continue;
+        }
+        data[s] = ptr;
+    }
+
+    bool ok = true;
+    for (int s = 0; s < SECTION_COUNT; ++s)
+    {
+        if (!errors[s].empty())
+        {
+            std::cout << "Binary scene " << f << ": section " << s << " " << errors[s] << "." << std::endl;
+            ok = false;
+        }
+    }
+    if (!ok) return false;
+
+    bf            = header.bf;
+    globalScale   = header.globalScale;
+    stereo_weight = header.stereo_weight;
+    intrinsics.resize(header.num_intrinsics);
+    images.resize(N);
+    worldPoints.resize(header.num_world_points);
+
+    SectionReader extrinsics_reader{data[SECTION_EXTRINSICS]};
+    auto poses      = extrinsics_reader.take<double>(N * P);
+    auto velocities = extrinsics_reader.take<double>(N * P);
+    auto intr       = extrinsics_reader.take<int32_t>(N);
+    auto num_points = extrinsics_reader.take<int32_t>(N);
+    auto constant   = extrinsics_reader.take<uint8_t>(N);
+
+    SectionReader points_reader{data[SECTION_IMAGE_POINTS]};
+    auto depth  = points_reader.take<double>(M);
+    auto point  = points_reader.take<double>(2 * M);
+    auto wp     = points_reader.take<int32_t>(M);
+    auto weight = points_reader.take<float>(M);
+
+    auto intrinsic_coeffs = reinterpret_cast<const double*>(data[SECTION_INTRINSICS]);
+    auto world_points     = reinterpret_cast<const double*>(data[SECTION_WORLD_POINTS]);
+
+    // Reject references out of range before they are used as indices
+    std::string invalid;
+    for (size_t i = 0; i < N && invalid.empty(); ++i)
+    {
+        if (num_points[i] < 0) invalid = "negative number of image points";
+        if (intr[i] < 0 || uint64_t(intr[i]) >= header.num_intrinsics) invalid = "invalid intrinsics reference";
+    }
+    for (size_t i = 0; i < M && invalid.empty(); ++i)
+    {
+        if (wp[i] < -1 || (wp[i] >= 0 && uint64_t(wp[i]) >= header.num_world_points))
+            invalid = "invalid world point reference";
+    }
+    if (!invalid.empty())
+    {
+        std::cout << "Binary scene " << f << ": " << invalid << "." << std::endl;
+        (*this) = Scene();
+        return false;
+    }
+
+    std::vector<size_t> point_offsets(N + 1, 0);
+    for (size_t i = 0; i < N; ++i) point_offsets[i + 1] = point_offsets[i] + num_points[i];
+    if (point_offsets.back() != M)
+    {
+        std::cout << "Binary scene " << f << ": inconsistent number of image points." << std::endl;
+        (*this) = Scene();
+        return false;
+    }
+
+#pragma omp parallel
+    {
+#pragma omp for nowait
+        for (size_t i = 0; i < intrinsics.size(); ++i)
+        {
+            intrinsics[i] = Vec4(Eigen::Map<const Vec4>(intrinsic_coeffs + 4 * i));
+        }
+
+#pragma omp for nowait
+        for (size_t i = 0; i < worldPoints.size(); ++i)
+        {
+            worldPoints[i].p = Eigen::Map<const Vec3>(world_points + 3 * i);
+        }
+
+#pragma omp for schedule(dynamic, 16)
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto& img = images[i];
+            std::copy(poses + P * i, poses + P * (i + 1), img.se3.data());
+            std::copy(velocities + P * i, velocities + P * (i + 1), img.velocity.data());
+            img.intr     = intr[i];
+            img.constant = constant[i];
+
+            img.stereoPoints.resize(num_points[i]);
+            size_t offset = point_offsets[i];
+            for (auto& ip : img.stereoPoints)
+            {
+                ip.wp     = wp[offset];
+                ip.depth  = depth[offset];
+                ip.point  = Vec2(point[2 * offset], point[2 * offset + 1]);
+                ip.weight = weight[offset];
+                offset++;
+            }
+        }
+    }
+
+    fixWorldPointReferences();
+    SAIGA_ASSERT(valid());
+    return true;
+}
+
 
 std::ostream& operator<<(std::ostream& strm, Scene& scene)
 {
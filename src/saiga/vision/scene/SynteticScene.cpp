@@ -83,6 +83,47 @@ Scene CircleSphere(int numWorldPoints, int numCameras, int numImagePoints, bool
     return scene;
 }
 
+Scene Trajectory(int numWorldPoints, int numCameras, double visibleRange, double stepSize)
+{
+    Scene scene;
+
+    double length = (numCameras - 1) * stepSize;
+    for (int i = 0; i < numWorldPoints; ++i)
+    {
+        WorldPoint wp;
+        wp.p = Vec3(Random::sampleDouble(-visibleRange, length + visibleRange), Random::sampleDouble(-1, 1),
+                    Random::sampleDouble(3, 5));
+        scene.worldPoints.push_back(wp);
+    }
+
+    Intrinsics4 intr(1000, 1000, 500, 500);
+    scene.intrinsics.push_back(intr);
+
+    for (int i = 0; i < numCameras; ++i)
+    {
+        Vec3 position(i * stepSize, 0, 0);
+
+        SceneImage si;
+        si.se3  = SE3(Quat::Identity(), -position);
+        si.intr = 0;
+
+        for (int j = 0; j < numWorldPoints; ++j)
+        {
+            if (std::abs(scene.worldPoints[j].p.x() - position.x()) >= visibleRange) continue;
+            StereoImagePoint mip;
+            mip.wp    = j;
+            auto p    = si.se3 * scene.worldPoints[mip.wp].p;
+            mip.point = intr.project(p);
+            si.stereoPoints.push_back(mip);
+        }
+        scene.images.push_back(si);
+    }
+
+    scene.fixWorldPointReferences();
+    scene.rms();
+    return scene;
+}
+
 Scene SceneCreator::circleSphere()
 {
     return CircleSphere(numWorldPoints, numCameras, numImagePoints, random_sphere);
@@ -19,6 +19,13 @@ namespace SynteticScene
  */
 SAIGA_VISION_API Scene CircleSphere(int numWorldPoints, int numCameras, int numImagePoints, bool random_sphere = false);
 
+/**
+ * Generates #numCameras cameras moving along the x-axis (distance #stepSize) and looking in z direction.
+ * The world points are distributed uniformly in front of the trajectory. A camera only observes points with a distance
+ * in x smaller than #visibleRange. This is a typical SLAM sequence for incremental and sliding window optimization.
+ */
+SAIGA_VISION_API Scene Trajectory(int numWorldPoints, int numCameras, double visibleRange, double stepSize = 0.1);
+
 
 
 /**
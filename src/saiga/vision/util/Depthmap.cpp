@@ -15,6 +15,7 @@ namespace Depthmap
 void toPointCloud(DepthMap dm, DepthPointCloud pc, const Intrinsics4& camera)
 {
     SAIGA_ASSERT(dm.h == pc.h && dm.w == pc.w);
+#pragma omp parallel for
     for (int i = 0; i < dm.h; ++i)
     {
         for (int j = 0; j < dm.w; ++j)
@@ -36,6 +37,7 @@ void toPointCloud(DepthMap dm, DepthPointCloud pc, const Intrinsics4& camera)
 void normalMap(DepthPointCloud pc, DepthNormalMap normals)
 {
     SAIGA_ASSERT(normals.h == pc.h && normals.w == pc.w);
+#pragma omp parallel for
     for (int i = 0; i < normals.h; ++i)
     {
         for (int j = 0; j < normals.w; ++j)
@@ -36,6 +36,11 @@ void OptimizationOptions::imgui()
     {
         ImGui::InputInt("maxIterativeIterations", &maxIterativeIterations);
         ImGui::InputDouble("iterativeTolerance", &iterativeTolerance);
+
+        int currentPrecond                  = (int)preconditioner;
+        static const char* precondItems[4] = {"BlockJacobi", "SSOR", "IncompleteCholesky", "ClusterJacobi"};
+        ImGui::Combo("Preconditioner", &currentPrecond, precondItems, 4);
+        preconditioner = (PreconditionerType)currentPrecond;
     }
 
     ImGui::Checkbox("debugOutput", &debugOutput);
@@ -53,6 +58,7 @@ std::ostream& operator<<(std::ostream& strm, const OptimizationOptions& op)
         strm << " solverType: CG Schur" << std::endl;
         strm << " maxIterativeIterations: " << op.maxIterativeIterations << std::endl;
         strm << " iterativeTolerance: " << op.iterativeTolerance << std::endl;
+        strm << " preconditioner: " << (int)op.preconditioner << std::endl;
     }
     else
     {
@@ -67,6 +73,7 @@ OptimizationResults LMOptimizer::solve()
 
     OptimizationResults result;
     result.linear_solver_time = 0;
+    linearSolverIterations    = 0;
 
 
 
@@ -204,7 +211,8 @@ OptimizationResults LMOptimizer::solve()
     }
     finalize();
 
-    result.cost_final = current_chi2;
+    result.cost_final               = current_chi2;
+    result.linear_solver_iterations = linearSolverIterations;
     return result;
 }
 
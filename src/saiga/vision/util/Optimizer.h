@@ -23,6 +23,9 @@ struct SAIGA_VISION_API OptimizationResults
     double jtj_time           = 0;
     double total_time         = 0;
 
+    // Sum of all CG iterations (only for the iterative solvers)
+    int linear_solver_iterations = 0;
+
     bool success = false;
 };
 
@@ -43,6 +46,33 @@ struct SAIGA_VISION_API OptimizationOptions
     double iterativeTolerance  = 1e-5;
     bool buildExplizitSchur    = false;
 
+    // Preconditioner of the iterative solver.
+    //   BlockJacobi:        Inverse of the diagonal blocks.
+    //   SSOR:               Block SSOR with relaxation ssorOmega (1 = symmetric Gauss-Seidel).
+    //   IncompleteCholesky: Block IC(k) with k = icFillLevel.
+    //   ClusterJacobi:      Inverse of the diagonal blocks of clusters with up to clusterSize cameras.
+    //                       For BA the cameras are clustered by covisibility.
+    // SSOR and IncompleteCholesky always build the explicit Schur complement.
+    enum class PreconditionerType : int
+    {
+        BlockJacobi        = 0,
+        SSOR               = 1,
+        IncompleteCholesky = 2,
+        ClusterJacobi      = 3
+    };
+    PreconditionerType preconditioner = PreconditionerType::BlockJacobi;
+    double ssorOmega                  = 1.0;
+    int icFillLevel                   = 0;
+    int clusterSize                   = 8;
+
+    // Iterative refinement of the linear solution. Recommended for the mixed precision solvers.
+    int refinementSteps = 0;
+
+    // Sparse factorization of the direct solver. Cholmod is only used if it was found at compile time.
+    // Otherwise the recursive supernodal (or simplicial) LDLT is used.
+    bool cholmod    = true;
+    bool supernodal = true;
+
     // early termiante if the chi2 delta is smaller than this value
     double minChi2Delta  = 1e-5;
     double initialLambda = 1.00e-04;
@@ -100,6 +130,9 @@ class SAIGA_VISION_API LMOptimizer : public Optimizer
 
     double lambda;
     double v = 2;
+
+    // Accumulated by solveLinearSystem() of the iterative solvers
+    int linearSolverIterations = 0;
 };
 
 }  // namespace Saiga
@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/geometry/AccelerationStructure.h"
+#include "saiga/core/geometry/BVH4.h"
+#include "saiga/core/math/random.h"
+
+#include "gtest/gtest.h"
+
+using namespace Saiga;
+
+// Small random triangles inside [-1,1]^3
+static std::vector<Triangle> RandomTriangles(int n)
+{
+    std::vector<Triangle> result(n);
+    for (auto& t : result)
+    {
+        vec3 center = Random::MatrixUniform<vec3>(-1, 1);
+        t.a         = center + Random::MatrixUniform<vec3>(-0.1, 0.1);
+        t.b         = center + Random::MatrixUniform<vec3>(-0.1, 0.1);
+        t.c         = center + Random::MatrixUniform<vec3>(-0.1, 0.1);
+    }
+    return result;
+}
+
+static Ray RandomRay()
+{
+    vec3 origin = Random::MatrixUniform<vec3>(-2, 2);
+    vec3 target = Random::MatrixUniform<vec3>(-0.5, 0.5);
+    return Ray((target - origin).normalized(), origin);
+}
+
+TEST(AccelerationStructure, SAHBVH)
+{
+    Random::setSeed(9345);
+    auto triangles = RandomTriangles(5000);
+
+    AccelerationStructure::SAHBVH bvh(triangles);
+    AccelerationStructure::BruteForce bf(triangles);
+
+    // Every triangle is referenced by exactly one leaf
+    std::vector<int> count(triangles.size(), 0);
+    for (auto& node : bvh.Nodes())
+    {
+        if (node._inner) continue;
+        for (uint32_t i = node._left; i < node._right; ++i) count[bvh.Triangles()[i].second]++;
+    }
+    for (auto c : count) EXPECT_EQ(c, 1);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        auto ray      = RandomRay();
+        auto expected = bf.getClosest(ray);
+        auto inter    = bvh.getClosest(ray);
+        EXPECT_EQ(inter.valid, expected.valid);
+        if (expected.valid)
+        {
+            EXPECT_EQ(inter.triangleIndex, expected.triangleIndex);
+            EXPECT_FLOAT_EQ(inter.t, expected.t);
+        }
+        EXPECT_EQ(bvh.getAll(ray).size(), bf.getAll(ray).size());
+    }
+}
+
+TEST(AccelerationStructure, BVH4)
+{
+    Random::setSeed(2938);
+    for (int n : {1, 3, 17, 5000})
+    {
+        auto triangles = RandomTriangles(n);
+
+        AccelerationStructure::BVH4 bvh(triangles);
+        AccelerationStructure::BruteForce bf(triangles);
+
+        for (int i = 0; i < 500; ++i)
+        {
+            auto ray      = RandomRay();
+            auto expected = bf.getClosest(ray);
+            auto inter    = bvh.getClosest(ray);
+            EXPECT_EQ(inter.valid, expected.valid);
+            if (expected.valid && inter.valid)
+            {
+                EXPECT_NEAR(inter.t, expected.t, 1e-5);
+                EXPECT_EQ(inter.backFace, triangles[inter.triangleIndex].normal().dot(ray.direction) > 0);
+            }
+            EXPECT_EQ(bvh.getAll(ray).size(), bf.getAll(ray).size());
+        }
+    }
+}
+
+TEST(AccelerationStructure, ClosestPoint)
+{
+    Random::setSeed(1273);
+    auto triangles = RandomTriangles(5000);
+
+    AccelerationStructure::ObjectMedianBVH median(triangles);
+    AccelerationStructure::BVH4 bvh(triangles);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        vec3 p = Random::MatrixUniform<vec3>(-1.5, 1.5);
+
+        float expected = std::numeric_limits<float>::infinity();
+        for (auto& t : triangles) expected = std::min(expected, t.Distance(p));
+
+        // Both use Triangle::Distance -> exactly the same result
+        EXPECT_EQ(bvh.ClosestPoint(p).first, expected);
+        EXPECT_EQ(median.ClosestPoint(p).first, expected);
+        EXPECT_EQ(triangles[bvh.ClosestPoint(p).second].Distance(p), expected);
+    }
+}
+
+TEST(AccelerationStructure, Batch)
+{
+    Random::setSeed(8234);
+    auto triangles = RandomTriangles(5000);
+
+    AccelerationStructure::BVH4 bvh(triangles);
+    AccelerationStructure::BruteForce bf(triangles);
+
+    // Coherent rays of 4x4 tiles from a common origin followed by random rays
+    std::vector<Ray> rays;
+    for (int tile = 0; tile < 64; ++tile)
+    {
+        vec3 origin = Random::MatrixUniform<vec3>(-2, 2);
+        vec3 target = Random::MatrixUniform<vec3>(-0.5, 0.5);
+        for (int i = 0; i < 16; ++i)
+        {
+            vec3 offset = vec3(i % 4, i / 4, 0) * 0.01;
+            rays.push_back(Ray((target + offset - origin).normalized(), origin));
+        }
+    }
+    for (int i = 0; i < 500; ++i) rays.push_back(RandomRay());
+
+    std::vector<Intersection::RayTriangleIntersection> expected(rays.size()), result(rays.size());
+    bf.getClosestBatch(rays, expected);
+
+    float t_max = 2;
+    std::vector<uint8_t> occluded(rays.size());
+
+    for (int packet_size : {1, 4, 8, 16})
+    {
+        bvh.packet_size = packet_size;
+        bvh.getClosestBatch(rays, result);
+        bvh.isOccludedBatch(rays, t_max, occluded);
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            // Same intersection code as the single ray traversal
+            auto single = bvh.getClosest(rays[i]);
+            EXPECT_EQ(result[i].valid, single.valid);
+            EXPECT_EQ(result[i].t, single.t);
+            EXPECT_EQ(result[i].triangleIndex, single.triangleIndex);
+
+            EXPECT_EQ(result[i].valid, expected[i].valid);
+            if (result[i].valid && expected[i].valid)
+            {
+                EXPECT_NEAR(result[i].t, expected[i].t, 1e-5);
+            }
+
+            bool expected_occluded = expected[i].valid && expected[i].t < t_max;
+            // Hits close to t_max might differ because of the different rounding
+            if (expected[i].valid && std::abs(expected[i].t - t_max) < 1e-4) continue;
+            EXPECT_EQ(bool(occluded[i]), expected_occluded);
+            EXPECT_EQ(bvh.isOccluded(rays[i], t_max), expected_occluded);
+        }
+    }
+}
@@ -5,9 +5,13 @@
  */
 
 
+#include "saiga/core/geometry/BatchCulling.h"
+#include "saiga/core/geometry/Frustum.h"
 #include "saiga/core/geometry/intersection.h"
 #include "saiga/core/geometry/plane.h"
 #include "saiga/core/geometry/sphere.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/time/performanceMeasure.h"
 
 #include "gtest/gtest.h"
 
@@ -49,7 +53,16 @@ class ClustererTest : public ::testing::Test
 
     void TearDown() override {}
 
-    void clusterLights()
+    void clusterLights() { clusterLightsImpl<false>(); }
+
+    // Same as clusterLights(), but on the SIMD kernels of BatchCulling.h:
+    //  - Lights outside of the grid are culled 4 at a time.
+    //  - The distances of a light to all planes are computed at once.
+    // The refinement only walks the small range [x0, x1] and stays scalar.
+    void clusterLightsBatched() { clusterLightsImpl<true>(); }
+
+    template <bool Batched>
+    void clusterLightsImpl()
     {
         clusterCache.resize(clusterCount);
         for (int c = 0; c < clusterCount; ++c)
@@ -60,12 +73,36 @@ class ClustererTest : public ::testing::Test
 
         int itemCount = 0;
 
-        for (int i = 0; i < clusterData.size(); ++i)
+        PlaneSoA soaX(planesX), soaY(planesY), soaZ(planesZ);
+        std::vector<float> distX(soaX.paddedSize()), distY(soaY.paddedSize()), distZ(soaZ.paddedSize());
+
+        std::vector<int> visible;
+        if constexpr (Batched)
         {
+            // Lights outside of the complete grid can not intersect any cluster
+            SphereSoA lights(clusterData);
+            Frustum outer = outerFrustum();
+            FrustumCullIndices(outer, lights, visible);
+        }
+        int numLights = Batched ? visible.size() : clusterData.size();
+
+        for (int j = 0; j < numLights; ++j)
+        {
+            int i              = Batched ? visible[j] : j;
             Sphere& sphere     = clusterData[i];
             vec3 sphereCenter  = sphere.pos;
             float sphereRadius = sphere.r;
 
+            if constexpr (Batched)
+            {
+                PlaneDistances(soaZ, sphereCenter, distZ.data());
+                PlaneDistances(soaY, sphereCenter, distY.data());
+                PlaneDistances(soaX, sphereCenter, distX.data());
+            }
+            auto dZ = [&](int k) { return Batched ? distZ[k] : planesZ[k].distance(sphereCenter); };
+            auto dY = [&](int k) { return Batched ? distY[k] : planesY[k].distance(sphereCenter); };
+            auto dX = [&](int k) { return Batched ? distX[k] : planesX[k].distance(sphereCenter); };
+
             int x0 = 0, x1 = planesX.size() - 1;
             int y0 = 0, y1 = planesY.size() - 1;
             int z0 = 0, z1 = planesZ.size() - 1;
@@ -74,20 +111,20 @@ class ClustererTest : public ::testing::Test
             int centerOutsideY = 0;
 
 
-            while (z0 < z1 && planesZ[z0].distance(sphereCenter) >= sphereRadius)
+            while (z0 < z1 && dZ(z0) >= sphereRadius)
             {
                 z0++;
             }
-            if (--z0 < 0 && planesZ[0].distance(sphereCenter) < 0)
+            if (--z0 < 0 && dZ(0) < 0)
             {
                 centerOutsideZ--;
             }
             z0 = std::max(0, z0);
-            while (z1 >= z0 && -planesZ[z1].distance(sphereCenter) >= sphereRadius)
+            while (z1 >= z0 && -dZ(z1) >= sphereRadius)
             {
                 --z1;
             }
-            if (++z1 > (int)planesZ.size() - 1 && planesZ[(int)planesZ.size() - 1].distance(sphereCenter) > 0)
+            if (++z1 > (int)planesZ.size() - 1 && dZ((int)planesZ.size() - 1) > 0)
             {
                 centerOutsideZ++;
             }
@@ -98,20 +135,20 @@ class ClustererTest : public ::testing::Test
             }
 
 
-            while (y0 < y1 && planesY[y0].distance(sphereCenter) >= sphereRadius)
+            while (y0 < y1 && dY(y0) >= sphereRadius)
             {
                 y0++;
             }
-            if (--y0 < 0 && planesY[0].distance(sphereCenter) < 0)
+            if (--y0 < 0 && dY(0) < 0)
             {
                 centerOutsideY--;
             }
             y0 = std::max(0, y0);
-            while (y1 >= y0 && -planesY[y1].distance(sphereCenter) >= sphereRadius)
+            while (y1 >= y0 && -dY(y1) >= sphereRadius)
             {
                 --y1;
             }
-            if (++y1 > (int)planesY.size() - 1 && planesY[(int)planesY.size() - 1].distance(sphereCenter) > 0)
+            if (++y1 > (int)planesY.size() - 1 && dY((int)planesY.size() - 1) > 0)
             {
                 centerOutsideY++;
             }
@@ -122,12 +159,12 @@ class ClustererTest : public ::testing::Test
             }
 
 
-            while (x0 < x1 && planesX[x0].distance(sphereCenter) >= sphereRadius)
+            while (x0 < x1 && dX(x0) >= sphereRadius)
             {
                 x0++;
             }
             x0 = std::max(0, --x0);
-            while (x1 >= x0 && -planesX[x1].distance(sphereCenter) >= sphereRadius)
+            while (x1 >= x0 && -dX(x1) >= sphereRadius)
             {
                 --x1;
             }
@@ -170,8 +207,8 @@ class ClustererTest : public ::testing::Test
                 int centerZ = cz / 2;
                 if (centerOutsideZ == 0 && cz % 2 == 0)
                 {
-                    float d0 = planesZ[z0].distance(sphereCenter);
-                    float d1 = -planesZ[z1].distance(sphereCenter);
+                    float d0 = dZ(z0);
+                    float d1 = -dZ(z1);
                     if (d0 <= d1) centerZ -= 1;
                 }
 
@@ -187,8 +224,8 @@ class ClustererTest : public ::testing::Test
                 int centerY = cy / 2;
                 if (centerOutsideY == 0 && cy % 2 == 0)
                 {
-                    float d0 = planesY[y0].distance(sphereCenter);
-                    float d1 = -planesY[y1].distance(sphereCenter);
+                    float d0 = dY(y0);
+                    float d1 = -dY(y1);
                     if (d0 <= d1) centerY -= 1;
                 }
 
@@ -241,6 +278,15 @@ class ClustererTest : public ::testing::Test
         }
     }
 
+    // The planes of the whole grid, with the normals pointing outwards.
+    Frustum outerFrustum()
+    {
+        Frustum outer;
+        outer.planes = {planesZ.front().invert(), planesZ.back(),          planesY.back(),
+                        planesY.front().invert(), planesX.front().invert(), planesX.back()};
+        return outer;
+    }
+
     void clusterLightsSAT()
     {
         clusterCacheSat.resize(clusterCount);
@@ -681,4 +727,49 @@ TEST_F(ClustererTest, ThreeCubedClustersOneSphereCenterBigger)
     }
 }
 
+TEST_F(ClustererTest, Batched)
+{
+    Random::setSeed(9345);
+    buildClusters(32, 18, 24, 1, 1, 0.5);
+
+    // Grid size is 32x18x12. Around half of the lights are outside.
+    for (int i = 0; i < 4000; ++i)
+    {
+        vec3 p(Random::sampleDouble(-16, 48), Random::sampleDouble(-9, 27), Random::sampleDouble(-6, 18));
+        clusterData.push_back(Sphere(p, Random::sampleDouble(0.1, 3)));
+    }
+
+    Frustum outer = outerFrustum();
+    std::vector<bool> outside(clusterData.size());
+    int numOutside = 0;
+    for (int i = 0; i < clusterData.size(); ++i)
+    {
+        outside[i] = outer.sphereInFrustum(clusterData[i]) == Frustum::OUTSIDE;
+        numOutside += outside[i];
+    }
+    EXPECT_GT(numOutside, 1000);
+
+    for (bool r : {false, true})
+    {
+        refinement = r;
+        clusterLights();
+        auto reference = clusterCache;
+        // The plane walk can assign lights outside of the grid to the border clusters.
+        // The batched version culls them before.
+        for (auto& c : reference)
+        {
+            c.erase(std::remove_if(c.begin(), c.end(), [&](int i) { return outside[i]; }), c.end());
+        }
+
+        clusterLightsBatched();
+        EXPECT_EQ(clusterCache, reference);
+
+        // The loop with one light and one plane at a time is the baseline.
+        auto scalar  = measureObject(5, [&]() { clusterLights(); });
+        auto batched = measureObject(5, [&]() { clusterLightsBatched(); });
+        std::cout << "Refinement " << r << ": Plane by plane " << scalar.median << "ms, Batched " << batched.median
+                  << "ms" << std::endl;
+    }
+}
+
 }  // namespace Saiga
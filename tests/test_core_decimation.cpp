@@ -0,0 +1,208 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/geometry/QuadricDecimation.h"
+#include "saiga/core/geometry/half_edge_mesh.h"
+#include "saiga/core/model/model_from_shape.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+
+using namespace Saiga;
+
+using MeshType = TriangleMesh<VertexNC, uint32_t>;
+
+static MeshType IcoSphere(int resolution)
+{
+    auto model = IcoSphereMesh(Saiga::Sphere(vec3(0, 0, 0), 1), resolution);
+    auto mesh  = model.Mesh<VertexNC, uint32_t>();
+    // The icosphere has duplicated vertices at the seams
+    mesh.weldVertices(0);
+    return mesh;
+}
+
+// A flat n x n grid in the xy-plane with a color gradient along x
+static MeshType Grid(int n)
+{
+    MeshType mesh;
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            float x = float(j) / (n - 1), y = float(i) / (n - 1);
+            VertexNC v(vec3(x, y, 0), vec3(0, 0, 1));
+            v.color = vec4(x, 1 - x, 0, 1);
+            mesh.vertices.push_back(v);
+        }
+    }
+    for (int i = 0; i < n - 1; ++i)
+    {
+        for (int j = 0; j < n - 1; ++j)
+        {
+            uint32_t v = i * n + j;
+            mesh.addFace(v, v + 1, v + n + 1);
+            mesh.addFace(v, v + n + 1, v + n);
+        }
+    }
+    return mesh;
+}
+
+// Number of edges with exactly one face. -1 if the mesh is not manifold.
+static int BoundaryEdges(const MeshType& mesh)
+{
+    std::map<std::pair<int, int>, int> edges;
+    for (auto& f : mesh.faces)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            int a = f(j), b = f((j + 1) % 3);
+            edges[{std::min(a, b), std::max(a, b)}]++;
+        }
+    }
+    int boundary = 0;
+    for (auto& e : edges)
+    {
+        if (e.second > 2) return -1;
+        boundary += e.second == 1;
+    }
+    return boundary;
+}
+
+TEST(QuadricDecimation, HalfEdgeMesh)
+{
+    auto mesh = IcoSphere(2);
+    HalfEdgeMesh<VertexNC, uint32_t> hem(mesh);
+    EXPECT_TRUE(hem.isValid());
+
+    // Closed mesh -> every vertex has a ring without boundary
+    for (int v = 0; v < (int)hem.vertices.size(); ++v)
+    {
+        EXPECT_FALSE(hem.isBoundaryVertex(v));
+        std::vector<int> neighbours;
+        hem.getNeighbours(v, neighbours);
+        EXPECT_GE(neighbours.size(), 5);
+    }
+
+    // Collapse a few edges manually
+    for (int he : {0, 30, 60, 90})
+    {
+        hem.halfEdgeCollapse(he);
+        EXPECT_TRUE(hem.isValid());
+    }
+
+    MeshType result;
+    hem.toIFS(result);
+    result.removeUnusedVertices();
+    EXPECT_EQ(result.faces.size(), mesh.faces.size() - 8);
+    EXPECT_EQ(result.vertices.size(), mesh.vertices.size() - 4);
+    EXPECT_EQ(BoundaryEdges(result), 0);
+}
+
+TEST(QuadricDecimation, Sphere)
+{
+    auto mesh = IcoSphere(4);
+    QuadricDecimationSettings settings;
+    settings.target_faces = mesh.faces.size() / 10;
+    QuadricDecimate(mesh, settings);
+
+    EXPECT_LE(mesh.faces.size(), settings.target_faces);
+    EXPECT_GE(mesh.faces.size(), settings.target_faces - 1);
+    EXPECT_TRUE(mesh.isValid());
+    EXPECT_EQ(BoundaryEdges(mesh), 0);
+
+    // Euler characteristic of a sphere
+    EXPECT_EQ(int(mesh.vertices.size()) - int(mesh.faces.size()) / 2, 2);
+
+    for (auto& v : mesh.vertices)
+    {
+        EXPECT_NEAR(make_vec3(v.position).norm(), 1, 0.02);
+    }
+}
+
+TEST(QuadricDecimation, PlaneWithBoundary)
+{
+    // Every inner vertex of a plane can be removed without error. The boundary has to stay in place.
+    auto mesh = Grid(30);
+    QuadricDecimationSettings settings;
+    settings.max_error = 1e-8;
+    QuadricDecimate(mesh, settings);
+
+    EXPECT_LT(mesh.faces.size(), 200);
+    EXPECT_EQ(BoundaryEdges(mesh) > 0, true);
+
+    AABB box = mesh.aabb();
+    EXPECT_NEAR(box.min.x(), 0, 1e-5);
+    EXPECT_NEAR(box.min.y(), 0, 1e-5);
+    EXPECT_NEAR(box.max.x(), 1, 1e-5);
+    EXPECT_NEAR(box.max.y(), 1, 1e-5);
+
+    float area = 0;
+    for (auto& f : mesh.faces)
+    {
+        vec3 a = make_vec3(mesh.vertices[f(0)].position);
+        vec3 b = make_vec3(mesh.vertices[f(1)].position);
+        vec3 c = make_vec3(mesh.vertices[f(2)].position);
+        vec3 n = (b - a).cross(c - a);
+        // No flipped faces
+        EXPECT_GT(n.z(), 0);
+        area += n.norm() * 0.5;
+    }
+    EXPECT_NEAR(area, 1, 1e-4);
+
+    // The color gradient is interpolated at the new positions
+    for (auto& v : mesh.vertices)
+    {
+        EXPECT_NEAR(v.color.x(), v.position.x(), 1e-4);
+        EXPECT_NEAR(v.position.z(), 0, 1e-6);
+    }
+}
+
+TEST(QuadricDecimation, LockBoundary)
+{
+    auto mesh = Grid(20);
+    int n     = 20;
+    QuadricDecimationSettings settings;
+    settings.lock_boundary = true;
+    settings.target_faces  = 100;
+    QuadricDecimate(mesh, settings);
+
+    // All 4 * (n-1) boundary vertices remain
+    EXPECT_EQ(BoundaryEdges(mesh), 4 * (n - 1));
+    int boundary_vertices = 0;
+    for (auto& v : mesh.vertices)
+    {
+        vec3 p = make_vec3(v.position);
+        boundary_vertices += (p.x() == 0 || p.y() == 0 || p.x() == 1 || p.y() == 1);
+    }
+    EXPECT_EQ(boundary_vertices, 4 * (n - 1));
+}
+
+TEST(QuadricDecimation, Parallel)
+{
+    auto mesh   = IcoSphere(5);
+    auto serial = mesh;
+
+    QuadricDecimationSettings settings;
+    settings.target_faces = mesh.faces.size() / 20;
+    QuadricDecimate(serial, settings);
+    QuadricDecimateParallel(mesh, settings, 3);
+
+    EXPECT_LE(mesh.faces.size(), settings.target_faces);
+    EXPECT_GE(mesh.faces.size(), settings.target_faces - 1);
+    EXPECT_TRUE(mesh.isValid());
+
+    // The seams are stitched -> still a closed sphere
+    EXPECT_EQ(BoundaryEdges(mesh), 0);
+    EXPECT_EQ(int(mesh.vertices.size()) - int(mesh.faces.size()) / 2, 2);
+
+    double max_error = 0, max_error_serial = 0;
+    for (auto& v : mesh.vertices) max_error = std::max<double>(max_error, std::abs(make_vec3(v.position).norm() - 1));
+    for (auto& v : serial.vertices)
+        max_error_serial = std::max<double>(max_error_serial, std::abs(make_vec3(v.position).norm() - 1));
+    EXPECT_LT(max_error, 0.02);
+    EXPECT_LT(max_error, 2 * max_error_serial + 1e-3);
+}
@@ -5,10 +5,15 @@
  */
 
 #include "saiga/config.h"
+#include "saiga/core/geometry/BatchCulling.h"
 #include "saiga/core/geometry/Frustum.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/util/CpuFeatures.h"
 
 #include "gtest/gtest.h"
 
+#include <bitset>
+
 namespace Saiga
 {
 TEST(Frustum, frustum)
@@ -17,5 +22,117 @@ TEST(Frustum, frustum)
     std::cout << frustum << std::endl;
 }
 
+static Frustum TestFrustum()
+{
+    mat4 model = mat4::Identity();
+    model.block<3, 1>(0, 3) = vec3(1, 2, 3);
+    return Frustum(model, radians(60.f), 1.5, 1, 20);
+}
+
+TEST(Frustum, BatchCullingSpheres)
+{
+    Random::setSeed(2354);
+    Frustum frustum = TestFrustum();
+
+    // 1001 is not a multiple of 4 or 32 -> tests the padding
+    std::vector<Sphere> spheres;
+    for (int i = 0; i < 1001; ++i)
+    {
+        vec3 p = Random::MatrixUniform<vec3>(-25, 25);
+        spheres.emplace_back(p, Random::sampleDouble(0, 3));
+    }
+    SphereSoA soa(spheres);
+    EXPECT_EQ(soa.size(), 1001);
+    EXPECT_EQ(soa.paddedSize(), 1004);
+
+    std::vector<int> expected;
+    for (int i = 0; i < (int)spheres.size(); ++i)
+    {
+        if (frustum.sphereInFrustum(spheres[i]) != Frustum::OUTSIDE) expected.push_back(i);
+    }
+    EXPECT_GT(expected.size(), 10);
+    EXPECT_LT(expected.size(), spheres.size() / 2);
+
+    for (bool simd : {false, true})
+    {
+        setSimdEnabled(simd);
+        std::vector<int> indices;
+        EXPECT_EQ(FrustumCullIndices(frustum, soa, indices), expected.size());
+        EXPECT_EQ(indices, expected);
+
+        std::vector<uint32_t> mask;
+        FrustumCullMask(frustum, soa, mask);
+        EXPECT_EQ(mask.size(), 32);
+        int visible = 0;
+        for (auto m : mask) visible += std::bitset<32>(m).count();
+        EXPECT_EQ(visible, expected.size());
+        for (int i : expected) EXPECT_TRUE(MaskBit(mask, i));
+    }
+    setSimdEnabled(true);
+}
+
+TEST(Frustum, BatchCullingAABB)
+{
+    Random::setSeed(9834);
+    Frustum frustum = TestFrustum();
+
+    AABBSoA soa;
+    std::vector<int> expected;
+    for (int i = 0; i < 777; ++i)
+    {
+        vec3 p = Random::MatrixUniform<vec3>(-25, 25);
+        vec3 e = Random::MatrixUniform<vec3>(0, 3);
+        AABB box(p - e, p + e);
+        soa.push_back(box);
+        EXPECT_EQ(soa.get(i).min, box.min);
+        if (frustum.aabbInFrustum(box) != Frustum::OUTSIDE) expected.push_back(i);
+    }
+    EXPECT_GT(expected.size(), 10);
+
+    // A box at the camera position is inside, a box behind the camera is outside
+    EXPECT_NE(frustum.aabbInFrustum(AABB(vec3(0, 1, -3), vec3(2, 3, -2))), Frustum::OUTSIDE);
+    EXPECT_EQ(frustum.aabbInFrustum(AABB(vec3(0, 1, 4), vec3(2, 3, 5))), Frustum::OUTSIDE);
+
+    for (bool simd : {false, true})
+    {
+        setSimdEnabled(simd);
+        std::vector<int> indices;
+        FrustumCullIndices(frustum, soa, indices);
+        EXPECT_EQ(indices, expected);
+
+        std::vector<uint32_t> mask;
+        FrustumCullMask(frustum, soa, mask);
+        for (int i = 0; i < soa.size(); ++i)
+        {
+            EXPECT_EQ(MaskBit(mask, i), std::binary_search(expected.begin(), expected.end(), i));
+        }
+    }
+    setSimdEnabled(true);
+}
+
+TEST(Frustum, PlaneDistances)
+{
+    Random::setSeed(123);
+    std::vector<Plane> planes;
+    for (int i = 0; i < 13; ++i)
+    {
+        planes.emplace_back(Random::MatrixUniform<vec3>(-5, 5), Random::MatrixUniform<vec3>(-1, 1).normalized());
+    }
+    PlaneSoA soa(planes);
+
+    for (bool simd : {false, true})
+    {
+        setSimdEnabled(simd);
+        vec3 p = Random::MatrixUniform<vec3>(-10, 10);
+        std::vector<float> distances(soa.paddedSize());
+        PlaneDistances(soa, p, distances.data());
+        for (int i = 0; i < (int)planes.size(); ++i)
+        {
+            EXPECT_NEAR(distances[i], planes[i].distance(p), 1e-5);
+        }
+    }
+    setSimdEnabled(true);
+}
+
 
 }  // namespace Saiga
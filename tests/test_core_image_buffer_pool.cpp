@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/Core.h"
+#include "saiga/core/image/imageBufferPool.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+// Counts the large heap allocations of the current thread.
+// Image buffers are always larger than this threshold.
+static thread_local size_t large_allocations = 0;
+static constexpr size_t large_allocation_size = 4096;
+
+void* operator new(size_t size)
+{
+    if (size >= large_allocation_size) large_allocations++;
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace Saiga
+{
+TEST(ImageBufferPool, SizeClass)
+{
+    EXPECT_EQ(ImageBufferPool::sizeClass(1), 4096);
+    EXPECT_EQ(ImageBufferPool::sizeClass(4096), 4096);
+    EXPECT_EQ(ImageBufferPool::sizeClass(4097), 4096 + 512);
+
+    for (size_t bytes : {5000, 640 * 480, 640 * 480 * 4, 1296 * 968 * 4, 123456789})
+    {
+        size_t cls = ImageBufferPool::sizeClass(bytes);
+        EXPECT_GE(cls, bytes);
+        EXPECT_LE(cls, bytes + bytes / 8);
+        EXPECT_EQ(ImageBufferPool::sizeClass(cls), cls);
+    }
+}
+
+TEST(ImageBufferPool, Reuse)
+{
+    ImageBufferPool pool;
+
+    auto a   = pool.acquire(1000 * 1000);
+    auto ptr = a.data();
+    EXPECT_EQ(a.size(), 1000 * 1000);
+    pool.release(std::move(a));
+    EXPECT_TRUE(a.empty());
+
+    // Same size class -> same memory
+    auto b = pool.acquire(1000 * 1000 + 10);
+    EXPECT_EQ(b.data(), ptr);
+    EXPECT_EQ(b.size(), 1000 * 1000 + 10);
+
+    auto stats = pool.statistics();
+    EXPECT_EQ(stats.allocations, 1);
+    EXPECT_EQ(stats.reuses, 1);
+    EXPECT_EQ(stats.cached_bytes, 0);
+
+    // Buffers above the limit are freed
+    ImageBufferPool small_pool(1024 * 1024);
+    small_pool.release(std::move(b));
+    small_pool.release(pool.acquire(1000 * 1000));
+    EXPECT_LE(small_pool.statistics().cached_bytes, 1024 * 1024);
+}
+
+TEST(ImageBufferPool, Image)
+{
+    auto pool = std::make_shared<ImageBufferPool>();
+
+    TemplatedImage<ucvec4> img(480, 640, pool);
+    auto ptr = img.data8();
+    img.free();
+    EXPECT_EQ(pool->statistics().cached_bytes, ImageBufferPool::sizeClass(480 * 640 * 4));
+
+    // Recreating the image reuses the buffer
+    img.create(480, 640);
+    EXPECT_EQ(img.data8(), ptr);
+
+    // clear() keeps the pool, copy assignment keeps the pool and moves transfer it
+    img.clear();
+    EXPECT_EQ(img.bufferPool(), pool);
+
+    TemplatedImage<ucvec4> other(480, 640);
+    other.getImageView().set(ucvec4(1, 2, 3, 4));
+    img = other;
+    EXPECT_EQ(img.data8(), ptr);
+    EXPECT_EQ(img.bufferPool(), pool);
+    EXPECT_EQ(img(10, 10), ucvec4(1, 2, 3, 4));
+
+    TemplatedImage<ucvec4> moved = std::move(img);
+    EXPECT_EQ(moved.bufferPool(), pool);
+    EXPECT_EQ(moved.data8(), ptr);
+
+    EXPECT_EQ(pool->statistics().allocations, 1);
+}
+
+TEST(ImageBufferPool, SteadyStateStress)
+{
+    // Simulates a streaming camera: each thread decodes frames of different types into a sliding window of
+    // images. After warmup all memory comes from the pool.
+    auto pool = std::make_shared<ImageBufferPool>();
+
+    // Without a pool every image allocates
+    {
+        size_t before = large_allocations;
+        TemplatedImage<ucvec4> img(480, 640);
+        EXPECT_EQ(large_allocations, before + 1);
+    }
+
+    constexpr int num_threads = 4;
+    constexpr int window      = 3;
+    constexpr int iterations  = 2000;
+
+    // Warmup: The pool holds enough buffers for the worst case of all threads.
+    {
+        std::vector<Image> images;
+        for (int i = 0; i < num_threads * window; ++i)
+        {
+            images.emplace_back(480, 640, UC4, pool);
+            images.emplace_back(480, 640, F1, pool);
+            images.emplace_back(480, 752, UC1, pool);
+            images.emplace_back(240, 320, UC1, pool);
+        }
+    }
+    auto warm_stats = pool->statistics();
+
+    std::atomic<size_t> total_large_allocations = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            std::vector<TemplatedImage<ucvec4>> rgb(window);
+            std::vector<TemplatedImage<float>> depth(window);
+            std::vector<TemplatedImage<unsigned char>> gray(window);
+            for (int i = 0; i < window; ++i)
+            {
+                rgb[i].setBufferPool(pool);
+                depth[i].setBufferPool(pool);
+                gray[i].setBufferPool(pool);
+            }
+
+            size_t before = large_allocations;
+            for (int it = 0; it < iterations; ++it)
+            {
+                int slot = it % window;
+
+                // Temporary images are allocated and destroyed every frame
+                TemplatedImage<unsigned char> tmp(240, 320, pool);
+                tmp.getImageView().set(t);
+
+                rgb[slot].create(480, 640);
+                depth[slot].create(480, 640);
+                rgb[slot](0, 0)   = ucvec4(t, 0, 0, 0);
+                depth[slot](0, 0) = it;
+
+                // Alternate the size to force reallocations
+                if (it % 2 == 0)
+                    gray[slot].create(480, 752);
+                else
+                    gray[slot].create(240, 320);
+                gray[slot](0, 0) = tmp(0, 0);
+
+                if (it % 7 == 0)
+                {
+                    rgb[slot].free();
+                    depth[slot].clear();
+                }
+            }
+            total_large_allocations += large_allocations - before;
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    auto stats = pool->statistics();
+    EXPECT_EQ(total_large_allocations, 0);
+    EXPECT_EQ(stats.allocations, warm_stats.allocations);
+    EXPECT_GT(stats.reuses, warm_stats.reuses + num_threads * iterations);
+}
+
+}  // namespace Saiga
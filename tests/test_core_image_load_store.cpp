@@ -184,6 +184,46 @@ TEST(ImageLoadStore, RawImage)
     EXPECT_EQ(img.getConstImageView(), img3.getConstImageView());
 }
 
+TEST(ImageLoadStore, RawImageMapped)
+{
+    Random::setSeed(90716);
+    using T = ucvec3;
+    // odd width -> the pitch contains padding
+    auto img = randomImage<T>(127, 93);
+
+    EXPECT_TRUE(img.saveRawAligned("raw_aligned.saigai"));
+
+    TemplatedImage<T> img2;
+    EXPECT_TRUE(img2.loadRawMapped("raw_aligned.saigai"));
+    EXPECT_TRUE(img2.isMapped());
+    EXPECT_TRUE(img2.valid());
+    EXPECT_EQ((size_t)img2.data8() % 4096, 0);
+    EXPECT_EQ(img.getConstImageView(), img2.getConstImageView());
+
+    // The normal loader can read the aligned format
+    TemplatedImage<T> img3;
+    EXPECT_TRUE(img3.loadRaw("raw_aligned.saigai"));
+    EXPECT_FALSE(img3.isMapped());
+    EXPECT_EQ(img.getConstImageView(), img3.getConstImageView());
+
+    // Copies own their memory, writes to the mapping don't change the file
+    TemplatedImage<T> img4 = img2;
+    EXPECT_FALSE(img4.isMapped());
+    img2(0, 0) = img2(0, 0) + ucvec3(1, 1, 1);
+    EXPECT_EQ(img.getConstImageView(), img4.getConstImageView());
+
+    TemplatedImage<T> img5;
+    EXPECT_TRUE(img5.loadRawMapped("raw_aligned.saigai"));
+    EXPECT_EQ(img.getConstImageView(), img5.getConstImageView());
+
+    // Compact files fall back to a copy
+    img.saveRaw("raw.saigai");
+    TemplatedImage<T> img6;
+    EXPECT_TRUE(img6.loadRawMapped("raw.saigai"));
+    EXPECT_FALSE(img6.isMapped());
+    EXPECT_EQ(img.getConstImageView(), img6.getConstImageView());
+}
+
 
 TEST(ImageLoadStoreBenchmark, PNG_UC4)
 {
@@ -224,6 +264,22 @@ TEST(ImageLoadStoreBenchmark, PNG_UC4)
         std::cout << "Saiga (raw) Median Load Time: " << load_measure.median << std::endl;
     }
 
+    {
+        std::string file   = "loadstoretest_saiga_aligned.saigai";
+        auto store_measure = measureObject(5, [&]() {
+            std::filesystem::remove(file);
+            EXPECT_TRUE(img.saveRawAligned(file));
+        });
+
+        auto load_measure = measureObject(5, [&]() {
+            TemplatedImage<T> img2;
+            EXPECT_TRUE(img2.loadRawMapped(file));
+        });
+
+        std::cout << "Saiga (raw aligned) Median Store Time: " << store_measure.median << std::endl;
+        std::cout << "Saiga (raw mapped) Median Load Time: " << load_measure.median << std::endl;
+    }
+
 #ifdef SAIGA_USE_ZLIB
     {
         std::string file   = "loadstoretest_saiga_comp.saigai";
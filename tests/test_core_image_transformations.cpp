@@ -0,0 +1,265 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/Core.h"
+#include "saiga/core/image/imageTransformations.h"
+#include "saiga/core/image/integralImage.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/util/CpuFeatures.h"
+
+#include "gtest/gtest.h"
+
+namespace Saiga
+{
+template <typename T>
+TemplatedImage<T> randomImage(int h, int w)
+{
+    TemplatedImage<T> img(h, w);
+    for (int i = 0; i < img.size(); ++i)
+    {
+        img.data8()[i] = (uint8_t)Saiga::Random::uniformInt(0, 255);
+    }
+    return img;
+}
+
+// The maximum absolute difference of two 8-bit images.
+template <typename T>
+int maxDifference(ImageView<const T> a, ImageView<const T> b)
+{
+    EXPECT_EQ(a.dimensions(), b.dimensions());
+    int diff = 0;
+    for (int i = 0; i < a.h; ++i)
+    {
+        auto ra = reinterpret_cast<const unsigned char*>(a.rowPtr(i));
+        auto rb = reinterpret_cast<const unsigned char*>(b.rowPtr(i));
+        for (int j = 0; j < a.w * int(sizeof(T)); ++j)
+        {
+            diff = std::max(diff, std::abs(int(ra[j]) - int(rb[j])));
+        }
+    }
+    return diff;
+}
+
+// Odd sizes so that the scalar remainder loops are tested as well.
+static constexpr int h = 67;
+static constexpr int w = 117;
+
+TEST(ImageTransformation, CpuFeatures)
+{
+    std::cout << cpuFeatures() << std::endl;
+}
+
+TEST(ImageTransformation, RGBAToGray)
+{
+    Random::setSeed(3956);
+    auto src = randomImage<ucvec4>(h, w);
+    TemplatedImage<unsigned char> ref(h, w), res(h, w);
+    TemplatedImage<float> reff(h, w), resf(h, w);
+
+    setSimdEnabled(false);
+    ImageTransformation::RGBAToGray8(src, ref);
+    ImageTransformation::RGBAToGrayF(src, reff, 1.0f / 255.0f);
+    setSimdEnabled(true);
+    ImageTransformation::RGBAToGray8(src, res);
+    ImageTransformation::RGBAToGrayF(src, resf, 1.0f / 255.0f);
+
+    EXPECT_LE(maxDifference<unsigned char>(ref, res), 1);
+    for (int i = 0; i < h; ++i)
+    {
+        for (int j = 0; j < w; ++j)
+        {
+            EXPECT_NEAR(reff(i, j), resf(i, j), 1e-5);
+        }
+    }
+}
+
+TEST(ImageTransformation, ChannelConversion)
+{
+    Random::setSeed(3956);
+    auto gray = randomImage<unsigned char>(h, w);
+    auto rgb  = randomImage<ucvec3>(h, w);
+    TemplatedImage<ucvec4> ref(h, w), res(h, w);
+
+    setSimdEnabled(false);
+    ImageTransformation::Gray8ToRGBA(gray, ref, 17);
+    setSimdEnabled(true);
+    ImageTransformation::Gray8ToRGBA(gray, res, 17);
+    EXPECT_EQ(ref.getConstImageView(), res.getConstImageView());
+
+    setSimdEnabled(false);
+    ImageTransformation::addAlphaChannel(rgb, ref, 99);
+    setSimdEnabled(true);
+    ImageTransformation::addAlphaChannel(rgb, res, 99);
+    EXPECT_EQ(ref.getConstImageView(), res.getConstImageView());
+}
+
+TEST(ImageTransformation, DepthToRGBA)
+{
+    Random::setSeed(3956);
+    TemplatedImage<float> depth(h, w);
+    for (int i = 0; i < h; ++i)
+        for (int j = 0; j < w; ++j) depth(i, j) = Random::sampleDouble(-1, 8);
+    TemplatedImage<ucvec4> ref(h, w), res(h, w);
+
+    setSimdEnabled(false);
+    ImageTransformation::depthToRGBA(depth, ref, 0, 7);
+    setSimdEnabled(true);
+    ImageTransformation::depthToRGBA(depth, res, 0, 7);
+    EXPECT_LE(maxDifference<ucvec4>(ref, res), 1);
+}
+
+TEST(ImageTransformation, ScaleDown2)
+{
+    Random::setSeed(3956);
+    auto src = randomImage<ucvec4>(h, w);
+    TemplatedImage<ucvec4> ref(h / 2, w / 2), res(h / 2, w / 2);
+    TemplatedImage<unsigned char> gray_ref(h / 2, w / 2), gray_res(h / 2, w / 2);
+
+    setSimdEnabled(false);
+    ImageTransformation::ScaleDown2(src, ref);
+    ImageTransformation::RGBAToGray8(ref, gray_ref);
+    setSimdEnabled(true);
+    ImageTransformation::ScaleDown2(src, res);
+    EXPECT_EQ(ref.getConstImageView(), res.getConstImageView());
+
+    // The fused kernel must match the two separate steps
+    ImageTransformation::RGBAToGray8ScaleDown2(src, gray_res);
+    EXPECT_LE(maxDifference<unsigned char>(gray_ref, gray_res), 1);
+
+    TemplatedImage<unsigned char> gray_separate(h / 2, w / 2);
+    ImageTransformation::RGBAToGray8(res, gray_separate);
+    EXPECT_EQ(gray_separate.getConstImageView(), gray_res.getConstImageView());
+}
+
+TEST(ImageTransformation, Resize)
+{
+    Random::setSeed(3956);
+    auto src = randomImage<ucvec4>(h - 1, w - 1);
+
+    // Area resize by an integer factor is identical to averaging
+    TemplatedImage<ucvec4> ref(src.h / 2, src.w / 2), res(src.h / 2, src.w / 2);
+    ImageTransformation::ScaleDown2(src, ref);
+    ImageTransformation::Resize(src, res, ImageTransformation::ResizeFilter::Area);
+    // ScaleDown2 truncates, Resize rounds
+    EXPECT_LE(maxDifference<ucvec4>(ref, res), 1);
+
+    // Identity
+    TemplatedImage<ucvec4> same(src.h, src.w);
+    ImageTransformation::Resize(src, same, ImageTransformation::ResizeFilter::Bilinear);
+    EXPECT_EQ(src.getConstImageView(), same.getConstImageView());
+    ImageTransformation::Resize(src, same, ImageTransformation::ResizeFilter::Area);
+    EXPECT_EQ(src.getConstImageView(), same.getConstImageView());
+
+    // A constant image stays constant for arbitrary scale factors
+    TemplatedImage<float> constant(h, w);
+    constant.getImageView().set(3.5f);
+    for (auto filter : {ImageTransformation::ResizeFilter::Bilinear, ImageTransformation::ResizeFilter::Area})
+    {
+        for (auto size : {ivec2(13, 7), ivec2(200, 31), ivec2(w, 1)})
+        {
+            TemplatedImage<float> resized(size.y(), size.x());
+            ImageTransformation::Resize(constant, resized, filter);
+            for (int i = 0; i < resized.h; ++i)
+                for (int j = 0; j < resized.w; ++j) EXPECT_NEAR(resized(i, j), 3.5f, 1e-4);
+        }
+    }
+}
+
+// Naive reference: Mean of the clipped (2r+1)^2 window.
+template <typename T>
+double naiveBoxMean(ImageView<const T> img, int y, int x, int r, double* variance = nullptr)
+{
+    double sum = 0, sq = 0;
+    int n      = 0;
+    for (int i = std::max(y - r, 0); i <= std::min(y + r, img.h - 1); ++i)
+    {
+        for (int j = std::max(x - r, 0); j <= std::min(x + r, img.w - 1); ++j)
+        {
+            double v = img(i, j);
+            sum += v;
+            sq += v * v;
+            n++;
+        }
+    }
+    if (variance) *variance = sq / n - (sum / n) * (sum / n);
+    return sum / n;
+}
+
+TEST(ImageTransformation, IntegralImage)
+{
+    Random::setSeed(3956);
+    auto src = randomImage<unsigned char>(h, w);
+
+    TemplatedImage<uint16_t> src16(h, w);
+    TemplatedImage<float> srcf(h, w);
+    for (int i = 0; i < h; ++i)
+    {
+        for (int j = 0; j < w; ++j)
+        {
+            src16(i, j) = src(i, j) * 257;
+            srcf(i, j)  = src(i, j) / 255.0f;
+        }
+    }
+
+    IntegralImage<unsigned char> integral(src, true);
+    IntegralImage<uint16_t> integral16(src16, true);
+    IntegralImage<float> integralf(srcf, true);
+
+    EXPECT_EQ(integral.Sum(0, 0, 0, 0), 0);
+    EXPECT_EQ(integral.Sum(3, 5, 4, 6), src(3, 5));
+
+    for (auto r : {0, 1, 4, 50})
+    {
+        for (auto p : {ivec2(0, 0), ivec2(10, 20), ivec2(w - 1, h - 1), ivec2(w / 2, h - 3)})
+        {
+            double var, var16, varf;
+            double mean   = naiveBoxMean<unsigned char>(src, p.y(), p.x(), r, &var);
+            double mean16 = naiveBoxMean<uint16_t>(src16, p.y(), p.x(), r, &var16);
+            double meanf  = naiveBoxMean<float>(srcf, p.y(), p.x(), r, &varf);
+
+            EXPECT_NEAR(integral.BoxMean(p.y(), p.x(), r), mean, 1e-8);
+            EXPECT_NEAR(integral.BoxVariance(p.y(), p.x(), r), var, 1e-6);
+            EXPECT_NEAR(integral16.BoxMean(p.y(), p.x(), r), mean16, 1e-8);
+            EXPECT_NEAR(integral16.BoxVariance(p.y(), p.x(), r), var16, 1e-2);
+            EXPECT_NEAR(integralf.BoxMean(p.y(), p.x(), r), meanf, 1e-6);
+            EXPECT_NEAR(integralf.BoxVariance(p.y(), p.x(), r), varf, 1e-6);
+        }
+    }
+}
+
+TEST(ImageTransformation, BoxFilter)
+{
+    Random::setSeed(3956);
+    auto src = randomImage<unsigned char>(h, w);
+    TemplatedImage<float> srcf(h, w);
+    for (int i = 0; i < h; ++i)
+        for (int j = 0; j < w; ++j) srcf(i, j) = src(i, j) * 0.1f;
+
+    // A radius larger than the image is valid as well
+    for (auto r : {0, 1, 3, 20, 200})
+    {
+        for (bool simd : {false, true})
+        {
+            setSimdEnabled(simd);
+            TemplatedImage<unsigned char> res(h, w);
+            TemplatedImage<float> resf(h, w);
+            ImageTransformation::BoxFilter(src, res, r);
+            ImageTransformation::BoxFilter(srcf, resf, r);
+
+            for (int i = 0; i < h; ++i)
+            {
+                for (int j = 0; j < w; ++j)
+                {
+                    EXPECT_NEAR(res(i, j), naiveBoxMean<unsigned char>(src, i, j, r), 0.51);
+                    EXPECT_NEAR(resf(i, j), naiveBoxMean<float>(srcf, i, j, r), 1e-4);
+                }
+            }
+        }
+    }
+    setSimdEnabled(true);
+}
+
+}  // namespace Saiga
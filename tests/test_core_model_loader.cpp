@@ -0,0 +1,290 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/model/UnifiedModel.h"
+#include "saiga/core/model/UnifiedModelBinary.h"
+#include "saiga/core/model/model_loader_obj.h"
+#include "saiga/core/model/model_loader_off.h"
+#include "saiga/core/model/model_loader_ply.h"
+
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace Saiga;
+
+static void WriteFile(const std::string& file, const std::string& content)
+{
+    std::ofstream strm(file, std::ios::binary);
+    strm << content;
+}
+
+static void ExpectVec(const vec3& a, const vec3& b)
+{
+    EXPECT_NEAR((a - b).norm(), 0, 1e-5) << a.transpose() << " | " << b.transpose();
+}
+
+TEST(ModelLoader, Obj)
+{
+    // A quad with texture coordinates and normals, followed by a triangle with negative (relative) indices.
+    WriteFile("test_model_loader.obj",
+              "# comment\n"
+              "v 0 0 0\n"
+              "v 1 0 0\n"
+              "v 1 1 0\n"
+              "v 0 1 0\n"
+              "vt 0 0\n"
+              "vt 1 0\n"
+              "vt 1 1\n"
+              "vt 0 1\n"
+              "vn 0 0 1\n"
+              "\n"
+              "f 1/1/1 2/2/1 3/3/1 4/4/1\r\n"
+              "v 0 0 +1\n"
+              "f -5 -4 -1\n");
+
+    UnifiedModel model("test_model_loader.obj");
+
+    ASSERT_EQ(model.NumFaces(), 3);
+    ASSERT_GE(model.NumVertices(), 5);
+    EXPECT_TRUE(model.HasNormal());
+    EXPECT_TRUE(model.HasTC());
+
+    // Fan triangulation of the quad
+    auto& t = model.triangles;
+    ExpectVec(model.position[t[0](0)], vec3(0, 0, 0));
+    ExpectVec(model.position[t[0](1)], vec3(1, 0, 0));
+    ExpectVec(model.position[t[0](2)], vec3(1, 1, 0));
+    ExpectVec(model.position[t[1](0)], vec3(1, 1, 0));
+    ExpectVec(model.position[t[1](1)], vec3(0, 1, 0));
+    ExpectVec(model.position[t[1](2)], vec3(0, 0, 0));
+    EXPECT_NEAR((model.texture_coordinates[t[0](2)] - vec2(1, 1)).norm(), 0, 1e-5);
+    ExpectVec(model.normal[t[0](0)], vec3(0, 0, 1));
+
+    // Negative indices
+    ExpectVec(model.position[t[2](0)], vec3(0, 0, 0));
+    ExpectVec(model.position[t[2](1)], vec3(1, 0, 0));
+    ExpectVec(model.position[t[2](2)], vec3(0, 0, 1));
+
+    // Triangle without normals -> computed
+    ExpectVec(model.normal[t[2](2)], vec3(0, 1, 0));
+}
+
+TEST(ModelLoader, Off)
+{
+    WriteFile("test_model_loader.off",
+              "OFF\n"
+              "# vertices faces edges\n"
+              "5 2 0\n"
+              "0 0 0\n"
+              "1 0 0\n"
+              "1 1 0\n"
+              "0 1 0\n"
+              "0.5 0.5 1e-1\n"
+              "4 0 1 2 3\n"
+              "3 0 1 4\n");
+
+    OffModelLoader loader;
+    ASSERT_TRUE(loader.loadFile("test_model_loader.off"));
+    auto& model = loader.model;
+
+    ASSERT_EQ(model.NumVertices(), 5);
+    ASSERT_EQ(model.NumFaces(), 3);
+    EXPECT_EQ(model.triangles[0], ivec3(0, 1, 2));
+    EXPECT_EQ(model.triangles[1], ivec3(0, 2, 3));
+    EXPECT_EQ(model.triangles[2], ivec3(0, 1, 4));
+    ExpectVec(model.position[4], vec3(0.5, 0.5, 0.1));
+    ExpectVec(model.normal[3], vec3(0, 0, 1));
+
+    // Negative counts and indices out of range
+    std::vector<std::string> invalid_files = {
+        "OFF\n-5 1 0\n3 0 1 2\n",
+        "OFF\n3 -1 0\n0 0 0\n1 0 0\n0 1 0\n",
+        "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 1 3\n",
+        "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 -1 1 2\n",
+    };
+    for (auto& content : invalid_files)
+    {
+        WriteFile("test_model_loader_invalid.off", content);
+        OffModelLoader invalid;
+        EXPECT_FALSE(invalid.loadFile("test_model_loader_invalid.off")) << content;
+    }
+}
+
+TEST(ModelLoader, Ply)
+{
+    // Binary mesh written by PLYLoader::save
+    TriangleMesh<VertexNC, uint32_t> mesh;
+    for (int i = 0; i < 100; ++i)
+    {
+        VertexNC v;
+        v.position = vec4(i, i * 0.5f, -i, 1);
+        v.normal   = vec4(0, 1, 0, 0);
+        v.color    = vec4(0.25, 0.5, 1, 1);
+        mesh.vertices.push_back(v);
+    }
+    for (int i = 0; i < 98; ++i)
+    {
+        mesh.faces.push_back(TriangleMesh<VertexNC, uint32_t>::Face(i, i + 1, i + 2));
+    }
+    PLYLoader::save("test_model_loader.ply", mesh);
+
+    PLYLoader binary("test_model_loader.ply");
+    EXPECT_EQ(binary.format, PLYLoader::Format::BINARY_LITTLE_ENDIAN);
+    auto& model = binary.model;
+    ASSERT_EQ(model.NumVertices(), 100);
+    ASSERT_EQ(model.NumFaces(), 98);
+    ASSERT_TRUE(model.HasColor());
+    for (int i = 0; i < 100; ++i)
+    {
+        ExpectVec(model.position[i], mesh.vertices[i].position.head<3>());
+        ExpectVec(model.normal[i], vec3(0, 1, 0));
+        EXPECT_NEAR((model.color[i] - vec4(0.25, 0.5, 1, 1)).norm(), 0, 1e-5);
+    }
+    for (int i = 0; i < 98; ++i)
+    {
+        EXPECT_EQ(model.triangles[i], ivec3(i, i + 1, i + 2));
+    }
+
+    // Ascii file with uchar colors, an extra element and a quad
+    WriteFile("test_model_loader_ascii.ply",
+              "ply\n"
+              "format ascii 1.0\n"
+              "comment test\n"
+              "element vertex 4\n"
+              "property float x\n"
+              "property float y\n"
+              "property float z\n"
+              "property uchar red\n"
+              "property uchar green\n"
+              "property uchar blue\n"
+              "element face 2\n"
+              "property list uchar int vertex_indices\n"
+              "element edge 1\n"
+              "property int vertex1\n"
+              "property int vertex2\n"
+              "end_header\n"
+              "0 0 0 255 0 0\n"
+              "1 0 0 0 255 0\n"
+              "1 1 0 0 0 255\n"
+              "0 1 0 255 255 255\n"
+              "4 0 1 2 3\n"
+              "3 3 2 1\n"
+              "0 1\n");
+
+    PLYLoader ascii("test_model_loader_ascii.ply");
+    EXPECT_EQ(ascii.format, PLYLoader::Format::ASCII);
+    auto& model2 = ascii.model;
+    ASSERT_EQ(model2.NumVertices(), 4);
+    ASSERT_EQ(model2.NumFaces(), 3);
+    EXPECT_EQ(model2.triangles[0], ivec3(0, 1, 2));
+    EXPECT_EQ(model2.triangles[1], ivec3(0, 2, 3));
+    EXPECT_EQ(model2.triangles[2], ivec3(3, 2, 1));
+    ExpectVec(model2.position[2], vec3(1, 1, 0));
+    EXPECT_NEAR((model2.color[1] - vec4(0, 1, 0, 1)).norm(), 0, 1e-5);
+    ASSERT_TRUE(model2.HasNormal());
+}
+
+TEST(ModelLoader, Binary)
+{
+    UnifiedModel model;
+    model.name = "binary";
+    for (int i = 0; i < 1000; ++i)
+    {
+        model.position.push_back(vec3(i, -i, 0.5f * i));
+        model.normal.push_back(vec3(0, 0, 1));
+        model.color.push_back(vec4(i / 1000.f, 0, 1, 1));
+        model.texture_coordinates.push_back(vec2(i, 2 * i));
+        model.data.push_back(vec4(1, 2, 3, i));
+        BoneInfo bi;
+        bi.addBone(i % 7, 1);
+        model.bone_info.push_back(bi);
+    }
+    for (int i = 0; i + 2 < 1000; ++i) model.triangles.push_back(ivec3(i, i + 1, i + 2));
+    model.lines.push_back(ivec2(3, 4));
+    UnifiedMaterial mat("mat");
+    mat.texture_diffuse = "diffuse.png";
+    mat.color_diffuse   = vec4(0.1, 0.2, 0.3, 0.4);
+    model.materials     = {UnifiedMaterial("default"), mat};
+    model.material_groups.push_back({0, 500, 0});
+    model.material_groups.push_back({500, 498, 1});
+
+    model.SaveBinary("test_model.saiga_model");
+
+    auto expect_equal = [&](const UnifiedModel& other) {
+        EXPECT_EQ(other.name, model.name);
+        EXPECT_EQ(other.position, model.position);
+        EXPECT_EQ(other.normal, model.normal);
+        EXPECT_EQ(other.color, model.color);
+        EXPECT_EQ(other.texture_coordinates, model.texture_coordinates);
+        EXPECT_EQ(other.data, model.data);
+        EXPECT_EQ(other.triangles, model.triangles);
+        EXPECT_EQ(other.lines, model.lines);
+        ASSERT_EQ(other.bone_info.size(), model.bone_info.size());
+        for (int i = 0; i < model.NumVertices(); ++i)
+        {
+            EXPECT_EQ(other.bone_info[i].bone_indices, model.bone_info[i].bone_indices);
+            EXPECT_EQ(other.bone_info[i].bone_weights, model.bone_info[i].bone_weights);
+        }
+        ASSERT_EQ(other.materials.size(), 2);
+        EXPECT_EQ(other.materials[1].name, "mat");
+        EXPECT_EQ(other.materials[1].texture_diffuse, "diffuse.png");
+        EXPECT_EQ(other.materials[1].color_diffuse, mat.color_diffuse);
+        ASSERT_EQ(other.material_groups.size(), 2);
+        EXPECT_EQ(other.material_groups[1].startFace, 500);
+        EXPECT_EQ(other.material_groups[1].numFaces, 498);
+        EXPECT_EQ(other.material_groups[1].materialId, 1);
+    };
+
+    UnifiedModel loaded("test_model.saiga_model");
+    expect_equal(loaded);
+
+    // The mapped arrays are aligned and point into the file
+    UnifiedModelMapped mapped;
+    ASSERT_TRUE(mapped.open("test_model.saiga_model"));
+    EXPECT_EQ(mapped.NumVertices(), 1000);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(mapped.color.data()) % 16, 0);
+    EXPECT_EQ(mapped.triangles[10], ivec3(10, 11, 12));
+    expect_equal(mapped.Model());
+
+    // Corrupted files are detected by the checksum
+    {
+        std::fstream strm("test_model.saiga_model", std::ios::binary | std::ios::in | std::ios::out);
+        strm.seekp(std::filesystem::file_size("test_model.saiga_model") - 100);
+        strm.put(0x42);
+    }
+    UnifiedModel corrupted;
+    EXPECT_FALSE(corrupted.LoadBinary("test_model.saiga_model"));
+}
+
+TEST(ModelLoader, BinaryCache)
+{
+    std::string file  = "test_model_cache.off";
+    std::string cache = file + ".saiga_model";
+    std::filesystem::remove(cache);
+
+    WriteFile(file, "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 1 2\n");
+    UnifiedModel first(file);
+    EXPECT_TRUE(std::filesystem::exists(cache));
+
+    UnifiedModel second(file);
+    EXPECT_EQ(second.position, first.position);
+    EXPECT_EQ(second.normal, first.normal);
+    EXPECT_EQ(second.triangles, first.triangles);
+
+    // Changing the source invalidates the cache (same size, different content)
+    WriteFile(file, "OFF\n3 1 0\n0 0 0\n1 0 0\n0 2 0\n3 0 1 2\n");
+    UnifiedModel third(file);
+    ExpectVec(third.position[2], vec3(0, 2, 0));
+
+    // Disabled cache
+    std::filesystem::remove(cache);
+    UnifiedModel::binary_cache = false;
+    UnifiedModel fourth(file);
+    UnifiedModel::binary_cache = true;
+    EXPECT_FALSE(std::filesystem::exists(cache));
+}
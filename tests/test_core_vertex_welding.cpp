@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/geometry/VertexWelding.h"
+#include "saiga/core/geometry/triangle_mesh.h"
+#include "saiga/core/math/random.h"
+#include "saiga/core/model/model_from_shape.h"
+
+#include "gtest/gtest.h"
+
+#include <set>
+
+using namespace Saiga;
+
+// Connected components of the epsilon graph with O(n^2) comparisons
+static std::vector<int> WeldPointsBruteForce(const std::vector<vec3>& points, float epsilon)
+{
+    int n = points.size();
+    std::vector<int> group(n);
+    std::iota(group.begin(), group.end(), 0);
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                if ((points[i] - points[j]).squaredNorm() <= epsilon * epsilon && group[j] < group[i])
+                {
+                    group[i] = group[j];
+                    changed  = true;
+                }
+            }
+        }
+    }
+    return group;
+}
+
+TEST(VertexWelding, WeldPoints)
+{
+    Random::setSeed(3457);
+    std::vector<vec3> points;
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 p = Random::MatrixUniform<vec3>(-1, 1);
+        points.push_back(p);
+        // Small clusters and chains
+        int k = Random::uniformInt(0, 3);
+        for (int j = 0; j < k; ++j)
+        {
+            p += Random::MatrixUniform<vec3>(-0.006, 0.006);
+            points.push_back(p);
+        }
+    }
+
+    float epsilon = 0.01;
+    auto expected = WeldPointsBruteForce(points, epsilon);
+    EXPECT_EQ(WeldPoints(points, epsilon), expected);
+
+    // Only identical positions
+    std::vector<vec3> duplicates = {vec3(1, 2, 3), vec3(1, 2, 3.00001), vec3(0, 0, 0), vec3(1, 2, 3), vec3(-0.f, 0, 0)};
+    EXPECT_EQ(WeldPoints(duplicates, 0), std::vector<int>({0, 1, 2, 0, 2}));
+}
+
+TEST(VertexWelding, TriangleMesh)
+{
+    auto model = IcoSphereMesh(Sphere(vec3(0, 0, 0), 1), 3);
+    auto mesh  = model.Mesh<VertexNC, uint32_t>();
+
+    // The icosphere has duplicated vertices at the seams
+    std::set<std::tuple<float, float, float>> unique;
+    for (auto& v : mesh.vertices) unique.insert({v.position.x(), v.position.y(), v.position.z()});
+    int num_vertices = unique.size();
+    int num_faces    = mesh.faces.size();
+
+    // Triangle soup with slightly perturbed corners
+    TriangleMesh<VertexNC, uint32_t> soup;
+    for (auto& f : mesh.faces)
+    {
+        VertexNC tri[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            tri[i] = mesh.vertices[f[i]];
+            tri[i].position.head<3>() += Random::MatrixUniform<vec3>(-1e-6, 1e-6);
+        }
+        soup.addTriangle(tri);
+    }
+    // A triangle that collapses to a single vertex
+    VertexNC tri[3] = {mesh.vertices[0], mesh.vertices[0], mesh.vertices[0]};
+    soup.addTriangle(tri);
+    EXPECT_EQ(soup.vertices.size(), (num_faces + 1) * 3);
+
+    soup.weldVertices(1e-5);
+    EXPECT_EQ(soup.vertices.size(), num_vertices);
+    EXPECT_EQ(soup.faces.size(), num_faces);
+    EXPECT_TRUE(soup.isValid());
+
+    for (int i = 0; i < num_faces; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            vec3 expected = make_vec3(mesh.vertices[mesh.faces[i][j]].position);
+            vec3 result   = make_vec3(soup.vertices[soup.faces[i][j]].position);
+            EXPECT_LT((expected - result).norm(), 1e-5);
+        }
+    }
+}
+
+TEST(VertexWelding, RemoveUnused)
+{
+    TriangleMesh<VertexNC, uint32_t> mesh;
+    for (int i = 0; i < 6; ++i) mesh.vertices.push_back(VertexNC(vec3(i, 0, 0)));
+    mesh.addFace(5, 1, 3);
+    mesh.addFace(1, 1, 3);
+    mesh.removeDegenerateFaces();
+    mesh.removeUnusedVertices();
+
+    // The order of the vertices is preserved
+    ASSERT_EQ(mesh.vertices.size(), 3);
+    ASSERT_EQ(mesh.faces.size(), 1);
+    EXPECT_EQ(mesh.vertices[0].position.x(), 1);
+    EXPECT_EQ(mesh.vertices[1].position.x(), 3);
+    EXPECT_EQ(mesh.vertices[2].position.x(), 5);
+    EXPECT_EQ(mesh.faces[0], ivec3(2, 0, 1).cast<uint32_t>());
+}
@@ -6,6 +6,7 @@
 
 #include "saiga/config.h"
 #include "saiga/core/util/BinaryFile.h"
+#include "saiga/core/util/file.h"
 #include "saiga/core/util/zlib.h"
 
 #include "gtest/gtest.h"
@@ -34,6 +35,32 @@ TEST(zlib, SimpleCompressUncompress)
     }
 }
 
+TEST(zlib, CheckedUncompress)
+{
+    std::vector<int> data;
+    for (int i = 0; i < 10000; ++i)
+    {
+        data.push_back(rand() % 10);
+    }
+    size_t size     = data.size() * sizeof(int);
+    auto compressed = compress(data.data(), size);
+
+    std::vector<unsigned char> result;
+    EXPECT_TRUE(uncompress(compressed.data(), compressed.size(), size, result));
+    ASSERT_EQ(result.size(), size);
+    EXPECT_EQ(memcmp(result.data(), data.data(), size), 0);
+
+    // Wrong expected size
+    EXPECT_FALSE(uncompress(compressed.data(), compressed.size(), size + 4, result));
+    // Truncated header and truncated data
+    EXPECT_FALSE(uncompress(compressed.data(), 10, size, result));
+    EXPECT_FALSE(uncompress(compressed.data(), compressed.size() - 1, size, result));
+
+    // Corrupted stream (adler32 checksum at the end)
+    compressed.back() ^= 0xFF;
+    EXPECT_FALSE(uncompress(compressed.data(), compressed.size(), size, result));
+}
+
 TEST(zlib, BinaryVector)
 {
     std::vector<int> data;
@@ -80,4 +107,53 @@ TEST(zlib, BinaryVectorCompress)
     EXPECT_EQ(data, data2);
 }
 
+TEST(zlib, DecompressStream)
+{
+    std::string expected = "3 1 2\n0 0 -1.5e+01 2.5\n1 0 1.25 -0.5\n";
+
+    // Two concatenated gzip members
+    const unsigned char gz[] = {
+        0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x33, 0x56,
+        0x30, 0x54, 0x30, 0xE2, 0x32, 0x50, 0x30, 0x50, 0xD0, 0x35, 0xD4, 0x33,
+        0x4D, 0xD5, 0x36, 0x00, 0x72, 0xF5, 0x4C, 0xB9, 0x00, 0xCC, 0x4E, 0x29,
+        0xB5, 0x17, 0x00, 0x00, 0x00, 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x02, 0x03, 0x33, 0x54, 0x30, 0x50, 0x30, 0xD4, 0x33, 0x32, 0x55,
+        0xD0, 0x35, 0xD0, 0x33, 0xE5, 0x02, 0x00, 0x81, 0x16, 0xF9, 0x88, 0x0E,
+        0x00, 0x00, 0x00
+    };
+    ArrayView<const char> gz_view((const char*)gz, sizeof(gz));
+    EXPECT_TRUE(File::isCompressed(gz_view));
+
+    std::vector<char> result;
+    EXPECT_TRUE(File::decompressStream(gz_view, result));
+    EXPECT_EQ(std::string(result.begin(), result.end()), expected);
+
+    // Truncated stream
+    EXPECT_FALSE(File::decompressStream(ArrayView<const char>(gz_view.data(), 20), result));
+
+    ArrayView<const char> text(expected.data(), expected.size());
+    EXPECT_FALSE(File::isCompressed(text));
+    EXPECT_FALSE(File::decompressStream(text, result));
+
+#ifdef SAIGA_USE_BZIP2
+    // Two concatenated bzip2 streams
+    const unsigned char bz2[] = {
+        0x42, 0x5A, 0x68, 0x39, 0x31, 0x41, 0x59, 0x26, 0x53, 0x59, 0x67, 0x41,
+        0x0B, 0xA8, 0x00, 0x00, 0x09, 0xD9, 0x00, 0x00, 0x10, 0x40, 0x0B, 0x7A,
+        0x00, 0x02, 0x00, 0x20, 0x00, 0x31, 0x00, 0xD3, 0x4D, 0x03, 0x51, 0xEA,
+        0x0F, 0xD5, 0x3C, 0xA1, 0x05, 0x22, 0xA7, 0x74, 0xCF, 0x32, 0x35, 0xBA,
+        0xAF, 0xC5, 0xDC, 0x91, 0x4E, 0x14, 0x24, 0x19, 0xD0, 0x42, 0xEA, 0x00,
+        0x42, 0x5A, 0x68, 0x39, 0x31, 0x41, 0x59, 0x26, 0x53, 0x59, 0x29, 0xEE,
+        0x9C, 0x35, 0x00, 0x00, 0x04, 0xD8, 0x00, 0x00, 0x10, 0x40, 0x03, 0x72,
+        0x00, 0x20, 0x00, 0x21, 0xA3, 0xD4, 0x64, 0x10, 0xC0, 0x8E, 0x52, 0x68,
+        0x0D, 0x91, 0x77, 0x8B, 0xB9, 0x22, 0x9C, 0x28, 0x48, 0x14, 0xF7, 0x4E,
+        0x1A, 0x80
+    };
+    ArrayView<const char> bz2_view((const char*)bz2, sizeof(bz2));
+    EXPECT_TRUE(File::isCompressed(bz2_view));
+    EXPECT_TRUE(File::decompressStream(bz2_view, result));
+    EXPECT_EQ(std::string(result.begin(), result.end()), expected);
+#endif
+}
+
 }  // namespace Saiga
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/util/file.h"
+#include "saiga/vision/scene/BALDataset.h"
+
+#include "gtest/gtest.h"
+
+#include "compare_numbers.h"
+
+namespace Saiga
+{
+// 2 cameras, 2 points, 3 observations. The cameras have no distortion, so undistortAll() does not change the
+// observations.
+static const std::string bal_text =
+    "2 2 3\n"
+    "0 0 -1.5e+01 2.5\n"
+    "1 0 1.25 -0.5\n"
+    "1 1 3 4\n"
+    "0 0 0.5\n0.1 0.2 0.3\n500\n0\n0\n"
+    "0 0 0\n0 0 0\n250.5\n0\n0\n"
+    "1 2 -3\n"
+    "-4.5 0 +2e1\n";
+
+static void CheckDataset(const BALDataset& bal)
+{
+    ASSERT_TRUE(bal.valid());
+    ASSERT_EQ(bal.cameras.size(), 2u);
+    ASSERT_EQ(bal.points.size(), 2u);
+    ASSERT_EQ(bal.observations.size(), 3u);
+
+    int camera_index[3] = {0, 1, 1};
+    int point_index[3]  = {0, 0, 1};
+    Vec2 point[3]       = {Vec2(-15, 2.5), Vec2(1.25, -0.5), Vec2(3, 4)};
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(bal.observations[i].camera_index, camera_index[i]);
+        EXPECT_EQ(bal.observations[i].point_index, point_index[i]);
+        ExpectCloseRelative(bal.observations[i].point, point[i], 1e-10);
+    }
+
+    auto& c0 = bal.cameras[0];
+    EXPECT_EQ(c0.f, 500);
+    ExpectCloseRelative(c0.se3.so3().log(), Vec3(0, 0, 0.5), 1e-10);
+    ExpectCloseRelative(c0.se3.translation(), Vec3(0.1, 0.2, 0.3), 1e-10);
+
+    auto& c1 = bal.cameras[1];
+    EXPECT_EQ(c1.f, 250.5);
+    ExpectCloseRelative(c1.se3.matrix(), SE3().matrix(), 1e-10);
+
+    ExpectCloseRelative(bal.points[0].point, Vec3(1, 2, -3), 1e-10);
+    ExpectCloseRelative(bal.points[1].point, Vec3(-4.5, 0, 20), 1e-10);
+}
+
+TEST(BALDataset, LoadText)
+{
+    std::string file = "test_bal_dataset.txt";
+    File::saveFileBinary(file, bal_text.data(), bal_text.size());
+    BALDataset bal(file);
+    CheckDataset(bal);
+}
+
+#ifdef SAIGA_USE_ZLIB
+TEST(BALDataset, LoadGzip)
+{
+    // gzip compressed bal_text
+    const unsigned char gz[] = {
+        0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x2D, 0x8C, 0xD1, 0x09, 0x00, 0x31, 0x08, 0x43,
+        0xFF, 0x9D, 0x22, 0xFF, 0x45, 0x89, 0xB1, 0x8E, 0xD4, 0xFD, 0x57, 0x38, 0x5B, 0x8E, 0x90, 0x40, 0x7C, 0x41,
+        0x41, 0x28, 0x23, 0x08, 0xCF, 0xE8, 0xB3, 0x98, 0x50, 0xB4, 0xE5, 0x1C, 0x32, 0xD4, 0x70, 0xBE, 0x96, 0x28,
+        0xEC, 0x37, 0xBB, 0x9D, 0x31, 0x3C, 0x34, 0x2E, 0x6B, 0xD2, 0x9E, 0x2E, 0xFB, 0x53, 0xFD, 0x56, 0xA3, 0xF9,
+        0x06, 0x2F, 0xF3, 0x1D, 0x3D, 0x64, 0xE9, 0xA4, 0x7D, 0x8D, 0x99, 0x9C, 0x0F, 0x72, 0x00, 0x00, 0x00};
+    std::string file = "test_bal_dataset.txt.gz";
+    File::saveFileBinary(file, gz, sizeof(gz));
+    BALDataset bal(file);
+    CheckDataset(bal);
+}
+#endif
+
+TEST(BALDataset, InvalidFile)
+{
+    // Truncated
+    std::string file = "test_bal_dataset_invalid.txt";
+    std::string text = "2 2 3\n0 0 1 2\n";
+    File::saveFileBinary(file, text.data(), text.size());
+    EXPECT_FALSE(BALDataset(file).valid());
+
+    // Broken header
+    text = "2 x 3\n";
+    File::saveFileBinary(file, text.data(), text.size());
+    EXPECT_FALSE(BALDataset(file).valid());
+
+    // Observation references a camera that does not exist
+    text = bal_text;
+    text[6] = '5';
+    File::saveFileBinary(file, text.data(), text.size());
+    EXPECT_FALSE(BALDataset(file).valid());
+}
+
+}  // namespace Saiga
@@ -7,6 +7,7 @@
 #include "saiga/config.h"
 #include "saiga/core/Core.h"
 #include "saiga/core/time/all.h"
+#include "saiga/core/util/Checksum.h"
 #include "saiga/core/util/table.h"
 #include "saiga/vision/ceres/CeresBA.h"
 #include "saiga/vision/recursive/BAPointOnly.h"
@@ -51,6 +52,17 @@ class BundleAdjustmentTest
         return cpy;
     }
 
+    Scene solveRecMixed(const BAOptions& options)
+    {
+        Scene cpy = scene;
+        BARecMixed ba;
+        ba.optimizationOptions = opoptions;
+        ba.baOptions           = options;
+        ba.create(cpy);
+        ba.initAndSolve();
+        return cpy;
+    }
+
     Scene solveRecRel(const BAOptions& options)
     {
         Scene cpy = scene;
@@ -231,6 +243,168 @@ TEST(Scene, LoadStore)
 }
 
 
+TEST(Scene, LoadStoreBinary)
+{
+    Scene scene = SynteticScene::CircleSphere(2500, 65, 250);
+    scene.images[3].constant = true;
+    scene.images[5].stereoPoints[7].depth  = 2.5;
+    scene.images[5].stereoPoints[7].weight = 0.5;
+
+    for (bool compress : {false, true})
+    {
+        scene.saveBinary("test_binary.scene", compress);
+
+        // load() detects the binary format
+        Scene scene2;
+        scene2.load("test_binary.scene");
+
+        EXPECT_EQ(scene.bf, scene2.bf);
+        EXPECT_EQ(scene.globalScale, scene2.globalScale);
+        ASSERT_EQ(scene.intrinsics.size(), scene2.intrinsics.size());
+        ASSERT_EQ(scene.images.size(), scene2.images.size());
+        ASSERT_EQ(scene.worldPoints.size(), scene2.worldPoints.size());
+
+        for (int i = 0; i < (int)scene.intrinsics.size(); ++i)
+        {
+            EXPECT_EQ(scene.intrinsics[i].coeffs(), scene2.intrinsics[i].coeffs());
+        }
+
+        for (int i = 0; i < (int)scene.worldPoints.size(); ++i)
+        {
+            EXPECT_EQ(scene.worldPoints[i].p, scene2.worldPoints[i].p);
+            EXPECT_EQ(scene.worldPoints[i].valid, scene2.worldPoints[i].valid);
+        }
+
+        for (int i = 0; i < (int)scene.images.size(); ++i)
+        {
+            auto& img  = scene.images[i];
+            auto& img2 = scene2.images[i];
+            EXPECT_EQ(img.se3.params(), img2.se3.params());
+            EXPECT_EQ(img.velocity.params(), img2.velocity.params());
+            EXPECT_EQ(img.constant, img2.constant);
+            EXPECT_EQ(img.intr, img2.intr);
+            EXPECT_EQ(img.validPoints, img2.validPoints);
+            ASSERT_EQ(img.stereoPoints.size(), img2.stereoPoints.size());
+
+            for (int j = 0; j < (int)img.stereoPoints.size(); ++j)
+            {
+                EXPECT_EQ(img.stereoPoints[j].wp, img2.stereoPoints[j].wp);
+                EXPECT_EQ(img.stereoPoints[j].depth, img2.stereoPoints[j].depth);
+                EXPECT_EQ(img.stereoPoints[j].point, img2.stereoPoints[j].point);
+                EXPECT_EQ(img.stereoPoints[j].weight, img2.stereoPoints[j].weight);
+            }
+        }
+        EXPECT_EQ(scene.chi2(), scene2.chi2());
+    }
+
+    // A modified byte in the world point section is detected by the checksum
+    scene.saveBinary("test_binary.scene", false);
+    {
+        std::fstream strm("test_binary.scene", std::ios::binary | std::ios::in | std::ios::out);
+        strm.seekp(-5, std::ios::end);
+        strm.put(42);
+    }
+    Scene scene3;
+    EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+    EXPECT_TRUE(scene3.images.empty());
+
+    // Invalid references with a matching checksum are rejected before they are used as indices.
+    // Section entry i starts at byte 72 + i * 40 and stores the offset at byte 8 and the checksum at byte 32.
+    auto patchSection = [](int section, size_t pos, int32_t value) {
+        std::fstream strm("test_binary.scene", std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t entry[5];
+        strm.seekg(72 + section * 40);
+        strm.read(reinterpret_cast<char*>(entry), sizeof(entry));
+        std::vector<char> data(entry[3]);
+        strm.seekg(entry[1]);
+        strm.read(data.data(), data.size());
+        std::memcpy(data.data() + pos, &value, sizeof(value));
+        uint64_t checksum = Checksum64(data.data(), data.size());
+        strm.seekp(entry[1]);
+        strm.write(data.data(), data.size());
+        strm.seekp(72 + section * 40 + 32);
+        strm.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    };
+    size_t N = scene.images.size();
+    size_t M = 0;
+    for (auto& img : scene.images) M += img.stereoPoints.size();
+    size_t intr_offset = N * 14 * sizeof(double);
+    size_t wp_offset   = M * 3 * sizeof(double);
+
+    for (int32_t wp : {-2, int32_t(scene.worldPoints.size())})
+    {
+        scene.saveBinary("test_binary.scene", false);
+        patchSection(2, wp_offset + 4 * sizeof(int32_t), wp);
+        Scene scene4;
+        scene4.load("test_binary.scene");
+        EXPECT_TRUE(scene4.images.empty());
+        EXPECT_FALSE(scene4.loadBinary("test_binary.scene"));
+    }
+    for (int32_t intr : {-1, int32_t(scene.intrinsics.size())})
+    {
+        scene.saveBinary("test_binary.scene", false);
+        patchSection(1, intr_offset + sizeof(int32_t), intr);
+        EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+    }
+
+    // Negative number of image points. The total still matches after the size_t overflow.
+    scene.saveBinary("test_binary.scene", false);
+    int32_t n0 = scene.images[0].stereoPoints.size();
+    int32_t n1 = scene.images[1].stereoPoints.size();
+    patchSection(1, intr_offset + N * sizeof(int32_t), -1);
+    patchSection(1, intr_offset + (N + 1) * sizeof(int32_t), n0 + n1 + 1);
+    EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+
+    // Section offset close to 2^64: offset + stored_size overflows
+    scene.saveBinary("test_binary.scene", false);
+    {
+        std::fstream strm("test_binary.scene", std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t offset = ~uint64_t(0) - 16;
+        strm.seekp(72 + 3 * 40 + 8);
+        strm.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+
+#ifdef SAIGA_USE_ZLIB
+    // Corrupted compressed sections are rejected instead of read out of bounds.
+    // The world point section is the last section of the file. Its section entry starts at byte 72 + 3 * 40 and the
+    // offset of its data is stored at byte 8 of the entry. The data starts with the zlib header
+    // (magic, compressed size, decompressed size).
+    auto corrupt = [](std::streamoff pos, uint64_t value) {
+        std::fstream strm("test_binary.scene", std::ios::binary | std::ios::in | std::ios::out);
+        strm.seekp(pos);
+        strm.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto worldPointOffset = []() {
+        std::ifstream strm("test_binary.scene", std::ios::binary);
+        uint64_t offset;
+        strm.seekg(72 + 3 * 40 + 8);
+        strm.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+        return std::streamoff(offset);
+    };
+
+    // Compressed size larger than the section
+    scene.saveBinary("test_binary.scene", true);
+    corrupt(worldPointOffset() + 8, uint64_t(1) << 40);
+    EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+
+    // Decompressed size does not match the section
+    scene.saveBinary("test_binary.scene", true);
+    corrupt(worldPointOffset() + 16, uint64_t(1) << 40);
+    EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+
+    // Corrupted deflate stream
+    scene.saveBinary("test_binary.scene", true);
+    {
+        std::fstream strm("test_binary.scene", std::ios::binary | std::ios::in | std::ios::out);
+        strm.seekp(-5, std::ios::end);
+        strm.put(42);
+    }
+    EXPECT_FALSE(scene3.loadBinary("test_binary.scene"));
+    EXPECT_TRUE(scene3.images.empty());
+#endif
+}
+
 TEST(BundleAdjustment, Empty)
 {
     Scene scene;
@@ -281,6 +455,25 @@ TEST(BundleAdjustment, Default)
 }
 
 
+TEST(BundleAdjustment, MixedPrecision)
+{
+    for (auto type : {OptimizationOptions::SolverType::Iterative, OptimizationOptions::SolverType::Direct})
+    {
+        BundleAdjustmentTest test;
+        test.buildScene(false);
+        test.opoptions.solverType      = type;
+        test.opoptions.refinementSteps = 1;
+
+        BAOptions options;
+        auto ref   = test.solveRec(options);
+        auto mixed = test.solveRecMixed(options);
+
+        std::cout << test.scene.chi2() << " -> " << ref.chi2() << " " << mixed.chi2() << std::endl;
+        EXPECT_LT(mixed.chi2(), test.scene.chi2());
+        ExpectClose(ref.chi2(), mixed.chi2(), 1e-1);
+    }
+}
+
 TEST(BundleAdjustment, DefaultParallel)
 {
     BundleAdjustmentTest test;
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/image/imageBufferPool.h"
+#include "saiga/vision/camera/CameraBase.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+namespace Saiga
+{
+// A dataset of 'num_frames' gray images. The pixels of frame i have the value i % 256.
+class SyntheticDataset : public DatasetCameraBase
+{
+   public:
+    SyntheticDataset(const DatasetParameters& params, int num_frames, int load_delay_ms)
+        : DatasetCameraBase(params), num_frames(num_frames), load_delay_ms(load_delay_ms)
+    {
+        camera_type = CameraInputType::Mono;
+        Load();
+    }
+    ~SyntheticDataset() { StopPrefetching(); }
+
+    int LoadMetaData() override
+    {
+        frames.resize(num_frames);
+        for (int i = 0; i < num_frames; ++i)
+        {
+            frames[i].id        = i;
+            frames[i].timeStamp = i * 0.1;
+        }
+        return num_frames;
+    }
+
+    void LoadImageData(FrameData& data) override
+    {
+        if (load_delay_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(load_delay_ms));
+        data.image.create(48, 64);
+        data.image.getImageView().set(data.id % 256);
+        loaded++;
+    }
+
+    // Number of frames that have been loaded (including the frames in the prefetch window)
+    std::atomic<int> loaded = 0;
+
+   private:
+    int num_frames;
+    int load_delay_ms;
+};
+
+static DatasetParameters StreamingParameters(int prefetch_frames, int prefetch_threads)
+{
+    DatasetParameters params;
+    params.playback_fps     = 1000;
+    params.preload          = false;
+    params.prefetch_frames  = prefetch_frames;
+    params.prefetch_threads = prefetch_threads;
+    return params;
+}
+
+// Reads all frames and checks their order and content.
+// Returns the maximum number of frames that have been loaded ahead of the consumer.
+static int ReadAll(SyntheticDataset& dataset, int num_frames)
+{
+    int max_ahead = 0;
+    FrameData frame;
+    for (int i = 0; i < num_frames; ++i)
+    {
+        max_ahead = std::max(max_ahead, dataset.loaded - i);
+        EXPECT_TRUE(dataset.getImageSync(frame));
+        EXPECT_EQ(frame.id, i);
+        EXPECT_EQ(frame.timeStamp, i * 0.1);
+        EXPECT_EQ(frame.image.rows, 48);
+        EXPECT_EQ(frame.image.cols, 64);
+        EXPECT_EQ(frame.image(0, 0), i % 256);
+        EXPECT_EQ(frame.image(47, 63), i % 256);
+    }
+    EXPECT_FALSE(dataset.isOpened());
+    EXPECT_FALSE(dataset.getImageSync(frame));
+    return max_ahead;
+}
+
+TEST(DatasetCamera, Synchronous)
+{
+    int n = 20;
+    for (bool preload : {true, false})
+    {
+        auto params    = StreamingParameters(0, 0);
+        params.preload = preload;
+        SyntheticDataset dataset(params, n, 0);
+        ReadAll(dataset, n);
+        EXPECT_EQ(dataset.loaded.load(), n);
+        EXPECT_EQ(dataset.StalledFrames(), 0);
+        EXPECT_EQ(dataset.IOStallTime(), 0);
+    }
+}
+
+TEST(DatasetCamera, Prefetch)
+{
+    int n = 100;
+    for (int prefetch_frames : {1, 4, 16})
+    {
+        for (int threads : {1, 3})
+        {
+            auto allocations_before = globalImageBufferPool()->statistics().allocations;
+
+            SyntheticDataset dataset(StreamingParameters(prefetch_frames, threads), n, 0);
+            int max_ahead = ReadAll(dataset, n);
+            EXPECT_EQ(dataset.loaded.load(), n);
+
+            // The prefetch window bounds the number of loaded frames and the memory
+            EXPECT_LE(max_ahead, prefetch_frames);
+            auto allocations = globalImageBufferPool()->statistics().allocations - allocations_before;
+            EXPECT_LE(allocations, size_t(prefetch_frames + 2));
+
+            EXPECT_LE(dataset.StalledFrames(), n);
+        }
+    }
+}
+
+TEST(DatasetCamera, PrefetchStall)
+{
+    // The decoder is much slower than the playback -> almost every frame waits for the prefetcher
+    int n = 10;
+    SyntheticDataset dataset(StreamingParameters(2, 1), n, 20);
+    ReadAll(dataset, n);
+    EXPECT_GT(dataset.StalledFrames(), 0);
+    EXPECT_LE(dataset.StalledFrames(), n);
+    EXPECT_GT(dataset.IOStallTime(), 0);
+
+    // Destroying the dataset while frames are still loading waits for the decoder threads
+    SyntheticDataset unfinished(StreamingParameters(4, 2), n, 20);
+}
+
+}  // namespace Saiga
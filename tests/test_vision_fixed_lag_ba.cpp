@@ -0,0 +1,141 @@
+﻿/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/math/random.h"
+#include "saiga/vision/recursive/BAFixedLag.h"
+#include "saiga/vision/recursive/BARecursive.h"
+#include "saiga/vision/scene/SynteticScene.h"
+
+#include "gtest/gtest.h"
+
+#include "compare_numbers.h"
+
+namespace Saiga
+{
+static OptimizationOptions fixedLagOptions()
+{
+    OptimizationOptions options;
+    options.debugOutput   = false;
+    options.maxIterations = 30;
+    options.minChi2Delta  = 0;
+    options.solverType    = OptimizationOptions::SolverType::Direct;
+    return options;
+}
+
+// Stereo observations, because the scale is not observable with a single fixed keyframe
+static Scene stereoTrajectory(int numWorldPoints, int numCameras)
+{
+    Scene scene = SynteticScene::Trajectory(numWorldPoints, numCameras, 0.5);
+    for (auto& img : scene.images)
+    {
+        for (auto& ip : img.stereoPoints)
+        {
+            ip.depth = (img.se3 * scene.worldPoints[ip.wp].p).z();
+        }
+    }
+    return scene;
+}
+
+static Scene noisyTrajectory(const Scene& reference)
+{
+    Scene scene = reference;
+    scene.addExtrinsicNoise(0.01);
+    scene.addWorldPointNoise(0.01);
+    // The first image is fixed during the optimization
+    scene.images[0].se3 = reference.images[0].se3;
+    return scene;
+}
+
+TEST(FixedLagBA, NoMarginalization)
+{
+    // If all keyframes fit into the window, the result must be identical to the full BA
+    Random::setSeed(2376);
+    Scene reference = stereoTrajectory(1000, 8);
+    reference.addImagePointNoise(1.0);
+    Scene scene = noisyTrajectory(reference);
+
+    Scene scene1 = scene;
+    BAFixedLag fl;
+    fl.windowSize          = 8;
+    fl.optimizationOptions = fixedLagOptions();
+    fl.create(scene1);
+    for (int i = 0; i < (int)scene1.images.size(); ++i) fl.addKeyframe(i);
+    EXPECT_EQ(fl.keyframes().size(), 8);
+    EXPECT_EQ(fl.numMarginalizedKeyframes(), 0);
+    fl.initAndSolve();
+
+    Scene scene2              = scene;
+    scene2.images[0].constant = true;
+    BARec ba;
+    ba.optimizationOptions = fixedLagOptions();
+    ba.create(scene2);
+    ba.initAndSolve();
+
+    ExpectCloseRelative(scene1.chi2(), scene2.chi2(), 1e-5);
+    for (int i = 0; i < (int)scene.images.size(); ++i)
+    {
+        ExpectCloseRelative(scene1.images[i].se3.params(), scene2.images[i].se3.params(), 1e-5, false);
+    }
+}
+
+TEST(FixedLagBA, SlidingWindow)
+{
+    Random::setSeed(4768);
+    Scene reference = stereoTrajectory(5000, 60);
+    Scene scene     = noisyTrajectory(reference);
+
+    BAFixedLag fl;
+    fl.windowSize          = 6;
+    fl.optimizationOptions = fixedLagOptions();
+    fl.create(scene);
+
+    int maxPoints = 0;
+    for (int i = 0; i < (int)scene.images.size(); ++i)
+    {
+        fl.addKeyframe(i);
+        auto result = fl.initAndSolve();
+        EXPECT_LE(result.cost_final, result.cost_initial);
+        EXPECT_LE(fl.keyframes().size(), 6);
+        maxPoints = std::max(maxPoints, fl.numPoints());
+    }
+    EXPECT_EQ(fl.numMarginalizedKeyframes(), 54);
+
+    // The window is bounded by the visible range and not by the size of the map
+    EXPECT_LT(maxPoints, 5000 / 2);
+
+    // Without image noise the reference is the optimum
+    for (int i = 0; i < (int)scene.images.size(); ++i)
+    {
+        ExpectCloseRelative(scene.images[i].se3.translation(), reference.images[i].se3.translation(), 1e-5, false);
+    }
+}
+
+TEST(FixedLagBA, PriorIsExact)
+{
+    // After marginalization the prior must reproduce the cost of the marginalized observations
+    Random::setSeed(9023);
+    Scene reference = stereoTrajectory(2000, 12);
+    reference.addImagePointNoise(1.0);
+    Scene scene = noisyTrajectory(reference);
+
+    BAFixedLag fl;
+    fl.windowSize          = 4;
+    fl.optimizationOptions = fixedLagOptions();
+    fl.create(scene);
+    for (int i = 0; i < 4; ++i) fl.addKeyframe(i);
+    fl.initAndSolve();
+
+    double before = fl.initAndSolve().cost_final;
+    fl.marginalizeOldest();
+    EXPECT_EQ(fl.keyframes().size(), 3);
+
+    // The estimate is still the optimum of the marginalized problem
+    auto result = fl.initAndSolve();
+    ExpectCloseRelative(result.cost_initial, before, 1e-5);
+    ExpectCloseRelative(result.cost_final, before, 1e-5);
+}
+
+}  // namespace Saiga
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2017 Darius Rückert
+ * Licensed under the MIT License.
+ * See LICENSE file for more information.
+ */
+
+#include "saiga/core/image/all.h"
+#include "saiga/vision/icp/ICPDepthMap.h"
+#include "saiga/vision/icp/MultiViewICP.h"
+#include "saiga/vision/util/Random.h"
+
+#include "gtest/gtest.h"
+
+#include "compare_numbers.h"
+
+namespace Saiga
+{
+// Renders the depth image of a camera inside a box shaped room [-1,1]x[-0.8,0.8]x[-1,4]
+static TemplatedImage<float> renderRoom(const Intrinsics4& K, const SE3& T_w_c, int h, int w)
+{
+    TemplatedImage<float> img(h, w);
+    Vec3 boxMin(-1, -0.8, -1), boxMax(1, 0.8, 4);
+    for (int i = 0; i < h; ++i)
+    {
+        for (int j = 0; j < w; ++j)
+        {
+            // ray in world space with z=1 in camera space -> the distance along the ray is the depth
+            Vec3 o = T_w_c.translation();
+            Vec3 d = T_w_c.so3() * K.unproject(Vec2(j, i), 1);
+
+            // The camera is inside the box -> first exit of the ray
+            double t = std::numeric_limits<double>::infinity();
+            for (int k = 0; k < 3; ++k)
+            {
+                if (d(k) > 0) t = std::min(t, (boxMax(k) - o(k)) / d(k));
+                if (d(k) < 0) t = std::min(t, (boxMin(k) - o(k)) / d(k));
+            }
+            img(i, j) = t;
+        }
+    }
+    return img;
+}
+
+class ICPTest
+{
+   public:
+    ICPTest()
+    {
+        K       = Intrinsics4(320, 320, 159.5, 119.5);
+        refPose = SE3();
+        srcPose = SE3(Sophus::SO3d::exp(Vec3(0.02, -0.03, 0.01)), Vec3(0.05, -0.02, 0.04));
+
+        refImg = renderRoom(K, refPose, 240, 320);
+        srcImg = renderRoom(K, srcPose, 240, 320);
+    }
+
+    Intrinsics4 K;
+    SE3 refPose, srcPose;
+    TemplatedImage<float> refImg, srcImg;
+};
+
+TEST(ICP, FusedPointToPlane)
+{
+    // The fused kernel must compute the same step as the correspondence based ICP
+    ICPTest test;
+    ICP::ProjectiveCorrespondencesParams params;
+    params.searchRadius = 1;
+
+    ICP::DepthMapExtended ref(test.refImg.getImageView(), test.K, test.refPose);
+    ICP::DepthMapExtended src(test.srcImg.getImageView(), test.K, SE3());
+
+    for (int k = 0; k < 3; ++k)
+    {
+        auto corrs  = ICP::projectiveCorrespondences(ref, src, params);
+        auto system = ICP::projectivePointToPlane(ref, src, params);
+        EXPECT_EQ(system.correspondences, corrs.size());
+
+        SE3 expected = ICP::pointToPlane(corrs, ref.pose, src.pose);
+        SE3 result   = system.update(src.pose);
+        ExpectCloseRelative(result.params(), expected.params(), 1e-8, false);
+        src.pose = expected;
+    }
+}
+
+TEST(ICP, AlignDepthMapsPyramid)
+{
+    ICPTest test;
+    ICP::ProjectiveCorrespondencesParams params;
+
+    // Coarse-to-fine alignment starting at the identity
+    SE3 result = ICP::alignDepthMaps(test.refImg.getImageView(), test.srcImg.getImageView(), test.refPose, SE3(),
+                                     test.K, 10, params, 3);
+    ExpectCloseRelative(result.params(), test.srcPose.params(), 1e-4, false);
+
+    // The coarse level has half the resolution and a scaled camera
+    ICP::DepthMapExtended ref(test.refImg.getImageView(), test.K, test.refPose);
+    ICP::DepthMapExtended coarse(ref, 2);
+    EXPECT_EQ(coarse.h(), 120);
+    EXPECT_EQ(coarse.w(), 160);
+    ExpectCloseRelative(coarse.camera.project(coarse.points(50, 60)), Vec2(60, 50), 1e-10, false);
+}
+
+TEST(ICP, MultiViewGlobal)
+{
+    Random::setSeed(3497);
+    Intrinsics4 K(160, 160, 79.5, 59.5);
+
+    int N = 8;
+    AlignedVector<SE3> poses, guesses;
+    std::vector<TemplatedImage<float>> images;
+    for (int i = 0; i < N; ++i)
+    {
+        SE3 pose(Sophus::SO3d::exp(Vec3(0.01 * i, 0.05 * i - 0.2, 0)), Vec3(0.05 * i - 0.2, 0, 0.02 * i));
+        poses.push_back(pose);
+        images.push_back(renderRoom(K, pose, 120, 160));
+
+        // The first pose is fixed
+        guesses.push_back(i == 0 ? pose : Random::JitterPose(pose, 0.02, 0.01));
+    }
+
+    std::vector<Depthmap::DepthMap> depthMaps;
+    for (auto& img : images) depthMaps.push_back(img.getImageView());
+
+    ICP::MultiViewICPParams params;
+    params.iterations = 10;
+    int pairs         = ICP::multiViewICPGlobal(depthMaps, guesses, K, params);
+    EXPECT_EQ(pairs, N * (N - 1) / 2);
+
+    // Small bias due to the low resolution and the projective association
+    for (int i = 0; i < N; ++i)
+    {
+        ExpectCloseRelative(guesses[i].params(), poses[i].params(), 1e-3, false);
+    }
+}
+
+}  // namespace Saiga
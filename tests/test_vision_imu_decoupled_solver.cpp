@@ -295,6 +295,85 @@ TEST(ImuDecoupledSolver, Velocity)
 
 
 
+TEST(ImuDecoupledSolver, BiasFirstOrderCorrection)
+{
+    DecoupledImuScene::SolverOptions options = DefaultSolverOptions();
+    options.solver_flags = IMU_SOLVE_BA | IMU_SOLVE_BG | IMU_SOLVE_VELOCITY | IMU_SOLVE_GRAVITY | IMU_SOLVE_SCALE;
+    options.final_recompute = false;
+
+    DecoupledImuScene scene = MakeScene(options);
+
+    // Reference: All edges are integrated again after every step
+    // Note: The copies share the preintegrations -> PreintAll before each solve
+    auto cpy1 = scene;
+    cpy1.PreintAll();
+    DecoupledImuSolver solver1;
+    solver1.optimizationOptions = DefaultOptOptions();
+    solver1.Create(cpy1, options);
+    solver1.initAndSolve();
+
+    // Small bias changes are only applied with the bias jacobians
+    options.bias_recompute_delta_squared = 0.01;
+    auto cpy2                            = scene;
+    cpy2.PreintAll();
+    DecoupledImuSolver solver2;
+    solver2.optimizationOptions = DefaultOptOptions();
+    solver2.Create(cpy2, options);
+    solver2.initAndSolve();
+
+    EXPECT_LT(solver2.RecomputedPreints(), solver1.RecomputedPreints());
+    EXPECT_NEAR(cpy1.chi2(), cpy2.chi2(), 1e-3);
+
+    // The preintegrations are always linearized at the current bias of the states
+    for (auto& e : cpy2.edges)
+    {
+        Preintegration preint(cpy2.states[e.from].velocity_and_bias);
+        preint.IntegrateMidPoint(*e.data, true);
+        ExpectCloseRelative(e.preint->delta_x, preint.delta_x, 1e-20);
+        ExpectCloseRelative(e.preint->delta_v, preint.delta_v, 1e-20);
+    }
+}
+
+
+
+TEST(ImuDecoupledSolver, BlockTridiagonal)
+{
+    DecoupledImuScene::SolverOptions options = DefaultSolverOptions();
+    options.solver_flags = IMU_SOLVE_BA | IMU_SOLVE_BG | IMU_SOLVE_VELOCITY | IMU_SOLVE_GRAVITY | IMU_SOLVE_SCALE;
+
+    DecoupledImuScene scene = MakeScene(options, 200);
+    scene.states[5].constant = true;
+
+    // Generic sparse LDLT vs. block tridiagonal solver
+    options.block_tridiagonal = false;
+    auto cpy1                 = scene;
+    cpy1.PreintAll();
+    DecoupledImuSolver solver1;
+    solver1.optimizationOptions = DefaultOptOptions();
+    solver1.Create(cpy1, options);
+    solver1.initAndSolve();
+
+    options.block_tridiagonal = true;
+    auto cpy2                 = scene;
+    cpy2.PreintAll();
+    DecoupledImuSolver solver2;
+    solver2.optimizationOptions = DefaultOptOptions();
+    solver2.Create(cpy2, options);
+    solver2.initAndSolve();
+
+    EXPECT_NEAR(cpy1.chi2(), cpy2.chi2(), 1e-5);
+    EXPECT_NEAR(cpy1.scale, cpy2.scale, 1e-5);
+    for (int i = 0; i < (int)scene.states.size(); ++i)
+    {
+        ExpectCloseRelative(cpy1.states[i].velocity_and_bias.velocity, cpy2.states[i].velocity_and_bias.velocity,
+                            1e-5, false);
+        ExpectCloseRelative(cpy1.states[i].velocity_and_bias.acc_bias, cpy2.states[i].velocity_and_bias.acc_bias,
+                            1e-5, false);
+    }
+}
+
+
+
 TEST(ImuDecoupledSolver, All_Benchmark)
 {
     DecoupledImuScene::SolverOptions options = DefaultSolverOptions();
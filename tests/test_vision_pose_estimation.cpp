@@ -111,3 +111,77 @@ TEST(PoseEstimation, Sim3)
         test.TestBasic();
     }
 }
+
+
+// Random scene with noise, 10% outliers and 50% stereo observations
+static PoseOptimizationScene<double> RobustPoseScene(int n, SE3& ground_truth)
+{
+    PoseOptimizationScene<double> scene;
+    scene.K      = StereoCamera4Base<double>(458.654, 457.296, 367.215, 248.375, 50);
+    ground_truth = Random::randomSE3();
+    for (int i = 0; i < n; ++i)
+    {
+        ObsBase<double> o;
+        o.ip         = Vec2(Random::sampleDouble(0, 734), Random::sampleDouble(0, 496));
+        double depth = Random::sampleDouble(1, 5);
+        scene.wps.push_back(ground_truth.inverse() * scene.K.unproject(o.ip, depth));
+
+        if (i % 2 == 0) o.depth = depth;
+        o.ip += Vec2(Random::gaussRand(0, 0.5), Random::gaussRand(0, 0.5));
+        if (i % 10 == 0) o.ip += Vec2(Random::sampleDouble(-50, 50), Random::sampleDouble(-50, 50));
+        scene.obs.push_back(o);
+    }
+    scene.outlier.resize(n, false);
+    scene.pose = Random::JitterPose(ground_truth, 0.02, 0.02);
+    return scene;
+}
+
+TEST(PoseEstimation, RobustPoseOptimization)
+{
+    int N = 2000;
+    SE3 gt;
+    auto scene = RobustPoseScene(N, gt);
+
+    RobustPoseOptimization<double> rpo;
+    auto single  = scene;
+    int inliers1 = rpo.optimizePoseRobust(single);
+    EXPECT_GE(inliers1, N * 0.85);
+    EXPECT_LE(inliers1, N * 0.9);
+    EXPECT_LT((single.pose.inverse() * gt).log().norm(), 1e-3);
+
+    // Threaded reduction
+    rpo.minObservationsPerThread = 100;
+    auto threaded                = scene;
+    int inliers2                 = rpo.optimizePoseRobust(threaded);
+    EXPECT_EQ(inliers1, inliers2);
+    EXPECT_EQ(single.outlier, threaded.outlier);
+    EXPECT_LT((single.pose.inverse() * threaded.pose).log().norm(), 1e-10);
+
+    // Observations marked as outlier and points with non-finite residuals do not change the result
+    auto invalid = scene;
+    for (double value : {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity()})
+    {
+        invalid.wps.push_back(Vec3(value, value, value));
+        invalid.obs.push_back(scene.obs.front());
+        invalid.outlier.push_back(std::isnan(value));
+    }
+    int inliers3 = rpo.optimizePoseRobust(invalid);
+    EXPECT_EQ(inliers1, inliers3);
+    EXPECT_LT((single.pose.inverse() * invalid.pose).log().norm(), 1e-10);
+
+    // Batch of candidates
+    AlignedVector<PoseOptimizationScene<double>> candidates;
+    for (int i = 0; i < 8; ++i)
+    {
+        candidates.push_back(scene);
+        candidates.back().pose = Random::JitterPose(gt, 0.02, 0.02);
+    }
+    auto reference = candidates;
+    std::vector<int> inliers(candidates.size());
+    rpo.optimizePoseRobustBatch(candidates, inliers);
+    for (int i = 0; i < (int)candidates.size(); ++i)
+    {
+        EXPECT_EQ(inliers[i], rpo.optimizePoseRobust(reference[i]));
+        EXPECT_LT((reference[i].pose.inverse() * candidates[i].pose).log().norm(), 1e-10);
+    }
+}
@@ -50,6 +50,16 @@ class PoseGraphOptimizationTest
         return cpy;
     }
 
+    PoseGraph solveRecMixed()
+    {
+        PoseGraph cpy = scene;
+        PGORecMixed ba;
+        ba.optimizationOptions = opoptions;
+        ba.create(cpy);
+        ba.initAndSolve();
+        return cpy;
+    }
+
     PoseGraph solveCeres()
     {
         PoseGraph cpy = scene;
@@ -71,6 +81,18 @@ class PoseGraphOptimizationTest
         ExpectClose(scene1.chi2(), scene2.chi2(), 1e-5);
     }
 
+    void testMixed()
+    {
+        opoptions.refinementSteps = 1;
+        auto scene1               = solveRec();
+        auto scene2               = solveRecMixed();
+
+        std::cout << scene.chi2() << " -> (double) " << scene1.chi2() << " (mixed) " << scene2.chi2() << std::endl;
+
+        EXPECT_LT(scene2.chi2(), scene.chi2());
+        ExpectClose(scene1.chi2(), scene2.chi2(), 1e-3);
+    }
+
     void buildScene(bool with_scale_drift)
     {
         if (with_scale_drift)
@@ -149,6 +171,81 @@ TEST(PoseGraphOptimization, LoopClosingSE3)
         test.test();
     }
 }
+TEST(PoseGraphOptimization, MixedPrecision)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        PoseGraphOptimizationTest test;
+        test.buildScene(false);
+        test.testMixed();
+    }
+}
+
+TEST(PoseGraphOptimization, ReuseStructure)
+{
+    // Repeated solves on a growing pose graph (like in a SLAM system)
+    PoseGraph full = SyntheticPoseGraph::CircleWithDrift(5, 250, 6, 0.01, 0);
+    full.addNoise(0.01);
+    full.sortEdges();
+
+    OptimizationOptions options;
+    options.debugOutput   = false;
+    options.maxIterations = 20;
+    options.solverType    = OptimizationOptions::SolverType::Direct;
+
+    for (bool supernodal : {false, true})
+    {
+        options.supernodal = supernodal;
+
+        // The first half of the graph
+        PoseGraph pg = full;
+        int n        = full.vertices.size() / 2;
+        pg.vertices.resize(n);
+        pg.edges.clear();
+        for (auto& e : full.edges)
+        {
+            if (e.to < n) pg.edges.push_back(e);
+        }
+
+        PGORec ba;
+        ba.optimizationOptions = options;
+        ba.create(pg);
+        ba.initAndSolve();
+        EXPECT_EQ(ba.lastStructureChange(), GraphStructure::Change::Changed);
+
+        // Same graph -> everything is reused
+        ba.initAndSolve();
+        EXPECT_EQ(ba.lastStructureChange(), GraphStructure::Change::None);
+
+        // Add the remaining vertices and edges. The old estimate is used as initial solution.
+        for (int i = n; i < (int)full.vertices.size(); ++i) pg.vertices.push_back(full.vertices[i]);
+        pg.edges = full.edges;
+        PoseGraph pg2 = pg;
+
+        ba.initAndSolve();
+        EXPECT_EQ(ba.lastStructureChange(), GraphStructure::Change::Appended);
+
+        // Reference without reuse
+        PGORec ba2;
+        ba2.optimizationOptions = options;
+        ba2.reuseStructure      = false;
+        ba2.create(pg2);
+        ba2.initAndSolve();
+        EXPECT_EQ(ba2.lastStructureChange(), GraphStructure::Change::Changed);
+
+        ExpectCloseRelative(pg.chi2(), pg2.chi2(), 1e-5);
+        for (int i = 0; i < (int)pg.vertices.size(); ++i)
+        {
+            ExpectCloseRelative(pg.vertices[i].T_w_i.params(), pg2.vertices[i].T_w_i.params(), 1e-5, false);
+        }
+
+        // Removing an edge requires a new analysis
+        pg.edges.pop_back();
+        ba.initAndSolve();
+        EXPECT_EQ(ba.lastStructureChange(), GraphStructure::Change::Changed);
+    }
+}
+
 TEST(PoseGraphOptimization, LoopClosingSim3)
 {
     for (int i = 0; i < 5; ++i)
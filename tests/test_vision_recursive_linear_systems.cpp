@@ -15,6 +15,8 @@
 #include "compare_numbers.h"
 #include "numeric_derivative.h"
 
+#include <numeric>
+
 
 namespace Saiga
 {
@@ -123,6 +125,386 @@ TEST(RecursiveLinearSolver, SparseBlock)
     }
 }
 
+TEST(RecursiveLinearSolver, SupernodalLDLT)
+{
+    Random::setSeed(23573457);
+    srand(4568213);
+    // A larger banded + random sparse block matrix, so that the factorization has several supernodes with
+    // dense descendant updates.
+
+    using T              = double;
+    const int block_size = 6;
+    int n                = 150;
+    int bandwidth        = 3;
+
+    using Block  = Eigen::Matrix<T, block_size, block_size, Eigen::RowMajor>;
+    using Vector = Eigen::Matrix<T, block_size, 1>;
+    using AType  = Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<Block>, Eigen::RowMajor>;
+    using BType  = Eigen::Matrix<Eigen::Recursive::MatrixScalar<Vector>, -1, 1>;
+
+    auto makeMatrix = [&](AType& A) {
+        typedef Eigen::Triplet<Block> Trip;
+        std::vector<Trip> tripletList;
+        for (int i = 0; i < n; ++i)
+        {
+            Block diag = Block::Random();
+            diag       = diag.selfadjointView<Eigen::Upper>();
+            diag.diagonal() += Vector::Ones() * 50;
+            tripletList.push_back(Trip(i, i, diag));
+
+            for (int j = i + 1; j < std::min(n, i + bandwidth + 1); ++j)
+            {
+                tripletList.push_back(Trip(i, j, Block::Random()));
+            }
+        }
+        // A few long range connections (like loop closures in PGO)
+        for (int k = 0; k < 10; ++k)
+        {
+            int i = k * 7;
+            int j = n - 1 - k * 11;
+            tripletList.push_back(Trip(i, j, Block::Random()));
+        }
+        A.resize(n, n);
+        A.setFromTriplets(tripletList.begin(), tripletList.end());
+    };
+
+    AType A;
+    makeMatrix(A);
+    BType b(n);
+    for (int i = 0; i < n; ++i) b(i) = Vector::Random();
+
+    auto check = [&](const AType& A, const BType& x) {
+        Eigen::Matrix<double, -1, -1> A_ex = expand(A);
+        A_ex                               = A_ex.selfadjointView<Eigen::Upper>();
+        Eigen::Matrix<double, -1, 1> ref   = A_ex.ldlt().solve(expand(b));
+        ExpectCloseRelative(ref, expand(x), 1e-10, false);
+    };
+
+    Eigen::Recursive::SupernodalLDLT<AType, Eigen::Upper> ldlt;
+    ldlt.compute(A);
+    EXPECT_EQ(ldlt.info(), Eigen::Success);
+    EXPECT_LT(ldlt.supernodes(), n);
+    check(A, ldlt.solve(b));
+
+    // Same structure new values
+    makeMatrix(A);
+    ldlt.factorize(A);
+    EXPECT_EQ(ldlt.info(), Eigen::Success);
+    check(A, ldlt.solve(b));
+
+    // Without amalgamation only the fundamental supernodes are used
+    Eigen::Recursive::SupernodalLDLT<AType, Eigen::Upper> ldlt2;
+    ldlt2.relaxedAmalgamation = false;
+    ldlt2.compute(A);
+    EXPECT_GE(ldlt2.supernodes(), ldlt.supernodes());
+    check(A, ldlt2.solve(b));
+
+    // Lower triangle of a column major matrix
+    using AType2 = Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<Block>, Eigen::ColMajor>;
+    AType2 A2    = A.transpose();
+    for (int k = 0; k < A2.outerSize(); ++k)
+    {
+        for (AType2::InnerIterator it(A2, k); it; ++it) it.valueRef().get().transposeInPlace();
+    }
+    Eigen::Recursive::SupernodalLDLT<AType2, Eigen::Lower> ldlt3;
+    ldlt3.compute(A2);
+    check(A, ldlt3.solve(b));
+
+    // Preset orderings: the ordering of a previous factorization and the natural ordering
+    Eigen::Recursive::SupernodalLDLT<AType, Eigen::Upper> ldlt4;
+    ldlt4.analyzePattern(A, ldlt.ordering());
+    ldlt4.factorize(A);
+    EXPECT_EQ(ldlt4.info(), Eigen::Success);
+    EXPECT_EQ(ldlt4.supernodes(), ldlt.supernodes());
+    check(A, ldlt4.solve(b));
+
+    std::vector<int> natural(n);
+    std::iota(natural.begin(), natural.end(), 0);
+    ldlt4.analyzePattern(A, natural);
+    ldlt4.factorize(A);
+    EXPECT_EQ(ldlt4.info(), Eigen::Success);
+    check(A, ldlt4.solve(b));
+
+    // Singular matrix: row and column 'zero_row' are zero. The zero pivots are reported and the solution stays finite.
+    int zero_row = n / 2;
+    for (int k = 0; k < A.outerSize(); ++k)
+    {
+        for (AType::InnerIterator it(A, k); it; ++it)
+        {
+            if (it.row() == zero_row || it.col() == zero_row) it.valueRef().get().setZero();
+        }
+    }
+    ldlt.factorize(A);
+    EXPECT_EQ(ldlt.info(), Eigen::NumericalIssue);
+    EXPECT_TRUE(expand(ldlt.solve(b)).allFinite());
+}
+
+TEST(RecursiveLinearSolver, MixedPrecisionRefinement)
+{
+    Random::setSeed(5634589);
+    srand(8934571);
+    // Float blocks of a badly conditioned (shifted block Laplacian) matrix. The refinement residual is computed in
+    // double, so a few refinement steps reach a much higher accuracy than the float factorization alone.
+
+    using T              = float;
+    const int block_size = 6;
+    int n                = 100;
+
+    using Block  = Eigen::Matrix<T, block_size, block_size, Eigen::RowMajor>;
+    using Vector = Eigen::Matrix<T, block_size, 1>;
+    using AType  = Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<Block>, Eigen::RowMajor>;
+    using BType  = Eigen::Matrix<Eigen::Recursive::MatrixScalar<Vector>, -1, 1>;
+
+    typedef Eigen::Triplet<Block> Trip;
+    std::vector<Trip> tripletList;
+    for (int i = 0; i < n; ++i)
+    {
+        Block diag = Block::Random() * 0.01;
+        diag       = diag.selfadjointView<Eigen::Upper>();
+        diag.diagonal() += Vector::Ones() * 2.001;
+        tripletList.push_back(Trip(i, i, diag));
+        if (i + 1 < n) tripletList.push_back(Trip(i, i + 1, -Block::Identity() + Block::Random() * 0.01));
+    }
+    AType A(n, n);
+    A.setFromTriplets(tripletList.begin(), tripletList.end());
+
+    BType b(n);
+    for (int i = 0; i < n; ++i) b(i) = Vector::Random();
+
+    // Reference solution of the float matrix in double
+    Eigen::Matrix<double, -1, -1> A_ex = expand(A).cast<double>();
+    A_ex                               = A_ex.selfadjointView<Eigen::Upper>();
+    Eigen::Matrix<double, -1, 1> ref   = A_ex.ldlt().solve(expand(b).cast<double>());
+
+    for (bool supernodal : {true, false})
+    {
+        auto relativeError = [&](int refinementSteps) {
+            Eigen::Recursive::LinearSolverOptions options;
+            options.solverType      = Eigen::Recursive::LinearSolverOptions::SolverType::Direct;
+            options.cholmod         = false;
+            options.supernodal      = supernodal;
+            options.refinementSteps = refinementSteps;
+
+            Eigen::Recursive::MixedSymmetricRecursiveSolver<AType, BType> solver;
+            BType x(n);
+            solver.solve(A, x, b, options);
+            return (expand(x).cast<double>() - ref).norm() / ref.norm();
+        };
+
+        double error0 = relativeError(0);
+        double error3 = relativeError(3);
+        EXPECT_LT(error3, 1e-6);
+        EXPECT_LT(error3, error0 * 0.1);
+    }
+}
+
+TEST(RecursiveLinearSolver, Preconditioner)
+{
+    Random::setSeed(9346781);
+    srand(2389457);
+
+    using T              = double;
+    const int block_size = 6;
+    int n                = 150;
+    int bandwidth        = 3;
+
+    using Block  = Eigen::Matrix<T, block_size, block_size, Eigen::RowMajor>;
+    using Vector = Eigen::Matrix<T, block_size, 1>;
+    using AType  = Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<Block>, Eigen::RowMajor>;
+    using BType  = Eigen::Matrix<Eigen::Recursive::MatrixScalar<Vector>, -1, 1>;
+
+    typedef Eigen::Triplet<Block> Trip;
+    std::vector<Trip> tripletList;
+    for (int i = 0; i < n; ++i)
+    {
+        Block diag = Block::Random();
+        diag       = diag.selfadjointView<Eigen::Upper>();
+        diag.diagonal() += Vector::Ones() * 40;
+        tripletList.push_back(Trip(i, i, diag));
+
+        for (int j = i + 1; j < std::min(n, i + bandwidth + 1); ++j)
+        {
+            tripletList.push_back(Trip(i, j, Block::Random()));
+        }
+    }
+    for (int k = 0; k < 10; ++k)
+    {
+        tripletList.push_back(Trip(k * 7, n - 1 - k * 11, Block::Random()));
+    }
+    AType A(n, n);
+    A.setFromTriplets(tripletList.begin(), tripletList.end());
+
+    BType b(n);
+    for (int i = 0; i < n; ++i) b(i) = Vector::Random();
+
+    Eigen::Matrix<double, -1, -1> A_ex = expand(A);
+    A_ex                               = A_ex.selfadjointView<Eigen::Upper>();
+    Eigen::Matrix<double, -1, 1> ref   = A_ex.ldlt().solve(expand(b));
+
+    auto cg = [&](const auto& P) {
+        BType x(n);
+        setZero(x);
+        Eigen::Index iters = 500;
+        double tol         = 1e-12;
+        recursive_conjugate_gradient(
+            [&](const BType& v, BType& result) { result = A.template selfadjointView<Eigen::Upper>() * v; }, b, x, P,
+            iters, tol);
+        ExpectCloseRelative(ref, expand(x), 1e-8, false);
+        return iters;
+    };
+
+    Eigen::Recursive::RecursiveDiagonalPreconditioner<Eigen::Recursive::MatrixScalar<Block>> jacobi;
+    jacobi.compute(A);
+    auto jacobiIters = cg(jacobi);
+
+    Eigen::Recursive::RecursiveSSORPreconditioner<AType> ssor;
+    ssor.compute(A);
+    EXPECT_LE(cg(ssor), jacobiIters);
+
+    ssor.omega = 1.2;
+    ssor.compute(A);
+    EXPECT_LE(cg(ssor), jacobiIters);
+
+    Eigen::Recursive::RecursiveIncompleteCholeskyPreconditioner<AType> ic;
+    ic.compute(A);
+    EXPECT_EQ(ic.info(), Eigen::Success);
+    auto ic0Iters = cg(ic);
+    EXPECT_LE(ic0Iters, jacobiIters);
+
+    ic.fillLevel = 2;
+    ic.compute(A);
+    EXPECT_GT(ic.nonZeros(), A.nonZeros() - n);
+    EXPECT_LE(cg(ic), ic0Iters);
+
+    // Without dropping IC is the exact factorization
+    ic.fillLevel = n;
+    ic.compute(A);
+    EXPECT_EQ(ic.shift(), 0);
+    EXPECT_LE(cg(ic), 1);
+
+    Eigen::Recursive::RecursiveClusterJacobiPreconditioner<Eigen::Recursive::MatrixScalar<Block>> cluster;
+    cluster.maxClusterSize = 4;
+    cluster.clusterByGraph(A);
+    cluster.factorize(A);
+    EXPECT_LT(cluster.numClusters(), n);
+    EXPECT_LE(cg(cluster), jacobiIters);
+}
+
+TEST(RecursiveLinearSolver, BAPreconditioner)
+{
+    // The preconditioners of the Schur complement solver. The cluster preconditioner is tested with the implicit
+    // and the explicit Schur complement.
+    Random::setSeed(457367);
+    srand(967345);
+
+    static constexpr int blockSizeCamera = 6;
+    static constexpr int blockSizePoint  = 3;
+
+    int n                 = 20;
+    int m                 = 200;
+    int non_zeros_per_row = 20;
+
+    using ADiag = Eigen::Matrix<double, blockSizeCamera, blockSizeCamera, Eigen::RowMajor>;
+    using BDiag = Eigen::Matrix<double, blockSizePoint, blockSizePoint, Eigen::RowMajor>;
+    using WElem = Eigen::Matrix<double, blockSizeCamera, blockSizePoint, Eigen::RowMajor>;
+    using ARes  = Eigen::Matrix<double, blockSizeCamera, 1>;
+    using BRes  = Eigen::Matrix<double, blockSizePoint, 1>;
+
+    using UType    = Eigen::DiagonalMatrix<Eigen::Recursive::MatrixScalar<ADiag>, -1>;
+    using VType    = Eigen::DiagonalMatrix<Eigen::Recursive::MatrixScalar<BDiag>, -1>;
+    using DAType   = Eigen::Matrix<Eigen::Recursive::MatrixScalar<ARes>, -1, 1>;
+    using DBType   = Eigen::Matrix<Eigen::Recursive::MatrixScalar<BRes>, -1, 1>;
+    using WType    = Eigen::SparseMatrix<Eigen::Recursive::MatrixScalar<WElem>, Eigen::RowMajor>;
+    using BAMatrix = Eigen::Recursive::SymmetricMixedMatrix2<UType, VType, WType>;
+    using BAVector = Eigen::Recursive::MixedVector2<DAType, DBType>;
+    using BASolver = Eigen::Recursive::MixedSymmetricRecursiveSolver<BAMatrix, BAVector>;
+
+    BAMatrix A;
+    BAVector x, b;
+    A.resize(n, m);
+    x.resize(n, m);
+    b.resize(n, m);
+    setZero(A.u);
+    setZero(A.v);
+    setZero(A.w);
+    setRandom(b.u);
+    setRandom(b.v);
+
+    for (int i = 0; i < n; ++i)
+    {
+        ADiag diag = ADiag::Random();
+        diag       = diag.selfadjointView<Eigen::Upper>();
+        diag.diagonal() += ARes::Ones() * 60;
+        A.u.diagonal()(i) = diag;
+    }
+    for (int i = 0; i < m; ++i)
+    {
+        BDiag diag = BDiag::Random();
+        diag       = diag.selfadjointView<Eigen::Upper>();
+        diag.diagonal() += BRes::Ones() * 10;
+        A.v.diagonal()(i) = diag;
+    }
+
+    // The points are only visible in neighboring cameras -> clusters of covisible cameras
+    typedef Eigen::Triplet<WElem> Trip;
+    std::vector<Trip> tripletList;
+    for (int i = 0; i < n; ++i)
+    {
+        auto indices = Random::uniqueIndices(non_zeros_per_row, 30);
+        for (auto j : indices)
+        {
+            tripletList.push_back(Trip(i, (j + i * 10) % m, WElem::Random()));
+        }
+    }
+    A.w.setFromTriplets(tripletList.begin(), tripletList.end());
+
+    Eigen::Matrix<double, -1, 1> ref_x1;
+    {
+        Eigen::Matrix<double, -1, -1> u_ex = expand(A.u);
+        Eigen::Matrix<double, -1, -1> v_ex = expand(A.v);
+        Eigen::Matrix<double, -1, -1> w_ex = expand(A.w);
+        Eigen::Matrix<double, -1, -1> A_ex(u_ex.rows() + w_ex.cols(), u_ex.cols() + w_ex.cols());
+        A_ex.setZero();
+        A_ex.block(0, 0, u_ex.rows(), u_ex.cols())                     = u_ex;
+        A_ex.block(u_ex.rows(), u_ex.cols(), v_ex.rows(), v_ex.cols()) = v_ex;
+        A_ex.block(0, u_ex.cols(), w_ex.rows(), w_ex.cols())           = w_ex;
+        A_ex                                                           = A_ex.selfadjointView<Eigen::Upper>();
+
+        Eigen::Matrix<double, -1, 1> b_ex(u_ex.rows() + v_ex.rows());
+        b_ex << expand(b.u), expand(b.v);
+        ref_x1 = A_ex.ldlt().solve(b_ex).segment(0, u_ex.rows());
+    }
+
+    using PT  = Eigen::Recursive::LinearSolverOptions::PreconditionerType;
+    auto test = [&](PT type, bool explizit, int clusterSize = 8) {
+        BASolver solver;
+        Eigen::Recursive::LinearSolverOptions lops;
+        lops.solverType             = Eigen::Recursive::LinearSolverOptions::SolverType::Iterative;
+        lops.maxIterativeIterations = 200;
+        lops.iterativeTolerance     = 1e-12;
+        lops.buildExplizitSchur     = explizit;
+        lops.preconditioner         = type;
+        lops.clusterSize            = clusterSize;
+        setZero(x);
+        solver.analyzePattern(A, lops);
+        solver.solve(A, x, b, lops);
+        ExpectCloseRelative(ref_x1, expand(x.u), 1e-8, false);
+        return solver.iterations();
+    };
+
+    int jacobiIters = test(PT::BlockJacobi, false);
+    EXPECT_EQ(test(PT::BlockJacobi, true), jacobiIters);
+    EXPECT_LE(test(PT::SSOR, false), jacobiIters);
+    EXPECT_LE(test(PT::IncompleteCholesky, false), jacobiIters);
+
+    int clusterIters = test(PT::ClusterJacobi, false);
+    EXPECT_LE(clusterIters, jacobiIters);
+    EXPECT_EQ(test(PT::ClusterJacobi, true), clusterIters);
+
+    // A single cluster is the exact inverse of S
+    EXPECT_LE(test(PT::ClusterJacobi, false, n), 1);
+}
+
 TEST(RecursiveLinearSolver, BA)
 {
     // Symmetric positive BA like matrix.
@@ -5,7 +5,9 @@
  */
 #include "saiga/core/Core.h"
 #include "saiga/core/model/model_loader_ply.h"
+#include "saiga/core/model/model_from_shape.h"
 #include "saiga/vision/reconstruction/MarchingCubes.h"
+#include "saiga/vision/reconstruction/MeshToTSDF.h"
 #include "saiga/vision/reconstruction/SparseTSDF.h"
 #include "saiga/vision/reconstruction/VoxelFusion.h"
 
@@ -342,6 +344,53 @@ TEST(TSDF, Trace)
     rgb_image2.save("tsdf_trace2.png");
 }
 
+TEST(TSDF, MeshToTSDF)
+{
+    Random::setSeed(2364);
+    auto model = IcoSphereMesh(Sphere(vec3(0, 0, 0), 1), 3);
+    std::vector<Triangle> triangles;
+    for (auto& f : model.triangles)
+    {
+        triangles.push_back(Triangle(model.position[f(0)].normalized(), model.position[f(1)].normalized(),
+                                     model.position[f(2)].normalized()));
+    }
+
+    // Signed distance of a sphere. The mesh is slightly inside the sphere.
+    MeshSignedDistance sdf(triangles);
+    int hint = -1;
+    for (int i = 0; i < 2000; ++i)
+    {
+        vec3 p    = Random::MatrixUniform<vec3>(-1.5, 1.5);
+        float d   = sdf.Distance(p, hint);
+        float ref = p.norm() - 1;
+        EXPECT_EQ(std::abs(d), Distance(triangles, p));
+        if (std::abs(ref) > 0.05)
+        {
+            EXPECT_EQ(d > 0, ref > 0);
+        }
+        EXPECT_NEAR(d, ref, 0.05);
+    }
+
+    float voxel_size = 0.05;
+    auto tsdf        = MeshToTSDF(triangles, voxel_size, 1);
+    EXPECT_GT(tsdf->current_blocks, 0);
+    for (int bi = 0; bi < tsdf->current_blocks; ++bi)
+    {
+        auto& b = tsdf->blocks[bi];
+        for (int i = 0; i < tsdf->VOXEL_BLOCK_SIZE; ++i)
+        {
+            for (int j = 0; j < tsdf->VOXEL_BLOCK_SIZE; ++j)
+            {
+                for (int k = 0; k < tsdf->VOXEL_BLOCK_SIZE; ++k)
+                {
+                    vec3 p = tsdf->GlobalPosition(b.index, i, j, k);
+                    EXPECT_EQ(b.data[i][j][k].distance, sdf.Distance(p));
+                }
+            }
+        }
+    }
+}
+
 }  // namespace Saiga
 
 int main()